@@ -165,6 +165,8 @@ public:
     TaskStats *GetTaskGroupStats();
     TaskStats *GetTaskStats();
     TaskStats *GetTaskStats(int task_instance);
+    TaskLatencyStats *GetLatencyStats() { return &latency_stats_; }
+    void UpdateLatencyStats(Task *t, uint64_t slow_run_threshold_usec);
     void ClearTaskGroupStats();
     void ClearTaskStats();
     void ClearTaskStats(int instance_id);
@@ -207,6 +209,7 @@ private:
     TaskEntryList           task_entry_db_;  // task-entries in this group
 
     TaskStats               stats_;
+    TaskLatencyStats        latency_stats_;
     DISALLOW_COPY_AND_ASSIGN(TaskGroup);
 };
 
@@ -221,7 +224,16 @@ tbb::task *TaskImpl::execute() {
     TaskInfo::reference running = task_running.local();
     running = parent_;
     try {
+        // enqueue_time_ is set only if latency stats are enabled
+        uint64_t start_time = 0;
+        if (parent_->enqueue_time_) {
+            start_time = ClockMonotonicUsec();
+        }
         bool is_complete = parent_->Run();
+        if (start_time) {
+            parent_->wait_time_ = start_time - parent_->enqueue_time_;
+            parent_->run_time_ = ClockMonotonicUsec() - start_time;
+        }
         running = NULL;
         if (is_complete == true) {
             parent_->SetTaskComplete();
@@ -284,7 +296,8 @@ int TaskScheduler::GetThreadCount() {
 // part of tbb. So, initialize TBB with one thread more than its default
 TaskScheduler::TaskScheduler() : 
     task_scheduler_(GetThreadCount() + 1),
-    running_(true), seqno_(0), id_max_(0) {
+    running_(true), seqno_(0), id_max_(0),
+    latency_stats_enabled_(false), slow_run_threshold_usec_(0) {
     hw_thread_count_ = GetThreadCount();
     task_group_db_.resize(TaskScheduler::kVectorGrowSize);
     stop_entry_ = new TaskEntry(-1);
@@ -409,9 +422,11 @@ void TaskScheduler::EnqueueUnLocked(Task *t) {
     // Ensure that task is enqueued only once.
     assert(t->GetSeqno() == 0);
     t->SetSeqNo(++seqno_);
+    if (latency_stats_enabled_) {
+        t->enqueue_time_ = ClockMonotonicUsec();
+    }
     TaskGroup *group = GetTaskGroup(t->GetTaskId());
 
-
     TaskEntry *entry = GetTaskEntry(t->GetTaskId(), t->GetTaskInstance());
     // Add task to waitq_ if its already populated
     if (entry->WaitQSize() != 0) {
@@ -501,7 +516,14 @@ void TaskScheduler::OnTaskExit(Task *t) {
     tbb::mutex::scoped_lock lock(mutex_);
 
     TaskEntry *entry = QueryTaskEntry(t->GetTaskId(), t->GetTaskInstance());
-    entry->TaskExited(t, GetTaskGroup(t->GetTaskId()));
+    TaskGroup *group = GetTaskGroup(t->GetTaskId());
+    if (t->enqueue_time_) {
+        if (latency_stats_enabled_) {
+            group->UpdateLatencyStats(t, slow_run_threshold_usec_);
+        }
+        t->ClearLatencyTimestamps();
+    }
+    entry->TaskExited(t, group);
 
     //
     // Delete the task it is not marked for recycling or already cancelled.
@@ -621,6 +643,25 @@ void TaskScheduler::ClearTaskStats(int task_id, int instance_id) {
     group->ClearTaskStats(instance_id);
 }
 
+void TaskScheduler::EnableLatencyStats(uint64_t slow_run_threshold_usec) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    latency_stats_enabled_ = true;
+    slow_run_threshold_usec_ = slow_run_threshold_usec;
+}
+
+void TaskScheduler::DisableLatencyStats() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    latency_stats_enabled_ = false;
+}
+
+const TaskLatencyStats *TaskScheduler::GetTaskGroupLatencyStats(int task_id) {
+    TaskGroup *group = GetTaskGroup(task_id);
+    if (group == NULL)
+        return NULL;
+
+    return group->GetLatencyStats();
+}
+
 TaskStats *TaskScheduler::GetTaskGroupStats(int task_id) {
     TaskGroup *group = GetTaskGroup(task_id);
     if (group == NULL)
@@ -862,6 +903,27 @@ bool TaskGroup::IsWaitQEmpty() {
 
 void TaskGroup::ClearTaskGroupStats() {
     memset(&stats_, 0, sizeof(stats_));
+    latency_stats_.Clear();
+}
+
+// Account queue-wait and run time of a task on its exit. Invoked with the
+// scheduler mutex held.
+void TaskGroup::UpdateLatencyStats(Task *t, uint64_t slow_run_threshold_usec) {
+    latency_stats_.wait_time_.Add(t->wait_time_);
+    latency_stats_.run_time_.Add(t->run_time_);
+
+    if (t->wait_time_ < slow_run_threshold_usec &&
+        t->run_time_ < slow_run_threshold_usec) {
+        return;
+    }
+
+    TaskRunRecord record;
+    record.task_instance_ = t->GetTaskInstance();
+    record.seqno_ = t->GetSeqno();
+    record.start_time_ = UTCTimestampUsec() - t->run_time_;
+    record.wait_usec_ = t->wait_time_;
+    record.run_usec_ = t->run_time_;
+    latency_stats_.slow_runs_.push_back(record);
 }
 
 void TaskGroup::ClearTaskStats() {
@@ -1153,12 +1215,47 @@ int TaskEntry::GetTaskDeferEntrySeqno() const {
 ////////////////////////////////////////////////////////////////////////////
 Task::Task(int task_id, int task_instance) : task_id_(task_id),
     task_instance_(task_instance), task_impl_(NULL), state_(INIT), seqno_(0),
-    task_recycle_(false), task_cancel_(false) {
+    task_recycle_(false), task_cancel_(false), enqueue_time_(0),
+    wait_time_(0), run_time_(0) {
 }
 
 Task::Task(int task_id) : task_id_(task_id),
     task_instance_(-1), task_impl_(NULL), state_(INIT), seqno_(0),
-    task_recycle_(false), task_cancel_(false) {
+    task_recycle_(false), task_cancel_(false), enqueue_time_(0),
+    wait_time_(0), run_time_(0) {
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Implementation for struct TaskLatencyHistogram
+////////////////////////////////////////////////////////////////////////////
+void TaskLatencyHistogram::Clear() {
+    count_ = 0;
+    total_usec_ = 0;
+    max_usec_ = 0;
+    memset(buckets_, 0, sizeof(buckets_));
+}
+
+int TaskLatencyHistogram::BucketIndex(uint64_t usec) {
+    int index = 0;
+    while (usec && index < kBucketCount - 1) {
+        usec >>= 1;
+        index++;
+    }
+    return index;
+}
+
+uint64_t TaskLatencyHistogram::BucketLowerBound(int index) {
+    if (index == 0)
+        return 0;
+    return (1ULL << (index - 1));
+}
+
+void TaskLatencyHistogram::Add(uint64_t usec) {
+    count_++;
+    total_usec_ += usec;
+    if (usec > max_usec_)
+        max_usec_ = usec;
+    buckets_[BucketIndex(usec)]++;
 }
 
 // Start execution of task
@@ -1214,6 +1311,37 @@ static const string TaskStateToString(Task::State state) {
     }
 }
 
+static const string LatencyBucketToString(int index) {
+    std::stringstream ss;
+    if (index == 0) {
+        ss << "< 1 us";
+    } else if (index == TaskLatencyHistogram::kBucketCount - 1) {
+        ss << ">= " << TaskLatencyHistogram::BucketLowerBound(index) << " us";
+    } else {
+        ss << TaskLatencyHistogram::BucketLowerBound(index) << " - "
+           << TaskLatencyHistogram::BucketLowerBound(index + 1) << " us";
+    }
+    return ss.str();
+}
+
+static void GetLatencyHistogramSandeshData(const TaskLatencyHistogram &hist,
+                                           SandeshTaskLatencyHistogram *data) {
+    data->set_count(hist.count_);
+    data->set_average_usec(hist.count_ ? hist.total_usec_ / hist.count_ : 0);
+    data->set_max_usec(hist.max_usec_);
+
+    std::vector<SandeshTaskLatencyBucket> buckets;
+    for (int i = 0; i < TaskLatencyHistogram::kBucketCount; i++) {
+        if (hist.buckets_[i] == 0)
+            continue;
+        SandeshTaskLatencyBucket bucket;
+        bucket.set_range(LatencyBucketToString(i));
+        bucket.set_count(hist.buckets_[i]);
+        buckets.push_back(bucket);
+    }
+    data->set_buckets(buckets);
+}
+
 void TaskScheduler::GetTaskEntrySummary(TaskEntry *entry,
                                         SandeshTaskEntrySummary *summary) {
     summary->set_task_entry_key(TaskEntryToString(entry));
@@ -1269,6 +1397,34 @@ void TaskScheduler::GetTaskGroupSandeshData(int task_id,
         defer_list.push_back(summary);
     }
     resp->set_defer_list(defer_list);
+
+    const TaskLatencyStats *latency_stats = group->GetLatencyStats();
+    if (latency_stats->wait_time_.count_ == 0)
+        return;
+
+    SandeshTaskLatencyHistogram wait_time;
+    GetLatencyHistogramSandeshData(latency_stats->wait_time_, &wait_time);
+    resp->set_wait_time(wait_time);
+
+    SandeshTaskLatencyHistogram run_time;
+    GetLatencyHistogramSandeshData(latency_stats->run_time_, &run_time);
+    resp->set_run_time(run_time);
+
+    std::vector<SandeshTaskRunRecord> slow_runs;
+    for (boost::circular_buffer<TaskRunRecord>::const_reverse_iterator it =
+         latency_stats->slow_runs_.rbegin();
+         it != latency_stats->slow_runs_.rend(); ++it) {
+        SandeshTaskRunRecord record;
+        record.set_instance_id(it->task_instance_);
+        record.set_seqno(it->seqno_);
+        record.set_start_time(
+            boost::posix_time::to_simple_string(
+                UTCUsecToPTime(it->start_time_)));
+        record.set_wait_time_usec(it->wait_usec_);
+        record.set_run_time_usec(it->run_usec_);
+        slow_runs.push_back(record);
+    }
+    resp->set_slow_runs(slow_runs);
 }
 
 void TaskScheduler::GetTaskEntrySandeshData(int task_id, int instance_id,
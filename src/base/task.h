@@ -31,6 +31,7 @@
 #ifndef ctrlplane_task_h
 #define ctrlplane_task_h
 
+#include <boost/circular_buffer.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <map>
 #include <vector>
@@ -54,6 +55,51 @@ struct TaskStats {
     int     defer_count_;
 };
 
+// Histogram of latency samples in power-of-2 microsecond buckets.
+// Bucket 0 counts samples below 1us, bucket i (i > 0) counts samples in
+// [2^(i-1), 2^i) usec. The last bucket absorbs everything larger.
+struct TaskLatencyHistogram {
+    static const int kBucketCount = 26;
+
+    TaskLatencyHistogram() { Clear(); }
+    void Clear();
+    void Add(uint64_t usec);
+    static int BucketIndex(uint64_t usec);
+    static uint64_t BucketLowerBound(int index);
+
+    uint64_t count_;
+    uint64_t total_usec_;
+    uint64_t max_usec_;
+    uint64_t buckets_[kBucketCount];
+};
+
+// Record of a single task run whose queue-wait or run time exceeded the
+// slow-run threshold configured in the TaskScheduler.
+struct TaskRunRecord {
+    int         task_instance_;
+    uint32_t    seqno_;
+    uint64_t    start_time_;        // UTC usec
+    uint64_t    wait_usec_;
+    uint64_t    run_usec_;
+};
+
+// Per TaskGroup latency statistics. Maintained only when latency stats are
+// enabled in the TaskScheduler.
+struct TaskLatencyStats {
+    static const size_t kSlowRunHistorySize = 16;
+
+    TaskLatencyStats() : slow_runs_(kSlowRunHistorySize) { }
+    void Clear() {
+        wait_time_.Clear();
+        run_time_.Clear();
+        slow_runs_.clear();
+    }
+
+    TaskLatencyHistogram wait_time_;    // enqueue to start of Run()
+    TaskLatencyHistogram run_time_;     // time spent in Run()
+    boost::circular_buffer<TaskRunRecord> slow_runs_;
+};
+
 struct TaskExclusion {
     TaskExclusion(int task_id) : match_id(task_id), match_instance(-1) {}
     TaskExclusion(int task_id, int instance_id)
@@ -101,6 +147,7 @@ public:
 
 private:
     friend class TaskEntry;
+    friend class TaskGroup;
     friend class TaskScheduler;
     friend class TaskImpl;
     void SetSeqNo(int seqno) {seqno_ = seqno;};
@@ -108,6 +155,11 @@ private:
     void SetTaskRecycle() { task_recycle_ = true; };
     void SetTaskComplete() { task_recycle_ = false; };
     void StartTask();
+    void ClearLatencyTimestamps() {
+        enqueue_time_ = 0;
+        wait_time_ = 0;
+        run_time_ = 0;
+    }
 
     int                 task_id_;       // The code path executed by the task.
     int                 task_instance_; // The dataset id within a code path.
@@ -117,6 +169,11 @@ private:
     bool                task_recycle_;
     bool                task_cancel_;
 
+    // Latency measurement, populated only if enabled in the TaskScheduler.
+    uint64_t            enqueue_time_;  // monotonic usec
+    uint64_t            wait_time_;     // usec spent waiting to run
+    uint64_t            run_time_;      // usec spent in Run()
+
     DISALLOW_COPY_AND_ASSIGN(Task);
 };
 
@@ -162,6 +219,17 @@ public:
     void ClearTaskStats(int task_id);
     void ClearTaskStats(int task_id, int instance_id);
 
+    // Per TaskGroup histograms of queue-wait and run time along with a
+    // history of the most recent slow runs. Disabled by default since it
+    // adds a couple of clock reads per task.
+    void EnableLatencyStats(uint64_t slow_run_threshold_usec);
+    void DisableLatencyStats();
+    bool latency_stats_enabled() const { return latency_stats_enabled_; }
+    uint64_t slow_run_threshold_usec() const {
+        return slow_run_threshold_usec_;
+    }
+    const TaskLatencyStats *GetTaskGroupLatencyStats(int task_id);
+
     TaskGroup *GetTaskGroup(int task_id);
     TaskGroup *QueryTaskGroup(int task_id);
     TaskEntry *GetTaskEntry(int task_id, int instance_id);
@@ -185,6 +253,7 @@ private:
     friend class SandeshTaskGroupReq;
     friend class SandeshTaskEntryReq;
     friend class SandeshTaskReq;
+    friend class SandeshTaskLatencyStatsReq;
     void GetTaskGroupSandeshData(int task_id, SandeshTaskGroupResp *resp);
     void GetTaskEntrySandeshData(int task_id, int instance_id,
                                  SandeshTaskEntryResp *resp);
@@ -222,6 +291,9 @@ private:
 
     int                     hw_thread_count_;
 
+    bool                    latency_stats_enabled_;
+    uint64_t                slow_run_threshold_usec_;
+
     DISALLOW_COPY_AND_ASSIGN(TaskScheduler);
 };
 
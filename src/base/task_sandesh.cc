@@ -40,14 +40,21 @@ static void SetStats(SandeshTaskStats &dest, TaskStats *src) {
     dest.set_defer_count(src->defer_count_);
 }
 
+static void SetSchedulerData(SandeshTaskSchedulerResp *resp,
+                             TaskScheduler *scheduler) {
+    resp->set_running(scheduler->GetRunStatus());
+    resp->set_thread_count(scheduler->HardwareThreadCount());
+    resp->set_latency_stats(scheduler->latency_stats_enabled());
+    resp->set_slow_run_threshold_usec(scheduler->slow_run_threshold_usec());
+}
+
 void SandeshTaskSchedulerReq::HandleRequest() const {
     TaskScheduler *scheduler = TaskScheduler::GetInstance();
     tbb::mutex::scoped_lock lock(scheduler->mutex_);
 
     SandeshTaskSchedulerResp *resp = new SandeshTaskSchedulerResp;
-    resp->set_running(scheduler->running_);
+    SetSchedulerData(resp, scheduler);
     resp->set_seqno(scheduler->seqno_);
-    resp->set_thread_count(scheduler->hw_thread_count_);
 
     std::vector<SandeshTaskGroupNameSummary> list;
     for (TaskScheduler::TaskIdMap::const_iterator it = 
@@ -56,6 +63,15 @@ void SandeshTaskSchedulerReq::HandleRequest() const {
         SandeshTaskGroupNameSummary entry;
         entry.set_task_id(it->second);
         entry.set_name(it->first);
+        TaskGroup *group = NULL;
+        if (it->second < (int) scheduler->task_group_db_.size())
+            group = scheduler->task_group_db_[it->second];
+        if (group != NULL && scheduler->latency_stats_enabled()) {
+            const TaskLatencyStats *latency_stats =
+                scheduler->GetTaskGroupLatencyStats(it->second);
+            entry.set_max_wait_time_usec(latency_stats->wait_time_.max_usec_);
+            entry.set_max_run_time_usec(latency_stats->run_time_.max_usec_);
+        }
         list.push_back(entry);
     }
     resp->set_task_group_list(list);
@@ -65,6 +81,24 @@ void SandeshTaskSchedulerReq::HandleRequest() const {
     resp->Response();
 }
 
+void SandeshTaskLatencyStatsReq::HandleRequest() const {
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    if (get_enable()) {
+        scheduler->EnableLatencyStats(get_slow_run_threshold_usec());
+    } else {
+        scheduler->DisableLatencyStats();
+    }
+
+    tbb::mutex::scoped_lock lock(scheduler->mutex_);
+    SandeshTaskSchedulerResp *resp = new SandeshTaskSchedulerResp;
+    SetSchedulerData(resp, scheduler);
+    resp->set_seqno(scheduler->seqno_);
+
+    resp->set_context(context());
+    resp->set_more(false);
+    resp->Response();
+}
+
 void SandeshTaskGroupReq::HandleRequest() const {
     TaskScheduler *scheduler = TaskScheduler::GetInstance();
     tbb::mutex::scoped_lock lock(scheduler->mutex_);
@@ -1353,6 +1353,75 @@ TEST_F(TestUT, test9_1)
     EXPECT_TRUE(scheduler->IsEmpty());
 }
 
+class LatencyTestTask : public Task {
+public:
+    LatencyTestTask(int id, int inst, int sleep_usec)
+        : Task(id, inst), sleep_usec_(sleep_usec) {
+    }
+    bool Run() {
+        usleep(sleep_usec_);
+        return true;
+    }
+
+private:
+    int sleep_usec_;
+};
+
+/* Enable latency stats and verify that queue-wait and run time of each task
+ * is accounted in the task group histograms and that slow runs are recorded */
+TEST_F(TestUT, latency_stats)
+{
+    scheduler->ClearTaskGroupStats(95);
+    scheduler->EnableLatencyStats(5000);
+
+    scheduler->Enqueue(new LatencyTestTask(95, 1, 10000));
+    scheduler->Enqueue(new LatencyTestTask(95, 1, 100));
+    scheduler->Enqueue(new LatencyTestTask(95, 2, 100));
+    for (int i = 0; i < 1000 && !scheduler->IsEmpty(); i++) {
+        usleep(1000);
+    }
+    EXPECT_TRUE(scheduler->IsEmpty());
+
+    const TaskLatencyStats *stats = scheduler->GetTaskGroupLatencyStats(95);
+    EXPECT_EQ(3U, stats->wait_time_.count_);
+    EXPECT_EQ(3U, stats->run_time_.count_);
+    EXPECT_LE(10000U, stats->run_time_.max_usec_);
+
+    // First task ran slow and the second task <95, 1> waited behind it.
+    EXPECT_LE(2U, stats->slow_runs_.size());
+    EXPECT_EQ(1, stats->slow_runs_[0].task_instance_);
+    EXPECT_LE(10000U, stats->slow_runs_[0].run_usec_);
+
+    uint64_t bucket_total = 0;
+    for (int i = 0; i < TaskLatencyHistogram::kBucketCount; i++) {
+        bucket_total += stats->run_time_.buckets_[i];
+    }
+    EXPECT_EQ(3U, bucket_total);
+
+    scheduler->DisableLatencyStats();
+    scheduler->Enqueue(new LatencyTestTask(95, 1, 100));
+    for (int i = 0; i < 1000 && !scheduler->IsEmpty(); i++) {
+        usleep(1000);
+    }
+    EXPECT_EQ(3U, stats->run_time_.count_);
+
+    scheduler->ClearTaskGroupStats(95);
+    EXPECT_EQ(0U, stats->run_time_.count_);
+    EXPECT_EQ(0U, stats->slow_runs_.size());
+}
+
+TEST_F(TestUT, latency_histogram_bucket)
+{
+    EXPECT_EQ(0, TaskLatencyHistogram::BucketIndex(0));
+    EXPECT_EQ(1, TaskLatencyHistogram::BucketIndex(1));
+    EXPECT_EQ(2, TaskLatencyHistogram::BucketIndex(2));
+    EXPECT_EQ(2, TaskLatencyHistogram::BucketIndex(3));
+    EXPECT_EQ(11, TaskLatencyHistogram::BucketIndex(1024));
+    EXPECT_EQ(TaskLatencyHistogram::kBucketCount - 1,
+              TaskLatencyHistogram::BucketIndex(0xFFFFFFFFFFFFULL));
+    EXPECT_EQ(1024U, TaskLatencyHistogram::BucketLowerBound(11));
+}
+
 int main(int argc, char *argv[])
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+//
+// Benchmark of 100k concurrent periodic timers with the ASIO timer and the
+// timer wheel backends. Not part of the unit test suites, run it by hand
+// with scons src/base:timer_wheel_benchmark.
+//
+
+#include <iostream>
+#include <vector>
+#include <boost/bind.hpp>
+#include "tbb/atomic.h"
+#include "io/test/event_manager_test.h"
+#include "base/test/task_test_util.h"
+#include "base/logging.h"
+#include "base/timer.h"
+#include "base/util.h"
+#include "testing/gunit.h"
+
+using namespace std;
+using tbb::atomic;
+
+class TimerBenchmarkTest : public ::testing::Test {
+protected:
+    TimerBenchmarkTest() : evm_(new EventManager()) {
+    }
+
+    virtual void SetUp() {
+        thread_.reset(new ServerThread(evm_.get()));
+        thread_->Start();
+    }
+
+    virtual void TearDown() {
+        task_util::WaitForIdle();
+        TimerManager::DisableTimerWheel();
+        evm_->Shutdown();
+        if (thread_.get() != NULL) {
+            thread_->Join();
+        }
+        task_util::WaitForIdle();
+    }
+
+    auto_ptr<ServerThread> thread_;
+    auto_ptr<EventManager> evm_;
+};
+
+class TimerBenchmark {
+public:
+    TimerBenchmark(boost::asio::io_service *io_service, int count,
+                   int period, int runs)
+        : remaining_(count, runs), period_(period), runs_(runs) {
+        fired_ = 0;
+        for (int i = 0; i < count; i++) {
+            timers_.push_back(
+                TimerManager::CreateTimer(*io_service, "Benchmark"));
+        }
+    }
+
+    ~TimerBenchmark() {
+        for (size_t i = 0; i < timers_.size(); i++) {
+            TimerManager::DeleteTimer(timers_[i]);
+        }
+    }
+
+    // Restart the timer until it has fired runs_ times.
+    bool Fire(int index) {
+        fired_.fetch_and_increment();
+        return (--remaining_[index] > 0);
+    }
+
+    uint64_t Run() {
+        uint64_t start = ClockMonotonicUsec();
+        for (size_t i = 0; i < timers_.size(); i++) {
+            // Spread the timer periods across 1..period_ msec.
+            timers_[i]->Start(1 + (i % period_),
+                              boost::bind(&TimerBenchmark::Fire, this, i));
+        }
+        TASK_UTIL_EXPECT_EQ_MSG((int) timers_.size() * runs_, fired_,
+                                "Timer benchmark");
+        task_util::WaitForIdle();
+        return ClockMonotonicUsec() - start;
+    }
+
+private:
+    std::vector<Timer *> timers_;
+    std::vector<int> remaining_;
+    atomic<int> fired_;
+    int period_;
+    int runs_;
+};
+
+static const int kBenchmarkTimers = 100000;
+static const int kBenchmarkPeriod = 100;
+static const int kBenchmarkRuns = 10;
+
+TEST_F(TimerBenchmarkTest, PeriodicTimers) {
+    uint64_t elapsed[2];
+    for (int wheel = 0; wheel < 2; wheel++) {
+        if (wheel) {
+            TimerManager::EnableTimerWheel();
+        }
+        TimerBenchmark benchmark(evm_->io_service(), kBenchmarkTimers,
+                                 kBenchmarkPeriod, kBenchmarkRuns);
+        elapsed[wheel] = benchmark.Run();
+        TimerManager::DisableTimerWheel();
+    }
+
+    uint64_t fires = kBenchmarkTimers * kBenchmarkRuns;
+    cout << fires << " periodic timer fires of " << kBenchmarkTimers
+         << " timers" << endl;
+    cout << "ASIO timers  : " << elapsed[0] / 1000 << " msec, "
+         << fires * 1000000 / elapsed[0] << " fires/sec" << endl;
+    cout << "Timer wheel  : " << elapsed[1] / 1000 << " msec, "
+         << fires * 1000000 / elapsed[1] << " fires/sec" << endl;
+}
+
+int main(int argc, char *argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    LoggingInit();
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include "tbb/atomic.h"
+#include "io/test/event_manager_test.h"
+#include "base/test/task_test_util.h"
+#include "base/logging.h"
+#include "base/timer.h"
+#include "base/timer_wheel.h"
+#include "testing/gunit.h"
+
+using namespace std;
+using tbb::atomic;
+
+class TimerWheelTest : public ::testing::Test {
+protected:
+    TimerWheelTest() : evm_(new EventManager()) {
+    }
+
+    virtual void SetUp() {
+        thread_.reset(new ServerThread(evm_.get()));
+        thread_->Start();
+        wheel_ = boost::make_shared<TimerWheel>(*evm_->io_service(), 1);
+        fired_ = 0;
+        aborted_ = 0;
+    }
+
+    virtual void TearDown() {
+        task_util::WaitForIdle();
+        wheel_.reset();
+        evm_->Shutdown();
+        if (thread_.get() != NULL) {
+            thread_->Join();
+        }
+        task_util::WaitForIdle();
+    }
+
+    void Callback(const boost::system::error_code &ec) {
+        if (ec) {
+            aborted_++;
+        } else {
+            fired_++;
+        }
+    }
+
+    void Schedule(TimerWheel::Entry *entry, int time) {
+        wheel_->Schedule(entry, time,
+            boost::bind(&TimerWheelTest::Callback, this, _1));
+    }
+
+    uint64_t current_tick() {
+        tbb::mutex::scoped_lock lock(wheel_->mutex_);
+        return wheel_->current_tick_;
+    }
+
+    uint64_t wakeups() {
+        tbb::mutex::scoped_lock lock(wheel_->mutex_);
+        return wheel_->wakeups_;
+    }
+
+    auto_ptr<ServerThread> thread_;
+    auto_ptr<EventManager> evm_;
+    boost::shared_ptr<TimerWheel> wheel_;
+    atomic<int> fired_;
+    atomic<int> aborted_;
+};
+
+TEST_F(TimerWheelTest, Basic) {
+    TimerWheel::Entry entries[8];
+    for (int i = 0; i < 8; i++) {
+        Schedule(&entries[i], i * 10);
+    }
+    EXPECT_EQ(8U, wheel_->size());
+    TASK_UTIL_EXPECT_EQ(8, fired_);
+    EXPECT_EQ(0, aborted_);
+    EXPECT_EQ(0U, wheel_->size());
+    for (int i = 0; i < 8; i++) {
+        EXPECT_FALSE(entries[i].scheduled());
+    }
+}
+
+TEST_F(TimerWheelTest, Cancel) {
+    TimerWheel::Entry entry1, entry2;
+    Schedule(&entry1, 50);
+    Schedule(&entry2, 50);
+    EXPECT_TRUE(wheel_->Cancel(&entry1));
+    EXPECT_FALSE(wheel_->Cancel(&entry1));
+    EXPECT_EQ(1U, wheel_->size());
+    TASK_UTIL_EXPECT_EQ(1, fired_);
+    usleep(100000);
+    EXPECT_EQ(1, fired_);
+    EXPECT_FALSE(wheel_->Cancel(&entry2));
+}
+
+TEST_F(TimerWheelTest, Reschedule) {
+    TimerWheel::Entry entry;
+    Schedule(&entry, 10000);
+    Schedule(&entry, 20);
+    EXPECT_EQ(1U, wheel_->size());
+    TASK_UTIL_EXPECT_EQ(1, fired_);
+    EXPECT_EQ(0U, wheel_->size());
+}
+
+// Entries in the upper levels get cascaded down and expire in order.
+TEST_F(TimerWheelTest, Cascade) {
+    TimerWheel::Entry entries[3];
+    Schedule(&entries[0], 300);
+    Schedule(&entries[1], 600);
+    Schedule(&entries[2], 1200);
+    TASK_UTIL_EXPECT_EQ(1, fired_);
+    EXPECT_TRUE(entries[1].scheduled());
+    TASK_UTIL_EXPECT_EQ(2, fired_);
+    EXPECT_TRUE(entries[2].scheduled());
+    TASK_UTIL_EXPECT_EQ(3, fired_);
+}
+
+// Expiry beyond the range of the wheel is parked and stays scheduled.
+TEST_F(TimerWheelTest, Overflow) {
+    TimerWheel::Entry entry1, entry2;
+    Schedule(&entry1, 0x7fffffff);
+    Schedule(&entry2, 20);
+    TASK_UTIL_EXPECT_EQ(1, fired_);
+    EXPECT_TRUE(entry1.scheduled());
+    EXPECT_LT(0U, current_tick());
+    EXPECT_TRUE(wheel_->Cancel(&entry1));
+    EXPECT_EQ(0U, wheel_->size());
+}
+
+// Wheel holding only long timers does not wake up on every tick.
+TEST_F(TimerWheelTest, IdleWakeups) {
+    TimerWheel::Entry entry1, entry2;
+    Schedule(&entry1, 2000);
+    Schedule(&entry2, 100000);
+    usleep(500000);
+    EXPECT_EQ(0, fired_);
+    EXPECT_GT(10U, wakeups());
+
+    // Earlier expiry re-arms the timer
+    TimerWheel::Entry entry3;
+    Schedule(&entry3, 20);
+    TASK_UTIL_EXPECT_EQ(1, fired_);
+    TASK_UTIL_EXPECT_EQ(2, fired_);
+    EXPECT_GT(20U, wakeups());
+    EXPECT_TRUE(wheel_->Cancel(&entry2));
+}
+
+//
+// Timer API on top of the timer wheel backend.
+//
+static atomic<int> timer_count_;
+
+static bool TimerCb() {
+    timer_count_.fetch_and_increment();
+    return false;
+}
+
+static bool PeriodicTimerCb(atomic<int> *count) {
+    timer_count_.fetch_and_increment();
+    return (count->fetch_and_decrement() > 1);
+}
+
+class TimerWheelBackendTest : public ::testing::Test {
+protected:
+    TimerWheelBackendTest() : evm_(new EventManager()) {
+    }
+
+    virtual void SetUp() {
+        TimerManager::EnableTimerWheel();
+        thread_.reset(new ServerThread(evm_.get()));
+        thread_->Start();
+        timer_count_ = 0;
+    }
+
+    virtual void TearDown() {
+        task_util::WaitForIdle();
+        TimerManager::DisableTimerWheel();
+        evm_->Shutdown();
+        if (thread_.get() != NULL) {
+            thread_->Join();
+        }
+        task_util::WaitForIdle();
+    }
+
+    auto_ptr<ServerThread> thread_;
+    auto_ptr<EventManager> evm_;
+};
+
+TEST_F(TimerWheelBackendTest, StartCancel) {
+    Timer *timer1 = TimerManager::CreateTimer(*evm_->io_service(), "Wheel-1");
+    Timer *timer2 = TimerManager::CreateTimer(*evm_->io_service(), "Wheel-2");
+    timer1->Start(20, TimerCb);
+    timer2->Start(20, TimerCb);
+    EXPECT_TRUE(timer1->running());
+    EXPECT_TRUE(timer2->Cancel());
+    TASK_UTIL_EXPECT_EQ(1, timer_count_);
+    task_util::WaitForIdle();
+    EXPECT_EQ(1, timer_count_);
+
+    timer2->Start(20, TimerCb);
+    TASK_UTIL_EXPECT_EQ(2, timer_count_);
+    task_util::WaitForIdle();
+    EXPECT_TRUE(TimerManager::DeleteTimer(timer1));
+    EXPECT_TRUE(TimerManager::DeleteTimer(timer2));
+}
+
+TEST_F(TimerWheelBackendTest, Periodic) {
+    atomic<int> count;
+    count = 10;
+    Timer *timer = TimerManager::CreateTimer(*evm_->io_service(), "Wheel-1");
+    timer->Start(5, boost::bind(&PeriodicTimerCb, &count));
+    TASK_UTIL_EXPECT_EQ(10, timer_count_);
+    task_util::WaitForIdle();
+    EXPECT_FALSE(timer->running());
+    EXPECT_TRUE(TimerManager::DeleteTimer(timer));
+}
+
+TEST_F(TimerWheelBackendTest, DeleteRunning) {
+    Timer *timer = TimerManager::CreateTimer(*evm_->io_service(), "Wheel-1");
+    timer->Start(20, TimerCb);
+    EXPECT_TRUE(TimerManager::DeleteTimer(timer));
+    usleep(50000);
+    task_util::WaitForIdle();
+    EXPECT_EQ(0, timer_count_);
+}
+
+int main(int argc, char *argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    LoggingInit();
+    return RUN_ALL_TESTS();
+}
@@ -2,6 +2,8 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <pthread.h>
+#include <boost/bind.hpp>
 #include "testing/gunit.h"
 #include "base/trace.h"
 
@@ -27,10 +29,230 @@ TEST_F(TraceTest, DISABLED_1MillionTraceWrite) {
         trace_buf->TraceWrite(ni);
     }
 }
+class TraceEntry {
+public:
+    TraceEntry(int writer, int index) : writer_(writer), index_(index) {
+    }
+    int writer_;
+    int index_;
+};
+
+class TraceReader {
+public:
+    void Read(TraceEntry *entry, bool more) {
+        entries_.push_back(std::make_pair(entry->writer_, entry->index_));
+        more_ = more;
+    }
+    std::vector<std::pair<int, int> > entries_;
+    bool more_;
+};
+
+static void ReadTraceBuffer(TraceBuffer<TraceEntry> *trace_buf,
+                            const std::string &context, int count,
+                            TraceReader *reader) {
+    reader->entries_.clear();
+    trace_buf->TraceRead(context, count,
+        boost::bind(&TraceReader::Read, reader, _1, _2));
+}
+
+TEST_F(TraceTest, ReadOrder) {
+    boost::shared_ptr<TraceBuffer<TraceEntry> > trace_buf(
+        Trace<TraceEntry>::GetInstance()->TraceBufAdd("ReadOrder", 8, true));
+    TraceReader reader;
+
+    ReadTraceBuffer(trace_buf.get(), "ctx", 0, &reader);
+    EXPECT_TRUE(reader.entries_.empty());
+
+    for (int i = 0; i < 20; i++) {
+        EXPECT_EQ((uint32_t) (i + 1),
+                  trace_buf->TraceWrite(new TraceEntry(0, i)));
+    }
+
+    // Only the last 8 entries are retained, oldest first.
+    ReadTraceBuffer(trace_buf.get(), "ctx", 0, &reader);
+    ASSERT_EQ(8U, reader.entries_.size());
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQ(12 + i, reader.entries_[i].second);
+    }
+    EXPECT_FALSE(reader.more_);
+    trace_buf->TraceReadDone("ctx");
+}
+
+TEST_F(TraceTest, BatchedRead) {
+    boost::shared_ptr<TraceBuffer<TraceEntry> > trace_buf(
+        Trace<TraceEntry>::GetInstance()->TraceBufAdd("BatchedRead", 16,
+                                                      true));
+    TraceReader reader;
+    for (int i = 0; i < 10; i++) {
+        trace_buf->TraceWrite(new TraceEntry(0, i));
+    }
+
+    ReadTraceBuffer(trace_buf.get(), "ctx", 4, &reader);
+    ASSERT_EQ(4U, reader.entries_.size());
+    EXPECT_EQ(0, reader.entries_[0].second);
+    EXPECT_TRUE(reader.more_);
+
+    // Entries written between reads are returned by the next batch.
+    trace_buf->TraceWrite(new TraceEntry(0, 10));
+    ReadTraceBuffer(trace_buf.get(), "ctx", 0, &reader);
+    ASSERT_EQ(7U, reader.entries_.size());
+    EXPECT_EQ(4, reader.entries_[0].second);
+    EXPECT_EQ(10, reader.entries_[6].second);
+
+    // Other contexts read from the oldest entry.
+    ReadTraceBuffer(trace_buf.get(), "other", 0, &reader);
+    EXPECT_EQ(11U, reader.entries_.size());
+
+    trace_buf->TraceReadDone("ctx");
+    trace_buf->TraceReadDone("other");
+    ReadTraceBuffer(trace_buf.get(), "ctx", 0, &reader);
+    EXPECT_EQ(11U, reader.entries_.size());
+    trace_buf->TraceReadDone("ctx");
+}
+
+// The configured size is split across the segments.
+TEST_F(TraceTest, SegmentSize) {
+    TraceBuffer<TraceEntry> trace_buf("SegmentSize", 1000, true);
+    EXPECT_LE(1U, trace_buf.SegmentCount());
+    EXPECT_GE(1000U / TraceBuffer<TraceEntry>::kMinSegmentSize,
+              trace_buf.SegmentCount());
+
+    TraceReader reader;
+    for (int i = 0; i < 5000; i++) {
+        trace_buf.TraceWrite(new TraceEntry(0, i));
+    }
+    ReadTraceBuffer(&trace_buf, "ctx", 0, &reader);
+    trace_buf.TraceReadDone("ctx");
+    EXPECT_GE(1000U, reader.entries_.size());
+    EXPECT_EQ(4999, reader.entries_.back().second);
+}
+
+// Buffer of size 0 has tracing disabled.
+TEST_F(TraceTest, ZeroSize) {
+    TraceBuffer<TraceEntry> trace_buf("ZeroSize", 0, true);
+    EXPECT_FALSE(trace_buf.IsTraceOn());
+    EXPECT_EQ(0U, trace_buf.SegmentCount());
+    EXPECT_EQ(0U, trace_buf.TraceWrite(new TraceEntry(0, 0)));
+
+    TraceReader reader;
+    ReadTraceBuffer(&trace_buf, "ctx", 0, &reader);
+    trace_buf.TraceReadDone("ctx");
+    EXPECT_TRUE(reader.entries_.empty());
+}
+
+static const int kWriterCount = 4;
+static const int kWriteCount = 100000;
+
+static void *TraceWriter(void *arg) {
+    std::pair<TraceBuffer<TraceEntry> *, int> *writer =
+        reinterpret_cast<std::pair<TraceBuffer<TraceEntry> *, int> *>(arg);
+    for (int i = 0; i < kWriteCount; i++) {
+        writer->first->TraceWrite(new TraceEntry(writer->second, i));
+    }
+    return NULL;
+}
+
+// Concurrent writers and readers. Entries from each writer are returned in
+// the order written.
+TEST_F(TraceTest, ConcurrentWrite) {
+    boost::shared_ptr<TraceBuffer<TraceEntry> > trace_buf(
+        Trace<TraceEntry>::GetInstance()->TraceBufAdd("ConcurrentWrite", 1000,
+                                                      true));
+    pthread_t threads[kWriterCount];
+    std::pair<TraceBuffer<TraceEntry> *, int> writers[kWriterCount];
+    for (int i = 0; i < kWriterCount; i++) {
+        writers[i] = std::make_pair(trace_buf.get(), i);
+        pthread_create(&threads[i], NULL, &TraceWriter, &writers[i]);
+    }
+
+    TraceReader reader;
+    for (int i = 0; i < 100; i++) {
+        ReadTraceBuffer(trace_buf.get(), "ctx", 0, &reader);
+        trace_buf->TraceReadDone("ctx");
+    }
+    for (int i = 0; i < kWriterCount; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // The writers fill the segments they are mapped to, and no more than
+    // the configured size is retained.
+    ReadTraceBuffer(trace_buf.get(), "ctx", 0, &reader);
+    trace_buf->TraceReadDone("ctx");
+    size_t segments = trace_buf->SegmentCount();
+    EXPECT_LE(reader.entries_.size(), 1000U);
+    EXPECT_GE(reader.entries_.size(),
+              std::min(segments, (size_t) kWriterCount) * (1000 / segments));
+
+    std::map<int, int> last;
+    for (size_t i = 0; i < reader.entries_.size(); i++) {
+        std::map<int, int>::iterator it =
+            last.find(reader.entries_[i].first);
+        if (it != last.end()) {
+            EXPECT_LT(it->second, reader.entries_[i].second);
+        }
+        last[reader.entries_[i].first] = reader.entries_[i].second;
+    }
+}
+class CountedEntry {
+public:
+    static const int kMagic = 0x7ace;
+    CountedEntry() : magic_(kMagic) { count_++; }
+    ~CountedEntry() { magic_ = 0; count_--; }
+    int magic_;
+    static tbb::atomic<int> count_;
+};
+tbb::atomic<int> CountedEntry::count_;
+
+class CountedReader {
+public:
+    CountedReader() : bad_(0) { }
+    void Read(CountedEntry *entry, bool more) {
+        if (entry->magic_ != CountedEntry::kMagic) {
+            bad_++;
+        }
+    }
+    int bad_;
+};
+
+static void *CountedWriter(void *arg) {
+    TraceBuffer<CountedEntry> *trace_buf =
+        reinterpret_cast<TraceBuffer<CountedEntry> *>(arg);
+    for (int i = 0; i < kWriteCount; i++) {
+        trace_buf->TraceWrite(new CountedEntry());
+    }
+    return NULL;
+}
+
+// Entries overwritten while a read is in progress are not freed under the
+// reader, and every entry is freed by the time the buffer is deleted.
+TEST_F(TraceTest, ReclaimDuringRead) {
+    CountedEntry::count_ = 0;
+    {
+        TraceBuffer<CountedEntry> trace_buf("Reclaim", 256, true);
+        pthread_t threads[kWriterCount];
+        for (int i = 0; i < kWriterCount; i++) {
+            pthread_create(&threads[i], NULL, &CountedWriter, &trace_buf);
+        }
+        CountedReader reader;
+        for (int i = 0; i < 100; i++) {
+            trace_buf.TraceRead("ctx", 0,
+                boost::bind(&CountedReader::Read, &reader, _1, _2));
+            trace_buf.TraceReadDone("ctx");
+        }
+        for (int i = 0; i < kWriterCount; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        EXPECT_EQ(0, reader.bad_);
+        EXPECT_GE(256, CountedEntry::count_);
+    }
+    EXPECT_EQ(0, CountedEntry::count_);
+}
 } // namespace
 
 template<> Trace<TraceStruct>
         *Trace<TraceStruct>::trace_ = NULL;
+template<> Trace<TraceEntry>
+        *Trace<TraceEntry>::trace_ = NULL;
 
 int main(int argc, char *argv[]) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -76,8 +76,7 @@ private:
 
 Timer::Timer(boost::asio::io_service &service, const std::string &name,
           int task_id, int task_instance, bool delete_on_completion)
-        : impl_(new TimerImpl(service)),
-          name_(name),
+        : name_(name),
           handler_(NULL),
           error_handler_(NULL),
           state_(Init),
@@ -88,6 +87,11 @@ Timer::Timer(boost::asio::io_service &service, const std::string &name,
           seq_no_(0),
           delete_on_completion_(delete_on_completion) {
     refcount_ = 0;
+    if (TimerManager::timer_wheel_enabled()) {
+        wheel_ = TimerManager::GetTimerWheel(service, task_id);
+    } else {
+        impl_.reset(new TimerImpl(service));
+    }
 }
 
 Timer::~Timer() {
@@ -114,6 +118,15 @@ bool Timer::Start(int time, Handler handler, ErrorHandler error_handler) {
     handler_ = handler;
     seq_no_++;
     error_handler_ = error_handler;
+
+    if (wheel_) {
+        SetState(Running);
+        wheel_->Schedule(&wheel_entry_, time,
+            boost::bind(&Timer::StartTimerTask, this, TimerPtr(this),
+                        time, seq_no_, boost::asio::placeholders::error));
+        return true;
+    }
+
     boost::system::error_code ec;
     impl_->expires_from_now(time, ec);
     if (ec) {
@@ -157,6 +170,12 @@ bool Timer::Cancel() {
         timer_task_ = NULL;
     }
 
+    // Release the wheel slot right away, the ASIO backend instead lets the
+    // pending wait expire.
+    if (wheel_) {
+        wheel_->Cancel(&wheel_entry_);
+    }
+
     SetState(Cancelled);
     return true;
 }
@@ -190,6 +209,8 @@ void Timer::StartTimerTask(TimerPtr reference, int time, uint32_t seq_no,
 // TimerManager class routines
 //
 TimerManager::TimerSet TimerManager::timer_ref_;
+TimerManager::TimerWheelMap TimerManager::timer_wheel_map_;
+int TimerManager::timer_wheel_tick_msec_;
 tbb::mutex TimerManager::mutex_;
 
 Timer *TimerManager::CreateTimer(
@@ -201,6 +222,39 @@ Timer *TimerManager::CreateTimer(
     return timer;
 }
 
+void TimerManager::EnableTimerWheel(int tick_msec) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    timer_wheel_tick_msec_ =
+        tick_msec > 0 ? tick_msec : TimerWheel::kDefaultTickMsec;
+}
+
+void TimerManager::DisableTimerWheel() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    timer_wheel_tick_msec_ = 0;
+}
+
+//
+// Find or create the timer wheel for <io_service, task-id>. Wheels are
+// owned by the timers using them and go away along with the last one.
+//
+boost::shared_ptr<TimerWheel> TimerManager::GetTimerWheel(
+        boost::asio::io_service &service, int task_id) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    TimerWheelKey key = std::make_pair(&service, task_id);
+    boost::shared_ptr<TimerWheel> wheel;
+
+    TimerWheelMap::iterator it = timer_wheel_map_.find(key);
+    if (it != timer_wheel_map_.end()) {
+        wheel = it->second.lock();
+        if (wheel && wheel->tick_msec() == timer_wheel_tick_msec_)
+            return wheel;
+    }
+
+    wheel.reset(new TimerWheel(service, timer_wheel_tick_msec_));
+    timer_wheel_map_[key] = wheel;
+    return wheel;
+}
+
 void TimerManager::AddTimer(Timer *timer) {
     tbb::mutex::scoped_lock lock(mutex_);
     timer_ref_.insert(TimerPtr(timer));
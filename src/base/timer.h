@@ -32,6 +32,14 @@
 //    Timer class will keep of reference from ASIO and Task. Timer will
 //    be deleted when both the references go away. (via intrusive pointer)
 //
+//  Backends:
+//  - By default every timer owns an ASIO timer.
+//  - When TimerManager::EnableTimerWheel() is called, timers created later
+//    are instead multiplexed onto a TimerWheel shared by all timers of the
+//    same <io_service, task-id>. Start/Cancel/Reschedule are then O(1) and
+//    a single ASIO timer drives all of them. Semantics of the Timer API are
+//    unchanged, except for timer resolution which is that of the wheel tick.
+//
 
 #ifndef TIMER_H_
 #define TIMER_H_
@@ -43,10 +51,14 @@
 #include <boost/intrusive_ptr.hpp>
 #include <boost/function.hpp>
 #include <boost/asio.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/system/error_code.hpp>
+#include <boost/weak_ptr.hpp>
+#include <map>
 #include <set>
 
 #include <base/task.h>
+#include <base/timer_wheel.h>
 
 class TimerImpl;
 
@@ -145,6 +157,8 @@ private:
     }
 
     std::auto_ptr<TimerImpl> impl_;
+    boost::shared_ptr<TimerWheel> wheel_;
+    TimerWheel::Entry wheel_entry_;
     std::string name_;
     Handler handler_;
     ErrorHandler error_handler_;
@@ -191,7 +205,15 @@ public:
                               bool delete_on_completion = false);
     static bool DeleteTimer(Timer *Timer);
 
+    // Use per <io_service, task-id> timer wheels with the given tick for
+    // all timers created after this call.
+    static void EnableTimerWheel(
+        int tick_msec = TimerWheel::kDefaultTickMsec);
+    static void DisableTimerWheel();
+    static bool timer_wheel_enabled() { return timer_wheel_tick_msec_ != 0; }
+
 private:
+    friend class Timer;
     friend class TimerTest;
 
     typedef boost::intrusive_ptr<Timer> TimerPtr;
@@ -202,10 +224,17 @@ private:
         }
     };
     typedef std::set<TimerPtr, TimerPtrCmp> TimerSet;
+    typedef std::pair<boost::asio::io_service *, int> TimerWheelKey;
+    typedef std::map<TimerWheelKey, boost::weak_ptr<TimerWheel> >
+        TimerWheelMap;
     static void AddTimer(Timer *Timer);
+    static boost::shared_ptr<TimerWheel> GetTimerWheel(
+        boost::asio::io_service &service, int task_id);
 
     static tbb::mutex mutex_;
     static TimerSet timer_ref_;
+    static TimerWheelMap timer_wheel_map_;
+    static int timer_wheel_tick_msec_;
 };
 
 #endif /* TIMER_H_ */
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "base/timer_wheel.h"
+
+#include <boost/asio/placeholders.hpp>
+#include <boost/bind.hpp>
+#include <climits>
+#include <vector>
+
+#include "base/timer_impl.h"
+
+TimerWheel::TimerWheel(boost::asio::io_service &io_service, int tick_msec)
+    : impl_(new TimerImpl(io_service)),
+      tick_msec_(tick_msec > 0 ? tick_msec : kDefaultTickMsec),
+      start_time_(ClockMonotonicUsec()),
+      current_tick_(0),
+      size_(0),
+      running_(false),
+      armed_tick_(0),
+      wakeups_(0) {
+}
+
+TimerWheel::~TimerWheel() {
+    boost::system::error_code ec;
+    impl_->cancel(ec);
+}
+
+uint64_t TimerWheel::NowUsec() const {
+    return ClockMonotonicUsec() - start_time_;
+}
+
+uint64_t TimerWheel::NowTick() const {
+    return NowUsec() / (tick_msec_ * 1000ULL);
+}
+
+size_t TimerWheel::size() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return size_;
+}
+
+//
+// Insert the entry in the lowest level that covers its expiry relative to
+// the current tick.
+//
+void TimerWheel::Insert(Entry *entry) {
+    uint64_t expiry = entry->expiry_;
+    uint64_t delta = expiry > current_tick_ ? expiry - current_tick_ : 0;
+
+    if (delta < kLevel0Size) {
+        slots_[expiry & (kLevel0Size - 1)].push_back(*entry);
+        return;
+    }
+
+    // Park expiries beyond the range of the wheel in the farthest slot.
+    if (delta >= kMaxDelta) {
+        expiry = current_tick_ + kMaxDelta - 1;
+    }
+
+    int base = kLevel0Size;
+    int shift = kLevel0Bits;
+    for (int level = 1; level < kLevels - 1; ++level) {
+        if (delta < (1ULL << (shift + kLevelNBits)))
+            break;
+        base += kLevelNSize;
+        shift += kLevelNBits;
+    }
+    slots_[base + ((expiry >> shift) & (kLevelNSize - 1))].push_back(*entry);
+}
+
+void TimerWheel::Remove(Entry *entry) {
+    entry->node_.unlink();
+    entry->scheduled_ = false;
+    size_--;
+}
+
+//
+// Move the entries of the current slot of the given level down to the
+// lower levels. Returns the index of the slot that was cascaded, such that
+// the caller proceeds to the next level when this level wraps around.
+//
+int TimerWheel::Cascade(int level) {
+    int shift = kLevel0Bits + (level - 1) * kLevelNBits;
+    int index = (current_tick_ >> shift) & (kLevelNSize - 1);
+
+    EntryList entries;
+    entries.splice(entries.end(),
+                   slots_[kLevel0Size + (level - 1) * kLevelNSize + index]);
+    while (!entries.empty()) {
+        Entry &entry = entries.front();
+        entries.pop_front();
+        Insert(&entry);
+    }
+    return index;
+}
+
+//
+// Process all ticks up to the given one, collecting expired entries.
+//
+void TimerWheel::Advance(uint64_t tick, EntryList *expired) {
+    while (current_tick_ < tick) {
+        current_tick_++;
+        int index = current_tick_ & (kLevel0Size - 1);
+        if (index == 0) {
+            for (int level = 1; level < kLevels; ++level) {
+                if (Cascade(level) != 0)
+                    break;
+            }
+        }
+        expired->splice(expired->end(), slots_[index]);
+    }
+}
+
+//
+// Find the first tick after the current one at which an entry expires or a
+// non-empty slot of an upper level is cascaded.
+//
+uint64_t TimerWheel::NextTick() const {
+    uint64_t next = current_tick_ + kMaxDelta;
+
+    uint64_t first = current_tick_ + 1;
+    for (int i = 0; i < kLevel0Size; ++i) {
+        uint64_t tick = first + i;
+        if (!slots_[tick & (kLevel0Size - 1)].empty()) {
+            next = tick;
+            break;
+        }
+    }
+
+    // Slot j of a level is cascaded when the tick crosses a multiple of
+    // the level's span with j as the level index.
+    int shift = kLevel0Bits;
+    for (int level = 1; level < kLevels; ++level) {
+        const EntryList *slots = &slots_[kLevel0Size +
+                                         (level - 1) * kLevelNSize];
+        uint64_t base = (current_tick_ >> shift) + 1;
+        for (int j = 0; j < kLevelNSize; ++j) {
+            if (slots[j].empty())
+                continue;
+            uint64_t index = base + ((j - base) & (kLevelNSize - 1));
+            uint64_t tick = index << shift;
+            if (tick < next)
+                next = tick;
+        }
+        shift += kLevelNBits;
+    }
+    return next;
+}
+
+void TimerWheel::Schedule(Entry *entry, int time, Callback callback) {
+    // Previous callback is destroyed after the lock is released, as it may
+    // hold the last reference to its owner.
+    Callback previous;
+
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (entry->scheduled_) {
+        Remove(entry);
+    }
+    previous.swap(entry->callback_);
+
+    // Resync with the clock when the wheel is idle.
+    if (size_ == 0) {
+        current_tick_ = NowTick();
+    }
+
+    uint64_t tick_usec = tick_msec_ * 1000ULL;
+    uint64_t expiry = (NowUsec() + time * 1000ULL + tick_usec - 1) / tick_usec;
+    if (expiry <= current_tick_) {
+        expiry = current_tick_ + 1;
+    }
+
+    entry->expiry_ = expiry;
+    entry->callback_ = callback;
+    entry->scheduled_ = true;
+    Insert(entry);
+    size_++;
+
+    if (!running_ || expiry < armed_tick_) {
+        StartTimer();
+    }
+}
+
+bool TimerWheel::Cancel(Entry *entry) {
+    Callback previous;
+
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (!entry->scheduled_) {
+        return false;
+    }
+    Remove(entry);
+    previous.swap(entry->callback_);
+    return true;
+}
+
+//
+// Arm the ASIO timer for the next tick that needs processing. Called with
+// mutex_ held. Re-arming a pending timer aborts its earlier wait.
+//
+void TimerWheel::StartTimer() {
+    uint64_t tick = NextTick();
+    uint64_t next = tick * tick_msec_ * 1000ULL;
+    uint64_t now = NowUsec();
+    uint64_t delay = next > now ? (next - now + 999) / 1000 : 0;
+    int time = delay > INT_MAX ? INT_MAX : delay;
+
+    boost::system::error_code ec;
+    impl_->expires_from_now(time, ec);
+    if (ec) {
+        running_ = false;
+        return;
+    }
+    running_ = true;
+    armed_tick_ = tick;
+    impl_->async_wait(boost::bind(&TimerWheel::TimerExpired, this,
+                                  shared_from_this(),
+                                  boost::asio::placeholders::error));
+}
+
+void TimerWheel::TimerExpired(boost::shared_ptr<TimerWheel> reference,
+                              const boost::system::error_code &ec) {
+    std::vector<Callback> callbacks;
+
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        // Wait aborted by a re-arm, the new wait is still pending.
+        if (ec == boost::asio::error::operation_aborted) {
+            return;
+        }
+        running_ = false;
+        wakeups_++;
+
+        EntryList expired;
+        Advance(NowTick(), &expired);
+        while (!expired.empty()) {
+            Entry &entry = expired.front();
+            expired.pop_front();
+            entry.scheduled_ = false;
+            size_--;
+            callbacks.push_back(Callback());
+            callbacks.back().swap(entry.callback_);
+        }
+
+        if (size_) {
+            StartTimer();
+        }
+    }
+
+    boost::system::error_code success;
+    for (std::vector<Callback>::iterator it = callbacks.begin();
+         it != callbacks.end(); ++it) {
+        (*it)(success);
+    }
+}
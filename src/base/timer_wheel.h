@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+//  Hierarchical timing wheel used to multiplex a large number of timers
+//  onto a single ASIO timer.
+//
+//  The wheel has 4 levels. Level 0 has 256 slots of one tick each. Each of
+//  the next 3 levels has 64 slots, every slot spanning all of the slots of
+//  the level below it. An entry is inserted in the lowest level that covers
+//  its expiry and is cascaded down when the lower levels wrap around.
+//  Expiries beyond the range of the wheel are parked in the farthest slot
+//  of the last level and cascaded again until they come in range.
+//
+//  Schedule() and Cancel() are O(1). The underlying ASIO timer runs only
+//  while there are entries in the wheel, and is armed for the next tick
+//  that has an entry to expire or a slot to cascade, so that a wheel
+//  holding only long timers does not wake up on every tick.
+//
+//  Callbacks are invoked from the ASIO thread without any wheel lock held,
+//  with the same semantics as the ASIO async_wait handler they replace.
+//  Rescheduling or cancelling an entry silently discards its callback.
+//
+
+#ifndef BASE_TIMER_WHEEL_H_
+#define BASE_TIMER_WHEEL_H_
+
+#include <tbb/mutex.h>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/function.hpp>
+#include <boost/intrusive/list.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/system/error_code.hpp>
+
+#include "base/util.h"
+
+class TimerImpl;
+
+class TimerWheel : public boost::enable_shared_from_this<TimerWheel> {
+public:
+    typedef boost::function<void(const boost::system::error_code &)>
+        Callback;
+
+    // Wheel linkage embedded in the object owning the timer, so that
+    // scheduling does not allocate.
+    class Entry {
+    public:
+        Entry() : expiry_(0), scheduled_(false) { }
+        bool scheduled() const { return scheduled_; }
+
+    private:
+        friend class TimerWheel;
+
+        boost::intrusive::list_member_hook<
+            boost::intrusive::link_mode<boost::intrusive::auto_unlink> > node_;
+        uint64_t expiry_;       // in ticks
+        Callback callback_;
+        bool scheduled_;
+
+        DISALLOW_COPY_AND_ASSIGN(Entry);
+    };
+
+    static const int kDefaultTickMsec = 1;
+
+    TimerWheel(boost::asio::io_service &io_service, int tick_msec);
+    ~TimerWheel();
+
+    // Schedule the entry to expire after time msec. An entry that is
+    // already scheduled is moved to its new expiry.
+    void Schedule(Entry *entry, int time, Callback callback);
+
+    // Remove the entry from the wheel. Returns false if it was not
+    // scheduled (e.g. already expired).
+    bool Cancel(Entry *entry);
+
+    size_t size() const;
+    int tick_msec() const { return tick_msec_; }
+
+private:
+    friend class TimerWheelTest;
+
+    typedef boost::intrusive::member_hook<Entry,
+        boost::intrusive::list_member_hook<
+            boost::intrusive::link_mode<boost::intrusive::auto_unlink> >,
+        &Entry::node_> EntryNode;
+    typedef boost::intrusive::list<Entry, EntryNode,
+        boost::intrusive::constant_time_size<false> > EntryList;
+
+    static const int kLevels = 4;
+    static const int kLevel0Bits = 8;
+    static const int kLevelNBits = 6;
+    static const int kLevel0Size = 1 << kLevel0Bits;
+    static const int kLevelNSize = 1 << kLevelNBits;
+    static const int kSlotCount = kLevel0Size + (kLevels - 1) * kLevelNSize;
+    static const uint64_t kMaxDelta =
+        1ULL << (kLevel0Bits + (kLevels - 1) * kLevelNBits);
+
+    uint64_t NowUsec() const;
+    uint64_t NowTick() const;
+    void Insert(Entry *entry);
+    void Remove(Entry *entry);
+    int Cascade(int level);
+    void Advance(uint64_t tick, EntryList *expired);
+    uint64_t NextTick() const;
+    void StartTimer();
+    void TimerExpired(boost::shared_ptr<TimerWheel> reference,
+                      const boost::system::error_code &ec);
+
+    mutable tbb::mutex mutex_;
+    boost::scoped_ptr<TimerImpl> impl_;
+    int tick_msec_;
+    uint64_t start_time_;       // monotonic usec corresponding to tick 0
+    uint64_t current_tick_;     // last tick processed
+    size_t size_;
+    bool running_;              // ASIO timer armed
+    uint64_t armed_tick_;       // tick the ASIO timer is armed for
+    uint64_t wakeups_;          // ASIO timer expiries processed
+    EntryList slots_[kSlotCount];
+
+    DISALLOW_COPY_AND_ASSIGN(TimerWheel);
+};
+
+#endif  // BASE_TIMER_WHEEL_H_
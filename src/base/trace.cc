@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "base/trace.h"
+
+// Shared by all TraceBuffer instantiations, such that a thread has the same
+// index in every buffer.
+size_t TraceThreadIndex() {
+    static tbb::atomic<size_t> next_index;
+    static __thread size_t index = 0;
+    if (index == 0) {
+        index = next_index.fetch_and_increment() + 1;
+    }
+    return index - 1;
+}
@@ -5,33 +5,86 @@
 #ifndef __TRACE_H__
 #define __TRACE_H__
 
+#include <tbb/atomic.h>
 #include <tbb/mutex.h>
+#include <tbb/spin_mutex.h>
+#include <tbb/task_scheduler_init.h>
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <stdexcept>
 #include <boost/function.hpp>
-#include <boost/ptr_container/ptr_circular_buffer.hpp>
 #include <boost/weak_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 #include "base/util.h"
 
+//
+// TraceBuffer keeps the most recent trace entries written from any thread.
+//
+// Writers never block. The configured size is split across a fixed set of
+// ring segments, one per hardware thread but none smaller than
+// kMinSegmentSize, so memory does not grow with the number of threads.
+// Each thread writes to the segment picked by its thread index, and threads
+// sharing a segment claim slots through an atomic write index. Every entry
+// is tagged with a sequence number from a buffer wide atomic counter, and
+// TraceRead merges the segments by sequence number, returning the retained
+// entries oldest first.
+//
+// Eviction is per segment: each segment keeps its own most recent entries.
+// The buffer as a whole retains about the configured number of entries, but
+// when some threads write more than others, entries of a busy segment are
+// evicted while older entries of a quieter segment are still retained.
+//
+// Entries are reclaimed with an epoch scheme. Each TraceRead takes a new
+// epoch and publishes it while it accesses entries. A writer tags the entry
+// it overwrites with the epoch current after the overwrite. The entry is
+// freed right away unless the active reader, if any, started at or before
+// that epoch and may have loaded it; then it is retired and freed by a later
+// write or at the end of the read.
+//
+// Read contexts remember the sequence number of the last entry returned,
+// such that subsequent batched reads of the same context resume from there.
+//
+// A buffer of size 0 has tracing disabled and drops every entry written.
+//
+
+// Index of the calling thread, assigned on first use.
+size_t TraceThreadIndex();
+
 template<typename TraceEntryT>
 class TraceBuffer {
 public:
+    static const size_t kMinSegmentSize = 128;
+
     TraceBuffer(const std::string& buf_name, size_t size, bool trace_enable) 
         : trace_buf_name_(buf_name), 
-          trace_buf_size_(size),
-          trace_buf_(trace_buf_size_),
-          write_index_(0),
-          read_index_(0),
-          wrap_(false),
-          seqno_(0) {
-        trace_enable_ = trace_enable;
+          trace_buf_size_(size) {
+        trace_enable_ = trace_enable && size != 0;
+        seqno_ = 0;
+        epoch_ = 0;
+        reader_epoch_ = 0;
+        retired_count_ = 0;
+
+        size_t count = std::min(
+            (size_t) tbb::task_scheduler_init::default_num_threads(),
+            size / kMinSegmentSize);
+        if (size && count == 0) {
+            count = 1;
+        }
+        for (size_t i = 0; i < count; i++) {
+            size_t segment_size = size / count + (i < size % count ? 1 : 0);
+            segments_.push_back(new Segment(segment_size));
+        }
     }
 
     ~TraceBuffer() {
         read_context_map_.clear();
-        trace_buf_.clear();
+        for (typename SegmentList::iterator it = segments_.begin();
+             it != segments_.end(); ++it) {
+            delete *it;
+        }
+        segments_.clear();
+        FreeRetired(true);
     }
 
     std::string Name() {
@@ -54,92 +107,78 @@ public:
         return trace_buf_size_; 
     }
 
-    uint32_t TraceWrite(TraceEntryT *trace_entry) {
-        tbb::mutex::scoped_lock lock(mutex_);
-       
-        // Add the trace
-        trace_buf_.push_back(trace_entry);
-
-        // Once the trace buffer is wrapped, increment the read index
-        if (wrap_) {
-            if (++read_index_ == trace_buf_size_) {
-                read_index_ = 0;
-            }
-        }
+    size_t SegmentCount() const {
+        return segments_.size();
+    }
 
-        // Increment the write_index_ and reset upon reaching trace_buf_size_
-        if (++write_index_ == trace_buf_size_) {
-            write_index_ = 0;
-            wrap_ = true;
+    uint32_t TraceWrite(TraceEntryT *trace_entry) {
+        if (segments_.empty()) {
+            delete trace_entry;
+            return 0;
         }
-        
-        // Trace messages could be read in batches instead of reading 
-        // the entire trace buffer in one shot. Therefore, trace messages
-        // could be added between subsequent read requests. If the 
-        // read_index_ [points to the oldest message in the trace buffer] 
-        // becomes same as the read index [points to the position in the 
-        // trace buffer from where the next trace message should be read] 
-        // stored in the read context, then there is no need to remember the
-        // read context. 
-        ReadContextMap::iterator it = read_context_map_.begin();
-        ReadContextMap::iterator next = it; 
-        for (int i = 0, cnt = read_context_map_.size(); i < cnt; 
-             i++, it = next) {
-            ++next;
-            if (*it->second.get() == read_index_) {
-                read_context_map_.erase(it); 
-            }
+        Segment *segment = segments_[TraceThreadIndex() % segments_.size()];
+        uint64_t seqno = seqno_.fetch_and_increment() + 1;
+
+        // Mark the slot as being updated while the entry is swapped, such
+        // that readers skip it.
+        Slot &slot = segment->slots_[segment->write_index_.fetch_and_increment()
+                                     % segment->slots_.size()];
+        slot.seqno_ = 0;
+        TraceEntryT *old_entry = slot.entry_.fetch_and_store(trace_entry);
+        slot.seqno_ = seqno;
+
+        // Free the overwritten entry unless the active reader may have
+        // loaded it. The swap above is a full fence, so a reader that
+        // publishes its epoch after the loads below sees the new entry.
+        uint64_t epoch = epoch_;
+        if (IsSafeToFree(epoch)) {
+            delete old_entry;
+        } else if (old_entry) {
+            Retire(epoch, old_entry);
         }
-
-        // Reset seqno_ if it reaches max value
-        if (++seqno_  > kMaxSeqno) {
-            seqno_ = kMinSeqno;
+        if (retired_count_ != 0) {
+            FreeRetired(false);
         }
 
-        return seqno_; 
+        // Reset seqno if it reaches max value
+        return (uint32_t) ((seqno - 1) % kMaxSeqno) + kMinSeqno;
     }
 
     void TraceRead(const std::string& context, const int count, 
             boost::function<void (TraceEntryT *, bool)> cb) {
         tbb::mutex::scoped_lock lock(mutex_);
-        if (trace_buf_.empty()) {
+        ReadEpochGuard guard(this);
+
+        // If the read context is present, resume after the last entry read
+        ReadContextMap::iterator context_it = 
+            read_context_map_.find(context);
+        uint64_t last_seqno = 0;
+        if (context_it != read_context_map_.end()) {
+            last_seqno = *context_it->second;
+        }
+
+        std::vector<SlotSnapshot> entries;
+        Snapshot(last_seqno, &entries);
+        if (entries.empty()) {
             // No message in the trace buffer
             return;
         }
 
-        // if count = 0, then set the cnt equal to the size of trace_buf_
-        int cnt = count ? count : trace_buf_.size();
+        // if count = 0, then read all the entries
+        size_t cnt = count ? std::min((size_t) count, entries.size()) :
+            entries.size();
+        for (size_t i = 0; i < cnt; i++) {
+            cb(entries[i].second, i + 1 != entries.size());
+        }
 
-        int *read_index_ptr;
-        typename ContainerType::iterator it;
-        ReadContextMap::iterator context_it = 
-            read_context_map_.find(context);
+        // Update the last sequence number read in the read context
         if (context_it != read_context_map_.end()) {
-            // If the read context is present, manipulate the position
-            // from where we wanna start
-            read_index_ptr = context_it->second.get();
-            int offset = *read_index_ptr - read_index_;
-            offset = offset > 0 ? offset : trace_buf_size_ + offset; 
-            it = trace_buf_.begin() + offset;
+            *context_it->second = entries[cnt - 1].first;
         } else {
-            // Create read context
-            boost::shared_ptr<int> read_context(new int(read_index_));
-            read_index_ptr = read_context.get();
+            boost::shared_ptr<uint64_t> read_context(
+                new uint64_t(entries[cnt - 1].first));
             read_context_map_.insert(std::make_pair(context, read_context));
-            it = trace_buf_.begin();
         }
-
-        int i;
-        typename ContainerType::iterator next = it;
-        for (i = 0; (it != trace_buf_.end()) && (i < cnt); i++, it = next) {
-            ++next;
-            cb(&(*it), next != trace_buf_.end());
-        }
-
-        // Update the read index in the read context
-        int offset = *read_index_ptr + i;
-        *read_index_ptr = offset >= trace_buf_size_ ? 
-            offset - trace_buf_size_ : offset;
     }
 
     void TraceReadDone(const std::string& context) {
@@ -152,30 +191,131 @@ public:
     }
 
 private:
-    typedef boost::ptr_circular_buffer<TraceEntryT> ContainerType;
-    typedef std::map<const std::string, boost::shared_ptr<int> > 
+    struct Slot {
+        Slot() {
+            entry_ = NULL;
+            seqno_ = 0;
+        }
+        tbb::atomic<TraceEntryT *> entry_;
+        tbb::atomic<uint64_t> seqno_;     // 0 while being updated
+    };
+
+    // Ring of trace entries, shared by the threads mapped to it.
+    struct Segment {
+        explicit Segment(size_t size) : slots_(size) {
+            write_index_ = 0;
+        }
+        ~Segment() {
+            for (size_t i = 0; i < slots_.size(); i++) {
+                delete slots_[i].entry_;
+            }
+        }
+
+        std::vector<Slot> slots_;
+        tbb::atomic<size_t> write_index_;
+    };
+
+    // Publishes a new epoch for the duration of a TraceRead. Readers are
+    // serialized, so there is at most one reader epoch at a time.
+    class ReadEpochGuard {
+    public:
+        explicit ReadEpochGuard(TraceBuffer *buffer) : buffer_(buffer) {
+            uint64_t epoch = buffer_->epoch_.fetch_and_increment() + 1;
+            buffer_->reader_epoch_.fetch_and_store(epoch);
+        }
+        ~ReadEpochGuard() {
+            buffer_->reader_epoch_.fetch_and_store(0);
+            buffer_->FreeRetired(true);
+        }
+    private:
+        TraceBuffer *buffer_;
+    };
+
+    typedef std::pair<uint64_t, TraceEntryT *> RetiredEntry;
+
+    typedef std::pair<uint64_t, TraceEntryT *> SlotSnapshot;
+    typedef std::vector<Segment *> SegmentList;
+    typedef std::map<const std::string, boost::shared_ptr<uint64_t> > 
         ReadContextMap;
 
+    struct SlotSnapshotCmp {
+        bool operator()(const SlotSnapshot &lhs,
+                        const SlotSnapshot &rhs) const {
+            return lhs.first < rhs.first;
+        }
+    };
+
+    // Collect the entries newer than seqno from all segments, sorted by
+    // sequence number.
+    void Snapshot(uint64_t seqno, std::vector<SlotSnapshot> *entries) {
+        for (typename SegmentList::iterator it = segments_.begin();
+             it != segments_.end(); ++it) {
+            std::vector<Slot> &slots = (*it)->slots_;
+            for (size_t i = 0; i < slots.size(); i++) {
+                uint64_t slot_seqno = slots[i].seqno_;
+                TraceEntryT *entry = slots[i].entry_;
+                if (slot_seqno <= seqno || slot_seqno != slots[i].seqno_)
+                    continue;
+                entries->push_back(std::make_pair(slot_seqno, entry));
+            }
+        }
+
+        std::sort(entries->begin(), entries->end(), SlotSnapshotCmp());
+    }
+
+    // An entry overwritten at the given epoch may be freed unless
+    // a reader that started at or before that epoch is still active.
+    bool IsSafeToFree(uint64_t epoch) const {
+        uint64_t reader_epoch = reader_epoch_;
+        return reader_epoch == 0 || reader_epoch > epoch;
+    }
+
+    void Retire(uint64_t epoch, TraceEntryT *entry) {
+        tbb::spin_mutex::scoped_lock lock(retired_mutex_);
+        retired_.push_back(std::make_pair(epoch, entry));
+        retired_count_ = retired_.size();
+    }
+
+    // Free the retired entries that no reader can access. A reader that
+    // starts after an entry was retired gets a later epoch. At the end of a
+    // read (no_reader), every retired entry may be freed.
+    void FreeRetired(bool no_reader) {
+        tbb::spin_mutex::scoped_lock lock(retired_mutex_);
+        size_t kept = 0;
+        for (size_t i = 0; i < retired_.size(); i++) {
+            if (no_reader || IsSafeToFree(retired_[i].first)) {
+                delete retired_[i].second;
+            } else {
+                retired_[kept++] = retired_[i];
+            }
+        }
+        retired_.resize(kept);
+        retired_count_ = kept;
+    }
+
     std::string trace_buf_name_;
-    int trace_buf_size_;
-    ContainerType trace_buf_;
+    size_t trace_buf_size_;
     tbb::atomic<bool> trace_enable_;
-    int write_index_; // points to the position in the trace buffer, 
-                      // where the next trace message would be added
-    int read_index_; // points to the position of the oldest 
-                     // trace message in the trace buffer
-    bool wrap_; // indicates if the trace buffer is wrapped
+    tbb::atomic<uint64_t> seqno_;
+    tbb::atomic<uint64_t> epoch_;
+    tbb::atomic<uint64_t> reader_epoch_; // epoch of active TraceRead, or 0
+    tbb::spin_mutex retired_mutex_;
+    tbb::atomic<size_t> retired_count_;
+    std::vector<RetiredEntry> retired_;  // entries a reader may access
+    SegmentList segments_;        // fixed at construction
     ReadContextMap read_context_map_; // stores the read context  
-    uint32_t seqno_;
-    tbb::mutex mutex_;
+    tbb::mutex mutex_;          // serializes readers
     
     // Reserve 0 and max(uint32_t)
-    static const uint32_t kMaxSeqno = ((2 ^ 32) - 1) - 1;
+    static const uint32_t kMaxSeqno = 0xFFFFFFFF - 1;
     static const uint32_t kMinSeqno = 1;
 
     DISALLOW_COPY_AND_ASSIGN(TraceBuffer);
 };
 
+template<typename TraceEntryT>
+const size_t TraceBuffer<TraceEntryT>::kMinSegmentSize;
+
 template<typename TraceEntryT>
 class TraceBufferDeleter {
 public:
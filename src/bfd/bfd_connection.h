@@ -5,15 +5,31 @@
 #ifndef SRC_BFD_BFD_CONNECTION_H_
 #define SRC_BFD_BFD_CONNECTION_H_
 
+#include "bfd/bfd_control_packet.h"
+
+#include <utility>
+#include <vector>
 #include <boost/asio/ip/address.hpp>
 
 namespace BFD {
-class ControlPacket;
 
 class Connection {
  public:
+    typedef std::vector<std::pair<boost::asio::ip::address, ControlPacket> >
+        PacketBatch;
+
     virtual void SendPacket(const boost::asio::ip::address &dstAddr,
                             const ControlPacket *packet) = 0;
+
+    // Send the packets of all the sessions that are due at once.
+    // Connections that are able to amortize the cost of a send across
+    // packets should override it.
+    virtual void SendPackets(const PacketBatch &batch) {
+        for (PacketBatch::const_iterator it = batch.begin();
+             it != batch.end(); ++it) {
+            SendPacket(it->first, &it->second);
+        }
+    }
     virtual ~Connection() {}
 };
 
@@ -6,6 +6,7 @@
 #define SRC_BFD_BFD_CONTROL_PACKET_H_
 
 #include <string>
+#include <vector>
 #include <boost/asio/ip/address.hpp>
 #include <base/parse_object.h>
 
@@ -51,6 +52,8 @@ struct ControlPacket : public ParseObject {
     boost::asio::ip::address sender_host;
 };
 
+typedef std::vector<const ControlPacket *> ControlPacketList;
+
 ControlPacket* ParseControlPacket(const uint8_t *data, size_t size);
 int EncodeControlPacket(const ControlPacket *msg, uint8_t *data, size_t size);
 
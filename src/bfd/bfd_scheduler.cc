@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "bfd/bfd_scheduler.h"
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+
+#include "io/event_manager.h"
+
+namespace BFD {
+
+SessionScheduler::SessionScheduler(EventManager *evm, RunCallback callback)
+    : evm_(evm),
+      wheel_(boost::make_shared<TimerWheel>(*evm->io_service(),
+                                            TimerWheel::kDefaultTickMsec)),
+      run_posted_(false),
+      callback_(callback) {
+}
+
+SessionScheduler::~SessionScheduler() {
+}
+
+void SessionScheduler::Shutdown() {
+    tbb::mutex::scoped_lock lock(callback_mutex_);
+    callback_ = NULL;
+}
+
+void SessionScheduler::ScheduleTransmit(TimerWheel::Entry *entry,
+                                        Discriminator discriminator,
+                                        const TimeInterval &interval) {
+    Schedule(entry, discriminator, kTransmit, interval);
+}
+
+void SessionScheduler::ScheduleDetectionTimeout(TimerWheel::Entry *entry,
+                                                Discriminator discriminator,
+                                                const TimeInterval &interval) {
+    Schedule(entry, discriminator, kDetectionTimeout, interval);
+}
+
+void SessionScheduler::Schedule(TimerWheel::Entry *entry,
+                                Discriminator discriminator, Event event,
+                                const TimeInterval &interval) {
+    wheel_->Schedule(entry, interval.total_milliseconds(),
+        boost::bind(&SessionScheduler::Expired, shared_from_this(),
+                    discriminator, event, _1));
+}
+
+void SessionScheduler::Cancel(TimerWheel::Entry *entry) {
+    wheel_->Cancel(entry);
+}
+
+//
+// Called from the timer wheel for every entry that expires. The first entry
+// of a tick posts Run(), which executes after the wheel is done with the
+// whole tick and thus picks up all the sessions due in it.
+//
+void SessionScheduler::Expired(Discriminator discriminator, Event event,
+                               const boost::system::error_code &ec) {
+    if (ec) {
+        return;
+    }
+
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (event == kTransmit) {
+        transmit_.push_back(discriminator);
+    } else {
+        expired_.push_back(discriminator);
+    }
+    if (!run_posted_) {
+        run_posted_ = true;
+        evm_->io_service()->post(
+            boost::bind(&SessionScheduler::Run, shared_from_this()));
+    }
+}
+
+void SessionScheduler::Run() {
+    DiscriminatorList transmit, expired;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        run_posted_ = false;
+        transmit.swap(transmit_);
+        expired.swap(expired_);
+    }
+
+    tbb::mutex::scoped_lock lock(callback_mutex_);
+    if (!callback_.empty()) {
+        callback_(transmit, expired);
+    }
+}
+
+}  // namespace BFD
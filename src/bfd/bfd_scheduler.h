@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef SRC_BFD_BFD_SCHEDULER_H_
+#define SRC_BFD_BFD_SCHEDULER_H_
+
+#include "bfd/bfd_common.h"
+
+#include <tbb/mutex.h>
+
+#include <vector>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "base/timer_wheel.h"
+
+class EventManager;
+
+namespace BFD {
+
+// Drives the periodic transmissions and the detection timeouts of all the
+// sessions of a Server from a single timer wheel, instead of a pair of ASIO
+// timers per session.
+//
+// Sessions that become due within the same wheel tick are collected and
+// handed over to the Server in one batch, such that their packets are built
+// and sent in a single pass. Sessions are identified by their local
+// discriminator, so that a batch never refers to a session that was deleted
+// after it was scheduled.
+class SessionScheduler :
+    public boost::enable_shared_from_this<SessionScheduler> {
+ public:
+    typedef std::vector<Discriminator> DiscriminatorList;
+    typedef boost::function<void(const DiscriminatorList &transmit,
+                                 const DiscriminatorList &expired)>
+        RunCallback;
+
+    SessionScheduler(EventManager *evm, RunCallback callback);
+    ~SessionScheduler();
+
+    void ScheduleTransmit(TimerWheel::Entry *entry,
+                          Discriminator discriminator,
+                          const TimeInterval &interval);
+    void ScheduleDetectionTimeout(TimerWheel::Entry *entry,
+                                  Discriminator discriminator,
+                                  const TimeInterval &interval);
+    void Cancel(TimerWheel::Entry *entry);
+
+    // Stop invoking the callback. Waits for a batch that is being
+    // processed to complete.
+    void Shutdown();
+
+ private:
+    enum Event {
+        kTransmit,
+        kDetectionTimeout,
+    };
+
+    void Schedule(TimerWheel::Entry *entry, Discriminator discriminator,
+                  Event event, const TimeInterval &interval);
+    void Expired(Discriminator discriminator, Event event,
+                 const boost::system::error_code &ec);
+    void Run();
+
+    EventManager *evm_;
+    boost::shared_ptr<TimerWheel> wheel_;
+
+    tbb::mutex mutex_;
+    DiscriminatorList transmit_;
+    DiscriminatorList expired_;
+    bool run_posted_;
+
+    tbb::mutex callback_mutex_;
+    RunCallback callback_;
+};
+
+}  // namespace BFD
+
+#endif  // SRC_BFD_BFD_SCHEDULER_H_
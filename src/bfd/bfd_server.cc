@@ -9,6 +9,7 @@
 #include "bfd/bfd_state_machine.h"
 #include "bfd/bfd_common.h"
 
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 
 #include "base/logging.h"
@@ -16,6 +17,18 @@
 
 namespace BFD {
 
+Server::Server(EventManager *evm, Connection *communicator) :
+        evm_(evm),
+        communicator_(communicator),
+        scheduler_(new SessionScheduler(evm,
+            boost::bind(&Server::RunScheduledSessions, this, _1, _2))),
+        session_manager_(evm, scheduler_.get()) {
+}
+
+Server::~Server() {
+    scheduler_->Shutdown();
+}
+
 Session* Server::GetSession(const ControlPacket *packet) {
     if (packet->receiver_discriminator)
         return session_manager_.SessionByDiscriminator(
@@ -31,7 +44,22 @@ Session *Server::SessionByAddress(const boost::asio::ip::address &address) {
 
 ResultCode Server::ProcessControlPacket(const ControlPacket *packet) {
     tbb::mutex::scoped_lock lock(mutex_);
+    return ProcessControlPacketLocked(packet);
+}
 
+size_t Server::ProcessControlPackets(const ControlPacketList &packets) {
+    tbb::mutex::scoped_lock lock(mutex_);
+
+    size_t processed = 0;
+    for (ControlPacketList::const_iterator it = packets.begin();
+         it != packets.end(); ++it) {
+        if (ProcessControlPacketLocked(*it) == kResultCode_Ok)
+            processed++;
+    }
+    return processed;
+}
+
+ResultCode Server::ProcessControlPacketLocked(const ControlPacket *packet) {
     ResultCode result;
     result = packet->Verify();
     if (result != kResultCode_Ok) {
@@ -56,6 +84,42 @@ ResultCode Server::ProcessControlPacket(const ControlPacket *packet) {
     return kResultCode_Ok;
 }
 
+//
+// Build the periodic packets of all the sessions that are due and send them
+// as one batch, after processing the detection timeouts. Sessions that were
+// removed after being scheduled are no longer found and are skipped.
+//
+void Server::RunScheduledSessions(
+        const SessionScheduler::DiscriminatorList &transmit,
+        const SessionScheduler::DiscriminatorList &expired) {
+    Connection::PacketBatch batch;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+
+        for (SessionScheduler::DiscriminatorList::const_iterator it =
+             expired.begin(); it != expired.end(); ++it) {
+            Session *session = session_manager_.SessionByDiscriminator(*it);
+            if (session)
+                session->DetectionTimeExpired();
+        }
+
+        batch.reserve(transmit.size());
+        for (SessionScheduler::DiscriminatorList::const_iterator it =
+             transmit.begin(); it != transmit.end(); ++it) {
+            Session *session = session_manager_.SessionByDiscriminator(*it);
+            if (session == NULL)
+                continue;
+            batch.push_back(std::make_pair(session->remote_host(),
+                                           ControlPacket()));
+            if (!session->PreparePeriodicPacket(&batch.back().second))
+                batch.pop_back();
+        }
+    }
+
+    if (!batch.empty())
+        communicator_->SendPackets(batch);
+}
+
 ResultCode Server::ConfigureSession(const boost::asio::ip::address &remoteHost,
                                      const SessionConfig &config,
                                      Discriminator *assignedDiscriminator) {
@@ -128,7 +192,7 @@ ResultCode Server::SessionManager::ConfigureSession(
 
     *assignedDiscriminator = GenerateUniqueDiscriminator();
     session = new Session(*assignedDiscriminator, remoteHost, evm_, config,
-                          communicator);
+                          communicator, scheduler_);
 
     by_discriminator_[*assignedDiscriminator] = session;
     by_address_[remoteHost] = session;
@@ -6,11 +6,15 @@
 #define SRC_BFD_BFD_SERVER_H_
 
 #include "bfd/bfd_common.h"
+#include "bfd/bfd_control_packet.h"
+#include "bfd/bfd_scheduler.h"
 
 #include <tbb/mutex.h>
 
 #include <map>
 #include <boost/asio/ip/address.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
 
 class EventManager;
 
@@ -21,15 +25,21 @@ class ControlPacket;
 class SessionConfig;
 
 // This class manages sessions with other BFD peers.
+//
+// All the sessions of a server are driven by a single SessionScheduler:
+// packets of the sessions due in the same tick are sent as one batch and
+// detection timeouts are processed in the same pass.
 class Server {
  public:
-    Server(EventManager *evm, Connection *communicator) :
-        evm_(evm),
-        communicator_(communicator),
-        session_manager_(evm) {}
+    Server(EventManager *evm, Connection *communicator);
+    ~Server();
 
     ResultCode ProcessControlPacket(const ControlPacket *packet);
 
+    // Process a burst of received packets under a single lock acquisition.
+    // Returns the number of packets that were processed successfully.
+    size_t ProcessControlPackets(const ControlPacketList &packets);
+
     // If a BFD session with specified [remoteHost] already exists, its
     // configuration is updated with [config], otherwise it gets created.
     // ! TODO implement configuration update
@@ -46,7 +56,8 @@ class Server {
  private:
     class SessionManager : boost::noncopyable {
      public:
-        explicit SessionManager(EventManager *evm) : evm_(evm) {}
+        SessionManager(EventManager *evm, SessionScheduler *scheduler)
+            : evm_(evm), scheduler_(scheduler) {}
         ~SessionManager();
 
         // see: Server::ConfigureSession
@@ -65,7 +76,8 @@ class Server {
         Session *SessionByAddress(const boost::asio::ip::address &address);
 
      private:
-        typedef std::map<Discriminator, Session*> DiscriminatorSessionMap;
+        typedef boost::unordered_map<Discriminator, Session*>
+                DiscriminatorSessionMap;
         typedef std::map<boost::asio::ip::address, Session*>
                 AddressSessionMap;
         typedef std::map<Session*, unsigned int> RefcountMap;
@@ -73,16 +85,22 @@ class Server {
         Discriminator GenerateUniqueDiscriminator();
 
         EventManager *evm_;
+        SessionScheduler *scheduler_;
         DiscriminatorSessionMap by_discriminator_;
         AddressSessionMap by_address_;
         RefcountMap refcounts_;
     };
 
     Session *GetSession(const ControlPacket *packet);
+    ResultCode ProcessControlPacketLocked(const ControlPacket *packet);
+    void RunScheduledSessions(
+        const SessionScheduler::DiscriminatorList &transmit,
+        const SessionScheduler::DiscriminatorList &expired);
 
     tbb::mutex mutex_;
     EventManager *evm_;
     Connection *communicator_;
+    boost::shared_ptr<SessionScheduler> scheduler_;
     SessionManager session_manager_;
 };
 
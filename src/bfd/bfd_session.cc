@@ -6,6 +6,7 @@
 #include "bfd/bfd_control_packet.h"
 #include "bfd/bfd_common.h"
 #include "bfd/bfd_connection.h"
+#include "bfd/bfd_scheduler.h"
 
 #include <tbb/mutex.h>
 #include <boost/asio.hpp>
@@ -20,12 +21,16 @@ namespace BFD {
 Session::Session(Discriminator localDiscriminator,
         boost::asio::ip::address remoteHost,
         EventManager *evm,
-        const SessionConfig &config, Connection *communicator) :
+        const SessionConfig &config, Connection *communicator,
+        SessionScheduler *scheduler) :
         localDiscriminator_(localDiscriminator),
         remoteHost_(remoteHost),
-        sendTimer_(TimerManager::CreateTimer(*evm->io_service(),
+        scheduler_(scheduler),
+        sendTimer_(scheduler ? NULL :
+                   TimerManager::CreateTimer(*evm->io_service(),
                                              "BFD TX timer")),
-        recvTimer_(TimerManager::CreateTimer(*evm->io_service(),
+        recvTimer_(scheduler ? NULL :
+                   TimerManager::CreateTimer(*evm->io_service(),
                                              "BFD RX timeout")),
         currentConfig_(config),
         nextConfig_(config),
@@ -64,6 +69,22 @@ bool Session::RecvTimerExpired() {
     return false;
 }
 
+bool Session::PreparePeriodicPacket(ControlPacket *packet) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (stopped_)
+        return false;
+
+    PreparePacket(nextConfig_, packet);
+    ScheduleSendTimer();
+    return true;
+}
+
+void Session::DetectionTimeExpired() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (!stopped_)
+        sm_->ProcessTimeout();
+}
+
 std::string Session::toString() const {
     tbb::mutex::scoped_lock lock(mutex_);
 
@@ -85,6 +106,10 @@ void Session::ScheduleSendTimer() {
     TimeInterval ti = tx_interval();
     LOG(DEBUG, __func__ << " " << ti);
 
+    if (scheduler_) {
+        scheduler_->ScheduleTransmit(&sendEntry_, localDiscriminator_, ti);
+        return;
+    }
     sendTimer_->Start(ti.total_milliseconds(),
                       boost::bind(&Session::SendTimerExpired, this));
 }
@@ -93,6 +118,11 @@ void Session::ScheduleRecvDeadlineTimer() {
     TimeInterval ti = detection_time();
     LOG(DEBUG, __func__ << ti);
 
+    if (scheduler_) {
+        scheduler_->ScheduleDetectionTimeout(&recvEntry_, localDiscriminator_,
+                                             ti);
+        return;
+    }
     recvTimer_->Cancel();
     recvTimer_->Start(ti.total_milliseconds(),
                       boost::bind(&Session::RecvTimerExpired, this));
@@ -214,8 +244,13 @@ void Session::Stop() {
     tbb::mutex::scoped_lock lock(mutex_);
 
     if (stopped_ == false) {
-        TimerManager::DeleteTimer(sendTimer_);
-        TimerManager::DeleteTimer(recvTimer_);
+        if (scheduler_) {
+            scheduler_->Cancel(&sendEntry_);
+            scheduler_->Cancel(&recvEntry_);
+        } else {
+            TimerManager::DeleteTimer(sendTimer_);
+            TimerManager::DeleteTimer(recvTimer_);
+        }
         stopped_ = true;
         sm_->SetCallback(boost::optional<StateMachine::ChangeCb>());
     }
@@ -14,6 +14,7 @@
 #include <boost/asio/ip/address.hpp>
 
 #include "base/timer.h"
+#include "base/timer_wheel.h"
 #include "tbb/mutex.h"
 #include "io/event_manager.h"
 
@@ -21,6 +22,7 @@ namespace BFD {
 class Connection;
 class SessionConfig;
 class ControlPacket;
+class SessionScheduler;
 
 struct SessionConfig {
     TimeInterval desiredMinTxInterval;
@@ -42,17 +44,26 @@ struct BFDRemoteSessionState {
     BFDState state;
 };
 
+// Sessions created by a Server are driven by its SessionScheduler.
+// Without a scheduler, a session runs its own transmit and detection timers.
 class Session {
  public:
     Session(Discriminator localDiscriminator,
             boost::asio::ip::address remoteHost,
             EventManager *evm,
             const SessionConfig &config,
-            Connection *communicator);
+            Connection *communicator,
+            SessionScheduler *scheduler = NULL);
     ~Session();
 
     void Stop();
     ResultCode ProcessControlPacket(const ControlPacket *packet);
+
+    // Invoked by the SessionScheduler. PreparePeriodicPacket fills in the
+    // periodic packet to be sent in the current batch and schedules the
+    // next transmission. Returns false if the session is stopped.
+    bool PreparePeriodicPacket(ControlPacket *packet);
+    void DetectionTimeExpired();
     void InitPollSequence();
     void RegisterChangeCallback(ClientId client_id,
                                 StateMachine::ChangeCb cb);
@@ -90,8 +101,11 @@ class Session {
     mutable tbb::mutex       mutex_;
     Discriminator            localDiscriminator_;
     boost::asio::ip::address remoteHost_;
+    SessionScheduler         *scheduler_;
     Timer                    *sendTimer_;
     Timer                    *recvTimer_;
+    TimerWheel::Entry        sendEntry_;
+    TimerWheel::Entry        recvEntry_;
     SessionConfig            currentConfig_;
     SessionConfig            nextConfig_;
     BFDRemoteSessionState    remoteSession_;
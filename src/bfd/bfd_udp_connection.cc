@@ -7,8 +7,9 @@
 #include "bfd/bfd_control_packet.h"
 #include "bfd/bfd_common.h"
 
+#include <memory>
 #include <boost/asio.hpp>
-#include <boost/scoped_ptr.hpp>
+#include <boost/bind.hpp>
 #include <boost/random.hpp>
 
 #include "base/logging.h"
@@ -20,11 +21,41 @@ UDPConnectionManager::UDPRecvServer::UDPRecvServer(EventManager *evm,
     Initialize(recvPort);
 }
 
+UDPConnectionManager::UDPRecvServer::~UDPRecvServer() {
+    for (ControlPacketList::iterator it = pending_.begin();
+         it != pending_.end(); ++it) {
+        delete *it;
+    }
+}
+
 void UDPConnectionManager::UDPRecvServer::RegisterCallback(
                                     RecvCallback callback) {
     this->callback_ = callback;
 }
 
+void UDPConnectionManager::UDPRecvServer::RegisterBatchCallback(
+                                    RecvBatchCallback callback) {
+    this->batch_callback_ = callback;
+}
+
+// Hand over all the packets received since the first one of the burst got
+// queued. Runs from the io_service after the pending receive completions.
+void UDPConnectionManager::UDPRecvServer::ProcessPending(
+                                    UdpServerPtr reference) {
+    ControlPacketList packets;
+    {
+        tbb::mutex::scoped_lock lock(pending_mutex_);
+        packets.swap(pending_);
+    }
+
+    if (batch_callback_)
+        batch_callback_.get()(packets);
+    for (ControlPacketList::iterator it = packets.begin();
+         it != packets.end(); ++it) {
+        delete *it;
+    }
+}
+
 void UDPConnectionManager::UDPRecvServer::HandleReceive(
         boost::asio::const_buffer &recv_buffer,
         boost::asio::ip::udp::endpoint remote_endpoint,
@@ -37,17 +68,28 @@ void UDPConnectionManager::UDPRecvServer::HandleReceive(
         return;
     }
 
-    boost::scoped_ptr<ControlPacket> controlPacket(
+    std::auto_ptr<ControlPacket> controlPacket(
             ParseControlPacket(
                 boost::asio::buffer_cast<const uint8_t *>(recv_buffer),
                 bytes_transferred));
-    if (controlPacket == NULL) {
+    if (controlPacket.get() == NULL) {
         LOG(ERROR, __func__ <<  "Unable to parse packet");
-    } else {
-        controlPacket->sender_host = remote_endpoint.address();
-        if (callback_)
-            callback_.get()(controlPacket.get());
+        return;
+    }
+    controlPacket->sender_host = remote_endpoint.address();
+
+    if (batch_callback_) {
+        tbb::mutex::scoped_lock lock(pending_mutex_);
+        pending_.push_back(controlPacket.release());
+        if (pending_.size() == 1) {
+            event_manager()->io_service()->post(
+                boost::bind(&UDPRecvServer::ProcessPending, this,
+                            UdpServerPtr(this)));
+        }
+        return;
     }
+    if (callback_)
+        callback_.get()(controlPacket.get());
 }
 
 UDPConnectionManager::UDPCommunicator::UDPCommunicator(EventManager *evm,
@@ -107,6 +149,10 @@ void UDPConnectionManager::RegisterCallback(RecvCallback callback) {
     udpRecv_->RegisterCallback(callback);
 }
 
+void UDPConnectionManager::RegisterBatchCallback(RecvBatchCallback callback) {
+    udpRecv_->RegisterBatchCallback(callback);
+}
+
 UDPConnectionManager::~UDPConnectionManager() {
     udpRecv_->Shutdown();
     udpSend_->Shutdown();
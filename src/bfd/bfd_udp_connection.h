@@ -8,6 +8,7 @@
 #include "bfd/bfd_connection.h"
 
 #include <boost/optional.hpp>
+#include <tbb/mutex.h>
 
 #include "io/udp_server.h"
 
@@ -15,12 +16,19 @@ namespace BFD {
 class UDPConnectionManager : public Connection {
  public:
     typedef boost::function<void(const ControlPacket *)> RecvCallback;
+    typedef boost::function<void(const ControlPacketList &)>
+        RecvBatchCallback;
 
     UDPConnectionManager(EventManager *evm, int recvPort = kRecvPortDefault,
                          int remotePort = kRecvPortDefault);
     ~UDPConnectionManager();
 
     void RegisterCallback(RecvCallback callback);
+
+    // Packets received back to back are queued and handed over in a single
+    // call, e.g. to Server::ProcessControlPackets.
+    void RegisterBatchCallback(RecvBatchCallback callback);
+
     virtual void SendPacket(const boost::asio::ip::address &dstAddr,
                             const ControlPacket *packet);
 
@@ -31,10 +39,17 @@ class UDPConnectionManager : public Connection {
 
     class UDPRecvServer : public UdpServer {
         boost::optional<RecvCallback> callback_;
+        boost::optional<RecvBatchCallback> batch_callback_;
+        tbb::mutex pending_mutex_;
+        ControlPacketList pending_;
+
+        void ProcessPending(UdpServerPtr reference);
 
      public:
         UDPRecvServer(EventManager *evm, int recvPort);
+        ~UDPRecvServer();
         void RegisterCallback(RecvCallback callback);
+        void RegisterBatchCallback(RecvBatchCallback callback);
         void HandleReceive(boost::asio::const_buffer &recv_buffer,
                 boost::asio::ip::udp::endpoint remote_endpoint,
                 std::size_t bytes_transferred,
@@ -23,6 +23,7 @@ void SendResponse(HttpSession *session,
         boost::lexical_cast<std::string>(msg.length()) + "\r\n" "\r\n" + msg;
     session->Send((const u_int8_t *)(response.c_str()),
                   response.length(), NULL);
+    session->SendResponseDone();
 }
 
 void SendErrorResponse(HttpSession *session,
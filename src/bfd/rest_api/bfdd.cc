@@ -41,8 +41,8 @@ int main(int argc, char *argv[]) {
 
     Server bfd_server(&evm, &cm);
     RESTServer server(&bfd_server);
-    cm.RegisterCallback(boost::bind(&Server::ProcessControlPacket,
-                        &bfd_server, _1));
+    cm.RegisterBatchCallback(boost::bind(&Server::ProcessControlPackets,
+                             &bfd_server, _1));
 
     HttpServer *http(new HttpServer(&evm));
     http->RegisterHandler(HTTP_WILDCARD_ENTRY,
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "bfd/bfd_server.h"
+#include "bfd/bfd_session.h"
+#include "bfd/test/bfd_test_utils.h"
+
+#include <iostream>
+#include <boost/asio.hpp>
+#include <testing/gunit.h>
+
+#include "base/test/task_test_util.h"
+
+using namespace BFD;
+using std::cout;
+using std::endl;
+
+//
+// Loopback between two servers. Server A hosts 10.0.x.y and server B hosts
+// 10.1.x.y; a packet sent to 10.1.x.y shows up at B as coming from 10.0.x.y
+// and vice versa, such that every session has a distinct peer address.
+// Each batch is delivered to the peer in one call.
+//
+class LoopbackConnection : public Connection {
+ public:
+    LoopbackConnection(boost::asio::io_service *io_service, int side)
+        : io_service_(io_service), side_(side), peer_(NULL) {
+        packets_ = 0;
+    }
+
+    void set_peer(Server *peer) { peer_ = peer; }
+    uint64_t packets() const { return packets_; }
+
+    static boost::asio::ip::address Address(int side, int index) {
+        return boost::asio::ip::address_v4(
+            (10 << 24) | (side << 16) | (index + 1));
+    }
+
+    virtual void SendPacket(const boost::asio::ip::address &dstAddr,
+                            const ControlPacket *packet) {
+        PacketBatch batch;
+        batch.push_back(std::make_pair(dstAddr, *packet));
+        SendPackets(batch);
+    }
+
+    virtual void SendPackets(const PacketBatch &batch) {
+        ControlPacketList *packets = new ControlPacketList;
+        packets->reserve(batch.size());
+        for (PacketBatch::const_iterator it = batch.begin();
+             it != batch.end(); ++it) {
+            ControlPacket *packet = new ControlPacket(it->second);
+            packet->sender_host = Source(it->first);
+            packet->length = kMinimalPacketLength;
+            packets->push_back(packet);
+        }
+        packets_.fetch_and_add(batch.size());
+        io_service_->post(boost::bind(&LoopbackConnection::Deliver, peer_,
+                                      packets));
+    }
+
+ private:
+    boost::asio::ip::address Source(const boost::asio::ip::address &dst) {
+        return boost::asio::ip::address_v4(
+            (dst.to_v4().to_ulong() & ~0xFF0000UL) | (side_ << 16));
+    }
+
+    static void Deliver(Server *peer, ControlPacketList *packets) {
+        peer->ProcessControlPackets(*packets);
+        for (ControlPacketList::iterator it = packets->begin();
+             it != packets->end(); ++it) {
+            delete *it;
+        }
+        delete packets;
+    }
+
+    boost::asio::io_service *io_service_;
+    int side_;
+    Server *peer_;
+    tbb::atomic<uint64_t> packets_;
+};
+
+class ScaleTest : public ::testing::Test {
+ public:
+    void StateChange(const BFDState &state) {
+        if (state == kDown)
+            down_.fetch_and_increment();
+    }
+
+ protected:
+    ScaleTest() {
+        down_ = 0;
+        config_.desiredMinTxInterval = boost::posix_time::milliseconds(50);
+        config_.requiredMinRxInterval = boost::posix_time::milliseconds(50);
+        config_.detectionTimeMultiplier = 5;
+    }
+
+    int CountUp(Server *server, int side, int count) {
+        int up = 0;
+        for (int i = 0; i < count; ++i) {
+            Session *session = server->SessionByAddress(
+                LoopbackConnection::Address(side, i));
+            if (session && session->local_state() == kUp)
+                up++;
+        }
+        return up;
+    }
+
+    SessionConfig config_;
+    tbb::atomic<int> down_;
+};
+
+// Sessions per server, i.e. 10k sessions in total.
+static const int kSessions = 5000;
+static const int kRunSeconds = 10;
+
+// Bring up the sessions at a 50 msec interval and check that none of them
+// flaps while the loopback runs.
+TEST_F(ScaleTest, Loopback) {
+    EventManager em;
+    LoopbackConnection connA(em.io_service(), 0);
+    LoopbackConnection connB(em.io_service(), 1);
+    Server serverA(&em, &connA);
+    Server serverB(&em, &connB);
+    connA.set_peer(&serverB);
+    connB.set_peer(&serverA);
+
+    for (int i = 0; i < kSessions; ++i) {
+        Discriminator discriminator;
+        serverA.ConfigureSession(LoopbackConnection::Address(1, i), config_,
+                                 &discriminator);
+        serverB.ConfigureSession(LoopbackConnection::Address(0, i), config_,
+                                 &discriminator);
+    }
+
+    EventManagerThread t(&em);
+
+    TASK_UTIL_EXPECT_EQ_MSG(kSessions, CountUp(&serverA, 1, kSessions),
+                            "Sessions up");
+    TASK_UTIL_EXPECT_EQ_MSG(kSessions, CountUp(&serverB, 0, kSessions),
+                            "Sessions up");
+
+    for (int i = 0; i < kSessions; ++i) {
+        serverA.SessionByAddress(LoopbackConnection::Address(1, i))->
+            RegisterChangeCallback(0,
+                boost::bind(&ScaleTest::StateChange, this, _1));
+    }
+
+    uint64_t start = connA.packets() + connB.packets();
+    boost::this_thread::sleep(boost::posix_time::seconds(kRunSeconds));
+    uint64_t sent = connA.packets() + connB.packets() - start;
+
+    EXPECT_EQ(0, down_);
+    EXPECT_EQ(kSessions, CountUp(&serverA, 1, kSessions));
+    EXPECT_EQ(kSessions, CountUp(&serverB, 0, kSessions));
+
+    cout << 2 * kSessions << " sessions: " << sent / kRunSeconds
+         << " packets/sec" << endl;
+
+    em.Shutdown();
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -9,6 +9,7 @@
 #include <vector>
 #include <boost/intrusive_ptr.hpp>
 #include <tbb/atomic.h>
+#include <tbb/spin_mutex.h>
 
 #include "base/label_block.h"
 #include "base/parse_object.h"
@@ -530,6 +531,7 @@ public:
 
 private:
     friend class BgpAttrDB;
+    friend class BgpMessage;
     friend int intrusive_ptr_add_ref(const BgpAttr *cattrp);
     friend int intrusive_ptr_del_ref(const BgpAttr *cattrp);
     friend void intrusive_ptr_release(const BgpAttr *cattrp);
@@ -555,6 +557,11 @@ private:
     EdgeForwardingPtr edge_forwarding_;
     LabelBlockPtr label_block_;
     BgpOListPtr olist_;
+
+    // Path attributes in wire format, without and with the NEXT_HOP. These
+    // are filled in by BgpMessage the first time the BgpAttr is advertised.
+    mutable tbb::spin_mutex encode_mutex_;
+    mutable std::vector<uint8_t> encoded_attrs_[2];
 };
 
 inline int intrusive_ptr_add_ref(const BgpAttr *cattrp) {
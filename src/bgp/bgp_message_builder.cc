@@ -8,73 +8,84 @@
 #include "bgp/bgp_route.h"
 #include "net/bgp_af.h"
 
-BgpMessage::BgpMessage() {
+// Offsets of the fields in an UPDATE that has no withdrawn routes.
+static const size_t kMsgLengthOffset = 16;
+static const size_t kAttrLengthOffset = BgpProto::kMinMessageSize + 2;
+static const size_t kAttrOffset = kAttrLengthOffset + 2;
+
+BgpMessage::BgpMessage(size_t max_size)
+    : data_(new uint8_t[max_size]),
+      max_size_(max_size),
+      datalen_(0),
+      mp_nlri_offset_(0) {
 }
 
 BgpMessage::~BgpMessage() {
 }
 
-void BgpMessage::StartReach(const RibOutAttr *roattr, const BgpRoute *route) {
-    BgpProto::Update update;
-    const BgpAttr *attr = roattr->attr();
-
+//
+// Build the list of path attributes for the BgpAttr. The NEXT_HOP is only
+// included for inet routes, other families carry it in the MP_REACH_NLRI.
+//
+static void BuildPathAttributes(const BgpAttr *attr, bool nexthop,
+                                BgpAttrSpec *spec) {
     BgpAttrOrigin *origin = new BgpAttrOrigin(attr->origin());
-    update.path_attributes.push_back(origin);
+    spec->push_back(origin);
 
-    if ((route->Afi() == BgpAf::IPv4) && (route->Safi() == BgpAf::Unicast)) {
+    if (nexthop) {
         BgpAttrNextHop *nh = new BgpAttrNextHop(attr->nexthop().to_v4().to_ulong());
-        update.path_attributes.push_back(nh);
+        spec->push_back(nh);
     }
 
     if (attr->med()) {
         BgpAttrMultiExitDisc *med = new BgpAttrMultiExitDisc(attr->med());
-        update.path_attributes.push_back(med);
+        spec->push_back(med);
     }
 
     if (attr->local_pref()) {
         BgpAttrLocalPref *lp = new BgpAttrLocalPref(attr->local_pref());
-        update.path_attributes.push_back(lp);
+        spec->push_back(lp);
     }
 
     if (attr->atomic_aggregate()) {
         BgpAttrAtomicAggregate *aa = new BgpAttrAtomicAggregate;
-        update.path_attributes.push_back(aa);
+        spec->push_back(aa);
     }
 
     if (attr->aggregator_as_num()) {
         BgpAttrAggregator *agg = new BgpAttrAggregator(
                 attr->aggregator_as_num(),
                 attr->aggregator_adderess().to_v4().to_ulong());
-        update.path_attributes.push_back(agg);
+        spec->push_back(agg);
     }
 
     if (!attr->originator_id().is_unspecified()) {
         BgpAttrOriginatorId *originator_id =
             new BgpAttrOriginatorId(attr->originator_id().to_ulong());
-        update.path_attributes.push_back(originator_id);
+        spec->push_back(originator_id);
     }
 
     if (attr->as_path()) {
         AsPathSpec *path = new AsPathSpec(attr->as_path()->path());
-        update.path_attributes.push_back(path);
+        spec->push_back(path);
     }
 
     if (attr->edge_discovery()) {
         EdgeDiscoverySpec *edspec =
             new EdgeDiscoverySpec(attr->edge_discovery()->edge_discovery());
-        update.path_attributes.push_back(edspec);
+        spec->push_back(edspec);
     }
 
     if (attr->edge_forwarding()) {
         EdgeForwardingSpec *efspec =
             new EdgeForwardingSpec(attr->edge_forwarding()->edge_forwarding());
-        update.path_attributes.push_back(efspec);
+        spec->push_back(efspec);
     }
 
     if (attr->community() && attr->community()->communities().size()) {
         CommunitySpec *comm = new CommunitySpec;
         comm->communities = attr->community()->communities();
-        update.path_attributes.push_back(comm);
+        spec->push_back(comm);
     }
 
     if (attr->ext_community() && attr->ext_community()->communities().size()) {
@@ -86,112 +97,163 @@ void BgpMessage::StartReach(const RibOutAttr *roattr, const BgpRoute *route) {
             uint64_t value = get_value(it->data(), it->size());
             ext_comm->communities.push_back(value);
         }
-        update.path_attributes.push_back(ext_comm);
+        spec->push_back(ext_comm);
     }
 
     if (attr->pmsi_tunnel()) {
         PmsiTunnelSpec *pmsi_spec =
             new PmsiTunnelSpec(attr->pmsi_tunnel()->pmsi_tunnel());
-        update.path_attributes.push_back(pmsi_spec);
+        spec->push_back(pmsi_spec);
     }
+}
 
-    std::vector<uint8_t> nh;
-
-    route->BuildBgpProtoNextHop(nh, attr->nexthop());
-
-    BgpMpNlri *nlri =
-        new BgpMpNlri(BgpAttribute::MPReachNlri, route->Afi(), route->Safi(), nh);
-    update.path_attributes.push_back(nlri);
-
-    if (route) {
-        BgpProtoPrefix *prefix = new BgpProtoPrefix;
-        route->BuildProtoPrefix(prefix, attr, roattr->label());
-        nlri->nlri.push_back(prefix);
-        num_reach_route_++;
+//
+// Append the path attributes, other than the MP_REACH_NLRI, to the message.
+//
+// The encoding is cached in the BgpAttr since the same attributes are sent
+// to all peers in the RibOut and are typically shared by many routes. The
+// BgpAttr is shared by RibOuts that are processed in parallel, hence the
+// lock.
+//
+bool BgpMessage::AddPathAttributes(const BgpAttr *attr, bool nexthop) {
+    tbb::spin_mutex::scoped_lock lock(attr->encode_mutex_);
+    std::vector<uint8_t> &encoded = attr->encoded_attrs_[nexthop ? 1 : 0];
+    if (encoded.empty()) {
+        BgpProto::Update update;
+        BuildPathAttributes(attr, nexthop, &update.path_attributes);
+        std::vector<uint8_t> data(max_size_);
+        int result = BgpProto::Encode(&update, &data[0], data.size());
+        if (result <= 0)
+            return false;
+        encoded.assign(data.begin() + kAttrOffset, data.begin() + result);
     }
 
-    datalen_ = BgpProto::Encode(&update, data_, sizeof(data_),
-            &encode_offsets_);
-    assert(datalen_ > 0);
+    if (datalen_ + encoded.size() > max_size_)
+        return false;
+    memcpy(data_.get() + datalen_, &encoded[0], encoded.size());
+    datalen_ += encoded.size();
+    return true;
 }
 
-void BgpMessage::StartUnreach(const BgpRoute *route) {
-    BgpProto::Update update;
+//
+// Append the header of the MP_REACH_NLRI or MP_UNREACH_NLRI attribute. The
+// attribute always uses an extended length, which is filled in as prefixes
+// get added.
+//
+bool BgpMessage::StartMpNlri(uint8_t code, const BgpRoute *route) {
+    if (datalen_ + 7 > max_size_)
+        return false;
+    uint8_t *data = data_.get();
+    mp_nlri_offset_ = datalen_;
+    data[datalen_++] = BgpMpNlri::kFlags | BgpAttribute::ExtendedLength;
+    data[datalen_++] = code;
+    datalen_ += 2;
+    put_value(data + datalen_, 2, route->Afi());
+    datalen_ += 2;
+    data[datalen_++] = route->Safi();
+    return true;
+}
 
-    BgpMpNlri *nlri =
-        new BgpMpNlri(BgpAttribute::MPUnreachNlri, route->Afi(), route->Safi());
-    update.path_attributes.push_back(nlri);
+//
+// The Start routines fail if the first route does not fit in an empty
+// message i.e. its attributes exceed the maximum message size.
+//
+bool BgpMessage::StartReach(const RibOutAttr *roattr, const BgpRoute *route) {
+    const BgpAttr *attr = roattr->attr();
+    bool nexthop =
+        (route->Afi() == BgpAf::IPv4) && (route->Safi() == BgpAf::Unicast);
+    if (!AddPathAttributes(attr, nexthop))
+        return false;
+    if (!StartMpNlri(BgpAttribute::MPReachNlri, route))
+        return false;
 
-    if (route) {
-        BgpProtoPrefix *prefix = new BgpProtoPrefix;
-        route->BuildProtoPrefix(prefix);
-        nlri->nlri.push_back(prefix);
-        num_unreach_route_++;
-    }
+    std::vector<uint8_t> nh;
+    route->BuildBgpProtoNextHop(nh, attr->nexthop());
+    if (datalen_ + 1 + nh.size() + 1 > max_size_)
+        return false;
+    uint8_t *data = data_.get();
+    data[datalen_++] = nh.size();
+    if (!nh.empty())
+        memcpy(data + datalen_, &nh[0], nh.size());
+    datalen_ += nh.size();
+    data[datalen_++] = 0;
+
+    if (!AddPrefix(route, roattr))
+        return false;
+    num_reach_route_++;
+    return true;
+}
 
-    datalen_ = BgpProto::Encode(&update, data_, sizeof(data_),
-            &encode_offsets_);
-    assert(datalen_ > 0);
+bool BgpMessage::StartUnreach(const BgpRoute *route) {
+    if (!StartMpNlri(BgpAttribute::MPUnreachNlri, route))
+        return false;
+    if (!AddPrefix(route, NULL))
+        return false;
+    num_unreach_route_++;
+    return true;
 }
 
-void BgpMessage::Start(const RibOutAttr *roattr, const BgpRoute *route) {
+bool BgpMessage::Start(const RibOutAttr *roattr, const BgpRoute *route) {
+    uint8_t *data = data_.get();
+    memset(data, 0xff, kMsgLengthOffset);
+    data[BgpProto::kMinMessageSize - 1] = BgpProto::UPDATE;
+    put_value(data + BgpProto::kMinMessageSize, 2, 0);
+    datalen_ = kAttrOffset;
+
     if (roattr->IsReachable()) {
-        StartReach(roattr, route);
+        return StartReach(roattr, route);
     } else {
-        StartUnreach(route);
+        return StartUnreach(route);
     }
 }
 
-bool BgpMessage::UpdateLength(const char *tag, int size, int delta) {
-    int offset = encode_offsets_.FindOffset(tag);
-    if (offset < 0) {
+//
+// Append the prefix for the route to the MP_REACH_NLRI or MP_UNREACH_NLRI,
+// in the encoding used by BgpPathAttributeMpNlriChoice, and update all the
+// lengths that cover it.
+//
+bool BgpMessage::AddPrefix(const BgpRoute *route, const RibOutAttr *roattr) {
+    if (roattr && roattr->IsReachable()) {
+        route->BuildProtoPrefix(&prefix_, roattr->attr(), roattr->label());
+    } else {
+        route->BuildProtoPrefix(&prefix_);
+    }
+
+    bool typed = (route->Afi() == BgpAf::L2Vpn &&
+                  route->Safi() == BgpAf::EVpn) ||
+                 (route->Afi() == BgpAf::IPv4 &&
+                  route->Safi() == BgpAf::ErmVpn);
+    size_t size = (typed ? 2 : 1) + prefix_.prefix.size();
+    if (datalen_ + size > max_size_)
         return false;
+
+    uint8_t *data = data_.get() + datalen_;
+    if (typed) {
+        *data++ = prefix_.type;
+        *data++ = prefix_.prefixlen / 8;
+    } else {
+        *data++ = prefix_.prefixlen;
     }
-    int value = get_value(&data_[offset], size);
-    value += delta;
-    put_value(&data_[offset], size, value);
+    if (!prefix_.prefix.empty())
+        memcpy(data, &prefix_.prefix[0], prefix_.prefix.size());
+    datalen_ += size;
+
+    uint8_t *msg = data_.get();
+    put_value(msg + kMsgLengthOffset, 2, datalen_);
+    put_value(msg + kAttrLengthOffset, 2, datalen_ - kAttrOffset);
+    put_value(msg + mp_nlri_offset_ + 2, 2, datalen_ - mp_nlri_offset_ - 4);
     return true;
 }
 
 bool BgpMessage::AddRoute(const BgpRoute *route, const RibOutAttr *roattr) {
-    uint8_t *data = data_ + datalen_;
-    size_t size = sizeof(data_) - datalen_;
-
-    BgpMpNlri nlri;
-    nlri.afi = route->Afi();
-    nlri.safi = route->Safi();
-    BgpProtoPrefix *prefix = new BgpProtoPrefix;
-    if (roattr) {
-        route->BuildProtoPrefix(prefix, roattr->attr(), roattr->label());
-    } else {
-        route->BuildProtoPrefix(prefix);
-    }
-    nlri.nlri.push_back(prefix);
+    if (!AddPrefix(route, roattr))
+        return false;
+
     if (roattr->IsReachable()) {
         num_reach_route_++;
     } else {
         num_unreach_route_++;
     }
-
-    int result = BgpProto::Encode(&nlri, data, size);
-    if (result <= 0) return false;
-
-    datalen_ += result;
-    if (!UpdateLength("BgpMsgLength", 2, result)) {
-        assert(false);
-        return false;
-    }
-
-    if (!UpdateLength("BgpPathAttribute", 2, result)) {
-        assert(false);
-        return false;
-    }
-
-    if (!UpdateLength("MpReachUnreachNlri", 2, result)) {
-        assert(false);
-        return false;
-    }
-
     return true;
 }
 
@@ -200,21 +262,26 @@ void BgpMessage::Finish() {
 
 const uint8_t *BgpMessage::GetData(IPeerUpdate *ipeer_update, size_t *lenp) {
     *lenp = datalen_;
-    return data_;
+    return data_.get();
 }
 
 Message *BgpMessageBuilder::Create(const BgpTable *table,
         const RibOutAttr *roattr, const BgpRoute *route) const {
-    BgpMessage *msg = new BgpMessage();
-    msg->Start(roattr, route);
+    BgpMessage *msg = new BgpMessage(max_size_);
+    if (!msg->Start(roattr, route)) {
+        delete msg;
+        return NULL;
+    }
     return msg;
 }
 
 BgpMessageBuilder BgpMessageBuilder::instance_;
+BgpMessageBuilder BgpMessageBuilder::extended_instance_(
+    BgpProto::kMaxExtendedMessageSize);
 
-BgpMessageBuilder::BgpMessageBuilder() {
+BgpMessageBuilder::BgpMessageBuilder(size_t max_size) : max_size_(max_size) {
 }
 
-BgpMessageBuilder *BgpMessageBuilder::GetInstance() {
-    return &instance_;
+BgpMessageBuilder *BgpMessageBuilder::GetInstance(bool extended_message) {
+    return extended_message ? &extended_instance_ : &instance_;
 }
@@ -5,39 +5,48 @@
 #ifndef ctrlplane_bgp_message_builder_h
 #define ctrlplane_bgp_message_builder_h
 
+#include <boost/scoped_array.hpp>
+
 #include "bgp/bgp_proto.h"
 #include "bgp/message_builder.h"
 
 class BgpMessage : public Message {
 public:
-    BgpMessage();
+    explicit BgpMessage(size_t max_size = BgpProto::kMaxMessageSize);
     virtual ~BgpMessage();
-    void Start(const RibOutAttr *roattr, const BgpRoute *route);
+    bool Start(const RibOutAttr *roattr, const BgpRoute *route);
     virtual bool AddRoute(const BgpRoute *route, const RibOutAttr *roattr);
     virtual void Finish();
     virtual const uint8_t *GetData(IPeerUpdate *ipeer_update, size_t *lenp);
 
 private:
-    void StartReach(const RibOutAttr *roattr, const BgpRoute *route);
-    void StartUnreach(const BgpRoute *route);
-    bool UpdateLength(const char *tag, int size, int delta);
-
-    EncodeOffsets encode_offsets_;
-    uint8_t data_[BgpProto::kMaxMessageSize];
+    bool StartReach(const RibOutAttr *roattr, const BgpRoute *route);
+    bool StartUnreach(const BgpRoute *route);
+    bool StartMpNlri(uint8_t code, const BgpRoute *route);
+    bool AddPathAttributes(const BgpAttr *attr, bool nexthop);
+    bool AddPrefix(const BgpRoute *route, const RibOutAttr *roattr);
+
+    boost::scoped_array<uint8_t> data_;
+    size_t max_size_;
     size_t datalen_;
+    size_t mp_nlri_offset_;
+    BgpProtoPrefix prefix_;
     DISALLOW_COPY_AND_ASSIGN(BgpMessage);
 };
 
 class BgpMessageBuilder : public MessageBuilder {
 public:
-    BgpMessageBuilder();
+    explicit BgpMessageBuilder(size_t max_size = BgpProto::kMaxMessageSize);
     virtual Message *Create(const BgpTable *table,
                             const RibOutAttr *roattr,
                             const BgpRoute *route) const;
-    static BgpMessageBuilder *GetInstance();
+    static BgpMessageBuilder *GetInstance(bool extended_message = false);
 
 private:
     static BgpMessageBuilder instance_;
+    static BgpMessageBuilder extended_instance_;
+
+    size_t max_size_;
     DISALLOW_COPY_AND_ASSIGN(BgpMessageBuilder);
 };
 
@@ -58,7 +58,8 @@ McastForwarder::McastForwarder(McastSGEntry *sg_entry, ErmVpnRoute *route)
       label_(0),
       address_(0),
       rd_(route->GetPrefix().route_distinguisher()),
-      router_id_(route->GetPrefix().router_id()) {
+      router_id_(route->GetPrefix().router_id()),
+      tree_index_(kInvalidIndex) {
     const BgpPath *path = route->BestPath();
     const BgpAttr *attr = path->GetAttr();
 
@@ -374,6 +375,9 @@ McastSGEntry::McastSGEntry(McastManagerPartition *partition,
          level < McastTreeManager::LevelCount; ++level) {
         ForwarderSet *forwarders = new ForwarderSet;
         forwarder_sets_.push_back(forwarders);
+        tree_nodes_.push_back(McastForwarderList());
+        pending_sets_.push_back(ForwarderSet());
+        changed_sets_.push_back(ForwarderChangeSet());
         update_needed_.push_back(false);
     }
 }
@@ -394,11 +398,13 @@ std::string McastSGEntry::ToString() const {
 
 //
 // Add the given McastForwarder under this McastSGEntry and trigger update
-// of the distribution tree.
+// of the distribution tree.  The McastForwarder gets attached to the tree
+// when the McastSGEntry is processed from the WorkQueue.
 //
 void McastSGEntry::AddForwarder(McastForwarder *forwarder) {
     uint8_t level = forwarder->level();
     forwarder_sets_[level]->insert(forwarder);
+    pending_sets_[level].insert(forwarder);
     update_needed_[level] = true;
     partition_->EnqueueSGEntry(this);
 }
@@ -412,19 +418,25 @@ void McastSGEntry::AddForwarder(McastForwarder *forwarder) {
 //
 void McastSGEntry::ChangeForwarder(McastForwarder *forwarder) {
     uint8_t level = forwarder->level();
+    changed_sets_[level].insert(forwarder);
     update_needed_[level] = true;
     partition_->EnqueueSGEntry(this);
 }
 
 //
 // Delete the given McastForwarder from this McastSGEntry and trigger update
-// of the distribution tree.
+// of the distribution tree.  The McastForwarder is detached from the tree
+// right away since the caller is going to delete it.
 //
 void McastSGEntry::DeleteForwarder(McastForwarder *forwarder) {
     if (forwarder == forest_node_)
         forest_node_ = NULL;
     uint8_t level = forwarder->level();
     forwarder_sets_[level]->erase(forwarder);
+    pending_sets_[level].erase(forwarder);
+    if (forwarder->tree_index() != McastForwarder::kInvalidIndex)
+        DetachForwarder(forwarder);
+    changed_sets_[level].erase(forwarder);
     update_needed_[level] = true;
     partition_->EnqueueSGEntry(this);
 }
@@ -461,10 +473,10 @@ void McastSGEntry::AddLocalTreeRoute() {
 
     // Select the last leaf in the distribution tree as the forest node.
     uint8_t level = McastTreeManager::LevelNative;
-    ForwarderSet *forwarders = forwarder_sets_[level];
-    if (forwarders->rbegin() == forwarders->rend())
+    const McastForwarderList &tree_nodes = tree_nodes_[level];
+    if (tree_nodes.empty())
         return;
-    forest_node_ = *forwarders->rbegin();
+    forest_node_ = tree_nodes.back();
 
     // Construct the prefix and route key.
     BgpServer *server = partition_->server();
@@ -556,8 +568,13 @@ void McastSGEntry::UpdateLocalTreeRoute() {
 //
 void McastSGEntry::UpdateRoutes(uint8_t level) {
     if (level == McastTreeManager::LevelNative) {
+        // The previous forest node needs to get rid of the global tree edges
+        // in its BgpOList if it is no longer the forest node.
+        McastForwarder *forest_node = forest_node_;
         DeleteLocalTreeRoute();
         AddLocalTreeRoute();
+        if (forest_node && forest_node != forest_node_)
+            partition_->GetTablePartition()->Notify(forest_node->route());
     } else {
         ForwarderSet *forwarders = forwarder_sets_[level];
         for (ForwarderSet::iterator it = forwarders->begin();
@@ -588,70 +605,170 @@ bool McastSGEntry::IsTreeBuilder(uint8_t level) {
 }
 
 //
+// Get the degree of the k-ary distribution tree at the given level. Local
+// level McastForwarders need a spare link for the edge to the forest node.
+//
+int McastSGEntry::GetDegree(uint8_t level) const {
+    if (level == McastTreeManager::LevelNative) {
+        return McastTreeManager::kDegree;
+    } else {
+        return McastTreeManager::kDegree - 1;
+    }
+}
+
 //
-// Update specified distribution tree for the McastSGEntry.  We traverse all
-// McastForwarders in sorted order and arrange them in breadth first fashion
-// in a k-ary tree.  Building the tree in this manner guarantees that we get
-// the same tree for a given set of forwarders, independent of the order in
-// in which they joined. This predictability is deemed to be more important
-// than other criteria such as minimizing disruption of traffic, minimizing
-// the cost/weight of the tree etc.
+// Add links in both directions between the given McastForwarders and mark
+// them as changed.
 //
-void McastSGEntry::UpdateTree(uint8_t level) {
-    CHECK_CONCURRENCY("db::DBTable");
+void McastSGEntry::LinkForwarders(McastForwarder *parent,
+        McastForwarder *child) {
+    uint8_t level = parent->level();
+    parent->AddLink(child);
+    child->AddLink(parent);
+    changed_sets_[level].insert(parent);
+    changed_sets_[level].insert(child);
+}
 
-    if (!update_needed_[level])
+//
+// Remove links in both directions between the given McastForwarders and mark
+// them as changed.
+//
+void McastSGEntry::UnlinkForwarders(McastForwarder *parent,
+        McastForwarder *child) {
+    uint8_t level = parent->level();
+    parent->RemoveLink(child);
+    child->RemoveLink(parent);
+    changed_sets_[level].insert(parent);
+    changed_sets_[level].insert(child);
+}
+
+//
+// Attach the McastForwarder at the end of the distribution tree and link it
+// to its parent.
+//
+void McastSGEntry::AttachForwarder(McastForwarder *forwarder) {
+    uint8_t level = forwarder->level();
+    McastForwarderList &tree_nodes = tree_nodes_[level];
+    int idx = tree_nodes.size();
+    forwarder->set_tree_index(idx);
+    tree_nodes.push_back(forwarder);
+    changed_sets_[level].insert(forwarder);
+    if (idx == 0)
         return;
-    update_needed_[level] = false;
 
-    int degree;
-    if (level == McastTreeManager::LevelNative) {
-        degree = McastTreeManager::kDegree;
-    } else {
-        degree = McastTreeManager::kDegree - 1;
+    int parent_idx = (idx - 1) / GetDegree(level);
+    LinkForwarders(tree_nodes[parent_idx], forwarder);
+}
+
+//
+// Detach the McastForwarder from the distribution tree.
+//
+// The last McastForwarder in the tree is always a leaf. It's unlinked from
+// its parent and takes over the position and the links of the McastForwarder
+// that's being detached, if that isn't the last McastForwarder itself.
+//
+void McastSGEntry::DetachForwarder(McastForwarder *forwarder) {
+    uint8_t level = forwarder->level();
+    McastForwarderList &tree_nodes = tree_nodes_[level];
+    int idx = forwarder->tree_index();
+    assert(tree_nodes[idx] == forwarder);
+
+    int last_idx = tree_nodes.size() - 1;
+    McastForwarder *last = tree_nodes[last_idx];
+    if (last_idx > 0) {
+        int parent_idx = (last_idx - 1) / GetDegree(level);
+        UnlinkForwarders(tree_nodes[parent_idx], last);
+    }
+    tree_nodes.pop_back();
+
+    if (last != forwarder) {
+        McastForwarderList links = forwarder->tree_links();
+        for (McastForwarderList::iterator it = links.begin();
+             it != links.end(); ++it) {
+            UnlinkForwarders(*it, forwarder);
+            LinkForwarders(*it, last);
+        }
+        last->set_tree_index(idx);
+        tree_nodes[idx] = last;
     }
 
-    // First get rid of the previous distribution tree and enqueue all the
-    // associated ErmVpnRoutes for notification. Note that DBListeners will
-    // not get invoked until after this routine is done.
-    ForwarderSet *forwarders = forwarder_sets_[level];
-    for (ForwarderSet::iterator it = forwarders->begin();
-         it != forwarders->end(); ++it) {
-       (*it)->FlushLinks();
-       (*it)->ReleaseLabel();
-       partition_->GetTablePartition()->Notify((*it)->route());
+    forwarder->set_tree_index(McastForwarder::kInvalidIndex);
+}
+
+//
+// Get rid of the distribution tree at the given level. All McastForwarders
+// go back to the pending set so that they get attached again if we become
+// the tree builder.
+//
+void McastSGEntry::FlushTree(uint8_t level) {
+    McastForwarderList &tree_nodes = tree_nodes_[level];
+    for (McastForwarderList::iterator it = tree_nodes.begin();
+         it != tree_nodes.end(); ++it) {
+        (*it)->FlushLinks();
+        (*it)->ReleaseLabel();
+        (*it)->set_tree_index(McastForwarder::kInvalidIndex);
+        pending_sets_[level].insert(*it);
+        partition_->GetTablePartition()->Notify((*it)->route());
     }
+    tree_nodes.clear();
+    changed_sets_[level].clear();
+}
+
+//
+// Update specified distribution tree for the McastSGEntry.  McastForwarders
+// are arranged in breadth first fashion in a k-ary tree.
+//
+// The tree is updated incrementally so that a join or leave only affects the
+// McastForwarders in its vicinity, instead of rebuilding the whole tree. This
+// matters for large broadcast domains, where the tree can have thousands of
+// McastForwarders. As a consequence, the shape of the tree depends on the
+// order in which McastForwarders joined and left. Pending McastForwarders are
+// attached in sorted order, so that a given sequence of updates still results
+// in the same tree.
+//
+// McastForwarders whose links have changed get a new label. Their neighbors
+// are notified as well since their BgpOLists contain the new label. Note that
+// DBListeners will not get invoked until after this routine is done.
+//
+void McastSGEntry::UpdateTree(uint8_t level) {
+    CHECK_CONCURRENCY("db::DBTable");
 
-    // Bail if we're not the tree builder.
+    if (!update_needed_[level])
+        return;
+    update_needed_[level] = false;
+
+    // Get rid of the distribution tree if we're not the tree builder.
     if (!IsTreeBuilder(level)) {
+        FlushTree(level);
         UpdateRoutes(level);
         return;
     }
 
-    // Create a vector of pointers to the McastForwarders in sorted order.
-    // We do this because std::set doesn't support random access iterators.
-    McastForwarderList vec;
-    vec.reserve(forwarders->size());
-    for (ForwarderSet::iterator it = forwarders->begin();
-         it != forwarders->end(); ++it) {
-        vec.push_back(*it);
+    // Attach all pending McastForwarders.
+    ForwarderSet &pending = pending_sets_[level];
+    for (ForwarderSet::iterator it = pending.begin();
+         it != pending.end(); ++it) {
+        AttachForwarder(*it);
     }
-
-    // Go through each McastForwarder in the vector and link it to it's parent
-    // McastForwarder in the k-ary tree. We also add a link from the parent to
-    // the entry in question.
-    for (McastForwarderList::iterator it = vec.begin(); it != vec.end(); ++it) {
-        (*it)->AllocateLabel();
-        int idx = it - vec.begin();
-        if (idx == 0)
-            continue;
-
-        int parent_idx = (idx - 1) / degree;
-        McastForwarderList::iterator parent_it = vec.begin() + parent_idx;
-        assert(parent_it != vec.end());
-        (*it)->AddLink(*parent_it);
-        (*parent_it)->AddLink(*it);
+    pending.clear();
+
+    // Allocate new labels for the changed McastForwarders and enqueue the
+    // associated ErmVpnRoutes and those of their neighbors for notification.
+    DBTablePartBase *tbl_partition = partition_->GetTablePartition();
+    ForwarderChangeSet &changed = changed_sets_[level];
+    for (ForwarderChangeSet::iterator it = changed.begin();
+         it != changed.end(); ++it) {
+        McastForwarder *forwarder = *it;
+        forwarder->ReleaseLabel();
+        forwarder->AllocateLabel();
+        tbl_partition->Notify(forwarder->route());
+        const McastForwarderList &links = forwarder->tree_links();
+        for (McastForwarderList::const_iterator link_it = links.begin();
+             link_it != links.end(); ++link_it) {
+            tbl_partition->Notify((*link_it)->route());
+        }
     }
+    changed.clear();
 
     // Update [Local|Global]TreeRoutes.
     UpdateRoutes(level);
@@ -71,6 +71,9 @@ typedef std::vector<McastForwarder *> McastForwarderList;
 // distribution tree. Thus the label can be stored in the McastForwarder itself
 // and does not need to be part of the link information.
 //
+// The tree_index_ is the position of the McastForwarder in the distribution
+// tree of the McastSGEntry, or kInvalidIndex if it is not part of the tree.
+//
 // If this control-node is elected as the tree builder for the (G,S), a global
 // distribution tree of all Local McastForwarders is built.  Relevant edges of
 // this global distribution tree are advertised to each control-node by adding
@@ -80,6 +83,8 @@ typedef std::vector<McastForwarder *> McastForwarderList;
 //
 class McastForwarder : public DBState {
 public:
+    static const int kInvalidIndex = -1;
+
     McastForwarder(McastSGEntry *sg_entry, ErmVpnRoute *route);
     ~McastForwarder();
 
@@ -106,6 +111,9 @@ public:
     ErmVpnRoute *route() { return route_; }
     RouteDistinguisher route_distinguisher() const { return rd_; }
     Ip4Address router_id() const { return router_id_; }
+    const McastForwarderList &tree_links() const { return tree_links_; }
+    int tree_index() const { return tree_index_; }
+    void set_tree_index(int tree_index) { tree_index_ = tree_index; }
 
     bool empty() { return tree_links_.empty(); }
 
@@ -127,6 +135,7 @@ private:
     Ip4Address router_id_;
     std::vector<std::string> encap_;
     McastForwarderList tree_links_;
+    int tree_index_;
 
     DISALLOW_COPY_AND_ASSIGN(McastForwarder);
 };
@@ -193,6 +202,16 @@ struct McastForwarderCompare {
 // GlobalTreeRoute is used to decide if it's for this control-node.  We set
 // our DBState on this ErmVpnRoute to be the McastSGEntry.
 //
+// The distribution tree at each level is maintained incrementally. The tree
+// nodes vector holds the McastForwarders in breadth first order of a k-ary
+// tree, so the parent of the McastForwarder at index i is at (i - 1) / k.
+// A new McastForwarder is attached at the end of the vector. A McastForwarder
+// that leaves is replaced by the McastForwarder at the end of the vector,
+// which is always a leaf. Either operation relinks at most k + 2 forwarders.
+// New McastForwarders are kept in the pending set until the tree is updated
+// from the WorkQueue, and the McastForwarders whose links have changed are
+// kept in the changed set so that they get a new label and are notified.
+//
 // The McastSGEntry is enqueued on the WorkQueue in the McastManagerPartition
 // when a McastForwarder is added, changed or deleted so that the distribution
 // tree and the necessary LocalTreeRoute or GlobalTreeRoutes can be updated.
@@ -235,8 +254,15 @@ private:
     friend class ShowMulticastManagerDetailHandler;
 
     typedef std::set<McastForwarder *, McastForwarderCompare> ForwarderSet;
+    typedef std::set<McastForwarder *> ForwarderChangeSet;
 
     bool IsTreeBuilder(uint8_t level);
+    int GetDegree(uint8_t level) const;
+    void LinkForwarders(McastForwarder *parent, McastForwarder *child);
+    void UnlinkForwarders(McastForwarder *parent, McastForwarder *child);
+    void AttachForwarder(McastForwarder *forwarder);
+    void DetachForwarder(McastForwarder *forwarder);
+    void FlushTree(uint8_t level);
     void UpdateTree(uint8_t level);
     void UpdateRoutes(uint8_t level);
 
@@ -246,6 +272,9 @@ private:
     ErmVpnRoute *local_tree_route_;
     ErmVpnRoute *tree_result_route_;
     std::vector<ForwarderSet *> forwarder_sets_;
+    std::vector<McastForwarderList> tree_nodes_;
+    std::vector<ForwarderSet> pending_sets_;
+    std::vector<ForwarderChangeSet> changed_sets_;
     std::vector<bool> update_needed_;
     bool on_work_queue_;
 
@@ -31,25 +31,25 @@ std::string BgpPath::PathSourceString(PathSource source) {
 BgpPath::BgpPath(const IPeer *peer, uint32_t path_id, PathSource src, 
                  const BgpAttrPtr ptr, uint32_t flags, uint32_t label)
     : peer_(peer), path_id_(path_id), source_(src), attr_(ptr), 
-      flags_(flags), label_(label) {
+      flags_(flags), label_(label), route_(NULL) {
 }
 
 BgpPath::BgpPath(const IPeer *peer, PathSource src, const BgpAttrPtr ptr, 
         uint32_t flags, uint32_t label)
     : peer_(peer), path_id_(0), source_(src), attr_(ptr), 
-      flags_(flags), label_(label) {
+      flags_(flags), label_(label), route_(NULL) {
 }
 
 BgpPath::BgpPath(uint32_t path_id, PathSource src, const BgpAttrPtr ptr,
         uint32_t flags, uint32_t label)
     : peer_(NULL), path_id_(path_id), source_(src), attr_(ptr), 
-      flags_(flags), label_(label) {
+      flags_(flags), label_(label), route_(NULL) {
 }
 
 BgpPath::BgpPath(PathSource src, const BgpAttrPtr ptr,
         uint32_t flags, uint32_t label)
     : peer_(NULL), path_id_(0), source_(src), attr_(ptr),
-      flags_(flags), label_(label) {
+      flags_(flags), label_(label), route_(NULL) {
 }
 
 // True is better
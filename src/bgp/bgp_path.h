@@ -5,6 +5,8 @@
 #ifndef ctrlplane_bgp_path_h
 #define ctrlplane_bgp_path_h
 
+#include <boost/intrusive/list.hpp>
+
 #include "base/util.h"
 #include "route/path.h"
 #include "bgp/bgp_peer.h"
@@ -15,6 +17,10 @@ class BgpRoute;
 
 class BgpPath : public Path {
 public:
+    typedef boost::intrusive::list_member_hook<
+        boost::intrusive::link_mode<boost::intrusive::auto_unlink>
+    > PeerPathHook;
+
     enum PathFlag {
         AsPathLooped = 1 << 0,
         NoNeighborAs = 1 << 1,
@@ -110,6 +116,15 @@ public:
     // Select one path over other
     int PathCompare(const BgpPath &rhs, bool allow_ecmp) const;
 
+    // Route that the path belongs to. Only maintained for paths that are
+    // linked in the per peer path index of the BgpTable.
+    BgpRoute *route() const { return route_; }
+    void set_route(BgpRoute *route) { route_ = route; }
+
+    // Member hook in the list of paths from the same peer in a partition of
+    // a BgpTable. The path unlinks itself when it's deleted.
+    PeerPathHook peer_node_;
+
 private:
     const IPeer *peer_;
     const uint32_t path_id_;
@@ -117,6 +132,7 @@ private:
     const BgpAttrPtr attr_;
     uint32_t flags_;
     uint32_t label_;
+    BgpRoute *route_;
 };
 
 class BgpSecondaryPath : public BgpPath {
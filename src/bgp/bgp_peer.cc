@@ -22,10 +22,12 @@
 #include "bgp/bgp_path.h"
 #include "bgp/bgp_peer_membership.h"
 #include "bgp/bgp_proto.h"
+#include "bgp/bgp_route.h"
 #include "bgp/bgp_server.h"
 #include "bgp/bgp_session.h"
 #include "bgp/state_machine.h"
 #include "bgp/bgp_session_manager.h"
+#include "bgp/bgp_update_reader.h"
 #include "bgp/bgp_peer_types.h"
 #include "bgp/bgp_sandesh.h"
 #include "bgp/ermvpn/ermvpn_table.h"
@@ -323,6 +325,7 @@ BgpPeer::BgpPeer(BgpServer *server, RoutingInstance *instance,
           membership_req_pending_(0),
           defer_close_(false),
           vpn_tables_registered_(false),
+          extended_message_(false),
           local_as_(config->local_as()),
           peer_as_(config_->peer_as()),
           remote_bgp_id_(0),
@@ -397,6 +400,7 @@ void BgpPeer::ConfigUpdate(const BgpNeighborConfig *config) {
     }
 
     bool clear_session = false;
+    bool sort_paths = false;
 
     BgpPeerInfoData peer_info;
     peer_info.set_name(ToUVEKey());
@@ -407,6 +411,7 @@ void BgpPeer::ConfigUpdate(const BgpNeighborConfig *config) {
         peer_key_ = key;
         peer_info.set_peer_address(peer_key_.endpoint.address().to_string());
         clear_session = true;
+        sort_paths = true;
     }
 
     // Check if there is any change in the configured address families.
@@ -446,6 +451,7 @@ void BgpPeer::ConfigUpdate(const BgpNeighborConfig *config) {
         policy_.type = peer_type_;
         policy_.as_number = peer_as_;
         clear_session = true;
+        sort_paths = true;
     }
 
     if (clear_session) {
@@ -455,6 +461,8 @@ void BgpPeer::ConfigUpdate(const BgpNeighborConfig *config) {
         BGPPeerInfo::Send(peer_info);
         Clear(BgpProto::Notification::OtherConfigChange);
     }
+    if (sort_paths)
+        BgpRoute::InvalidatePathOrder();
 }
 
 void BgpPeer::ClearConfig() {
@@ -749,6 +757,13 @@ void BgpPeer::SendOpen(TcpSession *session) {
                           restart_cap, 2);
     opt_param->capabilities.push_back(cap);
 
+    // Add extended message capability to receive UPDATEs of up to 64K
+    if (server_->extended_message()) {
+        cap = new BgpProto::OpenMessage::Capability(
+                  BgpProto::OpenMessage::Capability::ExtendedMessage, NULL, 0);
+        opt_param->capabilities.push_back(cap);
+    }
+
     if (opt_param->capabilities.size()) {
         openmsg.opt_params.push_back(opt_param);
     } else {
@@ -839,7 +854,10 @@ void BgpPeer::SendNotification(BgpSession *session,
 }
 
 void BgpPeer::SetCapabilities(const BgpProto::OpenMessage *msg) {
+    uint32_t prev_bgp_id = remote_bgp_id_;
     remote_bgp_id_ = msg->identifier;
+    if (prev_bgp_id != 0 && prev_bgp_id != remote_bgp_id_)
+        BgpRoute::InvalidatePathOrder();
     capabilities_.clear();
     std::vector<BgpProto::OpenMessage::OptParam *>::const_iterator it;
     for (it = msg->opt_params.begin(); it < msg->opt_params.end(); ++it) {
@@ -854,8 +872,13 @@ void BgpPeer::SetCapabilities(const BgpProto::OpenMessage *msg) {
 
     std::vector<std::string> families;
     std::vector<BgpProto::OpenMessage::Capability *>::iterator cap_it;
+    extended_message_ = false;
     for (cap_it = capabilities_.begin(); cap_it < capabilities_.end();
          ++cap_it) {
+        if ((*cap_it)->code ==
+            BgpProto::OpenMessage::Capability::ExtendedMessage) {
+            extended_message_ = server_->extended_message();
+        }
         if ((*cap_it)->code != BgpProto::OpenMessage::Capability::MpExtension)
             continue;
         uint8_t *data = (*cap_it)->capability.data();
@@ -870,6 +893,10 @@ void BgpPeer::SetCapabilities(const BgpProto::OpenMessage *msg) {
     }
     peer_info.set_families(families);
 
+    // The extended message capability is in use if we advertised it and the
+    // peer advertised it as well.
+    policy_.extended_message = extended_message_;
+
     negotiated_families_.clear();
     BOOST_FOREACH(Address::Family family, family_) {
         uint16_t afi;
@@ -892,6 +919,8 @@ void BgpPeer::SetCapabilities(const BgpProto::OpenMessage *msg) {
 //
 void BgpPeer::ResetCapabilities() {
     STLDeleteValues(&capabilities_);
+    extended_message_ = false;
+    policy_.extended_message = false;
     BgpPeerInfoData peer_info;
     peer_info.set_name(ToUVEKey());
     std::vector<std::string> families = std::vector<std::string>();
@@ -916,32 +945,170 @@ bool BgpPeer::MpNlriAllowed(uint16_t afi, uint8_t safi) {
     return false;
 }
 
-void BgpPeer::ProcessUpdate(const BgpProto::Update *msg) {
-    BgpAttrPtr attr = server_->attr_db()->Locate(msg->path_attributes);
-    // Check as path loop and neighbor-as 
-    const BgpAttr *path_attr = attr.get(); 
+//
+// Return the flags for paths learnt with the given attributes.
+//
+uint32_t BgpPeer::GetPathFlags(const BgpAttr *attr) const {
     uint32_t flags = 0;
 
-    inc_rx_route_update();
-
-    if (path_attr->as_path() != NULL) {
+    if (attr->as_path() != NULL) {
         // Check whether neighbor has appended its AS to the AS_PATH
         if ((PeerType() == BgpProto::EBGP) && 
-            (!path_attr->as_path()->path().AsLeftMostMatch(peer_as()))) {
+            (!attr->as_path()->path().AsLeftMostMatch(peer_as()))) {
             flags |= BgpPath::NoNeighborAs;
         }
 
         // Check for AS_PATH loop
-        if (path_attr->as_path()->path().AsPathLoop(
+        if (attr->as_path()->path().AsPathLoop(
                 server_->autonomous_system())) {
             flags |= BgpPath::AsPathLooped;
         }
     }
 
+    return flags;
+}
+
+//
+// Check whether the address family of an MP_REACH_NLRI or MP_UNREACH_NLRI
+// attribute has been negotiated with the peer.
+//
+bool BgpPeer::MpNlriFamilyNegotiated(uint16_t afi, uint8_t safi,
+                                     Address::Family *family) {
+    *family = BgpAf::AfiSafiToFamily(afi, safi);
+    if (!IsFamilyNegotiated(*family)) {
+        BGP_LOG_PEER(Message, this, SandeshLevel::SYS_NOTICE, BGP_LOG_FLAG_ALL,
+                     BGP_PEER_DIR_IN,
+                     "AFI "<< afi << " SAFI " << (int) safi <<
+                     " not allowed");
+        return false;
+    }
+    return true;
+}
+
+//
+// Enqueue the request for a single prefix to the table for the family.
+//
+void BgpPeer::ProcessNlri(Address::Family family, BgpTable *table,
+                          DBRequest::DBOperation oper,
+                          const BgpProtoPrefix &nlri, const BgpAttrPtr &attr,
+                          uint32_t flags) {
+    switch (family) {
+    case Address::INET: {
+        assert(table);
+        DBRequest req;
+        req.oper = oper;
+        if (oper == DBRequest::DB_ENTRY_ADD_CHANGE)
+            req.data.reset(new InetTable::RequestData(attr, flags, 0));
+        Ip4Prefix prefix = Ip4Prefix(nlri);
+        req.key.reset(new InetTable::RequestKey(prefix, this));
+        table->Enqueue(&req);
+        break;
+    }
+
+    case Address::INETVPN: {
+        assert(table);
+        uint32_t label = (nlri.prefix[0] << 16 |
+                          nlri.prefix[1] << 8 |
+                          nlri.prefix[2]) >> 4;
+        DBRequest req;
+        req.oper = oper;
+        if (oper == DBRequest::DB_ENTRY_ADD_CHANGE)
+            req.data.reset(new InetVpnTable::RequestData(attr, flags, label));
+        req.key.reset(new InetVpnTable::RequestKey(InetVpnPrefix(nlri), this));
+        table->Enqueue(&req);
+        break;
+    }
+
+    case Address::INET6VPN: {
+        assert(table);
+        uint32_t label = (nlri.prefix[0] << 16 |
+                          nlri.prefix[1] << 8 |
+                          nlri.prefix[2]) >> 4;
+        DBRequest req;
+        req.oper = oper;
+        if (oper == DBRequest::DB_ENTRY_ADD_CHANGE) {
+            req.data.reset(
+                    new Inet6VpnTable::RequestData(attr, flags, label));
+        }
+        req.key.reset(
+            new Inet6VpnTable::RequestKey(Inet6VpnPrefix(nlri), this));
+        table->Enqueue(&req);
+        break;
+    }
+
+    case Address::EVPN: {
+        assert(table);
+        EvpnPrefix prefix;
+        BgpAttrPtr new_attr;
+        uint32_t label = 0;
+        int result = EvpnPrefix::FromProtoPrefix(server_, nlri,
+            (oper == DBRequest::DB_ENTRY_ADD_CHANGE) ? attr.get() : NULL,
+            &prefix, &new_attr, &label);
+        if (result) {
+            BGP_LOG_PEER(Message, this, SandeshLevel::SYS_WARN,
+                BGP_LOG_FLAG_ALL, BGP_PEER_DIR_IN,
+                "NLRI parse error for EVPN route type " << nlri.type);
+            break;
+        }
+
+        DBRequest req;
+        req.oper = oper;
+        if (oper == DBRequest::DB_ENTRY_ADD_CHANGE)
+            req.data.reset(new EvpnTable::RequestData(new_attr, flags, label));
+        req.key.reset(new EvpnTable::RequestKey(prefix, this));
+        table->Enqueue(&req);
+        break;
+    }
+
+    case Address::RTARGET: {
+        assert(table);
+        DBRequest req;
+        req.oper = oper;
+        if (oper == DBRequest::DB_ENTRY_ADD_CHANGE)
+            req.data.reset(new RTargetTable::RequestData(attr, flags, 0));
+        RTargetPrefix prefix = RTargetPrefix(nlri);
+        req.key.reset(new RTargetTable::RequestKey(prefix, this));
+        table->Enqueue(&req);
+        break;
+    }
+
+    case Address::ERMVPN: {
+        assert(table);
+        if (!ErmVpnPrefix::IsValidForBgp(nlri.type)) {
+            BGP_LOG_PEER(Message, this, SandeshLevel::SYS_WARN,
+                BGP_LOG_FLAG_ALL, BGP_PEER_DIR_IN,
+                "ERMVPN: Unsupported route type " << nlri.type);
+            break;
+        }
+        DBRequest req;
+        req.oper = oper;
+        if (oper == DBRequest::DB_ENTRY_ADD_CHANGE)
+            req.data.reset(new ErmVpnTable::RequestData(attr, flags, 0));
+        req.key.reset(new ErmVpnTable::RequestKey(ErmVpnPrefix(nlri), this));
+        table->Enqueue(&req);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+void BgpPeer::ProcessUpdate(const BgpProto::Update *msg) {
+    if (msg->reader) {
+        ProcessUpdate(msg->reader.get());
+        return;
+    }
+
+    BgpAttrPtr attr = server_->attr_db()->Locate(msg->path_attributes);
+    // Check as path loop and neighbor-as 
+    uint32_t flags = GetPathFlags(attr.get());
+
+    inc_rx_route_update();
+
     RoutingInstance *instance = GetRoutingInstance();
     if (msg->nlri.size() || msg->withdrawn_routes.size()) {
-        InetTable *table =
-            static_cast<InetTable *>(instance->GetTable(Address::INET));
+        BgpTable *table = instance->GetTable(Address::INET);
         if (!table) {
             BGP_LOG_PEER(Message, this, SandeshLevel::SYS_CRIT, BGP_LOG_FLAG_ALL,
                          BGP_PEER_DIR_IN, "Cannot find inet table");
@@ -951,23 +1118,15 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg) {
         for (vector<BgpProtoPrefix *>::const_iterator it =
              msg->withdrawn_routes.begin(); it != msg->withdrawn_routes.end();
              ++it) {
-            DBRequest req;
-            req.oper = DBRequest::DB_ENTRY_DELETE;
-            req.data.reset(NULL);
-            Ip4Prefix prefix = Ip4Prefix(**it);
-            req.key.reset(new InetTable::RequestKey(prefix, this));
-            table->Enqueue(&req);
+            ProcessNlri(Address::INET, table, DBRequest::DB_ENTRY_DELETE,
+                        **it, attr, flags);
             inc_rx_route_unreach();
         }
 
         for (vector<BgpProtoPrefix *>::const_iterator it = msg->nlri.begin();
              it != msg->nlri.end(); ++it) {
-            DBRequest req;
-            req.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
-            req.data.reset(new InetTable::RequestData(attr, flags, 0));
-            Ip4Prefix prefix = Ip4Prefix(**it);
-            req.key.reset(new InetTable::RequestKey(prefix, this));
-            table->Enqueue(&req);
+            ProcessNlri(Address::INET, table, DBRequest::DB_ENTRY_ADD_CHANGE,
+                        **it, attr, flags);
             inc_rx_route_reach();
         }
     }
@@ -978,10 +1137,8 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg) {
         DBRequest::DBOperation oper;
         if ((*ait)->code == BgpAttribute::MPReachNlri) {
             oper = DBRequest::DB_ENTRY_ADD_CHANGE;
-            inc_rx_route_reach();
         } else if ((*ait)->code == BgpAttribute::MPUnreachNlri) {
             oper = DBRequest::DB_ENTRY_DELETE;
-            inc_rx_route_unreach();
         } else {
             continue;
         }
@@ -989,162 +1146,110 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg) {
         BgpMpNlri *nlri = static_cast<BgpMpNlri *>(*ait);
         if (!nlri) continue;
 
-        Address::Family family = BgpAf::AfiSafiToFamily(nlri->afi, nlri->safi);
-        if (!IsFamilyNegotiated(family)) {
-            BGP_LOG_PEER(Message, this, SandeshLevel::SYS_NOTICE, BGP_LOG_FLAG_ALL,
-                         BGP_PEER_DIR_IN,
-                         "AFI "<< nlri->afi << " SAFI " << (int) nlri->safi <<
-                         " not allowed");
+        Address::Family family;
+        if (!MpNlriFamilyNegotiated(nlri->afi, nlri->safi, &family))
             continue;
-        }
 
         if ((*ait)->code == BgpAttribute::MPReachNlri)
             attr = GetMpNlriNexthop(nlri, attr);
 
-        switch (family) {
-        case Address::INET: {
-            InetTable *table =
-                static_cast<InetTable *>(instance->GetTable(family));
+        BgpTable *table = instance->GetTable(family);
+        if (family == Address::RTARGET) {
             assert(table);
-
-            vector<BgpProtoPrefix *>::const_iterator it;
-            for (it = nlri->nlri.begin(); it < nlri->nlri.end(); it++) {
-                DBRequest req;
-                req.oper = oper;
-                if (oper == DBRequest::DB_ENTRY_ADD_CHANGE)
-                    req.data.reset(new InetTable::RequestData(attr, flags, 0));
-                Ip4Prefix prefix = Ip4Prefix(**it);
-                req.key.reset(new InetTable::RequestKey(prefix, this));
-                table->Enqueue(&req);
-            }
-            break;
-        }
-
-        case Address::INETVPN: {
-            InetVpnTable *table = 
-              static_cast<InetVpnTable *>(instance->GetTable(family));
-            assert(table);
-
-            vector<BgpProtoPrefix *>::const_iterator it;
-            for (it = nlri->nlri.begin(); it < nlri->nlri.end(); it++) {
-                uint32_t label = ((*it)->prefix[0] << 16 |
-                                  (*it)->prefix[1] << 8 |
-                                  (*it)->prefix[2]) >> 4;
-                DBRequest req;
-                req.oper = oper;
-                if (oper == DBRequest::DB_ENTRY_ADD_CHANGE)
-                    req.data.reset(new InetVpnTable::RequestData(attr, flags, label));
-                req.key.reset(new InetVpnTable::RequestKey(InetVpnPrefix(**it),
-                                                           this));
-                table->Enqueue(&req);
+            if (oper == DBRequest::DB_ENTRY_DELETE && nlri->nlri.empty()) {
+                // End-Of-RIB message
+                end_of_rib_timer_->Cancel();
+                RegisterToVpnTables(true);
+                return;
             }
-            break;
         }
 
-        case Address::INET6VPN: {
-            Inet6VpnTable *table = 
-                static_cast<Inet6VpnTable *>(instance->GetTable(family));
-            assert(table);
-
-            vector<BgpProtoPrefix *>::const_iterator it;
-            for (it = nlri->nlri.begin(); it < nlri->nlri.end(); ++it) {
-                uint32_t label = ((*it)->prefix[0] << 16 |
-                                  (*it)->prefix[1] << 8 |
-                                  (*it)->prefix[2]) >> 4;
-                DBRequest req;
-                req.oper = oper;
-                if (oper == DBRequest::DB_ENTRY_ADD_CHANGE) {
-                    req.data.reset(
-                            new Inet6VpnTable::RequestData(attr, flags, label));
-                }
-                req.key.reset(
-                    new Inet6VpnTable::RequestKey(Inet6VpnPrefix(**it), this));
-                table->Enqueue(&req);
+        vector<BgpProtoPrefix *>::const_iterator it;
+        for (it = nlri->nlri.begin(); it < nlri->nlri.end(); it++) {
+            ProcessNlri(family, table, oper, **it, attr, flags);
+            if (oper == DBRequest::DB_ENTRY_ADD_CHANGE) {
+                inc_rx_route_reach();
+            } else {
+                inc_rx_route_unreach();
             }
-            break;
         }
+    }
+}
 
+//
+// Same as the above, for an UPDATE that was accepted by BgpUpdateReader.
+// The attributes are decoded into the reader and the prefixes are visited
+// in place in the message.
+//
+// The MP_REACH_NLRI is processed before the MP_UNREACH_NLRI, in the same
+// order as Validate sorts the attributes of a generic Update. The reader
+// does not handle RTARGET, so there's no End-Of-RIB to take care of.
+//
+void BgpPeer::ProcessUpdate(BgpUpdateReader *reader) {
+    BgpAttrSpec spec;
+    reader->GetAttrSpec(&spec);
+    BgpAttrPtr attr = server_->attr_db()->Locate(spec);
+    uint32_t flags = GetPathFlags(attr.get());
 
-        case Address::EVPN: {
-            EvpnTable *table =
-                static_cast<EvpnTable *>(instance->GetTable(family));
-            assert(table);
+    inc_rx_route_update();
 
-            vector<BgpProtoPrefix *>::const_iterator it;
-            for (it = nlri->nlri.begin(); it < nlri->nlri.end(); it++) {
-                EvpnPrefix prefix;
-                BgpAttrPtr new_attr;
-                uint32_t label = 0;
-                int result = EvpnPrefix::FromProtoPrefix(server_, (**it),
-                    (oper == DBRequest::DB_ENTRY_ADD_CHANGE) ? attr.get() : NULL,
-                    &prefix, &new_attr, &label);
-                if (result) {
-                    BGP_LOG_PEER(Message, this, SandeshLevel::SYS_WARN,
-                        BGP_LOG_FLAG_ALL, BGP_PEER_DIR_IN,
-                        "NLRI parse error for EVPN route type " << (*it)->type);
-                    continue;
-                }
-
-                DBRequest req;
-                req.oper = oper;
-                if (oper == DBRequest::DB_ENTRY_ADD_CHANGE)
-                    req.data.reset(new EvpnTable::RequestData(new_attr, flags, label));
-                req.key.reset(new EvpnTable::RequestKey(prefix, this));
-                table->Enqueue(&req);
-            }
-            break;
+    RoutingInstance *instance = GetRoutingInstance();
+    BgpUpdateReader::PrefixIterator withdrawn = reader->withdrawn_routes();
+    BgpUpdateReader::PrefixIterator nlri = reader->nlri();
+    BgpProtoPrefix prefix;
+    if (!withdrawn.empty() || !nlri.empty()) {
+        BgpTable *table = instance->GetTable(Address::INET);
+        if (!table) {
+            BGP_LOG_PEER(Message, this, SandeshLevel::SYS_CRIT, BGP_LOG_FLAG_ALL,
+                         BGP_PEER_DIR_IN, "Cannot find inet table");
+            return;
         }
 
-        case Address::RTARGET: {
-            RTargetTable *table =
-                static_cast<RTargetTable *>(instance->GetTable(family));
-            assert(table);
-            if (oper == DBRequest::DB_ENTRY_DELETE && nlri->nlri.empty()) {
-                // End-Of-RIB message
-                end_of_rib_timer_->Cancel();
-                RegisterToVpnTables(true);
-                return;
-            }
-            vector<BgpProtoPrefix *>::const_iterator it;
-            for (it = nlri->nlri.begin(); it < nlri->nlri.end(); it++) {
-                DBRequest req;
-                req.oper = oper;
-                if (oper == DBRequest::DB_ENTRY_ADD_CHANGE)
-                    req.data.reset(new RTargetTable::RequestData(attr, flags, 0));
-                RTargetPrefix prefix = RTargetPrefix(**it);
-                req.key.reset(new RTargetTable::RequestKey(prefix, this));
-                table->Enqueue(&req);
-            }
-            break;
+        while (withdrawn.Next(&prefix)) {
+            ProcessNlri(Address::INET, table, DBRequest::DB_ENTRY_DELETE,
+                        prefix, attr, flags);
+            inc_rx_route_unreach();
         }
+        while (nlri.Next(&prefix)) {
+            ProcessNlri(Address::INET, table, DBRequest::DB_ENTRY_ADD_CHANGE,
+                        prefix, attr, flags);
+            inc_rx_route_reach();
+        }
+    }
 
-        case Address::ERMVPN: {
-            ErmVpnTable *table;
-            table = static_cast<ErmVpnTable *>(instance->GetTable(family));
-            assert(table);
+    const BgpUpdateReader::MpNlri *mp_nlri[] = {
+        &reader->mp_reach_nlri(), &reader->mp_unreach_nlri()
+    };
+    for (size_t idx = 0; idx < 2; ++idx) {
+        if (!mp_nlri[idx]->present)
+            continue;
 
-            vector<BgpProtoPrefix *>::const_iterator it;
-            for (it = nlri->nlri.begin(); it < nlri->nlri.end(); it++) {
-                if (!ErmVpnPrefix::IsValidForBgp((*it)->type)) {
-                    BGP_LOG_PEER(Message, this, SandeshLevel::SYS_WARN,
-                        BGP_LOG_FLAG_ALL, BGP_PEER_DIR_IN,
-                        "ERMVPN: Unsupported route type " << (*it)->type);
-                    continue;
-                }
-                DBRequest req;
-                req.oper = oper;
-                if (oper == DBRequest::DB_ENTRY_ADD_CHANGE)
-                    req.data.reset(new ErmVpnTable::RequestData(attr, flags,
-                                                              0));
-                req.key.reset(new ErmVpnTable::RequestKey(
-                                  ErmVpnPrefix(**it), this));
-                table->Enqueue(&req);
-            }
-            break;
+        DBRequest::DBOperation oper;
+        if (mp_nlri[idx] == &reader->mp_reach_nlri()) {
+            oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+        } else {
+            oper = DBRequest::DB_ENTRY_DELETE;
         }
 
-        default:
+        Address::Family family;
+        if (!MpNlriFamilyNegotiated(mp_nlri[idx]->afi, mp_nlri[idx]->safi,
+                                    &family))
             continue;
+
+        if (oper == DBRequest::DB_ENTRY_ADD_CHANGE) {
+            attr = GetMpNlriNexthop(mp_nlri[idx]->afi, mp_nlri[idx]->safi,
+                mp_nlri[idx]->nexthop, mp_nlri[idx]->nexthop_size, attr);
+        }
+
+        BgpTable *table = instance->GetTable(family);
+        BgpUpdateReader::PrefixIterator prefixes = mp_nlri[idx]->prefixes;
+        while (prefixes.Next(&prefix)) {
+            ProcessNlri(family, table, oper, prefix, attr, flags);
+            if (oper == DBRequest::DB_ENTRY_ADD_CHANGE) {
+                inc_rx_route_reach();
+            } else {
+                inc_rx_route_unreach();
+            }
         }
     }
 }
@@ -1330,7 +1435,30 @@ string BgpPeer::BytesToHexString(const u_int8_t *msg, size_t size) {
 void BgpPeer::ReceiveMsg(BgpSession *session, const u_int8_t *msg,
                          size_t size) {
     ParseErrorContext ec;
-    BgpProto::BgpMessage *minfo = BgpProto::Decode(msg, size, &ec);
+
+    // Only UPDATEs can exceed 4K, and only if the peer negotiated extended
+    // messages.
+    if (size > (size_t) BgpProto::kMaxMessageSize &&
+        (!extended_message_ || msg[BgpProto::kMinMessageSize - 1] !=
+                               BgpProto::UPDATE)) {
+        ec.error_code = BgpProto::Notification::MsgHdrErr;
+        ec.error_subcode = BgpProto::Notification::BadMsgLength;
+        ec.type_name = "BgpMsgLength";
+        ec.data = msg + 16;
+        ec.data_size = 2;
+        BGP_TRACE_PEER_PACKET(this, msg, BgpProto::kMinMessageSize,
+                              SandeshLevel::SYS_WARN);
+        BGP_LOG_PEER(Message, this, SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
+                     BGP_PEER_DIR_IN,
+                     "Message length " << size << " exceeds maximum");
+        state_machine_->OnMessageError(session, &ec);
+        return;
+    }
+
+    // Try the in-place decoder for common UPDATEs before the generic parser.
+    BgpProto::BgpMessage *minfo = BgpUpdateReader::Decode(msg, size);
+    if (minfo == NULL)
+        minfo = BgpProto::Decode(msg, size, &ec);
 
     if (minfo == NULL) {
         BGP_TRACE_PEER_PACKET(this, msg, size, SandeshLevel::SYS_WARN);
@@ -1373,33 +1501,37 @@ string BgpPeer::ToUVEKey() const {
 
 
 BgpAttrPtr BgpPeer::GetMpNlriNexthop(BgpMpNlri *nlri, BgpAttrPtr attr) {
+    const uint8_t *nexthop = nlri->nexthop.empty() ? NULL : &nlri->nexthop[0];
+    return GetMpNlriNexthop(nlri->afi, nlri->safi, nexthop,
+                            nlri->nexthop.size(), attr);
+}
+
+BgpAttrPtr BgpPeer::GetMpNlriNexthop(uint16_t afi, uint8_t safi,
+                                     const uint8_t *nexthop, size_t size,
+                                     BgpAttrPtr attr) {
     bool update_nh = false;
     IpAddress addr;
     Ip4Address::bytes_type bt = { { 0 } };
 
-    if (nlri->afi == BgpAf::IPv4) {
-        if (nlri->safi == BgpAf::Unicast || nlri->safi == BgpAf::RTarget) {
-            std::copy(nlri->nexthop.begin(), nlri->nexthop.end(),
-                      bt.begin());
+    if (afi == BgpAf::IPv4) {
+        if (safi == BgpAf::Unicast || safi == BgpAf::RTarget) {
+            std::copy(nexthop, nexthop + size, bt.begin());
             update_nh = true;
-        } else if (nlri->safi == BgpAf::Vpn) {
+        } else if (safi == BgpAf::Vpn) {
             size_t rdsize = RouteDistinguisher::kSize;
-            std::copy(nlri->nexthop.begin() + rdsize,
-                      nlri->nexthop.end(), bt.begin());
+            std::copy(nexthop + rdsize, nexthop + size, bt.begin());
             update_nh = true;
         }
-    } else if (nlri->afi == BgpAf::L2Vpn) {
-        if (nlri->safi == BgpAf::EVpn) {
-            std::copy(nlri->nexthop.begin(), nlri->nexthop.end(),
-                      bt.begin());
+    } else if (afi == BgpAf::L2Vpn) {
+        if (safi == BgpAf::EVpn) {
+            std::copy(nexthop, nexthop + size, bt.begin());
             update_nh = true;
         }
-    } else if (nlri->afi == BgpAf::IPv6) {
-        if (nlri->safi == BgpAf::Vpn) {
+    } else if (afi == BgpAf::IPv6) {
+        if (safi == BgpAf::Vpn) {
             Ip6Address::bytes_type v6_bt = { { 0 } };
             size_t rdsize = RouteDistinguisher::kSize;
-            std::copy(nlri->nexthop.begin() + rdsize,
-                      nlri->nexthop.end(), v6_bt.begin());
+            std::copy(nexthop + rdsize, nexthop + size, v6_bt.begin());
             Ip6Address v6_address(v6_bt);
             if (v6_address.is_v4_mapped()) {
                 bt = Address::V4FromV4MappedV6(v6_address).to_bytes();
@@ -1412,8 +1544,8 @@ BgpAttrPtr BgpPeer::GetMpNlriNexthop(BgpMpNlri *nlri, BgpAttrPtr attr) {
     // NOP in cases <afi,safi> doesn't carry nexthop attribute.
     if (update_nh) {
         addr = Ip4Address(bt);
-        attr = server_->attr_db()->UpdateNexthopAndLocate(attr.get(), nlri->afi,
-                                                          nlri->safi, addr);
+        attr = server_->attr_db()->UpdateNexthopAndLocate(attr.get(), afi,
+                                                          safi, addr);
     }
     return attr;
 }
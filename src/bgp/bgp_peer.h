@@ -28,6 +28,8 @@ class BgpNeighborConfig;
 class BgpPeerInfo;
 class BgpServer;
 class BgpSession;
+class BgpTable;
+class BgpUpdateReader;
 class RoutingInstance;
 class StateMachine;
 class BgpSession;
@@ -130,6 +132,7 @@ public:
     }
 
     bool IsFamilyNegotiated(Address::Family family);
+    bool extended_message() const { return extended_message_; }
 
     RoutingInstance *GetRoutingInstance() {
         return rtinstance_;
@@ -237,7 +240,17 @@ private:
     void UnregisterAllTables();
 
     virtual bool MpNlriAllowed(uint16_t afi, uint8_t safi);
+    bool MpNlriFamilyNegotiated(uint16_t afi, uint8_t safi,
+                                Address::Family *family);
     BgpAttrPtr GetMpNlriNexthop(BgpMpNlri *nlri, BgpAttrPtr attr);
+    BgpAttrPtr GetMpNlriNexthop(uint16_t afi, uint8_t safi,
+                                const uint8_t *nexthop, size_t size,
+                                BgpAttrPtr attr);
+    uint32_t GetPathFlags(const BgpAttr *attr) const;
+    void ProcessNlri(Address::Family family, BgpTable *table,
+                     DBRequest::DBOperation oper, const BgpProtoPrefix &nlri,
+                     const BgpAttrPtr &attr, uint32_t flags);
+    void ProcessUpdate(BgpUpdateReader *reader);
 
     void PostCloseRelease();
     void CustomClose();
@@ -285,6 +298,7 @@ private:
     uint32_t membership_req_pending_;
     bool defer_close_;
     bool vpn_tables_registered_;
+    bool extended_message_;
     std::vector<BgpProto::OpenMessage::Capability *> capabilities_;
     as_t local_as_;
     as_t peer_as_;
@@ -6,8 +6,11 @@
 
 #include <boost/assign/list_of.hpp>
 #include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <tbb/atomic.h>
 #include <tbb/mutex.h>
 
+#include "base/task.h"
 #include "base/task_annotations.h"
 #include <sandesh/sandesh_types.h>
 #include <sandesh/sandesh.h>
@@ -35,6 +38,7 @@ MembershipRequest::MembershipRequest() {
     action_mask = INVALID;
     ipeer = NULL;
     instance_id = -1;
+    request_time = 0;
 }
 
 //
@@ -91,7 +95,10 @@ IPeerRib::IPeerRib(
       ribin_registered_(false),
       ribout_registered_(false),
       stale_(false),
-      instance_id_(-1) {
+      instance_id_(-1),
+      joined_(false),
+      join_timed_(false),
+      join_latency_usec_(0) {
     if (membership_mgr != NULL) {
         LifetimeActor *deleter = table ? table->deleter() : NULL;
         if (deleter) {
@@ -265,25 +272,40 @@ void IPeerRib::SetRibOutRegistered(bool set) {
     ribout_registered_ = set;
 }
 
+//
+// Add the peer to the entry for the RibOut in the list, creating the entry
+// if needed. The peers in a batch of requests typically share a handful of
+// RibOuts, so a linear search is good enough.
+//
+static void RibOutPeerSetAdd(RibOutPeerSetList *list, RibOut *ribout,
+                             int index) {
+    for (RibOutPeerSetList::iterator it = list->begin();
+         it != list->end(); ++it) {
+        if (it->first == ribout) {
+            it->second.set(index);
+            return;
+        }
+    }
+    list->push_back(std::make_pair(ribout, RibPeerSet()));
+    list->back().second.set(index);
+}
+
 //
 // Process RibOut creation for a particular prefix
 //
 // Concurrency: Runs in the context of db-walker launched from the BGP peer
 // membership task.
 //
-void IPeerRib::RibOutJoin(DBTablePartBase *root, DBEntryBase *db_entry,
-                          BgpTable *table,
-                          MembershipRequest::Action action_mask) {
-    if (!(action_mask & MembershipRequest::RIBOUT_ADD)) {
+// The peer is only added to the join list here. The caller launches a single
+// BgpExport::Join per RibOut once all the peers have been collected.
+//
+void IPeerRib::RibOutJoin(MembershipRequest::Action action_mask,
+                          RibOutPeerSetList *join_list) {
+    if (!(action_mask & MembershipRequest::RIBOUT_ADD) || !ribout_) {
         return;
     }
 
-    RibPeerSet jmask;
-
-    //TODO: For peers with the same export policy, we could combine and
-    // launch one BgpExport::Join
-    jmask.set(ribout_->GetPeerIndex(ipeer_));
-    ribout_->bgp_export()->Join(root, jmask, db_entry);
+    RibOutPeerSetAdd(join_list, ribout_, ribout_->GetPeerIndex(ipeer_));
 }
 
 //
@@ -292,17 +314,16 @@ void IPeerRib::RibOutJoin(DBTablePartBase *root, DBEntryBase *db_entry,
 // Concurrency: Runs in the context of db-walker launched from the BGP peer
 // membership task.
 //
-void IPeerRib::RibOutLeave(DBTablePartBase *root, DBEntryBase *db_entry,
-                           BgpTable *table,
-                           MembershipRequest::Action action_mask) {
-    if (!(action_mask & MembershipRequest::RIBOUT_DELETE)) {
+// As with RibOutJoin, the caller launches a single BgpExport::Leave per
+// RibOut in the leave list.
+//
+void IPeerRib::RibOutLeave(MembershipRequest::Action action_mask,
+                           RibOutPeerSetList *leave_list) {
+    if (!(action_mask & MembershipRequest::RIBOUT_DELETE) || !ribout_) {
         return;
     }
 
-    RibPeerSet lmask;
-    lmask.set(ribout_->GetPeerIndex(ipeer_));
-
-    ribout_->bgp_export()->Leave(root, lmask, db_entry);
+    RibOutPeerSetAdd(leave_list, ribout_, ribout_->GetPeerIndex(ipeer_));
 }
 
 void IPeerRib::ManagedDelete() {
@@ -371,12 +392,10 @@ void PeerRibMembershipManager::Join(BgpTable *table,
 bool PeerRibMembershipManager::RouteJoin(DBTablePartBase *root,
                                          DBEntryBase *db_entry, BgpTable *table,
                                          MembershipRequestList *request_list) {
+    RibOutPeerSetList join_list;
 
     // Iterate through each of the peers in the request list and process RibIn
-    // and RibOut for this peer
-    //
-    // TODO: RibOut can be aggregated into a single call for all peers with the
-    // same export policy
+    // for this peer. Collect the peers per RibOut along the way.
     for (MembershipRequestList::iterator iter = request_list->begin();
              iter != request_list->end(); iter++) {
         MembershipRequest *request = iter.operator->();
@@ -385,10 +404,16 @@ bool PeerRibMembershipManager::RouteJoin(DBTablePartBase *root,
 
         if (peer_rib) {
             peer_rib->RibInJoin(root, db_entry, table, request->action_mask);
-            peer_rib->RibOutJoin(root, db_entry, table, request->action_mask);
+            peer_rib->RibOutJoin(request->action_mask, &join_list);
         }
     }
 
+    // Join all the peers in each RibOut in one shot.
+    for (RibOutPeerSetList::iterator iter = join_list.begin();
+         iter != join_list.end(); ++iter) {
+        iter->first->bgp_export()->Join(root, iter->second, db_entry);
+    }
+
     return true;
 }
 
@@ -421,6 +446,13 @@ void PeerRibMembershipManager::JoinDone(DBTableBase *db,
 void PeerRibMembershipManager::Leave(BgpTable *table,
                               MembershipRequestList *request_list) {
 
+    // Paths from the peers can be cleaned up without walking the table if
+    // none of the requests need to leave the RibOut.
+    if (IsRibInOnly(request_list)) {
+        RibInLeave(table, request_list);
+        return;
+    }
+
     DB *db = table->database();
 
     for (MembershipRequestList::iterator iter = request_list->begin();
@@ -462,6 +494,9 @@ bool PeerRibMembershipManager::RouteLeave(DBTablePartBase *root,
                                           DBEntryBase *db_entry,
                                           BgpTable *table,
                                           MembershipRequestList *request_list) {
+    RibOutPeerSetList leave_list;
+    std::vector<std::pair<IPeerRib *, MembershipRequest::Action> > ribin_list;
+
     for (MembershipRequestList::iterator iter = request_list->begin();
              iter != request_list->end(); iter++) {
         MembershipRequest *request = iter.operator->();
@@ -470,12 +505,125 @@ bool PeerRibMembershipManager::RouteLeave(DBTablePartBase *root,
         if (peer_rib == NULL) {
             continue;
         }
-        peer_rib->RibOutLeave(root, db_entry, table, request->action_mask);
-        peer_rib->RibInLeave(root, db_entry, table, request->action_mask);
+        peer_rib->RibOutLeave(request->action_mask, &leave_list);
+        ribin_list.push_back(std::make_pair(peer_rib, request->action_mask));
+    }
+
+    // Leave the RibOuts before cleaning up the RibIns, as was done for each
+    // peer individually.
+    for (RibOutPeerSetList::iterator iter = leave_list.begin();
+         iter != leave_list.end(); ++iter) {
+        iter->first->bgp_export()->Leave(root, iter->second, db_entry);
+    }
+    for (size_t idx = 0; idx < ribin_list.size(); ++idx) {
+        ribin_list[idx].first->RibInLeave(root, db_entry, table,
+                                          ribin_list[idx].second);
     }
     return true;
 }
 
+//
+// Return true if none of the requests in the list need to leave the RibOut.
+// This is the case for the stale sweep and the stale timer expiry.
+//
+bool PeerRibMembershipManager::IsRibInOnly(
+        MembershipRequestList *request_list) const {
+    for (MembershipRequestList::const_iterator iter = request_list->begin();
+         iter != request_list->end(); ++iter) {
+        if (iter->action_mask & MembershipRequest::RIBOUT_DELETE)
+            return false;
+    }
+    return true;
+}
+
+//
+// State shared by the RibInLeaveTasks for all partitions of a table. The
+// last task to finish posts the UNREGISTER_RIB_COMPLETE event.
+//
+struct PeerRibMembershipManager::RibInLeaveState {
+    RibInLeaveState(BgpTable *table, MembershipRequestList *request_list)
+        : table(table), request_list(request_list) {
+        pending = DB::PartitionCount();
+    }
+
+    BgpTable *table;
+    MembershipRequestList *request_list;
+    tbb::atomic<int> pending;
+};
+
+class PeerRibMembershipManager::RibInLeaveTask : public Task {
+public:
+    RibInLeaveTask(PeerRibMembershipManager *manager, int part_id,
+                   boost::shared_ptr<RibInLeaveState> state)
+        : Task(TaskScheduler::GetInstance()->GetTaskId("db::DBTable"),
+               part_id),
+          manager_(manager),
+          part_id_(part_id),
+          state_(state) {
+    }
+
+    virtual bool Run() {
+        BgpTable *table = state_->table;
+        manager_->PartitionRibInLeave(table->GetTablePartition(part_id_),
+                                      table, state_->request_list);
+        if (state_->pending.fetch_and_decrement() == 1)
+            manager_->LeaveDone(table, state_->request_list);
+        return true;
+    }
+
+private:
+    PeerRibMembershipManager *manager_;
+    int part_id_;
+    boost::shared_ptr<RibInLeaveState> state_;
+};
+
+//
+// Concurrency: Runs in the context of the BGP peer membership task.
+//
+// Clean up the RibIns of the peers in the request list. Instead of walking
+// the whole table, we only visit the routes that have paths from the peers,
+// using the per peer path index maintained by the BgpTable.  A task is run
+// for each partition and the LeaveDone callback is invoked once all of them
+// are done, same as for a table walk.
+//
+void PeerRibMembershipManager::RibInLeave(BgpTable *table,
+        MembershipRequestList *request_list) {
+    boost::shared_ptr<RibInLeaveState> state(
+        new RibInLeaveState(table, request_list));
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    for (int part_id = 0; part_id < DB::PartitionCount(); ++part_id) {
+        scheduler->Enqueue(new RibInLeaveTask(this, part_id, state));
+    }
+}
+
+//
+// Concurrency: Runs in the context of the db::DBTable task for the partition.
+//
+// Close the RibIns of the peers in the request list for all routes in the
+// partition that have paths from the peers.
+//
+void PeerRibMembershipManager::PartitionRibInLeave(DBTablePartBase *root,
+        BgpTable *table, MembershipRequestList *request_list) {
+    CHECK_CONCURRENCY("db::DBTable");
+
+    BgpTable::RouteList route_list;
+    for (MembershipRequestList::iterator iter = request_list->begin();
+         iter != request_list->end(); ++iter) {
+        MembershipRequest *request = iter.operator->();
+        IPeerRib *peer_rib = IPeerRibFind(request->ipeer, table);
+        if (peer_rib == NULL)
+            continue;
+
+        // Get a copy of the routes since the paths in the index get deleted
+        // or replaced as we go along.
+        table->GetPeerRouteList(root, request->ipeer, &route_list);
+        for (BgpTable::RouteList::iterator it = route_list.begin();
+             it != route_list.end(); ++it) {
+            peer_rib->RibInLeave(root, *it, table, request->action_mask);
+        }
+    }
+}
+
 void PeerRibMembershipManager::MembershipRequestListDebug(
     const char *function, int line, BgpTable *table,
     MembershipRequestList *request_list) {
@@ -584,6 +732,7 @@ void PeerRibMembershipManager::Register(
     request.instance_id = instance_id;
     request.policy = policy;
     request.notify_completion_fn = notify_completion_fn;
+    request.request_time = ClockMonotonicUsec();
 
     tbb::mutex::scoped_lock lock(mutex_);
     IPeerRibEvent *event = ProcessRequest(IPeerRibEvent::REGISTER_RIB, table,
@@ -774,14 +923,39 @@ void PeerRibMembershipManager::FillPeerMembershipInfo(const IPeer *peer,
     PeerRibMembershipManager::PeerRibSet::iterator it =
         peer_rib_set_.lower_bound(&peer_rib);
     std::vector<BgpNeighborRoutingTable> table_list;
+    TaskLatencyHistogram join_latency;
     for (;it != peer_rib_set_.end(); it++) {
         if ((*it)->ipeer() != peer) break;
         BgpNeighborRoutingTable table;
         table.set_name((*it)->table()->name());
         table.set_current_state("subscribed");
+        if ((*it)->join_timed()) {
+            table.set_join_latency_usec((*it)->join_latency_usec());
+            join_latency.Add((*it)->join_latency_usec());
+        } else if (!(*it)->joined()) {
+            table.set_current_request("join");
+        }
         table_list.push_back(table);
     }
     if (table_list.size()) resp.set_routing_tables(table_list);
+
+    BgpNeighborJoinLatency latency;
+    latency.set_count(join_latency.count_);
+    latency.set_average_usec(join_latency.count_ ?
+        join_latency.total_usec_ / join_latency.count_ : 0);
+    latency.set_max_usec(join_latency.max_usec_);
+    std::vector<BgpNeighborJoinLatencyBucket> buckets;
+    for (int idx = 0; idx < TaskLatencyHistogram::kBucketCount; idx++) {
+        if (join_latency.buckets_[idx] == 0)
+            continue;
+        BgpNeighborJoinLatencyBucket bucket;
+        bucket.set_lower_bound_usec(
+            TaskLatencyHistogram::BucketLowerBound(idx));
+        bucket.set_count(join_latency.buckets_[idx]);
+        buckets.push_back(bucket);
+    }
+    latency.set_buckets(buckets);
+    resp.set_join_latency(latency);
 }
 
 void PeerRibMembershipManager::FillRegisteredTable(IPeer *peer, 
@@ -926,6 +1100,26 @@ void PeerRibMembershipManager::ProcessRegisterRibEvent(BgpTable *table,
 void PeerRibMembershipManager::ProcessRegisterRibCompleteEvent(
     IPeerRibEvent *event) {
 
+    //
+    // Note down how long each peer waited for its join to complete. This
+    // includes the time spent behind a walk that was already in progress
+    // for the table when the request came in.
+    //
+    uint64_t now = ClockMonotonicUsec();
+    for (MembershipRequestList::iterator iter = event->request_list->begin();
+         iter != event->request_list->end(); iter++) {
+        MembershipRequest *request = iter.operator->();
+        IPeerRib *peer_rib = IPeerRibFind(request->ipeer, event->table);
+        if (!peer_rib)
+            continue;
+        if (request->request_time) {
+            peer_rib->SetJoinLatency(now > request->request_time ?
+                                     now - request->request_time : 0);
+        } else {
+            peer_rib->SetJoined();
+        }
+    }
+
     //
     // Iterate through each request and notify completion
     //
@@ -6,6 +6,8 @@
 #define __BGP_PEER_MEMBERSHIP_H__
 
 #include <set>
+#include <utility>
+#include <vector>
 
 #include "base/lifetime.h"
 #include "base/util.h"
@@ -44,6 +46,7 @@ public:
     IPeer              *ipeer;
     RibExportPolicy     policy;
     int                 instance_id;
+    uint64_t            request_time;   // monotonic usec of the request
 
     typedef boost::function<void(IPeer *ipeer, BgpTable *)> NotifyCompletionFn;
     NotifyCompletionFn  notify_completion_fn;
@@ -95,6 +98,14 @@ struct IPeerRibEvent {
     DISALLOW_COPY_AND_ASSIGN(IPeerRibEvent);
 };
 
+//
+// List of RibOuts and the peers in each of them that a route needs to be
+// joined to or left from. Used to collapse the RibOut processing for all
+// the peers in a batch of membership requests into a single BgpExport call
+// per RibOut for each route.
+//
+typedef std::vector<std::pair<RibOut *, RibPeerSet> > RibOutPeerSetList;
+
 //
 // This class represents the membership of an IPeer in a BgpTable. The
 // result of this membership is a RibOut instance.  An instance of an
@@ -134,16 +145,29 @@ public:
     bool IsRibOutRegistered() const;
     void SetRibOutRegistered(bool set);
 
-    void RibOutJoin(DBTablePartBase *root, DBEntryBase *db_entry,
-                    BgpTable *table, MembershipRequest::Action action_mask);
-    void RibOutLeave(DBTablePartBase *root, DBEntryBase *db_entry,
-                     BgpTable *table, MembershipRequest::Action action_mask);
+    void RibOutJoin(MembershipRequest::Action action_mask,
+                    RibOutPeerSetList *join_list);
+    void RibOutLeave(MembershipRequest::Action action_mask,
+                     RibOutPeerSetList *leave_list);
     
     void ManagedDelete();
 
     int instance_id() const { return instance_id_; }
     void set_instance_id(int instance_id) { instance_id_ = instance_id; }
 
+    // Set once the table walk that advertised the existing routes to the
+    // peer is complete. The join latency is the time taken from the
+    // register request till then, if the request time is known.
+    bool joined() const { return joined_; }
+    void SetJoined() { joined_ = true; }
+    bool join_timed() const { return join_timed_; }
+    uint64_t join_latency_usec() const { return join_latency_usec_; }
+    void SetJoinLatency(uint64_t usec) {
+        joined_ = true;
+        join_timed_ = true;
+        join_latency_usec_ = usec;
+    }
+
 private:
 
     IPeer *ipeer_;
@@ -155,6 +179,9 @@ private:
     bool ribout_registered_;
     bool stale_;
     int instance_id_;       // xmpp peer instance-id
+    bool joined_;
+    bool join_timed_;
+    uint64_t join_latency_usec_;
     DISALLOW_COPY_AND_ASSIGN(IPeerRib);
 };
 
@@ -240,7 +267,14 @@ private:
                    BgpTable *table, MembershipRequestList *request_list);
     void JoinDone(DBTableBase *db, MembershipRequestList *request_list);
 
+    class RibInLeaveTask;
+    struct RibInLeaveState;
+
     void Leave(BgpTable *table, MembershipRequestList *request_list);
+    bool IsRibInOnly(MembershipRequestList *request_list) const;
+    void RibInLeave(BgpTable *table, MembershipRequestList *request_list);
+    void PartitionRibInLeave(DBTablePartBase *root, BgpTable *table,
+                             MembershipRequestList *request_list);
     bool RouteLeave(DBTablePartBase *root, DBEntryBase *db_entry,
                     BgpTable *table, MembershipRequestList *request_list);
     void LeaveDone(DBTableBase *db, MembershipRequestList *request_list);
@@ -9,6 +9,7 @@
 #include "bgp/bgp_common.h"
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_peer.h"
+#include "bgp/bgp_update_reader.h"
 #include "bgp_server.h"
 #include "net/bgp_af.h"
 
@@ -206,6 +207,9 @@ struct BgpAttrCodeCompare {
 //Returns 0 if message is OK
 //Returns one of the values from enum UpdateMsgSubCode if an error is detected
 int BgpProto::Update::Validate(const BgpPeer *peer, std::string &data) {
+    if (reader)
+        return reader->Validate(peer, &data);
+
     BgpAttrCodeCompare comp;
     std::sort(path_attributes.begin(), path_attributes.end(), comp);
     bool origin = false, nh = false, as_path = false, mp_reach_nlri = false,
@@ -334,9 +338,10 @@ public:
     typedef Offset SaveOffset;
     static bool Verifier(const void *obj, const uint8_t *data, size_t size,
                          ParseContext *context) {
+        // The limit for the peer is enforced by BgpPeer::ReceiveMsg.
         int value = get_short(data);
         if (value < BgpProto::kMinMessageSize ||
-            value > BgpProto::kMaxMessageSize) {
+            value > BgpProto::kMaxExtendedMessageSize) {
             return false;
         }
         if ((size_t) value < context->offset() + size) {
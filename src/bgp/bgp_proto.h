@@ -5,12 +5,15 @@
 #ifndef __BGP_BGP_PROTO_H__
 #define __BGP_BGP_PROTO_H__
 
+#include <boost/scoped_ptr.hpp>
+
 #include "base/parse_object.h"
 #include "bgp/bgp_attr.h"
 #include "bgp/community.h"
 
 struct BgpMpNlri;
 class BgpPeer;
+class BgpUpdateReader;
 
 class BgpProto {
 public:
@@ -52,6 +55,7 @@ public:
                 OutboundRouteFiltering = 3,
                 MultipleRoutesToADestination = 4,
                 ExtendedNextHop = 5,
+                ExtendedMessage = 6,
                 GracefulRestart = 64,
                 AS4Support = 65,
                 Dynamic = 67,
@@ -71,6 +75,8 @@ public:
                         return "MultipleRoutesToADestination";
                     case ExtendedNextHop:
                         return "ExtendedNextHop";
+                    case ExtendedMessage:
+                        return "ExtendedMessage";
                     case GracefulRestart:
                         return "GracefulRestart";
                     case AS4Support:
@@ -313,11 +319,19 @@ public:
         std::vector <BgpProtoPrefix *> withdrawn_routes;
         std::vector <BgpAttribute *> path_attributes;
         std::vector <BgpProtoPrefix *> nlri;
+
+        // Copy of the message and the reader that parsed it, if it was
+        // decoded by BgpUpdateReader. The vectors above are empty in that
+        // case.
+        std::vector<uint8_t> raw;
+        boost::scoped_ptr<BgpUpdateReader> reader;
         static int EncodeData(Update *msg, uint8_t *data, size_t size);
     };
 
     static const int kMinMessageSize = 19;
     static const int kMaxMessageSize = 4096;
+    // Applies to UPDATEs when the ExtendedMessage capability is negotiated.
+    static const int kMaxExtendedMessageSize = 65535;
 
     static BgpMessage *Decode(const uint8_t *data, size_t size,
                               ParseErrorContext *ec = NULL);
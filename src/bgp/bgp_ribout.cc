@@ -50,6 +50,12 @@ bool RibExportPolicy::operator<(const RibExportPolicy &rhs) const {
     if (cluster_id > rhs.cluster_id) {
         return false;
     }
+    if (extended_message < rhs.extended_message) {
+        return true;
+    }
+    if (extended_message > rhs.extended_message) {
+        return false;
+    }
     return false;
 }
 
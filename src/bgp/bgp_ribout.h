@@ -233,13 +233,15 @@ struct RibExportPolicy {
     
     RibExportPolicy()
         : type(BgpProto::IBGP), encoding(BGP),
-          as_number(0), affinity(-1), cluster_id(0) {
+          as_number(0), affinity(-1), cluster_id(0),
+          extended_message(false) {
     }
 
     RibExportPolicy(BgpProto::BgpPeerType type, Encoding encoding,
             int affinity, u_int32_t cluster_id)
         : type(type), encoding(encoding), as_number(0),
-          affinity(affinity), cluster_id(cluster_id) {
+          affinity(affinity), cluster_id(cluster_id),
+          extended_message(false) {
         if (encoding == XMPP)
             assert(type == BgpProto::XMPP);
         if (encoding == BGP)
@@ -249,7 +251,8 @@ struct RibExportPolicy {
     RibExportPolicy(BgpProto::BgpPeerType type, Encoding encoding,
             as_t as_number, int affinity, u_int32_t cluster_id)
         : type(type), encoding(encoding), as_number(as_number),
-          affinity(affinity), cluster_id(cluster_id) {
+          affinity(affinity), cluster_id(cluster_id),
+          extended_message(false) {
         if (encoding == XMPP)
             assert(type == BgpProto::XMPP);
         if (encoding == BGP)
@@ -263,6 +266,9 @@ struct RibExportPolicy {
     as_t as_number;
     int affinity;
     uint32_t cluster_id;
+    // Peers that negotiated the extended message capability get UPDATEs
+    // of up to 64K.
+    bool extended_message;
 };
 
 //
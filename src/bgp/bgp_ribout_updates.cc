@@ -26,7 +26,7 @@ RibOutUpdates::RibOutUpdates(RibOut *ribout) : ribout_(ribout) {
         queue_vec_.push_back(queue);
     }
     monitor_.reset(new RibUpdateMonitor(ribout, &queue_vec_));
-    builder_ = MessageBuilder::GetInstance(ribout->ExportPolicy().encoding);
+    builder_ = MessageBuilder::GetInstance(ribout->ExportPolicy());
 }
 
 //
@@ -106,14 +106,22 @@ bool RibOutUpdates::DequeueCommon(UpdateMarker *marker, RouteUpdate *rt_update,
         }
 
         // Generate the update and merge additional updates into that message.
+        // Skip the route if it doesn't fit in a message by itself, but clear
+        // the bits anyway so that it doesn't stay in the queue.
         auto_ptr<Message> message(
             builder_->Create(table, &uinfo->roattr, rt_update->route()));
-        UpdatePack(rt_update->queue_id(), message.get(), uinfo, msgset);
-        message->Finish();
-
-        // Send the message to the target RibPeerSet.
         RibPeerSet msg_blocked;
-        UpdateSend(message.get(), msgset, &msg_blocked);
+        if (message.get() != NULL) {
+            UpdatePack(rt_update->queue_id(), message.get(), uinfo, msgset);
+            message->Finish();
+
+            // Send the message to the target RibPeerSet.
+            UpdateSend(message.get(), msgset, &msg_blocked);
+        } else {
+            BGP_LOG_STR(BgpMessage, SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
+                        "Route " << rt_update->route()->ToString() <<
+                        " too large to fit in an update message");
+        }
 
         // Reset bits in the UpdateInfo.  Note that this has already been done
         // via UpdatePack for all the other UpdateInfo elements that we packed
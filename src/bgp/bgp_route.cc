@@ -20,7 +20,9 @@
 #include "bgp/tunnel_encap/tunnel_encap.h"
 
 
-BgpRoute::BgpRoute() {
+tbb::atomic<uint32_t> BgpRoute::global_path_order_gen_;
+
+BgpRoute::BgpRoute() : path_order_gen_(global_path_order_gen_) {
 }
 
 BgpRoute::~BgpRoute() {
@@ -34,30 +36,102 @@ const BgpPath *BgpRoute::BestPath() const {
     return path;
 }
 
+//
+// Check if the path is the best path or is ECMP-equal to it. Listeners only
+// look at such paths, so changes to other paths don't need to be notified.
+//
+bool BgpRoute::IsEcmpPath(const BgpPath *path) const {
+    const BgpPath *best_path = BestPath();
+    return (best_path == path || best_path->PathCompare(*path, true) == 0);
+}
+
+//
+// MED is compared only between paths from the same neighbor AS, so the order
+// isn't transitive when the paths come from different neighbor ASes and the
+// MEDs differ. The position of a new path can't be found by comparing it to
+// the paths around it in that case.
+//
+bool BgpRoute::IsMedOrderDependent(const BgpPath *path) const {
+    const BgpAttr *attr = path->GetAttr();
+    bool neighbor_as_differs = false;
+    bool med_differs = false;
+    for (Route::PathList::const_iterator it = GetPathList().begin();
+         it != GetPathList().end(); ++it) {
+        const BgpPath *other = static_cast<const BgpPath *>(it.operator->());
+        const BgpAttr *other_attr = other->GetAttr();
+        if (other_attr->neighbor_as() != attr->neighbor_as())
+            neighbor_as_differs = true;
+        if (other_attr->med() != attr->med())
+            med_differs = true;
+        if (neighbor_as_differs && med_differs)
+            return true;
+    }
+    return false;
+}
+
+//
+// Path selection breaks ties using the type, the BGP identifier and the key
+// of the peer, which can change while its paths are on the path lists, e.g.
+// across a graceful restart. Path lists that were sorted before such a change
+// are sorted again the next time a path is added or deleted.
+//
+void BgpRoute::InvalidatePathOrder() {
+    global_path_order_gen_++;
+}
+
 //
 // Insert given path and redo path selection.
 //
-void BgpRoute::InsertPath(BgpPath *path) {
+// The path list is kept sorted, so the path is inserted at its position
+// instead of sorting the whole list, unless MED makes the order depend on
+// more than the paths around it or the list may be out of order. Return
+// true if the best path or the set of paths that are ECMP-equal to it
+// changed.
+//
+bool BgpRoute::InsertPath(BgpPath *path) {
     const Path *prev_front = front();
 
-    insert(path);
-
-    Sort(&BgpTable::PathSelection, prev_front);
+    uint32_t gen = global_path_order_gen_;
+    if (path_order_gen_ != gen || IsMedOrderDependent(path)) {
+        insert(path);
+        Sort(&BgpTable::PathSelection, prev_front);
+        path_order_gen_ = gen;
+    } else {
+        insert(path, &BgpTable::PathSelection);
+        if (prev_front != front())
+            set_last_change_at_to_now();
+    }
+    bool changed = (prev_front != front() || IsEcmpPath(path));
 
     // Update counters.
     BgpTable *table = static_cast<BgpTable *>(get_table());
     if (table) table->UpdatePathCount(path, +1);
     path->UpdatePeerRefCount(+1);
+
+    return changed;
 }
 
 //
 // Delete given path and redo path selection.
 //
-void BgpRoute::DeletePath(BgpPath *path) {
+// Removing a path leaves the rest of the list sorted, except when MED makes
+// the order depend on the path or the list may be out of order. Return true
+// if the best path or the set of paths that are ECMP-equal to it changed.
+//
+bool BgpRoute::DeletePath(BgpPath *path) {
     const Path *prev_front = front();
+    bool changed = IsEcmpPath(path);
+    uint32_t gen = global_path_order_gen_;
+    bool sort = (path_order_gen_ != gen || IsMedOrderDependent(path));
 
     remove(path);
-    Sort(&BgpTable::PathSelection, prev_front);
+    if (sort) {
+        Sort(&BgpTable::PathSelection, prev_front);
+        path_order_gen_ = gen;
+    } else if (prev_front != front()) {
+        set_last_change_at_to_now();
+    }
+    changed |= (prev_front != front());
 
     // Update counters.
     BgpTable *table = static_cast<BgpTable *>(get_table());
@@ -65,6 +139,7 @@ void BgpRoute::DeletePath(BgpPath *path) {
     path->UpdatePeerRefCount(-1);
 
     delete path;
+    return changed;
 }
 
 //
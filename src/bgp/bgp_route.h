@@ -5,6 +5,8 @@
 #ifndef ctrlplane_bgp_route_h
 #define ctrlplane_bgp_route_h
 
+#include <tbb/atomic.h>
+
 #include "route/route.h"
 #include "net/address.h"
 #include "bgp/bgp_path.h"
@@ -22,8 +24,13 @@ public:
 
     const BgpPath *BestPath() const;
 
-    void InsertPath(BgpPath *path);
-    void DeletePath(BgpPath *path);
+    bool InsertPath(BgpPath *path);
+    bool DeletePath(BgpPath *path);
+    bool IsEcmpPath(const BgpPath *path) const;
+    bool IsMedOrderDependent(const BgpPath *path) const;
+
+    // Called when a peer property that path selection looks at changes.
+    static void InvalidatePathOrder();
 
     BgpPath *FindPath(BgpPath::PathSource src, const IPeer *peer,
                       uint32_t path_id);
@@ -63,6 +70,10 @@ public:
     // Fill info needed for introspect
     void FillRouteInfo(BgpTable *table, ShowRoute *show_route);
 private:
+    static tbb::atomic<uint32_t> global_path_order_gen_;
+
+    // Value of global_path_order_gen_ when the path list was last sorted.
+    uint32_t path_order_gen_;
 
     DISALLOW_COPY_AND_ASSIGN(BgpRoute);
 };
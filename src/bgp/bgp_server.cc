@@ -219,6 +219,7 @@ bool BgpServer::IsReadyForDeletion() {
 
 BgpServer::BgpServer(EventManager *evm)
     : autonomous_system_(0), bgp_identifier_(0), hold_time_(0),
+      extended_message_(false),
       lifetime_manager_(new BgpLifetimeManager(this,
           TaskScheduler::GetInstance()->GetTaskId("bgp::Config"))),
       deleter_(new DeleteActor(this)),
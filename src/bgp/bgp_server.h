@@ -101,6 +101,10 @@ public:
     uint32_t bgp_identifier() const { return bgp_identifier_.to_ulong(); };
     uint16_t hold_time() const { return hold_time_; }
 
+    // Advertise the extended message capability to BGP peers.
+    bool extended_message() const { return extended_message_; }
+    void set_extended_message(bool enable) { extended_message_ = enable; }
+
     // Status
     uint32_t num_routing_instance() const;
     uint32_t num_bgp_peer() const {
@@ -142,6 +146,7 @@ private:
     boost::dynamic_bitset<> bmap_;      // free list.
     Ip4Address bgp_identifier_;
     uint16_t hold_time_;
+    bool extended_message_;
 
     DB db_;
     boost::dynamic_bitset<> peer_bmap_;
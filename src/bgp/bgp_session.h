@@ -31,7 +31,9 @@ protected:
 
 private:
     static const int kHeaderLenSize = 18;
-    static const int kMaxMessageSize = 4096;
+    // Messages up to the extended size are passed up to the peer, which
+    // checks them against the negotiated limit.
+    static const int kMaxMessageSize = BgpProto::kMaxExtendedMessageSize;
 
     DISALLOW_COPY_AND_ASSIGN(BgpMessageReader);
 };
@@ -4,12 +4,15 @@
 
 #include "bgp/bgp_table.h"
 
+#include <algorithm>
+
 #include <boost/foreach.hpp>
 #include "base/task_annotations.h"
 
 #include <sandesh/sandesh_types.h>
 #include <sandesh/sandesh.h>
 
+#include "db/db.h"
 #include "db/db_table_partition.h"
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_path.h"
@@ -59,6 +62,7 @@ class BgpTable::DeleteActor : public LifetimeActor {
 BgpTable::BgpTable(DB *db, const string &name)
         : RouteTable(db, name),
           rtinstance_(NULL),
+          peer_path_maps_(DB::PartitionCount()),
           instance_delete_ref_(this, NULL) {
     primary_path_count_ = 0;
     secondary_path_count_ = 0;
@@ -71,6 +75,11 @@ BgpTable::~BgpTable() {
     // destroy the DeleteActor which can have its Delete() method be called
     // via the reference.
     instance_delete_ref_.Reset(NULL);
+
+    for (std::vector<PeerPathMap>::iterator it = peer_path_maps_.begin();
+         it != peer_path_maps_.end(); ++it) {
+        STLDeleteElements(&(*it));
+    }
 }
 
 // TODO: Fix BgpTable creation to pass in instance argument in the constructor
@@ -253,7 +262,9 @@ void BgpTable::InputCommon(DBTablePartBase *root, BgpRoute *rt, BgpPath *path,
 
         assert(rt);
 
-        // The entry may currently be marked as deleted.
+        // The entry may currently be marked as deleted. Listeners must see
+        // it again even if the best path does not change.
+        bool notify = rt->IsDeleted();
         rt->ClearDelete();
 
         // Check whether peer already has a path
@@ -263,7 +274,7 @@ void BgpTable::InputCommon(DBTablePartBase *root, BgpRoute *rt, BgpPath *path,
                 (path->GetLabel() != label)) {
                 // Update Attributes and notify (if needed)
                 is_stale = path->IsStale();
-                rt->DeletePath(path);
+                notify |= rt->DeletePath(path);
             } else {
 
                 //
@@ -284,8 +295,13 @@ void BgpTable::InputCommon(DBTablePartBase *root, BgpRoute *rt, BgpPath *path,
             new_path->SetStale();
         }
 
-        rt->InsertPath(new_path);
-        root->Notify(rt);
+        // Skip the notification if neither the best path nor the paths that
+        // are ECMP-equal to it changed, since listeners ignore the others.
+        notify |= rt->InsertPath(new_path);
+        if (peer)
+            AddPeerPath(root, rt, new_path);
+        if (notify)
+            root->Notify(rt);
         break;
     }
 
@@ -295,12 +311,15 @@ void BgpTable::InputCommon(DBTablePartBase *root, BgpRoute *rt, BgpPath *path,
                           "Delete BGP path");
 
             // Remove the Path from the route
-            rt->RemovePath(BgpPath::BGP_XMPP, peer, path_id);
+            BgpPath *del_path = rt->FindPath(BgpPath::BGP_XMPP, peer, path_id);
+            bool notify = del_path ? rt->DeletePath(del_path) : false;
+            if (del_path && peer)
+                RemovePeerPathList(root, peer);
 
             if (rt->front() == NULL) {
                 // Delete the route only if all paths are gone
                 root->Delete(rt);
-            } else {
+            } else if (notify) {
                root->Notify(rt);
             }
         }
@@ -476,6 +495,77 @@ const LifetimeActor *BgpTable::deleter() const {
     return deleter_.get();
 }
 
+//
+// Link the path in the list of paths from its peer in the given partition.
+//
+void BgpTable::AddPeerPath(DBTablePartBase *root, BgpRoute *rt,
+                           BgpPath *path) {
+    PeerPathMap &peer_path_map = peer_path_maps_[root->index()];
+    PeerPathMap::iterator loc = peer_path_map.find(path->GetPeer());
+    if (loc == peer_path_map.end()) {
+        loc = peer_path_map.insert(
+            make_pair(path->GetPeer(), new PeerPathList)).first;
+    }
+    path->set_route(rt);
+    loc->second->push_back(*path);
+}
+
+//
+// Get rid of the list of paths from the given peer in the partition if it's
+// empty. Paths unlink themselves from the list when they are deleted.
+//
+void BgpTable::RemovePeerPathList(DBTablePartBase *root, const IPeer *peer) {
+    PeerPathMap &peer_path_map = peer_path_maps_[root->index()];
+    PeerPathMap::iterator loc = peer_path_map.find(peer);
+    if (loc == peer_path_map.end() || !loc->second->empty())
+        return;
+    delete loc->second;
+    peer_path_map.erase(loc);
+}
+
+//
+// Fill in the routes in the given partition that have primary paths from the
+// given peer. Each route shows up only once, even if the peer has multiple
+// paths for it.
+//
+void BgpTable::GetPeerRouteList(DBTablePartBase *root, const IPeer *peer,
+                                RouteList *route_list) {
+    CHECK_CONCURRENCY("db::DBTable");
+
+    route_list->clear();
+    PeerPathMap &peer_path_map = peer_path_maps_[root->index()];
+    PeerPathMap::iterator loc = peer_path_map.find(peer);
+    if (loc == peer_path_map.end())
+        return;
+    if (loc->second->empty()) {
+        RemovePeerPathList(root, peer);
+        return;
+    }
+
+    for (PeerPathList::iterator it = loc->second->begin();
+         it != loc->second->end(); ++it) {
+        route_list->push_back(it->route());
+    }
+    sort(route_list->begin(), route_list->end());
+    route_list->erase(unique(route_list->begin(), route_list->end()),
+                      route_list->end());
+}
+
+//
+// Get the number of primary paths from the given peer across all partitions.
+// Intended for use in unit tests and introspect.
+//
+size_t BgpTable::GetPeerPathCount(const IPeer *peer) const {
+    size_t count = 0;
+    for (std::vector<PeerPathMap>::const_iterator it =
+         peer_path_maps_.begin(); it != peer_path_maps_.end(); ++it) {
+        PeerPathMap::const_iterator loc = it->find(peer);
+        if (loc != it->end())
+            count += loc->second->size();
+    }
+    return count;
+}
+
 void BgpTable::UpdatePathCount(const BgpPath *path, int count) {
     if (dynamic_cast<const BgpSecondaryPath *>(path)) {
         secondary_path_count_ += count;
@@ -6,6 +6,9 @@
 #define ctrlplane_bgp_table_h
 
 #include <map>
+#include <vector>
+
+#include <boost/intrusive/list.hpp>
 #include <tbb/atomic.h>
 
 #include "base/lifetime.h"
@@ -28,6 +31,7 @@ struct UpdateInfo;
 class BgpTable : public RouteTable {
 public:
     typedef std::map<RibExportPolicy, RibOut *> RibOutMap;
+    typedef std::vector<BgpRoute *> RouteList;
 
     struct RequestKey : DBRequestKey {
         virtual const IPeer *GetPeer() const = 0;
@@ -113,6 +117,12 @@ public:
     const LifetimeActor *deleter() const;
     size_t GetPendingRiboutsCount(size_t &markers);
 
+    // Routes in the given partition that have paths from the given peer.
+    // Must be called from the db::DBTable task for the partition.
+    void GetPeerRouteList(DBTablePartBase *root, const IPeer *peer,
+                          RouteList *route_list);
+    size_t GetPeerPathCount(const IPeer *peer) const;
+
     void UpdatePathCount(const BgpPath *path, int count);
     const uint64_t GetPrimaryPathCount() const { return primary_path_count_; }
     const uint64_t GetSecondaryPathCount() const {
@@ -125,11 +135,25 @@ public:
 private:
     class DeleteActor;
     friend class BgpTableTest;
+
+    typedef boost::intrusive::member_hook<BgpPath, BgpPath::PeerPathHook,
+        &BgpPath::peer_node_> PeerPathMember;
+    typedef boost::intrusive::list<BgpPath, PeerPathMember,
+        boost::intrusive::constant_time_size<false> > PeerPathList;
+    typedef std::map<const IPeer *, PeerPathList *> PeerPathMap;
+
+    void AddPeerPath(DBTablePartBase *root, BgpRoute *rt, BgpPath *path);
+    void RemovePeerPathList(DBTablePartBase *root, const IPeer *peer);
+
     virtual BgpRoute *TableFind(DBTablePartition *rtp,
             const DBRequestKey *prefix) = 0;
     RoutingInstance *rtinstance_;
     RibOutMap ribout_map_;
 
+    // Per partition index of the primary paths from each peer, so that the
+    // paths from a peer can be cleaned up without walking the whole table.
+    std::vector<PeerPathMap> peer_path_maps_;
+
     boost::scoped_ptr<DeleteActor> deleter_;
     LifetimeRef<BgpTable> instance_delete_ref_;
     tbb::atomic<uint64_t> primary_path_count_;
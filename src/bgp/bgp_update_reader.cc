@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "bgp/bgp_update_reader.h"
+
+#include <memory>
+
+#include "base/parse_object.h"
+#include "bgp/bgp_peer.h"
+#include "net/address.h"
+#include "net/bgp_af.h"
+#include "net/rd.h"
+
+using std::string;
+
+//
+// Make sure that the section consists of a whole number of prefixes, each of
+// which has a length that's sane for the address family. The route code does
+// not expect anything else.
+//
+bool BgpUpdateReader::PrefixIterator::Verify(int min_bits, int max_bits) const {
+    const uint8_t *data = data_;
+    while (data < end_) {
+        int bits = data[0];
+        if (bits < min_bits || bits > max_bits)
+            return false;
+        size_t bytes = (bits + 7) / 8;
+        if (static_cast<size_t>(end_ - data) < 1 + bytes)
+            return false;
+        data += 1 + bytes;
+    }
+    return true;
+}
+
+bool BgpUpdateReader::PrefixIterator::Next(BgpProtoPrefix *prefix) {
+    if (data_ == end_)
+        return false;
+    int bits = data_[0];
+    size_t bytes = (bits + 7) / 8;
+    prefix->prefixlen = bits;
+    prefix->prefix.assign(data_ + 1, data_ + 1 + bytes);
+    data_ += 1 + bytes;
+    return true;
+}
+
+BgpUpdateReader::BgpUpdateReader(const uint8_t *data, size_t size)
+    : data_(data),
+      size_(size),
+      present_(0),
+      as_path_data_(NULL),
+      as_path_size_(0),
+      communities_data_(NULL),
+      communities_size_(0),
+      ext_communities_data_(NULL),
+      ext_communities_size_(0) {
+}
+
+//
+// Parse the message header, the withdrawn routes, the path attributes and
+// the NLRI in that order. Any deviation from what the generic parser would
+// accept, or anything that's uncommon, results in the message being left
+// to the generic parser.
+//
+bool BgpUpdateReader::Parse() {
+    static const size_t kMarkerSize = 16;
+    if (size_ < BgpProto::kMinMessageSize + 4 ||
+        size_ > BgpProto::kMaxExtendedMessageSize)
+        return false;
+    for (size_t idx = 0; idx < kMarkerSize; ++idx) {
+        if (data_[idx] != 0xff)
+            return false;
+    }
+    if (get_short(data_ + kMarkerSize) != size_)
+        return false;
+    if (data_[kMarkerSize + 2] != BgpProto::UPDATE)
+        return false;
+
+    const uint8_t *data = data_ + BgpProto::kMinMessageSize;
+    const uint8_t *end = data_ + size_;
+
+    size_t withdrawn_size = get_short(data);
+    data += 2;
+    if (static_cast<size_t>(end - data) < withdrawn_size)
+        return false;
+    withdrawn_routes_ = PrefixIterator(data, data + withdrawn_size);
+    if (!withdrawn_routes_.Verify(0, Address::kMaxV4PrefixLen))
+        return false;
+    data += withdrawn_size;
+
+    if (end - data < 2)
+        return false;
+    size_t attr_size = get_short(data);
+    data += 2;
+    if (static_cast<size_t>(end - data) < attr_size)
+        return false;
+
+    const uint8_t *attr_end = data + attr_size;
+    while (data < attr_end) {
+        if (attr_end - data < 3)
+            return false;
+        uint8_t flags = data[0];
+        uint8_t code = data[1];
+        size_t size;
+        if (flags & BgpAttribute::ExtendedLength) {
+            if (attr_end - data < 4)
+                return false;
+            size = get_short(data + 2);
+            data += 4;
+        } else {
+            size = data[2];
+            data += 3;
+        }
+        if (static_cast<size_t>(attr_end - data) < size)
+            return false;
+        if (!ParseAttribute(flags, code, data, size))
+            return false;
+        data += size;
+    }
+
+    nlri_ = PrefixIterator(attr_end, end);
+    return nlri_.Verify(0, Address::kMaxV4PrefixLen);
+}
+
+bool BgpUpdateReader::ParseAttribute(uint8_t flags, uint8_t code,
+                                     const uint8_t *value, size_t size) {
+    // Leave duplicates to the generic parser and Validate.
+    if (code >= 32 || IsPresent(code))
+        return false;
+
+    uint8_t type_flags = flags & BgpAttribute::FLAG_MASK;
+    switch (code) {
+    case BgpAttribute::Origin:
+        if (size != BgpAttrOrigin::kSize ||
+            type_flags != BgpAttrOrigin::kFlags ||
+            value[0] > BgpAttrOrigin::INCOMPLETE)
+            return false;
+        origin_.flags = flags;
+        origin_.origin = value[0];
+        break;
+
+    case BgpAttribute::NextHop:
+        if (size != BgpAttrNextHop::kSize ||
+            type_flags != BgpAttrNextHop::kFlags)
+            return false;
+        nexthop_.flags = flags;
+        nexthop_.nexthop = get_value(value, BgpAttrNextHop::kSize);
+        if (nexthop_.nexthop == 0)
+            return false;
+        break;
+
+    case BgpAttribute::MultiExitDisc:
+        if (size != BgpAttrMultiExitDisc::kSize ||
+            type_flags != BgpAttrMultiExitDisc::kFlags)
+            return false;
+        med_.flags = flags;
+        med_.med = get_value(value, BgpAttrMultiExitDisc::kSize);
+        break;
+
+    case BgpAttribute::LocalPref:
+        if (size != BgpAttrLocalPref::kSize ||
+            type_flags != BgpAttrLocalPref::kFlags)
+            return false;
+        local_pref_.flags = flags;
+        local_pref_.local_pref = get_value(value, BgpAttrLocalPref::kSize);
+        break;
+
+    case BgpAttribute::AtomicAggregate:
+        if (size != 0 || flags != BgpAttrAtomicAggregate::kFlags)
+            return false;
+        atomic_aggregate_.flags = flags;
+        break;
+
+    case BgpAttribute::Aggregator:
+        if (size != BgpAttrAggregator::kSize ||
+            type_flags != BgpAttrAggregator::kFlags)
+            return false;
+        aggregator_.flags = flags;
+        aggregator_.as_num = get_value(value, 2);
+        aggregator_.address = get_value(value + 2, 4);
+        break;
+
+    case BgpAttribute::OriginatorId:
+        if (size != BgpAttrOriginatorId::kSize ||
+            type_flags != BgpAttrOriginatorId::kFlags)
+            return false;
+        originator_id_.flags = flags;
+        originator_id_.originator_id =
+            get_value(value, BgpAttrOriginatorId::kSize);
+        break;
+
+    case BgpAttribute::AsPath: {
+        if (type_flags != AsPathSpec::kFlags)
+            return false;
+        const uint8_t *data = value;
+        const uint8_t *end = value + size;
+        while (data < end) {
+            if (end - data < 2)
+                return false;
+            size_t segment_size = 2 + data[1] * sizeof(as_t);
+            if (static_cast<size_t>(end - data) < segment_size)
+                return false;
+            data += segment_size;
+        }
+        as_path_.flags = flags;
+        as_path_data_ = value;
+        as_path_size_ = size;
+        break;
+    }
+
+    case BgpAttribute::Communities:
+        if (type_flags != CommunitySpec::kFlags ||
+            size % sizeof(uint32_t) != 0)
+            return false;
+        communities_.flags = flags;
+        communities_data_ = value;
+        communities_size_ = size;
+        break;
+
+    case BgpAttribute::ExtendedCommunities:
+        if (type_flags != ExtCommunitySpec::kFlags ||
+            size % sizeof(uint64_t) != 0)
+            return false;
+        ext_communities_.flags = flags;
+        ext_communities_data_ = value;
+        ext_communities_size_ = size;
+        break;
+
+    case BgpAttribute::MPReachNlri:
+        if (type_flags != BgpMpNlri::kFlags ||
+            !ParseMpNlri(code, value, size, &mp_reach_nlri_))
+            return false;
+        break;
+
+    case BgpAttribute::MPUnreachNlri:
+        if (type_flags != BgpMpNlri::kFlags ||
+            !ParseMpNlri(code, value, size, &mp_unreach_nlri_))
+            return false;
+        break;
+
+    default:
+        return false;
+    }
+
+    present_ |= (1U << code);
+    return true;
+}
+
+//
+// Only the families whose NLRI is a plain list of prefixes are handled.
+//
+bool BgpUpdateReader::ParseMpNlri(uint8_t code, const uint8_t *value,
+                                  size_t size, MpNlri *mp_nlri) {
+    const uint8_t *data = value;
+    const uint8_t *end = value + size;
+
+    if (size < 3)
+        return false;
+    mp_nlri->afi = get_value(data, 2);
+    mp_nlri->safi = data[2];
+    data += 3;
+
+    // Prefix length and nexthop size for each of the supported families.
+    // VPN prefixes carry a label and a route distinguisher.
+    static const int kVpnBits = (3 + RouteDistinguisher::kSize) * 8;
+    int min_bits, max_bits;
+    size_t nexthop_size;
+    if (mp_nlri->afi == BgpAf::IPv4 && mp_nlri->safi == BgpAf::Unicast) {
+        min_bits = 0;
+        max_bits = Address::kMaxV4PrefixLen;
+        nexthop_size = Address::kMaxV4Bytes;
+    } else if (mp_nlri->afi == BgpAf::IPv4 && mp_nlri->safi == BgpAf::Vpn) {
+        min_bits = kVpnBits;
+        max_bits = kVpnBits + Address::kMaxV4PrefixLen;
+        nexthop_size = RouteDistinguisher::kSize + Address::kMaxV4Bytes;
+    } else if (mp_nlri->afi == BgpAf::IPv6 && mp_nlri->safi == BgpAf::Vpn) {
+        min_bits = kVpnBits;
+        max_bits = kVpnBits + Address::kMaxV6PrefixLen;
+        nexthop_size = RouteDistinguisher::kSize + Address::kMaxV6Bytes;
+    } else {
+        return false;
+    }
+
+    if (code == BgpAttribute::MPReachNlri) {
+        // Nexthop length, nexthop and the reserved byte.
+        if (end - data < 1 || data[0] != nexthop_size ||
+            static_cast<size_t>(end - data) < 1 + nexthop_size + 1)
+            return false;
+        mp_nlri->nexthop_size = nexthop_size;
+        mp_nlri->nexthop = data + 1;
+        data += 1 + nexthop_size + 1;
+    }
+
+    mp_nlri->prefixes = PrefixIterator(data, end);
+    mp_nlri->present = true;
+    return mp_nlri->prefixes.Verify(min_bits, max_bits);
+}
+
+//
+// Same checks as BgpProto::Update::Validate. Duplicate attributes are not
+// accepted by Parse() to start with.
+//
+int BgpUpdateReader::Validate(const BgpPeer *peer, string *data) const {
+    bool ibgp = (peer->PeerType() == BgpProto::IBGP);
+
+    // IBGP can have an empty path for routes that are originated.
+    if (IsPresent(BgpAttribute::AsPath) && !ibgp) {
+        if (!as_path_size_ || !as_path_data_[1])
+            return BgpProto::Notification::MalformedASPath;
+    }
+
+    char attrib_type = 0;
+    bool nlri = !nlri_.empty();
+    if (nlri && !IsPresent(BgpAttribute::NextHop)) {
+        attrib_type = BgpAttribute::NextHop;
+    } else if (nlri || mp_reach_nlri_.present) {
+        if (!IsPresent(BgpAttribute::Origin)) {
+            attrib_type = BgpAttribute::Origin;
+        } else if (!IsPresent(BgpAttribute::AsPath)) {
+            attrib_type = BgpAttribute::AsPath;
+        } else if (ibgp && !IsPresent(BgpAttribute::LocalPref)) {
+            attrib_type = BgpAttribute::LocalPref;
+        }
+    }
+
+    if (attrib_type) {
+        *data = string(&attrib_type, 1);
+        return BgpProto::Notification::MissingWellKnownAttrib;
+    }
+    return 0;
+}
+
+//
+// Fill in the spec with the attributes in the message. The spec points to
+// members of the reader and must not outlive it.
+//
+void BgpUpdateReader::GetAttrSpec(BgpAttrSpec *spec) {
+    if (IsPresent(BgpAttribute::Origin))
+        spec->push_back(&origin_);
+
+    if (IsPresent(BgpAttribute::AsPath)) {
+        STLDeleteValues(&as_path_.path_segments);
+        const uint8_t *data = as_path_data_;
+        const uint8_t *end = as_path_data_ + as_path_size_;
+        while (data < end) {
+            AsPathSpec::PathSegment *ps = new AsPathSpec::PathSegment;
+            ps->path_segment_type = data[0];
+            size_t count = data[1];
+            data += 2;
+            ps->path_segment.reserve(count);
+            for (size_t idx = 0; idx < count; ++idx) {
+                ps->path_segment.push_back(get_value(data, sizeof(as_t)));
+                data += sizeof(as_t);
+            }
+            as_path_.path_segments.push_back(ps);
+        }
+        spec->push_back(&as_path_);
+    }
+
+    if (IsPresent(BgpAttribute::NextHop))
+        spec->push_back(&nexthop_);
+    if (IsPresent(BgpAttribute::MultiExitDisc))
+        spec->push_back(&med_);
+    if (IsPresent(BgpAttribute::LocalPref))
+        spec->push_back(&local_pref_);
+    if (IsPresent(BgpAttribute::AtomicAggregate))
+        spec->push_back(&atomic_aggregate_);
+    if (IsPresent(BgpAttribute::Aggregator))
+        spec->push_back(&aggregator_);
+
+    if (IsPresent(BgpAttribute::Communities)) {
+        communities_.communities.clear();
+        communities_.communities.reserve(
+            communities_size_ / sizeof(uint32_t));
+        for (size_t offset = 0; offset < communities_size_;
+             offset += sizeof(uint32_t)) {
+            communities_.communities.push_back(
+                get_value(communities_data_ + offset, sizeof(uint32_t)));
+        }
+        spec->push_back(&communities_);
+    }
+
+    if (IsPresent(BgpAttribute::OriginatorId))
+        spec->push_back(&originator_id_);
+
+    if (IsPresent(BgpAttribute::ExtendedCommunities)) {
+        ext_communities_.communities.clear();
+        ext_communities_.communities.reserve(
+            ext_communities_size_ / sizeof(uint64_t));
+        for (size_t offset = 0; offset < ext_communities_size_;
+             offset += sizeof(uint64_t)) {
+            ext_communities_.communities.push_back(get_value(
+                ext_communities_data_ + offset, sizeof(uint64_t)));
+        }
+        spec->push_back(&ext_communities_);
+    }
+}
+
+//
+// The Update is processed after the receive buffer has been released, so the
+// message is copied first and the copy is parsed, once. The reader is kept
+// in the Update for Validate and ProcessUpdate.
+//
+BgpProto::Update *BgpUpdateReader::Decode(const uint8_t *data, size_t size) {
+    if (size < BgpProto::kMinMessageSize ||
+        data[BgpProto::kMinMessageSize - 1] != BgpProto::UPDATE)
+        return NULL;
+
+    std::auto_ptr<BgpProto::Update> update(new BgpProto::Update);
+    update->raw.assign(data, data + size);
+    update->reader.reset(new BgpUpdateReader(&update->raw[0], size));
+    if (!update->reader->Parse())
+        return NULL;
+    return update.release();
+}
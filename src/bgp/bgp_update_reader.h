@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef SRC_BGP_BGP_UPDATE_READER_H_
+#define SRC_BGP_BGP_UPDATE_READER_H_
+
+#include <string>
+
+#include "bgp/bgp_aspath.h"
+#include "bgp/bgp_attr.h"
+#include "bgp/bgp_proto.h"
+#include "bgp/community.h"
+
+class BgpPeer;
+
+//
+// Decoder for BGP UPDATE messages that works in place on the message buffer.
+//
+// The UPDATEs in a full table feed carry the same handful of path attributes
+// along with inet or l3vpn prefixes. Parse() makes a single pass over such a
+// message without allocating anything. It checks the framing, decodes the
+// fixed size attributes into members of the reader and notes down where the
+// variable length attributes and the prefixes are located. GetAttrSpec then
+// builds a BgpAttrSpec that points to the members of the reader and the
+// prefixes are visited in place using a PrefixIterator.
+//
+// Parse() returns false for anything that it does not handle, which covers
+// malformed messages as well as rarely used attributes and address families.
+// The caller is expected to fall back to BgpProto::Decode in that case. The
+// generic parser deals with such messages and generates the appropriate
+// notification. Any message that's accepted by Parse() is also accepted by
+// BgpProto::Decode, with identical contents.
+//
+class BgpUpdateReader {
+public:
+    //
+    // Iterates over the prefixes in a section of the message. The caller is
+    // expected to pass the same BgpProtoPrefix to all calls to Next(), so
+    // that storage for the prefix is allocated only once.
+    //
+    class PrefixIterator {
+    public:
+        PrefixIterator() : data_(NULL), end_(NULL) { }
+        PrefixIterator(const uint8_t *data, const uint8_t *end)
+            : data_(data), end_(end) {
+        }
+
+        bool Next(BgpProtoPrefix *prefix);
+        bool empty() const { return data_ == end_; }
+
+    private:
+        friend class BgpUpdateReader;
+        bool Verify(int min_bits, int max_bits) const;
+
+        const uint8_t *data_;
+        const uint8_t *end_;
+    };
+
+    struct MpNlri {
+        MpNlri()
+            : present(false), afi(0), safi(0), nexthop(NULL),
+              nexthop_size(0) {
+        }
+
+        bool present;
+        uint16_t afi;
+        uint8_t safi;
+        const uint8_t *nexthop;
+        size_t nexthop_size;
+        PrefixIterator prefixes;
+    };
+
+    BgpUpdateReader(const uint8_t *data, size_t size);
+
+    bool Parse();
+    int Validate(const BgpPeer *peer, std::string *data) const;
+    void GetAttrSpec(BgpAttrSpec *spec);
+
+    PrefixIterator withdrawn_routes() const { return withdrawn_routes_; }
+    PrefixIterator nlri() const { return nlri_; }
+    const MpNlri &mp_reach_nlri() const { return mp_reach_nlri_; }
+    const MpNlri &mp_unreach_nlri() const { return mp_unreach_nlri_; }
+
+    //
+    // Return an Update that carries a copy of the message along with the
+    // reader that parsed it if it's accepted by Parse(), NULL otherwise.
+    //
+    static BgpProto::Update *Decode(const uint8_t *data, size_t size);
+
+private:
+    bool ParseAttribute(uint8_t flags, uint8_t code, const uint8_t *value,
+                        size_t size);
+    bool ParseMpNlri(uint8_t code, const uint8_t *value, size_t size,
+                     MpNlri *mp_nlri);
+    bool IsPresent(uint8_t code) const {
+        return (present_ & (1U << code)) != 0;
+    }
+
+    const uint8_t *data_;
+    size_t size_;
+    uint32_t present_;      // bitmask of the attribute codes seen
+
+    BgpAttrOrigin origin_;
+    BgpAttrNextHop nexthop_;
+    BgpAttrMultiExitDisc med_;
+    BgpAttrLocalPref local_pref_;
+    BgpAttrAtomicAggregate atomic_aggregate_;
+    BgpAttrAggregator aggregator_;
+    BgpAttrOriginatorId originator_id_;
+    AsPathSpec as_path_;
+    CommunitySpec communities_;
+    ExtCommunitySpec ext_communities_;
+
+    // Values of the variable length attributes, decoded by GetAttrSpec.
+    const uint8_t *as_path_data_;
+    size_t as_path_size_;
+    const uint8_t *communities_data_;
+    size_t communities_size_;
+    const uint8_t *ext_communities_data_;
+    size_t ext_communities_size_;
+
+    PrefixIterator withdrawn_routes_;
+    PrefixIterator nlri_;
+    MpNlri mp_reach_nlri_;
+    MpNlri mp_unreach_nlri_;
+
+    DISALLOW_COPY_AND_ASSIGN(BgpUpdateReader);
+};
+
+#endif  // SRC_BGP_BGP_UPDATE_READER_H_
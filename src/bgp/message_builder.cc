@@ -9,11 +9,10 @@
 Message::~Message() {
 }
 
-MessageBuilder *MessageBuilder::GetInstance(
-    RibExportPolicy::Encoding encoding) {
-    if (encoding == RibExportPolicy::BGP) {
-        return BgpMessageBuilder::GetInstance();
-    } else if (encoding == RibExportPolicy::XMPP) {
+MessageBuilder *MessageBuilder::GetInstance(const RibExportPolicy &policy) {
+    if (policy.encoding == RibExportPolicy::BGP) {
+        return BgpMessageBuilder::GetInstance(policy.extended_message);
+    } else if (policy.encoding == RibExportPolicy::XMPP) {
         return BgpXmppMessageBuilder::GetInstance();
     }
     return NULL;
@@ -31,10 +31,11 @@ protected:
 
 class MessageBuilder {
 public:
+    // Returns NULL if the route can't be encoded in a message by itself.
     virtual Message *Create(const BgpTable *table,
                             const RibOutAttr *roattr,
                             const BgpRoute *route) const = 0;
-    static MessageBuilder *GetInstance(RibExportPolicy::Encoding encoding);
+    static MessageBuilder *GetInstance(const RibExportPolicy &policy);
 };
 
 #endif
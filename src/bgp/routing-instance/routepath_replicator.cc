@@ -25,6 +25,7 @@
 #include "bgp/routing-instance/rtarget_group.h"
 #include "bgp/routing-instance/rtarget_group_mgr.h"
 #include "bgp/routing-instance/routing_instance_analytics_types.h"
+#include "db/db.h"
 #include "db/db_table_partition.h"
 #include "db/db_table_walker.h"
 
@@ -50,7 +51,8 @@ do {                                                                           \
 } while (false)
 
 TableState::TableState(BgpTable *table, DBTableBase::ListenerId id)
-    : id_(id), table_delete_ref_(this, table->deleter()) {
+    : id_(id), table_delete_ref_(this, table->deleter()),
+      rtarget_index_(DB::PartitionCount()) {
     assert(table->deleter() != NULL);
 }
 
@@ -61,6 +63,15 @@ TableState::~TableState() {
 void TableState::ManagedDelete() {
 }
 
+const TableState::RouteList *TableState::GetRouteList(int part_id,
+        const RouteTarget &rtarget) const {
+    const RouteTargetIndex &index = rtarget_index_[part_id];
+    RouteTargetIndex::const_iterator loc = index.find(rtarget);
+    if (loc == index.end())
+        return NULL;
+    return &loc->second;
+}
+
 RoutePathReplicator::RoutePathReplicator(
         BgpServer *server, Address::Family family)
         : server_(server),
@@ -71,7 +82,14 @@ RoutePathReplicator::RoutePathReplicator(
           unreg_trigger_(new TaskTrigger(
           boost::bind(&RoutePathReplicator::UnregisterTables, this),
               TaskScheduler::GetInstance()->GetTaskId("bgp::Config"), 0)),
+          rtarget_walk_lists_(DB::PartitionCount()),
           trace_buf_(SandeshTraceBufferCreate("RoutePathReplicator", 500)) {
+    for (int i = 0; i < DB::PartitionCount(); i++) {
+        rtarget_walk_triggers_.push_back(boost::shared_ptr<TaskTrigger>(
+            new TaskTrigger(boost::bind(
+                &RoutePathReplicator::ProcessRouteTargetWalkList, this, i),
+            TaskScheduler::GetInstance()->GetTaskId("db::DBTable"), i)));
+    }
 }
 
 RoutePathReplicator::~RoutePathReplicator() {
@@ -101,6 +119,86 @@ RoutePathReplicator::RequestWalk(BgpTable *table) {
     }
 }
 
+//
+// Request a walk of the routes in the table that carry the given RouteTarget.
+//
+// Only VPN tables maintain the RouteTarget index.  The routes in a VRF table
+// carry all the export targets of the instance, so there's nothing to gain
+// and we simply walk the entire table.  A full walk is also needed when the
+// table is going to be unregistered, so that the DBStates get cleaned up.
+//
+// The index is not complete while a walk of the entire table is pending or
+// in progress, or after a cleanup walk for a table that's about to be
+// unregistered, so we fall back to a full walk in those cases.
+//
+void RoutePathReplicator::RequestWalk(BgpTable *table,
+                                      const RouteTarget &rtarget) {
+    CHECK_CONCURRENCY("bgp::Config");
+    RouteReplicatorTableState::iterator loc = table_state_.find(table);
+    if (!table->IsVpnTable() || loc == table_state_.end() ||
+        loc->second->GetGroupList().empty() ||
+        bulk_sync_.find(table) != bulk_sync_.end() ||
+        unreg_table_list_.find(table) != unreg_table_list_.end()) {
+        RequestWalk(table);
+        return;
+    }
+
+    RPR_TRACE(Walk, table->name() + " " + rtarget.ToString());
+    for (int idx = 0; idx < DB::PartitionCount(); ++idx) {
+        rtarget_walk_lists_[idx].insert(std::make_pair(table, rtarget));
+        rtarget_walk_triggers_[idx]->Set();
+    }
+}
+
+//
+// Run the routes with the requested RouteTargets in the given partition
+// through the BgpTableListener.
+//
+// The TableState may have gone away if the table got unregistered after
+// a full walk in the meantime, in which case there's nothing left to do.
+//
+bool RoutePathReplicator::ProcessRouteTargetWalkList(int part_id) {
+    CHECK_CONCURRENCY("db::DBTable");
+
+    BOOST_FOREACH(const RouteTargetWalkList::value_type &value,
+                  rtarget_walk_lists_[part_id]) {
+        BgpTable *table = value.first;
+        RouteReplicatorTableState::iterator loc = table_state_.find(table);
+        if (loc == table_state_.end())
+            continue;
+        const TableState::RouteList *list =
+            loc->second->GetRouteList(part_id, value.second);
+        if (!list)
+            continue;
+
+        // Work on a copy since the listener updates the index.
+        std::vector<BgpRoute *> route_list(list->begin(), list->end());
+        DBTablePartBase *root = table->GetTablePartition(part_id);
+        BOOST_FOREACH(BgpRoute *rt, route_list) {
+            BgpTableListener(root, rt);
+        }
+    }
+
+    rtarget_walk_lists_[part_id].clear();
+    return true;
+}
+
+size_t RoutePathReplicator::GetRouteTargetRouteCount(BgpTable *table,
+        const RouteTarget &rtarget) const {
+    RouteReplicatorTableState::const_iterator loc = table_state_.find(table);
+    if (loc == table_state_.end())
+        return 0;
+
+    size_t count = 0;
+    for (int idx = 0; idx < DB::PartitionCount(); ++idx) {
+        const TableState::RouteList *list =
+            loc->second->GetRouteList(idx, rtarget);
+        if (list)
+            count += list->size();
+    }
+    return count;
+}
+
 bool
 RoutePathReplicator::StartWalk() {
     CHECK_CONCURRENCY("bgp::Config");
@@ -201,7 +299,7 @@ void RoutePathReplicator::Join(BgpTable *table, const RouteTarget &rt,
     RPR_TRACE(TableJoin, table->name(), rt.ToString(), import);
     if (import) {
         BOOST_FOREACH(BgpTable *bgptable, group->GetExportTables(family())) {
-            RequestWalk(bgptable);
+            RequestWalk(bgptable, rt);
         }
         walk_trigger_->Set();
         return;
@@ -216,12 +314,13 @@ void RoutePathReplicator::Join(BgpTable *table, const RouteTarget &rt,
         ts->MutableGroupList()->push_back(group);
         table_state_.insert(std::make_pair(table, ts));
         RPR_TRACE(RegTable, table->name());
+        RequestWalk(table);
     } else {
         TableState *ts = loc->second;
         ts->MutableGroupList()->push_back(group);
+        RequestWalk(table, rt);
     }
 
-    RequestWalk(table);
     walk_trigger_->Set();
 }
 
@@ -237,20 +336,17 @@ void RoutePathReplicator::Leave(BgpTable *table, const RouteTarget &rt,
     if (import) {
         group->RemoveImportTable(family(), table);
         BOOST_FOREACH(BgpTable *bgptable, group->GetExportTables(family())) {
-            RequestWalk(bgptable);
+            RequestWalk(bgptable, rt);
         }
     } else {
         group->RemoveExportTable(family(), table);
-        RequestWalk(table);
-    }
-
-    if (!import) {
         RouteReplicatorTableState::iterator loc = table_state_.find(table);
         assert(loc != table_state_.end());
         TableState *ts = loc->second;
         ts->MutableGroupList()->remove(group);
         // The unregister from DBTable and delete of the TableState
         // after the TableWalk is completed (started by BgpBulkSync)
+        RequestWalk(table, rt);
     }
 
     if ((group->GetImportTables(family()).size() == 1) &&
@@ -326,12 +422,42 @@ RoutePathReplicator::DBStateSync(BgpTable *table, BgpRoute *rt,
         DeleteSecondaryPath(table, rt, *dbstate_it);
         dbstate->GetMutableList()->erase(dbstate_it);
     }
-    if (dbstate->GetList().empty()) {
+    if (dbstate->GetList().empty() && dbstate->GetRouteTargetList().empty()) {
         rt->ClearState(table, id);
         delete dbstate;
     }
 }
 
+//
+// Update the RouteTarget index of the table to reflect the current list of
+// RouteTargets for the route.
+//
+void RoutePathReplicator::RouteTargetIndexSync(TableState *ts, int part_id,
+        BgpRoute *rt, RtReplicated *dbstate,
+        const RtReplicated::RouteTargetList &current) {
+    RtReplicated::RouteTargetList *previous =
+        dbstate->GetMutableRouteTargetList();
+    if (*previous == current)
+        return;
+
+    TableState::RouteTargetIndex *index = ts->MutableRouteTargetIndex(part_id);
+    BOOST_FOREACH(const RouteTarget &rtarget, *previous) {
+        if (current.find(rtarget) != current.end())
+            continue;
+        TableState::RouteTargetIndex::iterator loc = index->find(rtarget);
+        assert(loc != index->end());
+        loc->second.erase(rt);
+        if (loc->second.empty())
+            index->erase(loc);
+    }
+    BOOST_FOREACH(const RouteTarget &rtarget, current) {
+        if (previous->find(rtarget) != previous->end())
+            continue;
+        (*index)[rtarget].insert(rt);
+    }
+    *previous = current;
+}
+
 //
 // Update the ExtCommunity with the RouteTargets from the export list
 // and the OriginVn. The OriginVn is derived from the RouteTargets in
@@ -403,6 +529,7 @@ bool RoutePathReplicator::BgpTableListener(DBTablePartBase *root,
         static_cast<RtReplicated *>(rt->GetState(table, id));
 
     RtReplicated::ReplicatedRtPathList replicated_path_list;
+    RtReplicated::RouteTargetList rtarget_list;
 
     // Cleanup if the route is marked for deletion, or there is no best path or
     // if the best path is infeasible
@@ -411,6 +538,7 @@ bool RoutePathReplicator::BgpTableListener(DBTablePartBase *root,
         if (!dbstate) {
             return true;
         }
+        RouteTargetIndexSync(ts, root->index(), rt, dbstate, rtarget_list);
         DBStateSync(table, rt, id, dbstate, replicated_path_list);
         return true;
     }
@@ -433,10 +561,6 @@ bool RoutePathReplicator::BgpTableListener(DBTablePartBase *root,
         it != rt->GetPathList().end(); it++) {
         BgpPath *path = static_cast<BgpPath *>(it.operator->());
 
-        // Skip if the source peer is down
-        if (!path->IsStale() && path->GetPeer() && !path->GetPeer()->IsReady())
-            continue;
-
         // No need to replicate the replicated path
         if (path->IsReplicated()) continue;
 
@@ -446,6 +570,23 @@ bool RoutePathReplicator::BgpTableListener(DBTablePartBase *root,
         const BgpAttr *attr = path->GetAttr();
         const ExtCommunity *ext_community = attr->ext_community();
 
+        // Index the route under its RouteTargets. This is done before the
+        // peer check so that the route gets visited by RouteTarget walks.
+        // Nothing is indexed once the table is not part of any RtGroup so
+        // that all DBStates get cleaned up before the table is unregistered.
+        if (ext_community && table->IsVpnTable() &&
+            !ts->GetGroupList().empty()) {
+            BOOST_FOREACH(const ExtCommunity::ExtCommunityValue &comm,
+                          ext_community->communities()) {
+                if (ExtCommunity::is_route_target(comm))
+                    rtarget_list.insert(RouteTarget(comm));
+            }
+        }
+
+        // Skip if the source peer is down
+        if (!path->IsStale() && path->GetPeer() && !path->GetPeer()->IsReady())
+            continue;
+
         ExtCommunityPtr extcomm_ptr =
           UpdateExtCommunity(server(), rtinstance, ext_community, export_list);
         ext_community = extcomm_ptr.get();
@@ -515,6 +656,7 @@ bool RoutePathReplicator::BgpTableListener(DBTablePartBase *root,
         }
     }
 
+    RouteTargetIndexSync(ts, root->index(), rt, dbstate, rtarget_list);
     DBStateSync(table, rt, id, dbstate, replicated_path_list);
     return true;
 }
@@ -527,6 +669,8 @@ const RtReplicated *RoutePathReplicator::GetReplicationState(
     const TableState *ts = loc->second;
     RtReplicated *dbstate = 
         static_cast<RtReplicated *>(rt->GetState(table, ts->GetListenerId()));
+    if (dbstate && dbstate->GetList().empty())
+        return NULL;
     return dbstate;
 }
 
@@ -6,8 +6,12 @@
 #define ctrlplane_routepath_replicator_h
 
 #include <list>
+#include <map>
+#include <set>
+#include <vector>
 
 #include <boost/ptr_container/ptr_map.hpp>
+#include <boost/shared_ptr.hpp>
 #include <tbb/mutex.h>
 
 #include "bgp/bgp_table.h"
@@ -23,9 +27,23 @@ class RtGroup;
 class RouteTarget;
 class TaskTrigger;
 
+//
+// TableState is the per BgpTable state of the RoutePathReplicator.
+//
+// For VPN tables it also keeps an index from RouteTarget to the routes that
+// carry the RouteTarget in one of their ecmp paths. This is used to limit
+// the walk triggered by a change in the membership of a RtGroup to the
+// routes that carry the RouteTarget, instead of walking the entire table.
+// The index is updated from BgpTableListener and, like the DBTable itself,
+// is partitioned so that each partition is only accessed from the db::DBTable
+// task for that partition.
+//
 class TableState {
 public:
     typedef std::list<RtGroup *> GroupList;
+    typedef std::set<BgpRoute *> RouteList;
+    typedef std::map<RouteTarget, RouteList> RouteTargetIndex;
+
     TableState(BgpTable *table, DBTableBase::ListenerId id);
     ~TableState();
 
@@ -41,10 +59,17 @@ public:
         return id_;
     }
 
+    RouteTargetIndex *MutableRouteTargetIndex(int part_id) {
+        return &rtarget_index_[part_id];
+    }
+    const RouteList *GetRouteList(int part_id,
+                                  const RouteTarget &rtarget) const;
+
 private:
     DBTableBase::ListenerId id_;
     LifetimeRef<TableState> table_delete_ref_;
     GroupList list_;
+    std::vector<RouteTargetIndex> rtarget_index_;
     DISALLOW_COPY_AND_ASSIGN(TableState);
 };
 
@@ -118,6 +143,7 @@ public:
     };  
 
     typedef std::set<SecondaryRouteInfo> ReplicatedRtPathList;
+    typedef std::set<RouteTarget> RouteTargetList;
 
     // Get the list of replicated route for given Primary Route
     const ReplicatedRtPathList &GetList() const {
@@ -128,6 +154,15 @@ public:
         return &replicate_list_;
     }
 
+    // Get the list of RouteTargets under which the route is indexed
+    const RouteTargetList &GetRouteTargetList() const {
+        return rtarget_list_;
+    }
+
+    RouteTargetList *GetMutableRouteTargetList() {
+        return &rtarget_list_;
+    }
+
     // Add a replicated route to List
     void AddReplicatedRt(BgpTable *dest, const IPeer *peer, BgpRoute *rt);
 
@@ -137,6 +172,7 @@ public:
 
 private:
     ReplicatedRtPathList  replicate_list_;
+    RouteTargetList rtarget_list_;
 };
 
 // Matrix of RouteTarget and BgpTable that imports & exports route belonging
@@ -173,6 +209,13 @@ public:
 
     void RequestWalk(BgpTable *table);
 
+    // Walk only the routes in the table that carry the given RouteTarget.
+    // Falls back to a walk of the entire table if the table is not indexed.
+    void RequestWalk(BgpTable *table, const RouteTarget &rtarget);
+
+    size_t GetRouteTargetRouteCount(BgpTable *table,
+                                    const RouteTarget &rtarget) const;
+
     SandeshTraceBufferPtr trace_buffer() const { return trace_buf_; }
 
     bool UnregisterTables();
@@ -181,8 +224,10 @@ private:
     typedef std::map<BgpTable *, TableState *> RouteReplicatorTableState;
     typedef std::map<BgpTable *, BulkSyncState *> BulkSyncOrders;
     typedef std::set<BgpTable *> UnregTableList;
+    typedef std::set<std::pair<BgpTable *, RouteTarget> > RouteTargetWalkList;
 
     bool StartWalk();
+    bool ProcessRouteTargetWalkList(int part_id);
 
     void AddVpnTable(RtGroup *rtgroup);
 
@@ -191,6 +236,9 @@ private:
     void DBStateSync(BgpTable *table, BgpRoute *rt, DBTableBase::ListenerId id,
                      RtReplicated *dbstate, 
                      RtReplicated::ReplicatedRtPathList &current);
+    void RouteTargetIndexSync(TableState *ts, int part_id, BgpRoute *rt,
+                              RtReplicated *dbstate,
+                              const RtReplicated::RouteTargetList &current);
 
     // Mutex to protect unreg_table_list_, table_state_ and bulk_sync_ 
     // from multiple DBTable task
@@ -202,6 +250,8 @@ private:
     Address::Family family_;
     boost::scoped_ptr<TaskTrigger> walk_trigger_;
     boost::scoped_ptr<TaskTrigger> unreg_trigger_;
+    std::vector<RouteTargetWalkList> rtarget_walk_lists_;
+    std::vector<boost::shared_ptr<TaskTrigger> > rtarget_walk_triggers_;
     SandeshTraceBufferPtr trace_buf_;
 };
 
@@ -185,6 +185,125 @@ TEST_F(BgpMsgBuilderTest, Build) {
     delete ext_community;
     delete result;
 }
+
+//
+// Pack the same routes into a regular and an extended message. The regular
+// message fills up at 4K while the extended one takes all of them.
+//
+TEST_F(BgpMsgBuilderTest, ExtendedMessage) {
+    BgpAttrSpec attr;
+    BgpAttrOrigin origin(BgpAttrOrigin::IGP);
+    attr.push_back(&origin);
+    BgpAttrLocalPref lp(100);
+    attr.push_back(&lp);
+    CommunitySpec community;
+    community.communities.push_back(0x87654321);
+    attr.push_back(&community);
+    // Carried in the MP_REACH_NLRI, which is the last attribute.
+    BgpAttrNextHop nexthop(0xabcdef01);
+    attr.push_back(&nexthop);
+
+    RibOutAttr rib_out_attr;
+    rib_out_attr.set_attr(server_.attr_db()->Locate(attr));
+
+    static const int kRoutes = 1000;
+    vector<InetVpnRoute *> routes;
+    for (int i = 0; i < kRoutes; i++) {
+        ostringstream repr;
+        repr << "10.1.1.1:" << i + 1 << ":20.1." << i / 256 << "." << i % 256
+             << "/32";
+        routes.push_back(
+            new InetVpnRoute(InetVpnPrefix::FromString(repr.str())));
+    }
+
+    BgpMessage message;
+    BgpMessage extended(BgpProto::kMaxExtendedMessageSize);
+    message.Start(&rib_out_attr, routes[0]);
+    extended.Start(&rib_out_attr, routes[0]);
+    bool full = false;
+    for (int i = 1; i < kRoutes; i++) {
+        if (!full && !message.AddRoute(routes[i], &rib_out_attr))
+            full = true;
+        EXPECT_TRUE(extended.AddRoute(routes[i], &rib_out_attr));
+    }
+    EXPECT_TRUE(full);
+    EXPECT_GT(kRoutes, message.num_reach_routes());
+    EXPECT_EQ(kRoutes, extended.num_reach_routes());
+
+    size_t length;
+    const uint8_t *data = message.GetData(NULL, &length);
+    EXPECT_GE(BgpProto::kMaxMessageSize, length);
+    const BgpProto::Update *result = static_cast<const BgpProto::Update *>(
+        BgpProto::Decode(data, length));
+    ASSERT_TRUE(result != NULL);
+    EXPECT_EQ(attr.size(), result->path_attributes.size());
+    BgpMpNlri *nlri =
+        static_cast<BgpMpNlri *>(*(result->path_attributes.end() - 1));
+    EXPECT_EQ(message.num_reach_routes(), nlri->nlri.size());
+    delete result;
+
+    data = extended.GetData(NULL, &length);
+    EXPECT_LT(BgpProto::kMaxMessageSize, length);
+    result = static_cast<const BgpProto::Update *>(
+        BgpProto::Decode(data, length));
+    ASSERT_TRUE(result != NULL);
+    EXPECT_EQ(attr.size(), result->path_attributes.size());
+    for (size_t i = 0; i < attr.size() - 1; i++) {
+        EXPECT_EQ(0, attr[i]->CompareTo(*result->path_attributes[i]));
+    }
+    nlri = static_cast<BgpMpNlri *>(*(result->path_attributes.end() - 1));
+    ASSERT_EQ(kRoutes, nlri->nlri.size());
+    for (int i = 0; i < kRoutes; i++) {
+        BgpProtoPrefix prefix;
+        routes[i]->BuildProtoPrefix(&prefix, rib_out_attr.attr(), 0);
+        EXPECT_EQ(prefix.prefixlen, nlri->nlri[i]->prefixlen);
+        EXPECT_EQ(prefix.prefix, nlri->nlri[i]->prefix);
+    }
+    delete result;
+
+    STLDeleteValues(&routes);
+}
+
+//
+// Attributes that don't fit in a regular message can't be sent to a peer
+// without the extended message capability, but work with an extended one.
+//
+TEST_F(BgpMsgBuilderTest, OversizeAttributes) {
+    BgpAttrSpec attr;
+    BgpAttrOrigin origin(BgpAttrOrigin::IGP);
+    attr.push_back(&origin);
+    CommunitySpec community;
+    for (int i = 0; i < 1200; i++) {
+        community.communities.push_back(0x87650000 + i);
+    }
+    attr.push_back(&community);
+    BgpAttrNextHop nexthop(0xabcdef01);
+    attr.push_back(&nexthop);
+
+    RibOutAttr rib_out_attr;
+    rib_out_attr.set_attr(server_.attr_db()->Locate(attr));
+    InetVpnRoute route(InetVpnPrefix::FromString("10.1.1.1:1:20.1.1.1/32"));
+
+    MessageBuilder *builder = BgpMessageBuilder::GetInstance(false);
+    MessageBuilder *extended = BgpMessageBuilder::GetInstance(true);
+    EXPECT_TRUE(builder->Create(NULL, &rib_out_attr, &route) == NULL);
+
+    auto_ptr<Message> message(
+        extended->Create(NULL, &rib_out_attr, &route));
+    ASSERT_TRUE(message.get() != NULL);
+    EXPECT_EQ(1, message->num_reach_routes());
+    size_t length;
+    const uint8_t *data = message->GetData(NULL, &length);
+    EXPECT_LT(BgpProto::kMaxMessageSize, length);
+
+    // The encoding cached by the extended message is still too large.
+    EXPECT_TRUE(builder->Create(NULL, &rib_out_attr, &route) == NULL);
+    const BgpProto::Update *result = static_cast<const BgpProto::Update *>(
+        BgpProto::Decode(data, length));
+    ASSERT_TRUE(result != NULL);
+    EXPECT_EQ(attr.size(), result->path_attributes.size());
+    delete result;
+}
 }  // namespace
 
 static void SetUp() {
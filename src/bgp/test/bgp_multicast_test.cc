@@ -8,6 +8,7 @@
 #include "base/logging.h"
 #include "base/task.h"
 #include "base/task_annotations.h"
+#include "base/util.h"
 #include "base/test/task_test_util.h"
 #include "bgp/bgp_attr.h"
 #include "bgp/ipeer.h"
@@ -332,6 +333,31 @@ protected:
         VerifyForwarderCount(tm, group_str, "0.0.0.0", count);
     }
 
+    typedef std::map<std::string, uint32_t> ForwarderLabelMap;
+
+    void GetForwarderLabels(McastTreeManager *tm, string group_str,
+            ForwarderLabelMap *labels) {
+        ConcurrencyScope scope("db::DBTable");
+        boost::system::error_code ec;
+        Ip4Address group = Ip4Address::from_string(group_str.c_str(), ec);
+        Ip4Address source = Ip4Address::from_string("0.0.0.0", ec);
+
+        labels->clear();
+        for (McastTreeManager::PartitionList::iterator it =
+             tm->partitions_.begin(); it != tm->partitions_.end(); ++it) {
+            McastSGEntry *sg_entry = (*it)->FindSGEntry(group, source);
+            if (!sg_entry)
+                continue;
+            McastSGEntry::ForwarderSet *forwarders =
+                sg_entry->forwarder_sets_[McastTreeManager::LevelNative];
+            for (McastSGEntry::ForwarderSet::iterator it =
+                 forwarders->begin(); it != forwarders->end(); ++it) {
+                labels->insert(
+                    make_pair((*it)->address().to_string(), (*it)->label()));
+            }
+        }
+    }
+
     size_t VerifyTreeUpdateCount(McastTreeManager *tm) {
         size_t total = 0;
         for (int idx = 0; idx < DB::PartitionCount(); idx++) {
@@ -685,6 +711,79 @@ TEST_F(BgpMulticastTest, TreeUpdateCompression) {
     TASK_UTIL_EXPECT_EQ(6, VerifyTreeUpdateCount(red_tm_));
 }
 
+//
+// Build a tree with a large number of forwarders and then repeatedly remove
+// and add back a single forwarder. Each move should only relabel forwarders
+// around the position of the moved forwarder in the tree.
+//
+TEST_F(BgpMulticastTest, Scale) {
+    static const int kScalePeerCount = 5000;
+    static const int kMoveCount = 100;
+    static const size_t kMaxChangedLabels = 2 * McastTreeManager::kDegree + 4;
+
+    vector<XmppPeerMock *> scale_peers;
+    for (int idx = 0; idx < kScalePeerCount; idx++) {
+        std::ostringstream repr;
+        repr << "10.2." << (idx / 250) << "." << (idx % 250 + 1);
+        scale_peers.push_back(new XmppPeerMock(&server_, repr.str()));
+    }
+
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    uint64_t start = UTCTimestampUsec();
+    scheduler->Stop();
+    for (int idx = 0; idx < kScalePeerCount; idx++) {
+        scale_peers[idx]->AddRoute(red_table_, "192.168.1.255");
+    }
+    scheduler->Start();
+    task_util::WaitForIdle();
+    uint64_t build_usec = UTCTimestampUsec() - start;
+    VerifyRouteCount(red_table_, kScalePeerCount + 1);
+    VerifySGCount(red_tm_, 1);
+
+    ForwarderLabelMap labels;
+    GetForwarderLabels(red_tm_, "192.168.1.255", &labels);
+    TASK_UTIL_EXPECT_EQ(kScalePeerCount, labels.size());
+
+    uint64_t move_usec = 0;
+    for (int idx = 0; idx < kMoveCount; idx++) {
+        XmppPeerMock *peer = scale_peers[(idx * 97) % kScalePeerCount];
+        start = UTCTimestampUsec();
+        peer->DelRoute(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        peer->AddRoute(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        move_usec += UTCTimestampUsec() - start;
+
+        ForwarderLabelMap new_labels;
+        GetForwarderLabels(red_tm_, "192.168.1.255", &new_labels);
+        TASK_UTIL_EXPECT_EQ(kScalePeerCount, new_labels.size());
+
+        size_t changed = 0;
+        for (ForwarderLabelMap::const_iterator it = labels.begin();
+             it != labels.end(); ++it) {
+            ForwarderLabelMap::const_iterator new_it =
+                new_labels.find(it->first);
+            if (new_it != new_labels.end() && new_it->second != it->second)
+                changed++;
+        }
+        EXPECT_LE(changed, kMaxChangedLabels);
+        labels.swap(new_labels);
+    }
+
+    cout << "Built tree with " << kScalePeerCount << " forwarders in "
+         << build_usec / 1000 << " msec" << endl;
+    cout << "Moved " << kMoveCount << " forwarders in "
+         << move_usec / 1000 << " msec" << endl;
+
+    for (int idx = 0; idx < kScalePeerCount; idx++) {
+        scale_peers[idx]->DelRoute(red_table_, "192.168.1.255");
+    }
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, 0);
+    VerifySGCount(red_tm_, 0);
+    STLDeleteValues(&scale_peers);
+}
+
 int main(int argc, char **argv) {
     bgp_log_test::init();
     ::testing::InitGoogleTest(&argc, argv);
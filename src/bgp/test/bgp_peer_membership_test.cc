@@ -12,6 +12,7 @@
 #include "bgp/bgp_factory.h"
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_peer.h"
+#include "bgp/bgp_peer_types.h"
 #include "bgp/bgp_peer_membership.h"
 #include "bgp/bgp_proto.h"
 #include "bgp/bgp_server.h"
@@ -503,6 +504,136 @@ TEST_F(PeerMembershipMgrTest, PeerDeleteWithDBRequestPending) {
         server_->FindPeer(BgpConfigManager::kMasterInstance, peer_names_[0]));
 }
 
+// Requests from multiple peers that arrive while the queue is blocked get
+// joined in a single walk and the join latency shows up in introspect.
+TEST_F(PeerMembershipMgrTest, BatchedJoinLatency) {
+    PeerRibMembershipManager *mgr = server()->membership_mgr();
+
+    // Make sure we start out clean.
+    ASSERT_EQ(size(), 0);
+
+    static_cast<PeerRibMembershipManagerTest *>(
+        server_->membership_mgr())->SetQueueDisable(true);
+    for (int idx = 0; idx < 3; idx++) {
+        mgr->Register(peers_[idx], red_tbl_,
+                      peers_[idx]->GetRibExportPolicy(), -1);
+        mgr->Register(peers_[idx], blue_tbl_,
+                      peers_[idx]->GetRibExportPolicy(), -1);
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, size());
+
+    static_cast<PeerRibMembershipManagerTest *>(
+        server_->membership_mgr())->SetQueueDisable(false);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(6, size());
+
+    for (int idx = 0; idx < 3; idx++) {
+        IPeerRib *peer_rib = mgr->IPeerRibFind(peers_[idx], red_tbl_);
+        ASSERT_TRUE(peer_rib != NULL);
+        EXPECT_TRUE(peer_rib->joined());
+
+        BgpNeighborResp resp;
+        mgr->FillPeerMembershipInfo(peers_[idx], resp);
+        EXPECT_EQ(2U, resp.get_routing_tables().size());
+        for (size_t table = 0; table < 2; table++) {
+            EXPECT_EQ("",
+                resp.get_routing_tables()[table].get_current_request());
+        }
+        EXPECT_EQ(2U, resp.get_join_latency().get_count());
+        uint64_t total = 0;
+        const std::vector<BgpNeighborJoinLatencyBucket> &buckets =
+            resp.get_join_latency().get_buckets();
+        for (size_t bucket = 0; bucket < buckets.size(); bucket++) {
+            total += buckets[bucket].get_count();
+        }
+        EXPECT_EQ(2U, total);
+    }
+
+    for (int idx = 0; idx < 3; idx++) {
+        mgr->Unregister(peers_[idx], red_tbl_);
+        mgr->Unregister(peers_[idx], blue_tbl_);
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, size());
+}
+
+static int RibInDeleteAction(IPeerRib *peer_rib) {
+    return MembershipRequest::RIBIN_DELETE;
+}
+
+static void UnregisterPeerDone(IPeer *ipeer, BgpTable *table) {
+}
+
+static void AddInetRoute(BgpServer *server, BgpTable *table, IPeer *peer,
+                         const string &prefix_str, bool add) {
+    BgpAttrSpec attr_spec;
+    BgpAttrPtr attr = server->attr_db()->Locate(attr_spec);
+    Ip4Prefix prefix(Ip4Prefix::FromString(prefix_str));
+
+    DBRequest req;
+    req.key.reset(new InetTable::RequestKey(prefix, peer));
+    if (add) {
+        req.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+        req.data.reset(new InetTable::RequestData(attr, 0, 0));
+    } else {
+        req.oper = DBRequest::DB_ENTRY_DELETE;
+    }
+    table->Enqueue(&req);
+}
+
+// RibIn delete without RibOut delete only visits the paths from the peer
+// using the per peer path index in the table.
+TEST_F(PeerMembershipMgrTest, RibInDeleteWithPeerPathIndex) {
+    PeerRibMembershipManager *mgr = server()->membership_mgr();
+
+    // Make sure we start out clean.
+    ASSERT_EQ(size(), 0);
+
+    mgr->Register(peers_[0], red_tbl_, peers_[0]->GetRibExportPolicy(), -1);
+    mgr->Register(peers_[1], red_tbl_, peers_[1]->GetRibExportPolicy(), -1);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(2, size());
+
+    // Peer 0 adds 10.1.[0-7].0/24 and peer 1 adds 10.1.[4-11].0/24.
+    for (int idx = 0; idx < 12; idx++) {
+        ostringstream out;
+        out << "10.1." << idx << ".0/24";
+        if (idx < 8)
+            AddInetRoute(server(), red_tbl_, peers_[0], out.str(), true);
+        if (idx >= 4)
+            AddInetRoute(server(), red_tbl_, peers_[1], out.str(), true);
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(12, red_tbl_->Size());
+    TASK_UTIL_EXPECT_EQ(8, red_tbl_->GetPeerPathCount(peers_[0]));
+    TASK_UTIL_EXPECT_EQ(8, red_tbl_->GetPeerPathCount(peers_[1]));
+
+    // Delete the RibIn for peer 0.
+    mgr->UnregisterPeer(peers_[0], RibInDeleteAction, UnregisterPeerDone);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(8, red_tbl_->Size());
+    TASK_UTIL_EXPECT_EQ(0, red_tbl_->GetPeerPathCount(peers_[0]));
+    TASK_UTIL_EXPECT_EQ(8, red_tbl_->GetPeerPathCount(peers_[1]));
+
+    // The IPeerRib for peer 0 is still around since its RibOut is registered.
+    TASK_UTIL_EXPECT_EQ(2, size());
+
+    for (int idx = 4; idx < 12; idx++) {
+        ostringstream out;
+        out << "10.1." << idx << ".0/24";
+        AddInetRoute(server(), red_tbl_, peers_[1], out.str(), false);
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, red_tbl_->Size());
+    TASK_UTIL_EXPECT_EQ(0, red_tbl_->GetPeerPathCount(peers_[1]));
+
+    mgr->Unregister(peers_[0], red_tbl_);
+    mgr->Unregister(peers_[1], red_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, size());
+}
+
 static void SetUp() {
     bgp_log_test::init();
     ControlNode::SetDefaultSchedulingPolicy();
@@ -11,6 +11,7 @@
 #include "net/bgp_af.h"
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_proto.h"
+#include "bgp/bgp_update_reader.h"
 #include "bgp_message_test.h"
 
 using namespace std;
@@ -62,8 +63,107 @@ protected:
         }
 
         BgpProto::BgpMessage *msg = BgpProto::Decode(new_data, data_size);
+        BgpUpdateReader reader(new_data, data_size);
+        if (reader.Parse())
+            EXPECT_TRUE(msg != NULL);
         if (msg) delete msg;
     }
+
+    //
+    // Build an UPDATE that BgpUpdateReader handles. This is the same as the
+    // one from BgpMessageTest, except that the MP_REACH_NLRI and MP_UNREACH
+    // carry a proper nexthop and prefixes.
+    //
+    void GenerateReaderUpdate(BgpProto::Update *update, uint16_t afi,
+                              uint8_t safi) {
+        BgpMessageTest::GenerateUpdateMessage(update, afi, safi);
+        bool vpn = (safi == BgpAf::Vpn);
+        for (vector<BgpAttribute *>::iterator it =
+             update->path_attributes.begin();
+             it != update->path_attributes.end(); ++it) {
+            if ((*it)->code != BgpAttribute::MPReachNlri &&
+                (*it)->code != BgpAttribute::MPUnreachNlri)
+                continue;
+            BgpMpNlri *mp_nlri = static_cast<BgpMpNlri *>(*it);
+            if ((*it)->code == BgpAttribute::MPReachNlri) {
+                uint8_t nh[12] = { 0, 1, 0, 0, 0, 1, 0, 1, 192, 168, 1, 1 };
+                mp_nlri->nexthop.assign(vpn ? &nh[0] : &nh[8], &nh[12]);
+            }
+            for (vector<BgpProtoPrefix *>::iterator pit =
+                 mp_nlri->nlri.begin(); pit != mp_nlri->nlri.end(); ++pit) {
+                if (!vpn)
+                    continue;
+                uint8_t label_rd[11] =
+                    { 0, 0x10, 0x01, 0, 1, 0, 0, 0, 1, 0, 1 };
+                (*pit)->prefix.insert((*pit)->prefix.begin(),
+                                      &label_rd[0], &label_rd[11]);
+                (*pit)->prefixlen += 88;
+            }
+        }
+    }
+
+    static void ComparePrefixes(BgpUpdateReader::PrefixIterator iter,
+                                const vector<BgpProtoPrefix *> &expected) {
+        BgpProtoPrefix prefix;
+        size_t count = 0;
+        while (iter.Next(&prefix)) {
+            ASSERT_LT(count, expected.size());
+            EXPECT_EQ(expected[count]->prefixlen, prefix.prefixlen);
+            EXPECT_TRUE(expected[count]->prefix == prefix.prefix);
+            count++;
+        }
+        EXPECT_EQ(expected.size(), count);
+    }
+
+    //
+    // Make sure that the reader sees the same message as the generic parser.
+    //
+    void VerifyReader(const uint8_t *data, size_t size) {
+        BgpUpdateReader reader(data, size);
+        ASSERT_TRUE(reader.Parse());
+
+        const BgpProto::Update *result = static_cast<const BgpProto::Update *>(
+            BgpProto::Decode(data, size));
+        ASSERT_TRUE(result != NULL);
+
+        ComparePrefixes(reader.withdrawn_routes(), result->withdrawn_routes);
+        ComparePrefixes(reader.nlri(), result->nlri);
+
+        BgpAttrSpec spec;
+        reader.GetAttrSpec(&spec);
+        size_t count = 0;
+        for (vector<BgpAttribute *>::const_iterator it =
+             result->path_attributes.begin();
+             it != result->path_attributes.end(); ++it) {
+            if ((*it)->code == BgpAttribute::MPReachNlri ||
+                (*it)->code == BgpAttribute::MPUnreachNlri) {
+                const BgpMpNlri *mp_nlri = static_cast<BgpMpNlri *>(*it);
+                const BgpUpdateReader::MpNlri &reader_nlri =
+                    ((*it)->code == BgpAttribute::MPReachNlri) ?
+                        reader.mp_reach_nlri() : reader.mp_unreach_nlri();
+                EXPECT_TRUE(reader_nlri.present);
+                EXPECT_EQ(mp_nlri->afi, reader_nlri.afi);
+                EXPECT_EQ(mp_nlri->safi, reader_nlri.safi);
+                EXPECT_EQ(mp_nlri->nexthop.size(), reader_nlri.nexthop_size);
+                EXPECT_TRUE(std::equal(mp_nlri->nexthop.begin(),
+                    mp_nlri->nexthop.end(), reader_nlri.nexthop));
+                ComparePrefixes(reader_nlri.prefixes, mp_nlri->nlri);
+                continue;
+            }
+            count++;
+            bool found = false;
+            for (BgpAttrSpec::const_iterator sit = spec.begin();
+                 sit != spec.end(); ++sit) {
+                if ((*sit)->code != (*it)->code)
+                    continue;
+                EXPECT_EQ(0, (*sit)->CompareTo(**it));
+                found = true;
+            }
+            EXPECT_TRUE(found);
+        }
+        EXPECT_EQ(count, spec.size());
+        delete result;
+    }
 };
 
 class BuildUpdateMessage {
@@ -417,6 +517,67 @@ TEST_F(BgpProtoTest, EvpnUpdate) {
     }
 }
 
+TEST_F(BgpProtoTest, UpdateReader) {
+    BgpProto::Update update;
+    GenerateReaderUpdate(&update, BgpAf::IPv4, BgpAf::Unicast);
+    uint8_t data[256];
+
+    int res = BgpProto::Encode(&update, data, 256);
+    EXPECT_NE(-1, res);
+    VerifyReader(data, res);
+}
+
+TEST_F(BgpProtoTest, L3VPNUpdateReader) {
+    BgpProto::Update update;
+    GenerateReaderUpdate(&update, BgpAf::IPv4, BgpAf::Vpn);
+    uint8_t data[256];
+
+    int res = BgpProto::Encode(&update, data, 256);
+    EXPECT_NE(-1, res);
+    VerifyReader(data, res);
+
+    BgpProto::Update *result = BgpUpdateReader::Decode(data, res);
+    ASSERT_TRUE(result != NULL);
+    EXPECT_EQ(static_cast<size_t>(res), result->raw.size());
+    EXPECT_TRUE(std::equal(result->raw.begin(), result->raw.end(), data));
+    ASSERT_TRUE(result->reader != NULL);
+    EXPECT_FALSE(result->reader->nlri().empty() &&
+                 result->reader->mp_reach_nlri().prefixes.empty());
+    delete result;
+}
+
+//
+// Messages that the reader leaves to the generic parser.
+//
+TEST_F(BgpProtoTest, UpdateReaderFallback) {
+    uint8_t data[256];
+
+    // EVPN is not handled by the reader.
+    BgpProto::Update evpn;
+    GenerateReaderUpdate(&evpn, BgpAf::L2Vpn, BgpAf::EVpn);
+    int res = BgpProto::Encode(&evpn, data, 256);
+    EXPECT_NE(-1, res);
+    EXPECT_TRUE(BgpUpdateReader::Decode(data, res) == NULL);
+
+    // Neither are VPN prefixes without a label and route distinguisher.
+    BgpProto::Update update;
+    BgpMessageTest::GenerateUpdateMessage(&update, BgpAf::IPv4, BgpAf::Vpn);
+    res = BgpProto::Encode(&update, data, 256);
+    EXPECT_NE(-1, res);
+    EXPECT_TRUE(BgpUpdateReader::Decode(data, res) == NULL);
+
+    BgpProto::BgpMessage *result = BgpProto::Decode(data, res);
+    EXPECT_TRUE(result != NULL);
+    delete result;
+
+    // Nor anything that's not an UPDATE.
+    BgpProto::OpenMessage open;
+    BgpMessageTest::GenerateOpenMessage(&open);
+    res = BgpProto::Encode(&open, data, 256);
+    EXPECT_NE(-1, res);
+    EXPECT_TRUE(BgpUpdateReader::Decode(data, res) == NULL);
+}
+
 TEST_F(BgpProtoTest, OpenError) {
 
     uint8_t data[] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
@@ -678,6 +839,79 @@ TEST_F(BgpProtoTest, UpdateScale) {
     }
 }
 
+//
+// Compare the decode throughput of the generic parser with that of the
+// reader, using an UPDATE with the attributes from UpdateScale and a full
+// message worth of inet prefixes.
+//
+TEST_F(BgpProtoTest, UpdateDecodeThroughput) {
+    BgpProto::Update update;
+    static const int kIterations = 2000;
+
+    update.path_attributes.push_back(
+        new BgpAttrOrigin(BgpAttrOrigin::INCOMPLETE));
+    update.path_attributes.push_back(new BgpAttrNextHop(0xabcdef01));
+    update.path_attributes.push_back(new BgpAttrLocalPref(100));
+    AsPathSpec *path_spec = new AsPathSpec;
+    AsPathSpec::PathSegment *ps = new AsPathSpec::PathSegment;
+    ps->path_segment_type = AsPathSpec::PathSegment::AS_SEQUENCE;
+    ps->path_segment.push_back(20);
+    ps->path_segment.push_back(21);
+    ps->path_segment.push_back(22);
+    path_spec->path_segments.push_back(ps);
+    update.path_attributes.push_back(path_spec);
+    CommunitySpec *community = new CommunitySpec;
+    community->communities.push_back(0x87654321);
+    update.path_attributes.push_back(community);
+
+    for (int i = 0; i < 900; i++) {
+        BgpProtoPrefix *prefix = new BgpProtoPrefix;
+        prefix->prefixlen = 24;
+        prefix->prefix.push_back(10);
+        prefix->prefix.push_back(i >> 8);
+        prefix->prefix.push_back(i & 0xff);
+        update.nlri.push_back(prefix);
+    }
+
+    uint8_t data[4096];
+    int res = BgpProto::Encode(&update, data, 4096);
+    ASSERT_NE(-1, res);
+
+    uint64_t start = ClockMonotonicUsec();
+    for (int i = 0; i < kIterations; i++) {
+        BgpProto::BgpMessage *result = BgpProto::Decode(data, res);
+        ASSERT_TRUE(result != NULL);
+        delete result;
+    }
+    uint64_t generic_usec = ClockMonotonicUsec() - start;
+
+    size_t count = 0;
+    start = ClockMonotonicUsec();
+    for (int i = 0; i < kIterations; i++) {
+        BgpUpdateReader reader(data, res);
+        ASSERT_TRUE(reader.Parse());
+        BgpAttrSpec spec;
+        reader.GetAttrSpec(&spec);
+        BgpUpdateReader::PrefixIterator nlri = reader.nlri();
+        BgpProtoPrefix prefix;
+        while (nlri.Next(&prefix)) {
+            count++;
+        }
+    }
+    uint64_t reader_usec = ClockMonotonicUsec() - start;
+    generic_usec = generic_usec ? generic_usec : 1;
+    reader_usec = reader_usec ? reader_usec : 1;
+    EXPECT_EQ(update.nlri.size() * kIterations, count);
+
+    cout << res << " byte UPDATE, " << update.nlri.size() << " prefixes" << endl;
+    cout << "Generic parser: "
+         << kIterations * 1000000ULL / generic_usec
+         << " msgs/sec" << endl;
+    cout << "Update reader: "
+         << kIterations * 1000000ULL / reader_usec
+         << " msgs/sec" << endl;
+}
+
 TEST_F(BgpProtoTest, RandomError) {
     uint8_t data[4096];
     int count = 10000;
@@ -12,6 +12,7 @@
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_path.h"
 #include "bgp/bgp_server.h"
+#include "bgp/bgp_table.h"
 #include "bgp/inet/inet_route.h"
 #include "control-node/control_node.h"
 #include "io/event_manager.h"
@@ -20,6 +21,9 @@
 
 class BgpPeerMock : public IPeer {
 public:
+    BgpPeerMock() : bgp_identifier_(0) {
+    }
+
     virtual std::string ToString() const {
         return "test-peer";
     }
@@ -52,7 +56,10 @@ public:
         return BgpProto::IBGP;
     }
     virtual uint32_t bgp_identifier() const {
-        return 0;
+        return bgp_identifier_;
+    }
+    void set_bgp_identifier(uint32_t bgp_identifier) {
+        bgp_identifier_ = bgp_identifier;
     }
     virtual void UpdateRefCount(int count) const { }
     virtual tbb::atomic<int> GetRefCount() const {
@@ -61,6 +68,7 @@ public:
         return count;
     }
 private:
+    uint32_t bgp_identifier_;
 };
 
 class BgpRouteTest : public ::testing::Test {
@@ -134,6 +142,99 @@ TEST_F(BgpRouteTest, Paths) {
     route.RemovePath(&peer);
 }
 
+//
+// Paths are kept in sorted order as they get inserted and deleted, and the
+// return value tells whether the best path or the ECMP-equal set changed.
+//
+TEST_F(BgpRouteTest, IncrementalSelection) {
+    BgpAttrSpec spec;
+    BgpAttrDB *db = server_.attr_db();
+    BgpPeerMock peer;
+    Ip4Prefix prefix;
+    InetRoute route(prefix);
+
+    // Local preference 100 or 200 and a distinct med for each path.
+    static const int kPaths = 64;
+    std::vector<BgpPath *> paths;
+    for (int idx = 0; idx < kPaths; ++idx) {
+        BgpAttr *attr = new BgpAttr(db, spec);
+        attr->set_local_pref((idx % 8) ? 100 : 200);
+        attr->set_med((idx * 37) % kPaths);
+        BgpAttrPtr attr_ptr = db->Locate(attr);
+        paths.push_back(
+            new BgpPath(&peer, idx, BgpPath::BGP_XMPP, attr_ptr, 0, 0));
+    }
+
+    // The first path is the best one, the others are ECMP-equal to it only
+    // if they have local preference 200.
+    EXPECT_TRUE(route.InsertPath(paths[0]));
+    for (int idx = 1; idx < kPaths; ++idx) {
+        EXPECT_EQ((idx % 8) == 0, route.InsertPath(paths[idx]));
+    }
+    EXPECT_EQ(kPaths, route.count());
+
+    const Route::PathList &path_list = route.GetPathList();
+    for (Route::PathList::const_iterator it = path_list.begin(), prev = it++;
+         it != path_list.end(); prev = it++) {
+        EXPECT_FALSE(BgpTable::PathSelection(*it, *prev));
+    }
+    const BgpPath *best_path = route.BestPath();
+    EXPECT_EQ(200, best_path->GetAttr()->local_pref());
+    EXPECT_EQ(0, best_path->GetAttr()->med());
+
+    // Deleting non ECMP paths does not change the best path.
+    for (int idx = 1; idx < kPaths; ++idx) {
+        if (idx % 8)
+            EXPECT_FALSE(route.DeletePath(paths[idx]));
+    }
+    EXPECT_EQ(best_path, route.BestPath());
+    EXPECT_EQ(kPaths / 8, route.count());
+
+    EXPECT_TRUE(route.DeletePath(const_cast<BgpPath *>(best_path)));
+    EXPECT_NE(best_path, route.BestPath());
+    route.RemovePath(&peer);
+    EXPECT_EQ(0, route.count());
+}
+
+//
+// Paths that were ordered by the BGP identifier of the peer are sorted again
+// when the identifier changes while they are on the list.
+//
+TEST_F(BgpRouteTest, PeerIdentifierChange) {
+    BgpAttrSpec spec;
+    BgpAttrDB *db = server_.attr_db();
+    BgpAttrPtr attr = db->Locate(spec);
+    BgpPeerMock peer[3];
+    Ip4Prefix prefix;
+    InetRoute route(prefix);
+
+    for (int idx = 0; idx < 3; ++idx) {
+        peer[idx].set_bgp_identifier(idx + 1);
+    }
+    BgpPath *path0 = new BgpPath(&peer[0], 0, BgpPath::BGP_XMPP, attr, 0, 0);
+    BgpPath *path1 = new BgpPath(&peer[1], 0, BgpPath::BGP_XMPP, attr, 0, 0);
+    route.InsertPath(path0);
+    route.InsertPath(path1);
+    EXPECT_EQ(path0, route.BestPath());
+
+    peer[0].set_bgp_identifier(4);
+    BgpRoute::InvalidatePathOrder();
+    route.InsertPath(
+        new BgpPath(&peer[2], 0, BgpPath::BGP_XMPP, attr, 0, 0));
+    EXPECT_EQ(path1, route.BestPath());
+
+    const Route::PathList &path_list = route.GetPathList();
+    for (Route::PathList::const_iterator it = path_list.begin(), prev = it++;
+         it != path_list.end(); prev = it++) {
+        EXPECT_FALSE(BgpTable::PathSelection(*it, *prev));
+    }
+
+    for (int idx = 0; idx < 3; ++idx) {
+        route.RemovePath(&peer[idx]);
+    }
+    EXPECT_EQ(0, route.count());
+}
+
 }  // namespace
 
 static void SetUp() {
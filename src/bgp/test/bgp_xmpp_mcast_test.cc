@@ -568,10 +568,10 @@ TEST_F(BgpXmppMcastMultiAgentTest, Join) {
     VerifyOListElem(agent_xb_, "blue", mroute, 1, "10.1.1.1", agent_xa_);
     VerifyOListElem(agent_xc_, "blue", mroute, 1, "10.1.1.1", agent_xa_);
 
-    // Make sure that labels have changed for all agents.
+    // Make sure that labels have changed for agents whose links changed.
     TASK_UTIL_EXPECT_NE(label_xa,
         VerifyLabel(agent_xa_, "blue", mroute, 10000, 19999));
-    TASK_UTIL_EXPECT_NE(label_xb,
+    TASK_UTIL_EXPECT_EQ(label_xb,
         VerifyLabel(agent_xb_, "blue", mroute, 20000, 29999));
     TASK_UTIL_EXPECT_NE(label_xc,
         VerifyLabel(agent_xc_, "blue", mroute, 30000, 39999));
@@ -622,10 +622,10 @@ TEST_F(BgpXmppMcastMultiAgentTest, Leave) {
     VerifyOListElem(agent_xb_, "blue", mroute, 1, "10.1.1.1", agent_xa_);
     VerifyOListElem(agent_xc_, "blue", mroute, 0);
 
-    // Make sure that labels have changed for all agents.
+    // Make sure that labels have changed for agents whose links changed.
     TASK_UTIL_EXPECT_NE(label_xa,
         VerifyLabel(agent_xa_, "blue", mroute, 10000, 19999));
-    TASK_UTIL_EXPECT_NE(label_xb,
+    TASK_UTIL_EXPECT_EQ(label_xb,
         VerifyLabel(agent_xb_, "blue", mroute, 20000, 29999));
     TASK_UTIL_EXPECT_NE(label_xc,
         VerifyLabel(agent_xc_, "blue", mroute));
@@ -1143,6 +1143,83 @@ TEST_F(ReplicationTest, AnotherPathWithDifferentRD) {
     VERIFY_EQ(0, RouteCount("green"));
 }
 
+//
+// VPN routes are indexed by their route targets, and only the routes with
+// the route target get visited when an instance starts or stops importing
+// the route target.
+//
+TEST_F(ReplicationTest, RouteTargetIndex) {
+    vector<string> instance_names = list_of("blue")("red")("green");
+    multimap<string, string> connections = map_list_of("blue", "red");
+    NetworkConfig(instance_names, connections);
+    task_util::WaitForIdle();
+
+    boost::system::error_code ec;
+    peers_.push_back(
+        new BgpPeerMock(Ip4Address::from_string("192.168.0.1", ec)));
+
+    BgpTable *table = static_cast<BgpTable *>(
+        bgp_server_->database()->FindTable("bgp.l3vpn.0"));
+    RoutePathReplicator *replicator = bgp_server_->replicator(Address::INETVPN);
+    RouteTarget rtarget1 = RouteTarget::FromString("target:1:1");
+    RouteTarget rtarget2 = RouteTarget::FromString("target:1:2");
+
+    AddVPNRouteWithTarget(peers_[0], "192.168.0.1:1:10.0.1.1/32", 100,
+                          "target:1:1");
+    AddVPNRouteWithTarget(peers_[0], "192.168.0.1:1:10.0.1.2/32", 100,
+                          "target:1:1");
+    AddVPNRouteWithTarget(peers_[0], "192.168.0.1:1:10.0.1.3/32", 100,
+                          "target:1:1");
+    AddVPNRouteWithTarget(peers_[0], "192.168.0.1:1:10.0.2.1/32", 100,
+                          "target:1:2");
+    task_util::WaitForIdle();
+
+    // Routes are indexed, but not imported anywhere.
+    VERIFY_EQ(3, replicator->GetRouteTargetRouteCount(table, rtarget1));
+    VERIFY_EQ(1, replicator->GetRouteTargetRouteCount(table, rtarget2));
+    VERIFY_EQ(0, RouteCount("green"));
+    BgpRoute *rt = VPNRouteLookup("192.168.0.1:1:10.0.1.1/32");
+    ASSERT_TRUE(rt != NULL);
+    VERIFY_EQ(0, replicator->GetReplicationState(table, rt));
+
+    // Import the first route target in green.
+    AddInstanceRouteTarget("green", "target:1:1");
+    VERIFY_EQ(3, RouteCount("green"));
+    TASK_UTIL_EXPECT_TRUE(InetRouteLookup("green", "10.0.1.1/32") != NULL);
+    TASK_UTIL_EXPECT_TRUE(InetRouteLookup("green", "10.0.2.1/32") == NULL);
+    VERIFY_EQ(0, RouteCount("blue"));
+
+    // Move one route to the second route target.
+    AddVPNRouteWithTarget(peers_[0], "192.168.0.1:1:10.0.1.1/32", 100,
+                          "target:1:2");
+    task_util::WaitForIdle();
+    VERIFY_EQ(2, replicator->GetRouteTargetRouteCount(table, rtarget1));
+    VERIFY_EQ(2, replicator->GetRouteTargetRouteCount(table, rtarget2));
+    VERIFY_EQ(2, RouteCount("green"));
+    TASK_UTIL_EXPECT_TRUE(InetRouteLookup("green", "10.0.1.1/32") == NULL);
+
+    // Import the second route target in green as well.
+    AddInstanceRouteTarget("green", "target:1:2");
+    VERIFY_EQ(4, RouteCount("green"));
+
+    // Stop importing the first route target.
+    RemoveInstanceRouteTarget("green", "target:1:1");
+    VERIFY_EQ(2, RouteCount("green"));
+    TASK_UTIL_EXPECT_TRUE(InetRouteLookup("green", "10.0.1.1/32") != NULL);
+    TASK_UTIL_EXPECT_TRUE(InetRouteLookup("green", "10.0.2.1/32") != NULL);
+
+    RemoveInstanceRouteTarget("green", "target:1:2");
+    VERIFY_EQ(0, RouteCount("green"));
+
+    DeleteVPNRoute(peers_[0], "192.168.0.1:1:10.0.1.1/32");
+    DeleteVPNRoute(peers_[0], "192.168.0.1:1:10.0.1.2/32");
+    DeleteVPNRoute(peers_[0], "192.168.0.1:1:10.0.1.3/32");
+    DeleteVPNRoute(peers_[0], "192.168.0.1:1:10.0.2.1/32");
+    task_util::WaitForIdle();
+    VERIFY_EQ(0, replicator->GetRouteTargetRouteCount(table, rtarget1));
+    VERIFY_EQ(0, replicator->GetRouteTargetRouteCount(table, rtarget2));
+}
+
 TEST_F(ReplicationTest, UpdateInstanceRouteTargets1) {
     vector<string> instance_names = list_of("blue")("red");
     multimap<string, string> connections = map_list_of("blue", "red");
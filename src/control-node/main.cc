@@ -14,6 +14,7 @@
 #include "base/logging.h"
 #include "base/connection_info.h"
 #include "base/cpuinfo.h"
+#include "base/timer.h"
 #include "bgp/bgp_config.h"
 #include "bgp/bgp_config_parser.h"
 #include "bgp/bgp_peer.h"
@@ -398,6 +399,11 @@ int main(int argc, char *argv[]) {
         exit(-1);
     }
 
+    // Timers created from here on are multiplexed on per task timer wheels.
+    if (options.timer_wheel_tick()) {
+        TimerManager::EnableTimerWheel(options.timer_wheel_tick());
+    }
+
     ControlNode::SetProgramName(argv[0]);
     Module::type module = Module::CONTROL_NODE;
     string module_name = g_vns_constants.ModuleNames.find(module)->second;
@@ -456,6 +462,7 @@ int main(int argc, char *argv[]) {
     ControlNode::SetTestMode(options.test_mode());
 
     boost::scoped_ptr<BgpServer> bgp_server(new BgpServer(&evm));
+    bgp_server->set_extended_message(options.bgp_extended_message());
     sandesh_context.bgp_server = bgp_server.get();
 
     DB config_db;
@@ -70,6 +70,9 @@ void Options::Initialize(EventManager &evm,
         ("DEFAULT.bgp_config_file",
              opt::value<string>()->default_value("bgp_config.xml"),
              "BGP Configuration file")
+        ("DEFAULT.bgp_extended_message",
+             opt::bool_switch(&bgp_extended_message_),
+             "Advertise BGP extended message capability for UPDATEs up to 64K")
         ("DEFAULT.bgp_port",
              opt::value<uint16_t>()->default_value(default_bgp_port),
              "BGP listener port")
@@ -109,6 +112,9 @@ void Options::Initialize(EventManager &evm,
              "Syslog facility to receive log lines")
         ("DEFAULT.test_mode", opt::bool_switch(&test_mode_),
              "Enable control-node to run in test-mode")
+        ("DEFAULT.timer_wheel_tick", opt::value<int>()->default_value(0),
+             "Tick in msec of the timer wheels running timers, 0 to use an "
+             "ASIO timer per timer")
 
         ("DEFAULT.xmpp_server_port",
              opt::value<uint16_t>()->default_value(default_xmpp_port),
@@ -239,6 +245,7 @@ bool Options::Process(int argc, char *argv[],
     GetOptValue<string>(var_map, log_level_, "DEFAULT.log_level");
     GetOptValue<bool>(var_map, use_syslog_, "DEFAULT.use_syslog");
     GetOptValue<string>(var_map, syslog_facility_, "DEFAULT.syslog_facility");
+    GetOptValue<int>(var_map, timer_wheel_tick_, "DEFAULT.timer_wheel_tick");
     GetOptValue<uint16_t>(var_map, xmpp_port_, "DEFAULT.xmpp_server_port");
 
     GetOptValue<uint16_t>(var_map, discovery_port_, "DISCOVERY.port");
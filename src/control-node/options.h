@@ -12,6 +12,7 @@ public:
     bool Parse(EventManager &evm, int argc, char **argv);
 
     const std::string bgp_config_file() const { return bgp_config_file_; }
+    const bool bgp_extended_message() const { return bgp_extended_message_; }
     const uint16_t bgp_port() const { return bgp_port_; }
     const std::vector<std::string> collector_server_list() const {
         return collector_server_list_;
@@ -37,6 +38,7 @@ public:
     const std::string ifmap_certs_store() const { return ifmap_certs_store_; }
     const uint16_t xmpp_port() const { return xmpp_port_; }
     const bool test_mode() const { return test_mode_; }
+    const int timer_wheel_tick() const { return timer_wheel_tick_; }
     const bool collectors_configured() const { return collectors_configured_; }
 
 private:
@@ -58,6 +60,7 @@ private:
                     boost::program_options::options_description &options);
 
     std::string bgp_config_file_;
+    bool bgp_extended_message_;
     uint16_t bgp_port_;
     std::vector<std::string> collector_server_list_;
     std::string config_file_;
@@ -81,6 +84,7 @@ private:
     std::string ifmap_certs_store_;
     uint16_t xmpp_port_;
     bool test_mode_;
+    int timer_wheel_tick_;
     bool collectors_configured_;
 
     std::vector<std::string> default_collector_server_list_;
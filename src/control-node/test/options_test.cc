@@ -52,6 +52,7 @@ TEST_F(OptionsTest, NoArguments) {
     options_.Parse(evm_, argc, argv);
 
     EXPECT_EQ(options_.bgp_config_file(), "bgp_config.xml");
+    EXPECT_EQ(options_.bgp_extended_message(), false);
     EXPECT_EQ(options_.bgp_port(), default_bgp_port);
     TASK_UTIL_EXPECT_VECTOR_EQ(default_collector_server_list_,
                      options_.collector_server_list());
@@ -74,6 +75,7 @@ TEST_F(OptionsTest, NoArguments) {
     EXPECT_EQ(options_.ifmap_certs_store(), "");
     EXPECT_EQ(options_.xmpp_port(), default_xmpp_port);
     EXPECT_EQ(options_.test_mode(), false);
+    EXPECT_EQ(options_.timer_wheel_tick(), 0);
 }
 
 TEST_F(OptionsTest, DefaultConfFile) {
@@ -87,6 +89,7 @@ TEST_F(OptionsTest, DefaultConfFile) {
     options_.Parse(evm_, argc, argv);
 
     EXPECT_EQ(options_.bgp_config_file(), "bgp_config.xml");
+    EXPECT_EQ(options_.bgp_extended_message(), false);
     EXPECT_EQ(options_.bgp_port(), default_bgp_port);
     TASK_UTIL_EXPECT_VECTOR_EQ(default_collector_server_list_,
                      options_.collector_server_list());
@@ -125,6 +128,7 @@ TEST_F(OptionsTest, OverrideStringFromCommandLine) {
     options_.Parse(evm_, argc, argv);
 
     EXPECT_EQ(options_.bgp_config_file(), "bgp_config.xml");
+    EXPECT_EQ(options_.bgp_extended_message(), false);
     EXPECT_EQ(options_.bgp_port(), default_bgp_port);
     TASK_UTIL_EXPECT_VECTOR_EQ(default_collector_server_list_,
                      options_.collector_server_list());
@@ -163,6 +167,7 @@ TEST_F(OptionsTest, OverrideBooleanFromCommandLine) {
     options_.Parse(evm_, argc, argv);
 
     EXPECT_EQ(options_.bgp_config_file(), "bgp_config.xml");
+    EXPECT_EQ(options_.bgp_extended_message(), false);
     EXPECT_EQ(options_.bgp_port(), default_bgp_port);
     TASK_UTIL_EXPECT_VECTOR_EQ(default_collector_server_list_,
                      options_.collector_server_list());
@@ -186,12 +191,14 @@ TEST_F(OptionsTest, OverrideBooleanFromCommandLine) {
     EXPECT_EQ(options_.ifmap_certs_store(), "");
     EXPECT_EQ(options_.xmpp_port(), default_xmpp_port);
     EXPECT_EQ(options_.test_mode(), true); // Overridden from command line.
+    EXPECT_EQ(options_.timer_wheel_tick(), 0);
 }
 
 TEST_F(OptionsTest, CustomConfigFile) {
     string config = ""
         "[DEFAULT]\n"
         "bgp_config_file=test.xml\n"
+        "bgp_extended_message=1\n"
         "bgp_port=200\n"
         "collectors=10.10.10.1:100\n"
         "collectors=20.20.20.2:200\n"
@@ -207,6 +214,7 @@ TEST_F(OptionsTest, CustomConfigFile) {
         "log_level=SYS_DEBUG\n"
         "log_local=1\n"
         "test_mode=1\n"
+        "timer_wheel_tick=10\n"
         "xmpp_server_port=100\n"
         "\n"
         "[DISCOVERY]\n"
@@ -234,6 +242,7 @@ TEST_F(OptionsTest, CustomConfigFile) {
     options_.Parse(evm_, argc, argv);
 
     EXPECT_EQ(options_.bgp_config_file(), "test.xml");
+    EXPECT_EQ(options_.bgp_extended_message(), true);
     EXPECT_EQ(options_.bgp_port(), 200);
 
     vector<string> collector_server_list;
@@ -262,12 +271,14 @@ TEST_F(OptionsTest, CustomConfigFile) {
     EXPECT_EQ(options_.ifmap_certs_store(), "test-store");
     EXPECT_EQ(options_.xmpp_port(), 100);
     EXPECT_EQ(options_.test_mode(), true);
+    EXPECT_EQ(options_.timer_wheel_tick(), 10);
 }
 
 TEST_F(OptionsTest, CustomConfigFileAndOverrideFromCommandLine) {
     string config = ""
         "[DEFAULT]\n"
         "bgp_config_file=test.xml\n"
+        "bgp_extended_message=1\n"
         "bgp_port=200\n"
         "collectors=10.10.10.1:100\n"
         "collectors=20.20.20.2:200\n"
@@ -283,6 +294,7 @@ TEST_F(OptionsTest, CustomConfigFileAndOverrideFromCommandLine) {
         "log_level=SYS_DEBUG\n"
         "log_local=0\n"
         "test_mode=1\n"
+        "timer_wheel_tick=10\n"
         "xmpp_server_port=100\n"
         "\n"
         "[DISCOVERY]\n"
@@ -320,6 +332,7 @@ TEST_F(OptionsTest, CustomConfigFileAndOverrideFromCommandLine) {
     options_.Parse(evm_, argc, argv);
 
     EXPECT_EQ(options_.bgp_config_file(), "test.xml");
+    EXPECT_EQ(options_.bgp_extended_message(), true);
     EXPECT_EQ(options_.bgp_port(), 200);
 
     vector<string> collector_server_list;
@@ -349,6 +362,7 @@ TEST_F(OptionsTest, CustomConfigFileAndOverrideFromCommandLine) {
     EXPECT_EQ(options_.ifmap_certs_store(), "test-store");
     EXPECT_EQ(options_.xmpp_port(), 100);
     EXPECT_EQ(options_.test_mode(), true);
+    EXPECT_EQ(options_.timer_wheel_tick(), 10);
 }
 
 TEST_F(OptionsTest, CustomConfigFileWithInvalidHostIp) {
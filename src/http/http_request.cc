@@ -9,7 +9,8 @@
 using namespace std;
 
 HttpRequest::HttpRequest() :
-    method_(static_cast<http_method>(-1)), event_(TcpSession::EVENT_NONE) {
+    method_(static_cast<http_method>(-1)), event_(TcpSession::EVENT_NONE),
+    keep_alive_(false), bad_request_(false) {
 }
 
 string HttpRequest::ToString() const {
@@ -30,6 +30,8 @@ public:
         body_.append(data, length);
     }
     void SetEvent(enum TcpSession::Event event) { event_ = event; }
+    void SetKeepAlive(bool keep_alive) { keep_alive_ = keep_alive; }
+    void SetBadRequest() { bad_request_ = true; }
 
     std::string ToString() const;
 
@@ -38,12 +40,19 @@ public:
     const HeaderMap & Headers() const { return headers_; }
     const std::string & Body() const { return body_; }
     TcpSession::Event Event() const { return event_; }
+    // Whether the client expects the connection to remain open after the
+    // response (HTTP/1.1 default, or HTTP/1.0 with keep-alive).
+    bool KeepAlive() const { return keep_alive_; }
+    // Input that failed to parse, answered with 400 Bad Request.
+    bool BadRequest() const { return bad_request_; }
 private:
     http_method method_;
     std::string url_;
     HeaderMap headers_;
     std::string body_;
     TcpSession::Event event_; // used when the request indicates an event
+    bool keep_alive_;
+    bool bad_request_;
 };
 
 #endif
@@ -9,8 +9,89 @@
 
 using namespace std;
 
-HttpServer::HttpServer(EventManager *evm) : TcpServer(evm) {
-    //ctor
+//
+// Trie of path segments used to look up the handler of a request. Lookup
+// walks down one node per segment of the path, keeping track of the deepest
+// prefix handler, so that its cost does not depend on the number of
+// registered handlers.
+//
+class HttpServer::HandlerTrie {
+public:
+    HandlerTrie() : root_(new Node()) {
+    }
+
+    void Insert(const string &path, HttpHandlerFn handler, bool prefix) {
+        Node *node = root_.get();
+        size_t pos = 0;
+        string segment;
+        while (NextSegment(path, &pos, &segment)) {
+            Node::ChildMap::iterator it = node->children.find(segment);
+            if (it == node->children.end()) {
+                it = node->children.insert(
+                    make_pair(segment, new Node())).first;
+            }
+            node = it->second;
+        }
+        HttpHandlerFn *fn = prefix ? &node->prefix : &node->exact;
+        if (fn->empty()) {
+            *fn = handler;
+        }
+    }
+
+    HttpHandlerFn Find(const string &path) const {
+        const Node *node = root_.get();
+        const HttpHandlerFn *match = &node->prefix;
+        size_t pos = 0;
+        string segment;
+        while (NextSegment(path, &pos, &segment)) {
+            Node::ChildMap::const_iterator it = node->children.find(segment);
+            if (it == node->children.end()) {
+                return *match;
+            }
+            node = it->second;
+            if (!node->prefix.empty()) {
+                match = &node->prefix;
+            }
+        }
+        return node->exact.empty() ? *match : node->exact;
+    }
+
+private:
+    struct Node {
+        typedef map<string, Node *> ChildMap;
+        ~Node() {
+            STLDeleteElements(&children);
+        }
+        HttpHandlerFn exact;
+        HttpHandlerFn prefix;
+        ChildMap children;
+    };
+
+    // Extract the segment that starts at *pos. The leading '/' is ignored,
+    // a trailing one yields an empty last segment such that "/a" and "/a/"
+    // remain distinct.
+    static bool NextSegment(const string &path, size_t *pos,
+                            string *segment) {
+        if (*pos == 0 && !path.empty() && path[0] == '/') {
+            *pos = 1;
+        }
+        if (*pos > path.size() || (*pos == path.size() && *pos <= 1)) {
+            return false;
+        }
+        size_t end = path.find('/', *pos);
+        if (end == string::npos) {
+            end = path.size();
+        }
+        segment->assign(path, *pos, end - *pos);
+        *pos = end + 1;
+        return true;
+    }
+
+    boost::scoped_ptr<Node> root_;
+};
+
+HttpServer::HttpServer(EventManager *evm)
+    : TcpServer(evm), http_handlers_(new HandlerTrie()) {
 }
 
 HttpServer::~HttpServer() {
@@ -18,7 +99,7 @@ HttpServer::~HttpServer() {
 }
 
 void HttpServer::Shutdown() {
-    http_handlers_.clear();
+    http_handlers_.reset(new HandlerTrie());
     TcpServer::Shutdown();
 }
 
@@ -40,18 +121,22 @@ bool HttpServer::AcceptSession(TcpSession *session) {
 }
 
 void HttpServer::RegisterHandler(const string &path, HttpHandlerFn handler) {
-    http_handlers_.insert(make_pair(path, handler));
+    if (path == HTTP_WILDCARD_ENTRY) {
+        http_handlers_->Insert("", handler, true);
+    } else {
+        http_handlers_->Insert(path, handler, false);
+    }
 }
 
-HttpServer::HttpHandlerFn HttpServer::GetHandler(const string &path) {
-    HandlerTrie::iterator iter = http_handlers_.find(path);
-    if (iter == http_handlers_.end()) {
-        // check if wildcard entry is present
-        iter = http_handlers_.find(HTTP_WILDCARD_ENTRY);
-        if (iter == http_handlers_.end()) {
-    	    return NULL;
-        }
+void HttpServer::RegisterPrefixHandler(const string &prefix,
+                                       HttpHandlerFn handler) {
+    string path(prefix);
+    if (path.size() > 1 && path[path.size() - 1] == '/') {
+        path.erase(path.size() - 1);
     }
-    return iter->second;
+    http_handlers_->Insert(path, handler, true);
 }
 
+HttpServer::HttpHandlerFn HttpServer::GetHandler(const string &path) {
+    return http_handlers_->Find(path);
+}
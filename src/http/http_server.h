@@ -9,6 +9,7 @@
 #include <string>
 
 #include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include "io/tcp_server.h"
 #include "base/util.h"
@@ -29,13 +30,19 @@ public:
     virtual TcpSession *AllocSession(Socket *socket);
     virtual bool AcceptSession(TcpSession *session);
 
+    // Handler for the given path. HTTP_WILDCARD_ENTRY registers the handler
+    // for all the paths that have no other match.
     void RegisterHandler(const std::string &path, HttpHandlerFn handler);
+    // Handler for all the paths under the given one, e.g. "/static" matches
+    // "/static/css/style.css". The longest matching prefix wins.
+    void RegisterPrefixHandler(const std::string &prefix,
+                               HttpHandlerFn handler);
     HttpHandlerFn GetHandler(const std::string &path);
     void Shutdown();
 
 private:
-    typedef std::map<std::string, HttpHandlerFn> HandlerTrie;
-    HandlerTrie http_handlers_;
+    class HandlerTrie;
+    boost::scoped_ptr<HandlerTrie> http_handlers_;
     DISALLOW_COPY_AND_ASSIGN(HttpServer);
 };
 
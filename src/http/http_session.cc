@@ -4,6 +4,7 @@
 
 #include "http/http_session.h"
 
+#include <deque>
 #include <map>
 #include <boost/bind.hpp>
 #include <cstdio>
@@ -25,34 +26,41 @@ HttpSession::map_type * HttpSession::context_map_ = 0;
 tbb::mutex HttpSession::map_mutex_;
 tbb::atomic<long> HttpSession::task_count_;
 
-// Input processing context
+// Input processing context. The parser state is kept across requests, such
+// that pipelined requests and requests split across reads are handled.
 class HttpSession::RequestBuilder {
 public:
-    RequestBuilder() : complete_(false) {
+    RequestBuilder() {
         parser_.data = this;
         Clear();
     }
 
+    ~RequestBuilder() {
+        STLDeleteValues(&complete_);
+    }
+
     void Clear() {
         http_parser_init(&parser_, HTTP_REQUEST);
         request_.reset(new HttpRequest());
-        complete_ = false;
+        tmp_url_.clear();
         header_key_.clear();
         header_value_.clear();
     }
-    size_t Parse(const u_int8_t *data, size_t datalen) {
-        size_t nparsed = 
+
+    // Returns false on a parse error.
+    bool Parse(const u_int8_t *data, size_t datalen) {
+        size_t nparsed =
             http_parser_execute(&parser_, &settings_,
                     reinterpret_cast<const char *>(data), datalen);
-        return nparsed;
+        return (nparsed == datalen && HTTP_PARSER_ERRNO(&parser_) == HPE_OK);
     }
 
-    bool complete() const { return complete_; }
+    bool complete() const { return !complete_.empty(); }
 
-    // Transfers ownership
+    // Transfers ownership of the oldest complete request.
     HttpRequest *GetRequest() {
-        HttpRequest *request = request_.get();
-        request_.release();
+        HttpRequest *request = complete_.front();
+        complete_.pop_front();
         return request;
     }
 private:
@@ -72,7 +80,9 @@ private:
     static int OnMessageComplete(struct http_parser *parser) {
         RequestBuilder *builder =
             reinterpret_cast<RequestBuilder *>(parser->data);
-        builder->complete_ = true;
+        builder->request_->SetKeepAlive(http_should_keep_alive(parser));
+        builder->complete_.push_back(builder->request_.release());
+        builder->request_.reset(new HttpRequest());
         return 0;
     }
 
@@ -126,7 +136,7 @@ private:
     struct http_parser parser_;
     std::auto_ptr<HttpRequest> request_;
 
-    bool complete_;
+    std::deque<HttpRequest *> complete_;
     string tmp_url_;        // temporary: used while parsing
     string header_key_;
     string header_value_;
@@ -167,9 +177,26 @@ public:
 ;
         session->Send(reinterpret_cast<const u_int8_t *>(no_response),
               sizeof(no_response), NULL);
+        session->SendResponseDone();
         delete request;
     }
 
+    void BadRequest(HttpSession *session) {
+        static const char bad_request[] =
+"HTTP/1.1 400 Bad Request\r\n"
+"Content-Type: text/html; charset=UTF-8\r\n"
+"Content-Length: 47\r\n"
+"Connection: close\r\n"
+"\r\n"
+"<html>\n"
+"<title>400 Bad Request</title>\n"
+"</html>\r\n"
+;
+        session->Send(reinterpret_cast<const u_int8_t *>(bad_request),
+              sizeof(bad_request) - 1, NULL);
+        session->SendResponseDone();
+    }
+
     // Retrieve a request item from the queue. Return true if the queue
     // is empty _after_ the pop, false otherwise.
     bool FromQ(HttpRequest *& r) {
@@ -183,12 +210,20 @@ public:
         bool del_session = false;
         HttpServer *server = static_cast<HttpServer *>(session_->server());
         while (true) {
+            // Later requests wait for the deferred response to be done.
+            if (session_->response_deferred_) break;
             request = NULL;
             bool empty = FromQ(request);
             if (!request) break;
             HTTP_SYS_LOG("HttpSession", SandeshLevel::UT_INFO,
                          "URL is " + request->ToString());
-            if (request->ToString().empty()) {
+            if (request->BadRequest()) {
+                if (!session_->close_after_response()) {
+                    session_->SetCloseAfterResponse();
+                    BadRequest(session_.get());
+                }
+                delete request;
+            } else if (request->ToString().empty()) {
                 if (session_->event_cb_ && !session_->event_cb_.empty()) {
                     session_->event_cb_(session_.get(), request->Event());
                 }
@@ -196,6 +231,9 @@ public:
                 session_->set_observer(NULL);
                 session_->Close();
                 delete request;
+            } else if (session_->close_after_response()) {
+                // Pipelined after a request without keep-alive
+                delete request;
             } else {
                 HttpServer::HttpHandlerFn handler =
                         server->GetHandler(request->UrlPath());
@@ -203,7 +241,11 @@ public:
                     handler = boost::bind(&RequestHandler::NotFound,
                                           this, _1, _2);
                 }
+                if (!request->KeepAlive()) {
+                    session_->SetCloseAfterResponse();
+                }
                 handler(session_.get(), request);
+                if (session_->response_deferred_) break;
             }
 
             // If the queue was empty, do not proceed further. If new request
@@ -224,7 +266,11 @@ private:
 };
 
 HttpSession::HttpSession(HttpServer *server, Socket *socket)
-    : TcpSession(server, socket), event_cb_(NULL) {
+    : TcpSession(server, socket), event_cb_(NULL), bad_request_(false) {
+    close_after_response_ = false;
+    response_written_ = false;
+    response_deferred_ = false;
+    closing_ = false;
     if (req_handler_task_id_ == -1) {
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
         req_handler_task_id_ = scheduler->GetTaskId("http::RequestHandlerTask");
@@ -256,9 +302,12 @@ void HttpSession::OnSessionEvent(TcpSession *session,
     HttpSession *h_session = dynamic_cast<HttpSession *>(session);
     assert(h_session);
 
-    bool was_empty = false;
+    bool enqueue = false;
     switch (event) {
     case TcpSession::CLOSE:
+        if (closing_.fetch_and_store(true)) {
+            break;
+        }
         {
             tbb::mutex::scoped_lock lock(map_mutex_);
             if (GetMap()->erase(h_session->context_str_)) {
@@ -274,7 +323,10 @@ void HttpSession::OnSessionEvent(TcpSession *session,
             string nourl = "";
             request->SetUrl(&nourl);
             request->SetEvent(event);
-            was_empty = request_queue_.empty();
+            // A deferred response can no longer be delivered, so requests
+            // held behind it are released to reach the close.
+            enqueue = request_queue_.empty();
+            enqueue |= response_deferred_.fetch_and_store(false);
             request_queue_.push(request);
         }
         break;
@@ -282,14 +334,18 @@ void HttpSession::OnSessionEvent(TcpSession *session,
         break;
     }
 
-    if (was_empty) {
-        TaskScheduler *scheduler = TaskScheduler::GetInstance();
-        RequestHandler *task = new RequestHandler(this);
-        HttpSession::task_count_++;
-        scheduler->Enqueue(task);
+    if (enqueue) {
+        EnqueueRequestHandler();
     }
 }
 
+void HttpSession::EnqueueRequestHandler() {
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    RequestHandler *task = new RequestHandler(this);
+    HttpSession::task_count_++;
+    scheduler->Enqueue(task);
+}
+
 void HttpSession::OnRead(Buffer buffer) {
     const u_int8_t *data = BufferData(buffer);
     size_t size = BufferSize(buffer);
@@ -303,24 +359,117 @@ void HttpSession::OnRead(Buffer buffer) {
             ReleaseBuffer(buffer);
             return;
         }
+        if (bad_request_) {
+            ReleaseBuffer(buffer);
+            return;
+        }
         if (request_builder_.get() == NULL) {
             request_builder_.reset(new RequestBuilder());
         }
-        request_builder_->Parse(data, size);
-        if (request_builder_->complete()) {
-            was_empty = request_queue_.empty();
+        bool parsed = request_builder_->Parse(data, size);
+
+        // A single read may complete several pipelined requests. They are
+        // queued in order and answered in order by the RequestHandler.
+        was_empty = request_queue_.empty();
+        bool queued = false;
+        while (request_builder_->complete()) {
             HttpRequest *request = request_builder_->GetRequest();
             HTTP_SYS_LOG("HttpSession", SandeshLevel::UT_DEBUG, request->ToString());
             request_queue_.push(request);
-            request_builder_->Clear();
+            queued = true;
+        }
+
+        // Input after a parse error cannot be framed. Answer it with an
+        // error after the requests that preceded it, then close.
+        if (!parsed) {
+            HTTP_SYS_LOG("HttpSession", SandeshLevel::UT_ERROR,
+                         "Request parse error");
+            bad_request_ = true;
+            request_builder_.reset();
+            HttpRequest *request = new HttpRequest();
+            request->SetBadRequest();
+            request_queue_.push(request);
+            queued = true;
         }
+        was_empty = was_empty && queued;
     }
     if (was_empty) {
-        TaskScheduler *scheduler = TaskScheduler::GetInstance();
-        RequestHandler *task = new RequestHandler(this);
-        HttpSession::task_count_++;
-        scheduler->Enqueue(task);
+        EnqueueRequestHandler();
     }
-    // TODO: error handling
     ReleaseBuffer(buffer);
 }
+
+void HttpSession::SendResponseDone() {
+    if (close_after_response_) {
+        response_written_ = true;
+        CloseIfResponseWritten();
+    }
+    if (response_deferred_.fetch_and_store(false) && !request_queue_.empty()) {
+        EnqueueRequestHandler();
+    }
+}
+
+void HttpSession::DeferResponse() {
+    response_deferred_ = true;
+}
+
+void HttpSession::WriteReady(const boost::system::error_code &error) {
+    if (response_written_) {
+        CloseIfResponseWritten();
+    }
+}
+
+// Close once the complete response has left the session. The socket is
+// closed through the same path as a close by the peer.
+void HttpSession::CloseIfResponseWritten() {
+    if (IsWritePending()) {
+        return;
+    }
+    OnSessionEvent(this, TcpSession::CLOSE);
+}
+
+bool HttpSession::SendChunkedResponseHeader(const string &content_type,
+                                            bool keep_alive) {
+    string header("HTTP/1.1 200 OK\r\n"
+                  "Content-Type: " + content_type + "\r\n"
+                  "Transfer-Encoding: chunked\r\n");
+    if (!keep_alive || close_after_response_) {
+        header += "Connection: close\r\n";
+    }
+    header += "\r\n";
+    return Send(reinterpret_cast<const u_int8_t *>(header.c_str()),
+                header.size(), NULL);
+}
+
+//
+// The chunk is framed by a size line and a trailing CRLF around the data.
+// The data is not copied into a frame; TcpSession copies whatever cannot
+// be written to the socket right away.
+//
+bool HttpSession::SendChunk(const u_int8_t *data, size_t size) {
+    if (size == 0) {
+        return true;
+    }
+    char prefix[32];
+    int len = snprintf(prefix, sizeof(prefix), "%zx\r\n", size);
+    static const char suffix[] = "\r\n";
+
+    bool ret = Send(reinterpret_cast<const u_int8_t *>(prefix), len, NULL);
+    ret &= Send(data, size, NULL);
+    ret &= Send(reinterpret_cast<const u_int8_t *>(suffix),
+                sizeof(suffix) - 1, NULL);
+    return ret;
+}
+
+bool HttpSession::SendChunk(const string &data) {
+    return SendChunk(reinterpret_cast<const u_int8_t *>(data.c_str()),
+                     data.size());
+}
+
+bool HttpSession::SendLastChunk() {
+    static const char last_chunk[] = "0\r\n\r\n";
+    bool ret = Send(reinterpret_cast<const u_int8_t *>(last_chunk),
+                    sizeof(last_chunk) - 1, NULL);
+    SendResponseDone();
+    return ret;
+}
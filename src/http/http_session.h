@@ -49,8 +49,32 @@ class HttpSession: public TcpSession {
     void AcceptSession();
     void RegisterEventCb(SessionEventCb cb);
 
+    // Ends the response to the current request. Connections of requests
+    // without keep-alive (HTTP/1.0, or "Connection: close") are closed once
+    // the response has been written; requests pipelined after such a
+    // request are dropped. A response may take any number of Send calls
+    // before this. SendLastChunk ends a chunked response.
+    void SendResponseDone();
+
+    // Called by a handler that answers the current request after returning,
+    // e.g. once a backend replies. Requests pipelined after it are held
+    // until SendResponseDone, such that responses go out in request order.
+    void DeferResponse();
+
+    // HTTP/1.1 chunked transfer encoding, for handlers that stream a large
+    // response as it is produced (e.g. while walking a table) instead of
+    // building it in memory first. Data that cannot be written right away
+    // is queued in the session; the return value is false in that case and
+    // may be used to pace the producer.
+    bool SendChunkedResponseHeader(const std::string &content_type,
+                                   bool keep_alive = true);
+    bool SendChunk(const u_int8_t *data, size_t size);
+    bool SendChunk(const std::string &data);
+    bool SendLastChunk();
+
   protected:
     virtual void OnRead(Buffer buffer);
+    virtual void WriteReady(const boost::system::error_code &error);
 
   private:
     class RequestBuilder;
@@ -60,6 +84,10 @@ class HttpSession: public TcpSession {
 
     void OnSessionEvent(TcpSession *session,
             enum TcpSession::Event event);
+    void SetCloseAfterResponse() { close_after_response_ = true; }
+    bool close_after_response() const { return close_after_response_; }
+    void CloseIfResponseWritten();
+    void EnqueueRequestHandler();
 
     static map_type* GetMap() {
         if (!context_map_) {
@@ -83,6 +111,11 @@ class HttpSession: public TcpSession {
     std::string context_str_;
     std::string client_context_str_;
     SessionEventCb event_cb_;
+    bool bad_request_;                      // parse error, input is dropped
+    tbb::atomic<bool> close_after_response_;
+    tbb::atomic<bool> response_written_;
+    tbb::atomic<bool> response_deferred_;   // async handler has not replied
+    tbb::atomic<bool> closing_;
 
     static int req_handler_task_id_;
     static map_type* context_map_;
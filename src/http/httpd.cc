@@ -36,6 +36,7 @@ public:
 ;
 	session->Send(reinterpret_cast<const u_int8_t *>(response),
 		      sizeof(response), NULL);
+        session->SendResponseDone();
         delete request;
     }
 };
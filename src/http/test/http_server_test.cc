@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <tbb/atomic.h>
+
+#include "base/logging.h"
+#include "base/test/task_test_util.h"
+#include "http/http_request.h"
+#include "http/http_server.h"
+#include "http/http_session.h"
+#include "io/event_manager.h"
+#include "io/test/event_manager_test.h"
+#include "testing/gunit.h"
+
+using namespace std;
+
+static void SendResponse(HttpSession *session, const string &body) {
+    string response = "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: " + boost::lexical_cast<string>(body.size()) +
+        "\r\n\r\n" + body;
+    session->Send(reinterpret_cast<const u_int8_t *>(response.c_str()),
+                  response.size(), NULL);
+    session->SendResponseDone();
+}
+
+class HttpServerTest : public ::testing::Test {
+public:
+    void Record(const string &tag, HttpSession *session,
+                const HttpRequest *request) {
+        handled_.push_back(tag);
+    }
+
+protected:
+    HttpServerTest() : evm_(new EventManager()), deferred_(NULL) {
+        echo_count_ = 0;
+    }
+
+    virtual void SetUp() {
+        server_ = new HttpServer(evm_.get());
+        server_->RegisterPrefixHandler("/echo",
+            boost::bind(&HttpServerTest::Echo, this, _1, _2));
+        server_->RegisterHandler("/async",
+            boost::bind(&HttpServerTest::Async, this, _1, _2));
+        server_->RegisterHandler("/chunked",
+            boost::bind(&HttpServerTest::Chunked, this, _1, _2));
+        server_->Initialize(0);
+        thread_.reset(new ServerThread(evm_.get()));
+        thread_->Start();
+        task_util::WaitForIdle();
+    }
+
+    virtual void TearDown() {
+        server_->Shutdown();
+        server_->ClearSessions();
+        task_util::WaitForIdle();
+        TcpServerManager::DeleteServer(server_);
+        evm_->Shutdown();
+        if (thread_.get() != NULL) {
+            thread_->Join();
+        }
+        task_util::WaitForIdle();
+    }
+
+    void Echo(HttpSession *session, const HttpRequest *request) {
+        echo_count_++;
+        SendResponse(session, request->UrlPath());
+        delete request;
+    }
+
+    // Answered later by the test, in two sends.
+    void Async(HttpSession *session, const HttpRequest *request) {
+        session->DeferResponse();
+        deferred_ = session;
+        delete request;
+    }
+
+    void Chunked(HttpSession *session, const HttpRequest *request) {
+        session->SendChunkedResponseHeader("text/plain");
+        session->SendChunk("hello ");
+        session->SendChunk("world");
+        session->SendLastChunk();
+        delete request;
+    }
+
+    // Dispatch path to the registered handler and return its tag.
+    string Dispatch(const string &path) {
+        handled_.clear();
+        HttpServer::HttpHandlerFn handler = server_->GetHandler(path);
+        if (handler == NULL) {
+            return "";
+        }
+        handler(NULL, NULL);
+        return handled_.empty() ? "" : handled_.back();
+    }
+
+    int Connect() {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        EXPECT_LE(0, fd);
+        struct timeval tv = { 5, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(server_->GetPort());
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        EXPECT_EQ(0, connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                             sizeof(addr)));
+        return fd;
+    }
+
+    void Write(int fd, const string &data) {
+        EXPECT_EQ((ssize_t) data.size(), write(fd, data.c_str(), data.size()));
+    }
+
+    // Read until the server closes the connection. Returns false if the
+    // connection is still open when the read times out.
+    bool ReadAll(int fd, string *data) {
+        char buf[4096];
+        while (true) {
+            ssize_t len = read(fd, buf, sizeof(buf));
+            if (len == 0) {
+                return true;
+            }
+            if (len < 0) {
+                return false;
+            }
+            data->append(buf, len);
+        }
+    }
+
+    // Read until data holds expected, or the read times out.
+    void ReadUntil(int fd, const string &expected, string *data) {
+        char buf[4096];
+        while (data->find(expected) == string::npos) {
+            ssize_t len = read(fd, buf, sizeof(buf));
+            if (len <= 0) {
+                return;
+            }
+            data->append(buf, len);
+        }
+    }
+
+    auto_ptr<EventManager> evm_;
+    auto_ptr<ServerThread> thread_;
+    HttpServer *server_;
+    vector<string> handled_;
+    tbb::atomic<int> echo_count_;
+    HttpSession *deferred_;
+};
+
+// Exact path, then the longest prefix, then the wildcard entry.
+TEST_F(HttpServerTest, PrefixDispatch) {
+    server_->RegisterHandler("/static/index.html",
+        boost::bind(&HttpServerTest::Record, this, "exact", _1, _2));
+    server_->RegisterPrefixHandler("/static",
+        boost::bind(&HttpServerTest::Record, this, "static", _1, _2));
+    server_->RegisterPrefixHandler("/static/css",
+        boost::bind(&HttpServerTest::Record, this, "css", _1, _2));
+    EXPECT_EQ("", Dispatch("/unknown"));
+
+    server_->RegisterHandler(HTTP_WILDCARD_ENTRY,
+        boost::bind(&HttpServerTest::Record, this, "wildcard", _1, _2));
+    EXPECT_EQ("exact", Dispatch("/static/index.html"));
+    EXPECT_EQ("static", Dispatch("/static"));
+    EXPECT_EQ("static", Dispatch("/static/js/main.js"));
+    EXPECT_EQ("css", Dispatch("/static/css/style.css"));
+    EXPECT_EQ("wildcard", Dispatch("/staticfile"));
+    EXPECT_EQ("wildcard", Dispatch("/unknown"));
+}
+
+// Pipelined requests are answered in order, and the connection is closed
+// after the response to the request with "Connection: close".
+TEST_F(HttpServerTest, Pipelined) {
+    int fd = Connect();
+    Write(fd, "GET /echo/1 HTTP/1.1\r\nHost: localhost\r\n\r\n"
+              "GET /echo/2 HTTP/1.1\r\nHost: localhost\r\n\r\n"
+              "GET /echo/3 HTTP/1.1\r\nHost: localhost\r\n"
+              "Connection: close\r\n\r\n"
+              "GET /echo/4 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    string data;
+    EXPECT_TRUE(ReadAll(fd, &data));
+    close(fd);
+
+    size_t pos1 = data.find("/echo/1");
+    size_t pos2 = data.find("/echo/2");
+    size_t pos3 = data.find("/echo/3");
+    ASSERT_NE(string::npos, pos1);
+    ASSERT_NE(string::npos, pos2);
+    ASSERT_NE(string::npos, pos3);
+    EXPECT_LT(pos1, pos2);
+    EXPECT_LT(pos2, pos3);
+    EXPECT_EQ(string::npos, data.find("/echo/4"));
+}
+
+// Request split across reads, on a connection that stays open.
+TEST_F(HttpServerTest, SplitRequest) {
+    int fd = Connect();
+    Write(fd, "GET /echo/split HTTP/1.1\r\nHo");
+    usleep(50000);
+    Write(fd, "st: localhost\r\n\r\n");
+    string data;
+    ReadUntil(fd, "/echo/split", &data);
+    EXPECT_NE(string::npos, data.find("HTTP/1.1 200 OK"));
+    EXPECT_NE(string::npos, data.find("/echo/split"));
+
+    Write(fd, "GET /echo/next HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    ReadUntil(fd, "/echo/next", &data);
+    EXPECT_NE(string::npos, data.find("/echo/next"));
+    close(fd);
+}
+
+// HTTP/1.0 requests without keep-alive are closed after the response.
+TEST_F(HttpServerTest, Http10Close) {
+    int fd = Connect();
+    Write(fd, "GET /echo/old HTTP/1.0\r\n\r\n");
+    string data;
+    EXPECT_TRUE(ReadAll(fd, &data));
+    EXPECT_NE(string::npos, data.find("/echo/old"));
+    close(fd);
+}
+
+// A request pipelined after one that is answered asynchronously is not
+// handled until that response is done, and its response follows it.
+TEST_F(HttpServerTest, DeferredResponseOrder) {
+    int fd = Connect();
+    Write(fd, "GET /async HTTP/1.1\r\nHost: localhost\r\n\r\n"
+              "GET /echo/after HTTP/1.1\r\nHost: localhost\r\n"
+              "Connection: close\r\n\r\n");
+    TASK_UTIL_EXPECT_TRUE(deferred_ != NULL);
+    task_util::WaitForIdle();
+    EXPECT_EQ(0, echo_count_);
+
+    string body = "async";
+    string response = "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: 5\r\n\r\n";
+    deferred_->Send(reinterpret_cast<const u_int8_t *>(response.c_str()),
+                    response.size(), NULL);
+    deferred_->Send(reinterpret_cast<const u_int8_t *>(body.c_str()),
+                    body.size(), NULL);
+    deferred_->SendResponseDone();
+
+    string data;
+    EXPECT_TRUE(ReadAll(fd, &data));
+    close(fd);
+    EXPECT_EQ(1, echo_count_);
+
+    size_t async = data.find("async");
+    size_t after = data.find("/echo/after");
+    ASSERT_NE(string::npos, async);
+    ASSERT_NE(string::npos, after);
+    EXPECT_LT(async, after);
+}
+
+TEST_F(HttpServerTest, ChunkedResponse) {
+    int fd = Connect();
+    Write(fd, "GET /chunked HTTP/1.1\r\nHost: localhost\r\n"
+              "Connection: close\r\n\r\n");
+    string data;
+    EXPECT_TRUE(ReadAll(fd, &data));
+    close(fd);
+
+    EXPECT_EQ("HTTP/1.1 200 OK\r\n"
+              "Content-Type: text/plain\r\n"
+              "Transfer-Encoding: chunked\r\n"
+              "Connection: close\r\n"
+              "\r\n"
+              "6\r\nhello \r\n"
+              "5\r\nworld\r\n"
+              "0\r\n\r\n", data);
+}
+
+// Parse error is answered with 400 after the preceding requests, and the
+// connection is closed.
+TEST_F(HttpServerTest, ParseError) {
+    int fd = Connect();
+    Write(fd, "GET /echo/good HTTP/1.1\r\nHost: localhost\r\n\r\n"
+              "NOT AN HTTP REQUEST\r\n\r\n");
+    string data;
+    EXPECT_TRUE(ReadAll(fd, &data));
+    close(fd);
+
+    size_t good = data.find("/echo/good");
+    size_t bad = data.find("HTTP/1.1 400 Bad Request");
+    ASSERT_NE(string::npos, good);
+    ASSERT_NE(string::npos, bad);
+    EXPECT_LT(good, bad);
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -31,6 +31,9 @@ public:
     typedef boost::function<void(const error_code &ec)> SendReadyCb;
     void RegisterNotification(SendReadyCb);
 
+    // Data is queued waiting for the socket to become writable.
+    bool IsPending() const { return !buffer_queue_.empty(); }
+
 private:
     typedef boost::intrusive_ptr<TcpSession> TcpSessionPtr;
     typedef std::list<boost::asio::mutable_buffer> BufferQueue;
@@ -262,6 +262,11 @@ void TcpSession::AsyncWriteHandler(TcpSessionPtr session,
     }
 }
 
+bool TcpSession::IsWritePending() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return writer_->IsPending();
+}
+
 bool TcpSession::Send(const u_int8_t *data, size_t size, size_t *sent) {
     bool ret = true;
     tbb::mutex::scoped_lock lock(mutex_);
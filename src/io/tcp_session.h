@@ -114,6 +114,11 @@ public:
         return closed_;
     }
 
+    // Returns true if data passed to Send is still queued in the session,
+    // waiting for the socket to become writable. WriteReady is called
+    // once it has been written.
+    bool IsWritePending() const;
+
     Endpoint remote_endpoint() const {
         return remote_;
     }
@@ -40,8 +40,7 @@ bool KSyncNetlinkEntry::Add() {
         free(msg);
         return true;
     }
-    KSyncSock   *sock = KSyncSock::Get(0);
-    sock->SendAsync(this, msg_len, msg, KSyncEntry::ADD_ACK);
+    SendMsg(msg, msg_len, KSyncEntry::ADD_ACK);
     return false;
 }
 
@@ -59,8 +58,7 @@ bool KSyncNetlinkEntry::Change() {
         free(msg);
         return true;
     }
-    KSyncSock   *sock = KSyncSock::Get(0);
-    sock->SendAsync(this, msg_len, msg, KSyncEntry::CHANGE_ACK);
+    SendMsg(msg, msg_len, KSyncEntry::CHANGE_ACK);
     return false;
 }
 
@@ -73,11 +71,16 @@ bool KSyncNetlinkEntry::Delete() {
         free(msg);
         return true;
     }
-    KSyncSock   *sock = KSyncSock::Get(0);
-    sock->SendAsync(this, msg_len, msg, KSyncEntry::DEL_ACK);
+    SendMsg(msg, msg_len, KSyncEntry::DEL_ACK);
     return false;
 }
 
+void KSyncNetlinkEntry::SendMsg(char *msg, int msg_len,
+                                KSyncEntry::KSyncEvent event) {
+    KSyncSock   *sock = KSyncSock::Get(0);
+    sock->SendAsync(this, msg_len, msg, event);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // KSyncNetlinkDBEntry routines
 ///////////////////////////////////////////////////////////////////////////////
@@ -35,6 +35,9 @@ public:
     bool Delete();
     virtual bool Sync() = 0;
     virtual bool AllowDeleteStateComp() {return true;}
+    // Send the message generated for the object to kernel. Ack for the
+    // message generates event on the object
+    virtual void SendMsg(char *msg, int msg_len, KSyncEntry::KSyncEvent event);
 private:
     DISALLOW_COPY_AND_ASSIGN(KSyncNetlinkEntry);
 };
@@ -112,6 +112,10 @@ void KSyncSockNetlink::Decoder(char *data, SandeshContext *ctxt) {
             LOG(ERROR, "Unknown generic netlink cmd : " << genlh->cmd);
             assert(0);
         }
+    } else if (nlh->nlmsg_type == NLMSG_ERROR) {
+        // Only generated locally, see EnqueueErrorResponse
+        struct nlmsgerr *err = (struct nlmsgerr *)NLMSG_DATA(nlh);
+        static_cast<AgentSandeshContext *>(ctxt)->SetErrno(-err->error);
     } else if (nlh->nlmsg_type != NLMSG_DONE) {
         LOG(ERROR, "Netlink unknown message type : " << nlh->nlmsg_type);
         assert(0);
@@ -167,6 +171,79 @@ void KSyncSockNetlink::AsyncSendTo(IoContext *ioc, mutable_buffers_1 buf,
     free(cl.cl_buf);
 }
 
+// Encode each IoContext as a netlink message with its own seqno and send
+// all of them in one datagram. Kernel processes the messages in a datagram
+// one after the other and acks each of them. IoContexts go to the wait tree
+// only once their message is built
+void KSyncSockNetlink::AsyncSendBulk(const IoContextList &list, HandlerCb cb) {
+    BulkBuffer bulk_buf(new std::vector<char>());
+    for (IoContextList::const_iterator it = list.begin(); it != list.end();
+         ++it) {
+        IoContext *ioc = *it;
+        struct nl_client cl;
+        unsigned char *nl_buf;
+        uint32_t nl_buf_len;
+        int ret;
+
+        nl_init_generic_client_req(&cl, GetNetlinkFamilyId());
+        if ((ret = nl_build_header(&cl, &nl_buf, &nl_buf_len)) < 0) {
+            LOG(ERROR, "Error creating netlink message. Error : " << ret);
+            free(cl.cl_buf);
+            EnqueueErrorResponse(ioc, -ret);
+            continue;
+        }
+        AddToWaitTree(ioc);
+
+        nl_update_header(&cl, ioc->GetMsgLen());
+        struct nlmsghdr *nlh = (struct nlmsghdr *)cl.cl_buf;
+        nlh->nlmsg_pid = KSyncSock::GetPid();
+        nlh->nlmsg_seq = ioc->GetSeqno();
+
+        size_t offset = bulk_buf->size();
+        bulk_buf->resize(offset + NLMSG_ALIGN(nlh->nlmsg_len), 0);
+        memcpy(&(*bulk_buf)[offset], cl.cl_buf, cl.cl_buf_offset);
+        memcpy(&(*bulk_buf)[offset + cl.cl_buf_offset], ioc->GetMsg(),
+               ioc->GetMsgLen());
+        free(cl.cl_buf);
+    }
+
+    if (bulk_buf->empty()) {
+        return;
+    }
+
+    // Buffer is held by the handler till the write completes
+    boost::asio::netlink::raw::endpoint ep;
+    sock_.async_send_to(buffer(&(*bulk_buf)[0], bulk_buf->size()), ep,
+                        boost::bind(&KSyncSockNetlink::BulkWriteHandler,
+                                    bulk_buf, cb, placeholders::error,
+                                    placeholders::bytes_transferred));
+}
+
+// Complete an IoContext that could not be sent as if vrouter failed the
+// request, so that its entry gets the error and the ack it is waiting for.
+// The response is processed in the task of the IoContext like any other.
+void KSyncSockNetlink::EnqueueErrorResponse(IoContext *ioc, int error) {
+    size_t len = NLMSG_SPACE(sizeof(struct nlmsgerr));
+    char *data = new char[len];
+    memset(data, 0, len);
+    struct nlmsghdr *nlh = (struct nlmsghdr *)data;
+    nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct nlmsgerr));
+    nlh->nlmsg_type = NLMSG_ERROR;
+    nlh->nlmsg_pid = KSyncSock::GetPid();
+    nlh->nlmsg_seq = ioc->GetSeqno();
+    struct nlmsgerr *err = (struct nlmsgerr *)NLMSG_DATA(nlh);
+    err->error = -error;
+
+    AddToWaitTree(ioc);
+    EnqueueRxData(data);
+}
+
+void KSyncSockNetlink::BulkWriteHandler(BulkBuffer buf, HandlerCb cb,
+                                        const boost::system::error_code &error,
+                                        size_t bytes_transferred) {
+    cb(error, bytes_transferred);
+}
+
 size_t KSyncSockNetlink::SendTo(const_buffers_1 buf, uint32_t seq_no) {
     struct nl_client cl;
     unsigned char *nl_buf;
@@ -402,7 +479,11 @@ Tree::iterator KSyncSock::GetIoContext(char *data) {
 
 bool KSyncSock::ValidateAndEnqueue(char *data) {
     Validate(data);
+    EnqueueRxData(data);
+    return true;
+}
 
+void KSyncSock::EnqueueRxData(char *data) {
     IoContext::IoContextWorkQId q_id;
     if ((GetSeqno(data) & KSYNC_DEFAULT_Q_ID_SEQ) == KSYNC_DEFAULT_Q_ID_SEQ) {
         q_id = IoContext::DEFAULT_Q_ID;
@@ -410,7 +491,6 @@ bool KSyncSock::ValidateAndEnqueue(char *data) {
         q_id = IoContext::UVE_Q_ID;
     }
     receive_work_queue[q_id]->Enqueue(data);
-    return true;
 }
 
 // Process kernel data - executes in the task specified by IoContext
@@ -501,7 +581,17 @@ void KSyncSock::GenericSend(IoContext *ioc) {
     async_send_queue_->Enqueue(ioc);
 }
 
+void KSyncSock::SendAsyncBulk(const IoContextList &list) {
+    if (list.empty())
+        return;
+    async_send_queue_->Enqueue(new KSyncBulkIoContext(list));
+}
+
 bool KSyncSock::SendAsyncImpl(IoContext *ioc) {
+    if (ioc->IsBulk()) {
+        return SendBulkImpl(static_cast<KSyncBulkIoContext *>(ioc));
+    }
+
     {
         tbb::mutex::scoped_lock lock(mutex_);
         wait_tree_.insert(*ioc);
@@ -512,19 +602,59 @@ bool KSyncSock::SendAsyncImpl(IoContext *ioc) {
                                 placeholders::error,
                                 placeholders::bytes_transferred));
     } else {
-        SendTo(boost::asio::buffer((const char *)ioc->GetMsg(),
-                    ioc->GetMsgLen()), ioc->GetSeqno());
-        bool more_data = false;
-        do {
-            char *rxbuf = new char[kBufLen];
-            Receive(boost::asio::buffer(rxbuf, kBufLen));
-            more_data = IsMoreData(rxbuf);
-            ValidateAndEnqueue(rxbuf);
-        } while(more_data);
+        SendSyncImpl(ioc);
     }
     return true;
 }
 
+// The bulk context only carries the list, it is freed once the IoContexts
+// in it are written. IoContexts are freed on receiving ack as usual
+bool KSyncSock::SendBulkImpl(KSyncBulkIoContext *bulk) {
+    const IoContextList &list = bulk->list();
+    if (!run_sync_mode_) {
+        AsyncSendBulk(list, boost::bind(&KSyncSock::WriteHandler, this,
+                                        placeholders::error,
+                                        placeholders::bytes_transferred));
+    } else {
+        for (IoContextList::const_iterator it = list.begin();
+             it != list.end(); ++it) {
+            AddToWaitTree(*it);
+            SendSyncImpl(*it);
+        }
+    }
+    delete bulk;
+    return true;
+}
+
+void KSyncSock::SendSyncImpl(IoContext *ioc) {
+    SendTo(boost::asio::buffer((const char *)ioc->GetMsg(),
+                ioc->GetMsgLen()), ioc->GetSeqno());
+    bool more_data = false;
+    do {
+        char *rxbuf = new char[kBufLen];
+        Receive(boost::asio::buffer(rxbuf, kBufLen));
+        more_data = IsMoreData(rxbuf);
+        ValidateAndEnqueue(rxbuf);
+    } while(more_data);
+}
+
+void KSyncSock::AddToWaitTree(IoContext *ioc) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    wait_tree_.insert(*ioc);
+}
+
+// Sockets that can not carry more than one message per write send the
+// IoContexts one by one
+void KSyncSock::AsyncSendBulk(const IoContextList &list, HandlerCb cb) {
+    for (IoContextList::const_iterator it = list.begin(); it != list.end();
+         ++it) {
+        IoContext *ioc = *it;
+        AddToWaitTree(ioc);
+        AsyncSendTo(ioc, boost::asio::buffer(ioc->GetMsg(), ioc->GetMsgLen()),
+                    cb);
+    }
+}
+
 KSyncIoContext::KSyncIoContext(KSyncEntry *sync_entry, int msg_len,
                                char *msg, uint32_t seqno,
                                KSyncEntry::KSyncEvent event) :
@@ -11,6 +11,7 @@
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/netlink_protocol.hpp>
 #include <boost/asio/netlink_endpoint.hpp>
+#include <boost/shared_ptr.hpp>
 #include <tbb/atomic.h>
 #include <tbb/mutex.h>
 #include <base/queue_task.h>
@@ -92,6 +93,7 @@ public:
 
     virtual void Handler() {};
     virtual void ErrorHandler(int err) {};
+    virtual bool IsBulk() const { return false; }
 
     AgentSandeshContext *GetSandeshContext() { return ctx_; }
     IoContextWorkQId GetWorkQId() { return work_q_id_; }
@@ -127,6 +129,23 @@ private:
     KSyncEntry::KSyncEvent event_;
 };
 
+typedef std::vector<IoContext *> IoContextList;
+
+/* Group of IoContexts written to the socket together. Each IoContext keeps
+ * its own seqno and is acked individually
+ */
+class KSyncBulkIoContext : public IoContext {
+public:
+    explicit KSyncBulkIoContext(const IoContextList &list)
+        : IoContext(), list_(list) { }
+    virtual ~KSyncBulkIoContext() { }
+
+    virtual bool IsBulk() const { return true; }
+    const IoContextList &list() const { return list_; }
+private:
+    IoContextList list_;
+};
+
 typedef boost::intrusive::member_hook<IoContext,
         boost::intrusive::set_member_hook<>,
         &IoContext::node_> KSyncSockNode;
@@ -150,6 +169,9 @@ public:
     static KSyncSock *Get(int partition_id);
     // Write a KSyncEntry to kernel
     void SendAsync(KSyncEntry *entry, int msg_len, char *msg, KSyncEntry::KSyncEvent event);
+    // Write a list of IoContexts to kernel in one go. Netlink sockets send
+    // all the messages in a single datagram
+    void SendAsyncBulk(const IoContextList &list);
     std::size_t BlockingSend(const char *msg, int msg_len);
     bool BlockingRecv();
 
@@ -177,6 +199,11 @@ public:
 protected:
     static void Init(int count);
     static void SetSockTableEntry(int i, KSyncSock *sock);
+    // Must be called before the message of the IoContext is written, so
+    // that the ack finds it
+    void AddToWaitTree(IoContext *ioc);
+    // Queue a response for processing in the task of its IoContext
+    void EnqueueRxData(char *data);
     // Tree of all KSyncEntries pending ack from Netlink socket
     Tree wait_tree_;
     WorkQueue<IoContext *> *async_send_queue_;
@@ -196,6 +223,8 @@ private:
     virtual bool Validate(char *data) = 0;
     bool ValidateAndEnqueue(char *data);
     bool SendAsyncImpl(IoContext *ioc);
+    bool SendBulkImpl(KSyncBulkIoContext *bulk);
+    void SendSyncImpl(IoContext *ioc);
 
     bool SendAsyncStart() {
         tbb::mutex::scoped_lock lock(mutex_);
@@ -205,6 +234,7 @@ private:
     virtual void AsyncReceive(boost::asio::mutable_buffers_1, HandlerCb) = 0;
     virtual void AsyncSendTo(IoContext *, boost::asio::mutable_buffers_1,
                              HandlerCb) = 0;
+    virtual void AsyncSendBulk(const IoContextList &list, HandlerCb cb);
     virtual std::size_t SendTo(boost::asio::const_buffers_1, uint32_t) = 0;
     virtual void Receive(boost::asio::mutable_buffers_1) = 0;
 
@@ -245,9 +275,15 @@ public:
     virtual void AsyncReceive(boost::asio::mutable_buffers_1, HandlerCb);
     virtual void AsyncSendTo(IoContext *, boost::asio::mutable_buffers_1,
                              HandlerCb);
+    virtual void AsyncSendBulk(const IoContextList &list, HandlerCb cb);
     virtual std::size_t SendTo(boost::asio::const_buffers_1, uint32_t);
     virtual void Receive(boost::asio::mutable_buffers_1);
 private:
+    typedef boost::shared_ptr<std::vector<char> > BulkBuffer;
+    void EnqueueErrorResponse(IoContext *ioc, int error);
+    static void BulkWriteHandler(BulkBuffer buf, HandlerCb cb,
+                                 const boost::system::error_code &error,
+                                 size_t bytes_transferred);
     boost::asio::netlink::raw::socket sock_;
 };
 
@@ -26,6 +26,31 @@ void Route::insert(const Path *ipath) {
     path_.push_back(*path);
 }
 
+//
+// Same position as insert followed by a stable Sort, without reordering the
+// rest of the list. Paths that are better than the current best or no better
+// than the current worst, the common cases, are inserted in constant time.
+//
+void Route::insert(const Path *ipath, Compare compare) {
+    Path *path = const_cast<Path *> (ipath);
+
+    path->set_time_stamp_usecs(UTCTimestampUsec());
+    if (path_.empty() || compare(*path, path_.front())) {
+        path_.push_front(*path);
+        return;
+    }
+
+    PathList::iterator it = path_.end();
+    while (it != path_.begin()) {
+        PathList::iterator prev = it;
+        --prev;
+        if (!compare(*path, *prev))
+            break;
+        it = prev;
+    }
+    path_.insert(it, *path);
+}
+
 // Remove a path
 void Route::remove(const Path *ipath) {
     Path *path = const_cast<Path *> (ipath);
@@ -37,6 +37,10 @@ public:
     // Insert a path
     void insert(const Path *path);
 
+    // Insert a path at its position in a path list that's already sorted
+    // based on the compare function.
+    void insert(const Path *path, Compare compare);
+
     // Remove a path
     void remove(const Path *path);
 
@@ -51,6 +51,22 @@ public:
         return index;
     }
 
+    // Store entry at a given index. Fails if the index is already allocated
+    bool InsertAtIndex(size_t index, EntryType *entry) {
+        if (index >= bitmap_.size()) {
+            size_t size = ((index / kGrowSize) + 1) * kGrowSize;
+            bitmap_.resize(size, 1);
+            entries_.resize(size);
+        }
+
+        if (bitmap_[index] == 0) {
+            return false;
+        }
+        bitmap_.set(index, 0);
+        entries_[index] = entry;
+        return true;
+    }
+
     void Update(size_t index, EntryType *entry) {
         assert(index < bitmap_.size());
         assert(bitmap_[index] == 0);
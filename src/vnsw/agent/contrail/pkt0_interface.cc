@@ -132,6 +132,10 @@ void Pkt0Interface::InitControlInterface() {
     input_.assign(tap_fd_, ec);
     assert(ec == 0);
 
+    // Reads after the first packet in a burst must not block
+    input_.non_blocking(true, ec);
+    assert(ec == 0);
+
     VrouterControlInterface::InitControlInterface();
     AsyncRead();
 }
@@ -169,7 +173,11 @@ int Pkt0Interface::Send(uint8_t *buff, uint16_t buff_len,
 }
 
 void Pkt0Interface::AsyncRead() {
-    read_buff_ = new uint8_t[kMaxPacketSize];
+    if (read_buff_ == NULL) {
+        Agent *agent = pkt_handler()->agent();
+        read_buff_ = agent->pkt()->packet_buffer_manager()->AllocateBuffer
+            (PktHandler::RX_PACKET);
+    }
     input_.async_read_some(
             boost::asio::buffer(read_buff_, kMaxPacketSize),
             boost::bind(&Pkt0Interface::ReadHandler, this,
@@ -187,12 +195,12 @@ void Pkt0Interface::ReadHandler(const boost::system::error_code &error,
         }
     }
 
+    // The buffer is handed over to the PacketBuffer. Read buffer is reused
+    // for the next read in case of error
     if (!error) {
-        Agent *agent = pkt_handler()->agent();
-        PacketBufferPtr pkt(agent->pkt()->packet_buffer_manager()->Allocate
-            (PktHandler::RX_PACKET, read_buff_, kMaxPacketSize, 0, length,
-             0));
-        VrouterControlInterface::Process(pkt);
+        uint8_t *buff = read_buff_;
+        read_buff_ = NULL;
+        VrouterControlInterface::ProcessBurst(&input_, buff, length);
     }
 
     AsyncRead();
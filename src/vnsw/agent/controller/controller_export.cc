@@ -173,7 +173,8 @@ void RouteExport::UnicastNotify(AgentXmppChannel *bgp_xmpp_peer,
                 AgentXmppChannel::ControllerSendRouteAdd(bgp_xmpp_peer, 
                         static_cast<AgentRoute * >(route), state->vn_, 
                         state->label_, path->GetTunnelBmap(),
-                        &path->sg_list(), type, state->path_preference_);
+                        &path->sg_list(), type, state->path_preference_,
+                        state->exported_);
         }
     } else {
         if (state->exported_ == true) {
@@ -269,7 +270,8 @@ void RouteExport::MulticastNotify(AgentXmppChannel *bgp_xmpp_peer,
             if (associate) {
             state->exported_ =
                 AgentXmppChannel::ControllerSendMcastRouteAdd(bgp_xmpp_peer,
-                                                              route);
+                                                              route,
+                                                              state->exported_);
             } else {
                 AgentXmppChannel::ControllerSendMcastRouteDelete(bgp_xmpp_peer,
                                                                  route);
@@ -331,7 +333,8 @@ void RouteExport::MulticastNotify(AgentXmppChannel *bgp_xmpp_peer,
                                                         route,
                                                         route->dest_vn_name(),
                                                         state->label_,
-                                                        TunnelType::AllType());
+                                                        TunnelType::AllType(),
+                                                        state->evpn_exported_);
                 } else {
                     state->evpn_exported_ =
                         AgentXmppChannel::ControllerSendEvpnRouteDelete(bgp_xmpp_peer,
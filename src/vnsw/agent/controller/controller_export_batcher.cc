@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <unistd.h>
+
+#include <base/task.h>
+#include <cmn/agent_cmn.h>
+#include <controller/controller_peer.h>
+#include <controller/controller_export_batcher.h>
+
+const uint32_t RouteExportBatcher::kMaxBatchSize;
+
+// Flushes pending messages once the current run of route notifications is
+// done. Queued on db::DBTable at most once at a time.
+class RouteExportBatcher::FlushTask : public Task {
+public:
+    explicit FlushTask(RouteExportBatcher *batcher)
+        : Task(TaskScheduler::GetInstance()->GetTaskId("db::DBTable"), 0),
+          batcher_(batcher) {
+    }
+    virtual bool Run() {
+        batcher_->Run();
+        return true;
+    }
+private:
+    RouteExportBatcher *batcher_;
+};
+
+RouteExportBatcher::RouteExportBatcher(AgentXmppChannel *channel)
+    : channel_(channel), first_enqueue_time_(0), flush_task_(NULL),
+      disabled_(false), batches_(0), batch_msgs_(0), suppressed_(0),
+      send_failures_(0), last_latency_(0), max_latency_(0) {
+}
+
+// The channel may be deleted while a flush is queued. Drop the pending
+// messages, then cancel the flush task, or wait for it to finish if it is
+// already running.
+RouteExportBatcher::~RouteExportBatcher() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    updates_.clear();
+    ordered_msgs_.clear();
+    order_.clear();
+    while (flush_task_ != NULL) {
+        TaskScheduler *scheduler = TaskScheduler::GetInstance();
+        if (scheduler->Cancel(flush_task_) == TaskScheduler::CANCELLED) {
+            flush_task_ = NULL;
+            break;
+        }
+        lock.release();
+        usleep(1000);
+        lock.acquire(mutex_);
+    }
+}
+
+void RouteExportBatcher::Enqueue(const std::string &key, bool associate,
+                                 bool advertised, const std::string &msg) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    UpdateMap::iterator it = updates_.find(key);
+    if (it != updates_.end()) {
+        suppressed_++;
+        // Delete of a route whose add control node has not seen cancels
+        // the pending add
+        if (!associate && it->second.associate && !it->second.advertised) {
+            suppressed_++;
+            updates_.erase(it);
+            return;
+        }
+        it->second.associate = associate;
+        it->second.msg = msg;
+        return;
+    }
+
+    if (order_.empty()) {
+        first_enqueue_time_ = ClockMonotonicUsec();
+    }
+    updates_.insert(std::make_pair(key, Update(associate, advertised, msg,
+                                               order_.size())));
+    order_.push_back(key);
+    Queued();
+}
+
+void RouteExportBatcher::EnqueueOrdered(const std::string &msg) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (order_.empty()) {
+        first_enqueue_time_ = ClockMonotonicUsec();
+    }
+    // Pending updates go out ahead of the ordered message, later updates
+    // for the same routes are queued after it
+    for (UpdateMap::iterator it = updates_.begin(); it != updates_.end();
+         ++it) {
+        ordered_msgs_.insert(std::make_pair(it->second.pos, it->second.msg));
+    }
+    updates_.clear();
+    ordered_msgs_.insert(std::make_pair(order_.size(), msg));
+    order_.push_back(std::string());
+    Queued();
+}
+
+void RouteExportBatcher::Queued() {
+    if (updates_.size() + ordered_msgs_.size() >= kMaxBatchSize) {
+        FlushInternal();
+        return;
+    }
+    if (flush_task_ == NULL && !disabled_) {
+        flush_task_ = new FlushTask(this);
+        TaskScheduler::GetInstance()->Enqueue(flush_task_);
+    }
+}
+
+void RouteExportBatcher::FlushInternal() {
+    std::string buf;
+    uint32_t count = 0;
+    for (size_t i = 0; i < order_.size(); i++) {
+        OrderedMsgMap::iterator oit = ordered_msgs_.find(i);
+        if (oit != ordered_msgs_.end()) {
+            buf += oit->second;
+            count++;
+            continue;
+        }
+
+        UpdateMap::iterator uit = updates_.find(order_[i]);
+        if (uit == updates_.end() || uit->second.pos != i) {
+            continue;
+        }
+        buf += uit->second.msg;
+        count++;
+    }
+
+    if (count == 0) {
+        order_.clear();
+        return;
+    }
+
+    // A false return with the channel up only means the data is queued
+    // in the session. With the channel down the batch is kept, and is
+    // dropped when the next session comes up.
+    if (!channel_->SendUpdate(reinterpret_cast<uint8_t *>(&buf[0]),
+                              buf.size()) &&
+        !AgentXmppChannel::IsBgpPeerActive(channel_)) {
+        send_failures_++;
+        return;
+    }
+    updates_.clear();
+    ordered_msgs_.clear();
+    order_.clear();
+    batches_++;
+    batch_msgs_ += count;
+    uint64_t now = ClockMonotonicUsec();
+    last_latency_ = (now > first_enqueue_time_) ? now - first_enqueue_time_ : 0;
+    if (last_latency_ > max_latency_) {
+        max_latency_ = last_latency_;
+    }
+}
+
+void RouteExportBatcher::Flush() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    FlushInternal();
+}
+
+void RouteExportBatcher::Run() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    flush_task_ = NULL;
+    if (!disabled_) {
+        FlushInternal();
+    }
+}
+
+void RouteExportBatcher::Clear() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    updates_.clear();
+    ordered_msgs_.clear();
+    order_.clear();
+}
+
+void RouteExportBatcher::set_disable() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    disabled_ = true;
+}
+
+void RouteExportBatcher::set_enable() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    disabled_ = false;
+    if (!order_.empty()) {
+        Queued();
+    }
+}
+
+size_t RouteExportBatcher::pending() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return updates_.size() + ordered_msgs_.size();
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __CONTROLLER_EXPORT_BATCHER_H__
+#define __CONTROLLER_EXPORT_BATCHER_H__
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <tbb/mutex.h>
+#include <base/util.h>
+
+class AgentXmppChannel;
+class Task;
+
+// Coalesces route export messages sent on an AgentXmppChannel.
+//
+// Messages are kept per route till the current run of route notifications
+// is done, or kMaxBatchSize routes are pending, and are then written to the
+// channel together. A message for a route replaces the one pending for it.
+// A delete replacing a pending add of a route that control node has not
+// been sent before cancels both.
+//
+// Messages other than route updates, like VRF subscribe, are queued with
+// EnqueueOrdered. They are never coalesced, so that VRF subscriptions don't
+// force a flush per VRF. Route updates pending when an ordered message is
+// queued are fixed in place and sent ahead of it. Only updates queued after
+// the last ordered message are coalesced.
+//
+// If the channel goes down, a batch that fails to be written is kept
+// pending. It is dropped with Clear when the next session comes up, as
+// routes are exported afresh to its peer.
+class RouteExportBatcher {
+public:
+    static const uint32_t kMaxBatchSize = 64;
+
+    RouteExportBatcher(AgentXmppChannel *channel);
+    ~RouteExportBatcher();
+
+    // key identifies the route, including its prefix length, at control
+    // node. advertised tells whether the route was exported to control node
+    // before this message. msg holds the encoded publish and collection
+    // stanzas for the route
+    void Enqueue(const std::string &key, bool associate, bool advertised,
+                 const std::string &msg);
+    void EnqueueOrdered(const std::string &msg);
+    // Send pending messages right away
+    void Flush();
+    // Drop pending messages on change of session
+    void Clear();
+
+    size_t pending() const;
+    uint64_t batches() const { return batches_; }
+    uint64_t batch_msgs() const { return batch_msgs_; }
+    uint64_t suppressed() const { return suppressed_; }
+    uint64_t send_failures() const { return send_failures_; }
+    // Time in usec from first message queued in batch till batch is sent
+    uint64_t last_latency() const { return last_latency_; }
+    uint64_t max_latency() const { return max_latency_; }
+
+    // For test only, hold off the flush at the end of a run of route
+    // notifications
+    void set_disable();
+    void set_enable();
+
+private:
+    class FlushTask;
+
+    struct Update {
+        Update(bool a, bool adv, const std::string &m, size_t p) :
+            associate(a), advertised(adv), msg(m), pos(p) { }
+        bool associate;
+        // Control node was sent the route before this batch
+        bool advertised;
+        std::string msg;
+        // Index of the update in order_
+        size_t pos;
+    };
+    typedef std::map<std::string, Update> UpdateMap;
+    typedef std::map<size_t, std::string> OrderedMsgMap;
+
+    void Run();
+    void Queued();
+    void FlushInternal();
+
+    AgentXmppChannel *channel_;
+    mutable tbb::mutex mutex_;
+    UpdateMap updates_;
+    // Messages queued with EnqueueOrdered, and updates queued ahead of
+    // them, keyed by index in order_
+    OrderedMsgMap ordered_msgs_;
+    // Keys in order they were queued
+    std::vector<std::string> order_;
+    uint64_t first_enqueue_time_;
+    // Flush task queued on db::DBTable, owned by the scheduler
+    Task *flush_task_;
+    bool disabled_;
+
+    uint64_t batches_;
+    uint64_t batch_msgs_;
+    uint64_t suppressed_;
+    uint64_t send_failures_;
+    uint64_t last_latency_;
+    uint64_t max_latency_;
+    DISALLOW_COPY_AND_ASSIGN(RouteExportBatcher);
+};
+
+#endif // __CONTROLLER_EXPORT_BATCHER_H__
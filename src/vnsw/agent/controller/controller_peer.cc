@@ -12,6 +12,7 @@
 #include "controller/controller_peer.h"
 #include "controller/controller_ifmap.h"
 #include "controller/controller_vrf_export.h"
+#include "controller/controller_export_batcher.h"
 #include "controller/controller_init.h"
 #include "oper/vrf.h"
 #include "oper/nexthop.h"
@@ -42,7 +43,8 @@ AgentXmppChannel::AgentXmppChannel(Agent *agent,
                                    const std::string &label_range, 
                                    uint8_t xs_idx) 
     : channel_(NULL), xmpp_server_(xmpp_server), label_range_(label_range),
-      xs_idx_(xs_idx), agent_(agent), unicast_sequence_number_(0) {
+      xs_idx_(xs_idx), agent_(agent), unicast_sequence_number_(0),
+      export_batcher_(new RouteExportBatcher(this)) {
     bgp_peer_id_.reset();
 }
 
@@ -77,6 +79,8 @@ void AgentXmppChannel::CreateBgpPeer() {
     Ip4Address ip = Ip4Address::from_string(addr.c_str(), ec);
     assert(ec.value() == 0);
     bgp_peer_id_.reset(new BgpPeer(ip, addr, this, id));
+    //Routes are exported afresh on new session
+    export_batcher_->Clear();
 }
 
 void AgentXmppChannel::DeCommissionBgpPeer() {
@@ -1344,6 +1348,10 @@ bool AgentXmppChannel::ControllerSendSubscribe(AgentXmppChannel *peer,
     if (!peer) {
         return false;
     }      
+    //Queued messages are only sent on an active session
+    if (!IsBgpPeerActive(peer)) {
+        return false;
+    }
     CONTROLLER_TRACE(Trace, peer->GetBgpPeerName(), vrf->GetName(), 
                      subscribe ? "Subscribe" : "Unsubscribe");
     //Build the DOM tree
@@ -1375,9 +1383,12 @@ bool AgentXmppChannel::ControllerSendSubscribe(AgentXmppChannel *peer,
     pugi->AddChildNode("instance-id", vrf_id.str());
 
     datalen_ = XmppProto::EncodeMessage(impl.get(), data_, sizeof(data_));
-    
-    // send data
-    return (peer->SendUpdate(data_,datalen_));
+
+    // Queued in order with route exports, routes exported in the vrf go out
+    // ahead of unsubscribe and after subscribe
+    peer->export_batcher()->EnqueueOrdered(
+        std::string(reinterpret_cast<char *>(data_), datalen_));
+    return true;
 }
 
 bool AgentXmppChannel::ControllerSendV4UnicastRouteCommon(AgentRoute *route,
@@ -1386,9 +1397,13 @@ bool AgentXmppChannel::ControllerSendV4UnicastRouteCommon(AgentRoute *route,
                                        uint32_t mpls_label,
                                        TunnelType::TypeBmap bmap,
                                        const PathPreference &path_preference,
-                                       bool associate) {
+                                       bool associate,
+                                       bool advertised) {
 
     static int id = 0;
+    if (!IsBgpPeerActive(this)) {
+        return false;
+    }
     ItemType item;
     uint8_t data_[4096];
     size_t datalen_;
@@ -1461,8 +1476,7 @@ bool AgentXmppChannel::ControllerSendV4UnicastRouteCommon(AgentRoute *route,
     item.Encode(&node);
 
     datalen_ = XmppProto::EncodeMessage(impl.get(), data_, sizeof(data_));
-    // send data
-    SendUpdate(data_,datalen_);
+    std::string msg(reinterpret_cast<const char *>(data_), datalen_);
 
     pugi->DeleteNode("pubsub");
     pugi->ReadNode("iq");
@@ -1483,21 +1497,29 @@ bool AgentXmppChannel::ControllerSendV4UnicastRouteCommon(AgentRoute *route,
     pugi->AddAttribute("node", node_id);
 
     datalen_ = XmppProto::EncodeMessage(impl.get(), data_, sizeof(data_));
-    // send data
-    return (SendUpdate(data_,datalen_));
+    msg.append(reinterpret_cast<const char *>(data_), datalen_);
+    //node_id has no prefix length, overlapping prefixes need their own keys
+    stringstream export_key;
+    export_key << item.entry.nlri.af << "/" << item.entry.nlri.safi << "/"
+               << route->vrf()->GetName() << "/" << item.entry.nlri.address;
+    // queue data, sent along with other routes
+    export_batcher_->Enqueue(export_key.str(), associate, advertised, msg);
+    return true;
 }
 
 bool AgentXmppChannel::ControllerSendEvpnRouteCommon(AgentRoute *route,
                                                      std::string vn,
                                                      uint32_t label,
                                                      uint32_t tunnel_bmap,
-                                                     bool associate) {
+                                                     bool associate,
+                                                     bool advertised) {
     static int id = 0;
     EnetItemType item;
     uint8_t data_[4096];
     size_t datalen_;
 
     if (label == MplsTable::kInvalidLabel) return false;
+    if (!IsBgpPeerActive(this)) return false;
 
     //Build the DOM tree
     auto_ptr<XmlBase> impl(XmppStanza::AllocXmppXmlImpl());
@@ -1594,8 +1616,7 @@ bool AgentXmppChannel::ControllerSendEvpnRouteCommon(AgentRoute *route,
     item.Encode(&node);
 
     datalen_ = XmppProto::EncodeMessage(impl.get(), data_, sizeof(data_));
-    // send data
-    SendUpdate(data_,datalen_);
+    std::string msg(reinterpret_cast<const char *>(data_), datalen_);
 
     pugi->DeleteNode("pubsub");
     pugi->ReadNode("iq");
@@ -1616,18 +1637,26 @@ bool AgentXmppChannel::ControllerSendEvpnRouteCommon(AgentRoute *route,
     pugi->AddAttribute("node", node_id);
 
     datalen_ = XmppProto::EncodeMessage(impl.get(), data_, sizeof(data_));
-    // send data
-    return (SendUpdate(data_,datalen_));
+    msg.append(reinterpret_cast<const char *>(data_), datalen_);
+    //Withdraw and add of a route differ in ethernet tag, keep them apart
+    stringstream export_key;
+    export_key << route->vrf()->GetName() << "/" << node_id << "/"
+               << item.entry.nlri.ethernet_tag;
+    // queue data, sent along with other routes
+    export_batcher_->Enqueue(export_key.str(), associate, advertised, msg);
+    return true;
 }
 
 bool AgentXmppChannel::ControllerSendMcastRouteCommon(AgentRoute *route,
-                                                      bool add_route) {
+                                                      bool add_route,
+                                                      bool advertised) {
 
     static int id = 0;
     autogen::McastItemType item;
     uint8_t data_[4096];
     size_t datalen_;
    
+    if (!IsBgpPeerActive(this)) return false;
     if (add_route && (agent_->mulitcast_builder() != this)) {
         CONTROLLER_TRACE(Trace, GetBgpPeerName(),
                          route->vrf()->GetName(),
@@ -1690,8 +1719,7 @@ bool AgentXmppChannel::ControllerSendMcastRouteCommon(AgentRoute *route,
     item.Encode(&node);
 
     datalen_ = XmppProto::EncodeMessage(impl.get(), data_, sizeof(data_));
-    // send data
-    SendUpdate(data_,datalen_);
+    std::string msg(reinterpret_cast<const char *>(data_), datalen_);
 
 
     pugi->DeleteNode("pubsub");
@@ -1713,15 +1741,21 @@ bool AgentXmppChannel::ControllerSendMcastRouteCommon(AgentRoute *route,
     pugi->AddAttribute("node", node_id); 
 
     datalen_ = XmppProto::EncodeMessage(impl.get(), data_, sizeof(data_));
-    // send data
-    return (SendUpdate(data_,datalen_));
+    msg.append(reinterpret_cast<const char *>(data_), datalen_);
+    stringstream export_key;
+    export_key << item.entry.nlri.af << "/" << item.entry.nlri.safi << "/"
+               << route->vrf()->GetName() << "/" << route->ToString();
+    // queue data, sent along with other routes
+    export_batcher_->Enqueue(export_key.str(), add_route, advertised, msg);
+    return true;
 }
 
 bool AgentXmppChannel::ControllerSendEvpnRouteAdd(AgentXmppChannel *peer,
                                                   AgentRoute *route,
                                                   std::string vn,
                                                   uint32_t label,
-                                                  uint32_t tunnel_bmap) {
+                                                  uint32_t tunnel_bmap,
+                                                  bool advertised) {
     if (!peer) return false;
 
     CONTROLLER_TRACE(RouteExport, peer->GetBgpPeerName(),
@@ -1731,7 +1765,8 @@ bool AgentXmppChannel::ControllerSendEvpnRouteAdd(AgentXmppChannel *peer,
                                                 vn,
                                                 label,
                                                 tunnel_bmap,
-                                                true));
+                                                true,
+                                                advertised));
 }
 
 bool AgentXmppChannel::ControllerSendEvpnRouteDelete(AgentXmppChannel *peer,
@@ -1748,7 +1783,8 @@ bool AgentXmppChannel::ControllerSendEvpnRouteDelete(AgentXmppChannel *peer,
                                                 vn,
                                                 label,
                                                 tunnel_bmap,
-                                                false));
+                                                false,
+                                                true));
 }
 
 bool AgentXmppChannel::ControllerSendRouteAdd(AgentXmppChannel *peer,
@@ -1759,7 +1795,8 @@ bool AgentXmppChannel::ControllerSendRouteAdd(AgentXmppChannel *peer,
                                               const SecurityGroupList *sg_list,
                                               Agent::RouteTableType type,
                                               const PathPreference
-                                              &path_preference)
+                                              &path_preference,
+                                              bool advertised)
 {
     if (!peer) return false;
 
@@ -1773,11 +1810,13 @@ bool AgentXmppChannel::ControllerSendRouteAdd(AgentXmppChannel *peer,
         (peer->agent()->simulate_evpn_tor() == false)) {
         ret = peer->ControllerSendV4UnicastRouteCommon(route, vn,
                                                        sg_list, label, bmap,
-                                                       path_preference, true);
+                                                       path_preference, true,
+                                                       advertised);
     }
     if (type == Agent::LAYER2) {
         ret = peer->ControllerSendEvpnRouteCommon(route, vn,
-                                                  label, bmap, true);
+                                                  label, bmap, true,
+                                                  advertised);
     }
     return ret;
 }
@@ -1806,23 +1845,24 @@ bool AgentXmppChannel::ControllerSendRouteDelete(AgentXmppChannel *peer,
                                                        sg_list, label,
                                                        bmap,
                                                        path_preference,
-                                                       false);
+                                                       false, true);
     }
     if (type == Agent::LAYER2) {
         ret = peer->ControllerSendEvpnRouteCommon(route, vn,
-                                                  label, bmap, false);
+                                                  label, bmap, false, true);
     }
     return ret;
 }
 
 bool AgentXmppChannel::ControllerSendMcastRouteAdd(AgentXmppChannel *peer,
-                                                   AgentRoute *route) {
+                                                   AgentRoute *route,
+                                                   bool advertised) {
     if (!peer) return false;
 
     CONTROLLER_TRACE(RouteExport, peer->GetBgpPeerName(),
                      route->vrf()->GetName(),
                      route->ToString(), true, 0);
-    return peer->ControllerSendMcastRouteCommon(route, true);
+    return peer->ControllerSendMcastRouteCommon(route, true, advertised);
 }
 
 bool AgentXmppChannel::ControllerSendMcastRouteDelete(AgentXmppChannel *peer,
@@ -1833,7 +1873,7 @@ bool AgentXmppChannel::ControllerSendMcastRouteDelete(AgentXmppChannel *peer,
                      route->vrf()->GetName(),
                      route->ToString(), false, 0);
 
-    return peer->ControllerSendMcastRouteCommon(route, false);
+    return peer->ControllerSendMcastRouteCommon(route, false, true);
 }
 
 void AgentXmppChannel::UpdateConnectionInfo(xmps::PeerState state) {
@@ -23,6 +23,7 @@ class BgpPeer;
 class VrfEntry;
 class XmlPugi;
 class PathPreference;
+class RouteExportBatcher;
 
 class AgentXmppChannel {
 public:
@@ -57,7 +58,9 @@ public:
     static bool ControllerSendSubscribe(AgentXmppChannel *peer,
                                         VrfEntry *vrf,
                                         bool subscribe);
-    //Add to control-node
+    //Add to control-node. advertised tells whether the route was exported
+    //before, a delete of a route that was not cancels a pending add.
+    //Returns false if the session is not up.
     static bool ControllerSendRouteAdd(AgentXmppChannel *peer,
                                        AgentRoute *route,
                                        std::string vn,
@@ -65,14 +68,17 @@ public:
                                        uint32_t tunnel_bmap,
                                        const SecurityGroupList *sg_list,
                                        Agent::RouteTableType type,
-                                       const PathPreference &path_preference);
+                                       const PathPreference &path_preference,
+                                       bool advertised);
     static bool ControllerSendEvpnRouteAdd(AgentXmppChannel *peer,
                                            AgentRoute *route,
                                            std::string vn,
                                            uint32_t mpls_label,
-                                           uint32_t tunnel_bmap);
+                                           uint32_t tunnel_bmap,
+                                           bool advertised);
     static bool ControllerSendMcastRouteAdd(AgentXmppChannel *peer,
-                                            AgentRoute *route);
+                                            AgentRoute *route,
+                                            bool advertised);
     //Deletes to control node
     static bool ControllerSendRouteDelete(AgentXmppChannel *peer,
                                           AgentRoute *route,
@@ -116,6 +122,10 @@ public:
     void increment_unicast_sequence_number() {unicast_sequence_number_++;}
     uint64_t unicast_sequence_number() const {return unicast_sequence_number_;}
 
+    RouteExportBatcher *export_batcher() const {
+        return export_batcher_.get();
+    }
+
     //Common helpers
     bool ControllerSendV4UnicastRouteCommon(AgentRoute *route,
                                             std::string vn,
@@ -123,14 +133,17 @@ public:
                                             uint32_t mpls_label,
                                             uint32_t tunnel_bmap,
                                             const PathPreference &path_preference,
-                                            bool associate);
+                                            bool associate,
+                                            bool advertised);
     bool ControllerSendEvpnRouteCommon(AgentRoute *route,
                                        std::string vn,
                                        uint32_t mpls_label,
                                        uint32_t tunnel_bmap,
-                                       bool associate);
+                                       bool associate,
+                                       bool advertised);
     bool ControllerSendMcastRouteCommon(AgentRoute *route,
-                                        bool associate);
+                                        bool associate,
+                                        bool advertised);
 
 protected:
     virtual void WriteReadyCb(const boost::system::error_code &ec);
@@ -154,6 +167,7 @@ private:
     boost::shared_ptr<BgpPeer> bgp_peer_id_;
     Agent *agent_;
     uint64_t unicast_sequence_number_;
+    boost::scoped_ptr<RouteExportBatcher> export_batcher_;
 };
 
 #endif // __CONTROLLER_PEER_H__
@@ -7,6 +7,9 @@
 #include <controller/controller_sandesh.h>
 #include <controller/controller_types.h>
 #include <controller/controller_peer.h>
+#include <controller/controller_export_batcher.h>
+#include <controller/controller_route_walker.h>
+#include <oper/peer.h>
 
 void AgentXmppConnectionStatusReq::HandleRequest() const {
     uint8_t count = 0;
@@ -57,6 +60,34 @@ void AgentXmppConnectionStatusReq::HandleRequest() const {
 
 		data.set_rx_proto_stats(rx_proto_stats); 
                 data.set_tx_proto_stats(tx_proto_stats); 
+
+                RouteExportBatcher *batcher = ch->export_batcher();
+                ControllerExportStats export_stats;
+                export_stats.batches = batcher->batches();
+                export_stats.batch_msgs = batcher->batch_msgs();
+                export_stats.suppressed = batcher->suppressed();
+                export_stats.last_latency_usec = batcher->last_latency();
+                export_stats.max_latency_usec = batcher->max_latency();
+                export_stats.send_failures = batcher->send_failures();
+                data.set_route_export_stats(export_stats);
+
+                BgpPeer *peer = ch->bgp_peer_id();
+                if (peer) {
+                    ControllerRouteWalker *walker = peer->route_walker();
+                    ControllerRouteWalkStats walk_stats;
+                    walk_stats.start_time = walker->walk_start_time();
+                    walk_stats.vrf_walk_time = walker->vrf_walk_time();
+                    walk_stats.walk_time = walker->walk_time();
+                    walk_stats.vrfs = walker->vrf_route_walks();
+                    walk_stats.route_tables = walker->route_table_walks();
+                    walk_stats.routes = walker->route_notify_count();
+                    walk_stats.max_vrf_walk_time =
+                        walker->max_vrf_route_walk_time();
+                    walk_stats.max_vrf_walk_vrf =
+                        walker->max_vrf_route_walk_vrf();
+                    walk_stats.in_progress = !walker->IsWalkCompleted();
+                    data.set_route_walk_stats(walk_stats);
+                }
             }
 
 	    std::vector<AgentXmppData> &list =
@@ -416,6 +416,9 @@ void AgentInit::Shutdown() {
     RunInTaskContext(this, task_id, boost::bind(&IoShutdownInternal, this));
     RunInTaskContext(this, task_id, boost::bind(&FlushFlowsInternal, this));
     RunInTaskContext(this, task_id, boost::bind(&VgwShutdownInternal, this));
+    // Checkpoint the indices before entries are deleted
+    if (agent_->oper_db())
+        agent_->oper_db()->index_checkpoint()->Shutdown();
     DeleteDBEntriesBase();
     WaitForDBEmpty();
     RunInTaskContext(this, task_id, boost::bind(&ServicesShutdownInternal,
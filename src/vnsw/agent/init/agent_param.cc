@@ -402,6 +402,8 @@ void AgentParam::ParseDefaultSection() {
     } else {
         log_flow_ = false;
     }
+
+    GetValueFromTree<string>(checkpoint_file_, "DEFAULT.checkpoint_file");
 }
 
 void AgentParam::ParseMetadataProxy() { 
@@ -421,6 +423,10 @@ void AgentParam::ParseFlows() {
         "FLOWS.max_vm_linklocal_flows")) {
         linklocal_vm_flows_ = Agent::kDefaultMaxLinkLocalOpenFds;
     }
+    if (!GetValueFromTree<uint32_t>(max_vm_flow_setup_rate_,
+        "FLOWS.max_vm_flow_setup_rate")) {
+        max_vm_flow_setup_rate_ = 0;
+    }
 }
 
 void AgentParam::ParseHeadlessMode() {
@@ -535,6 +541,7 @@ void AgentParam::ParseDefaultSectionArguments
     if (var_map.count("DEFAULT.log_flow")) {
          log_flow_ = true;
     }
+    GetOptValue<string>(var_map, checkpoint_file_, "DEFAULT.checkpoint_file");
 }
 
 void AgentParam::ParseMetadataProxyArguments
@@ -550,6 +557,8 @@ void AgentParam::ParseFlowArguments
                           "FLOWS.max_system_linklocal_flows");
     GetOptValue<uint16_t>(var_map, linklocal_vm_flows_,
                           "FLOWS.max_vm_linklocal_flows");
+    GetOptValue<uint32_t>(var_map, max_vm_flow_setup_rate_,
+                          "FLOWS.max_vm_flow_setup_rate");
 }
 
 void AgentParam::ParseHeadlessModeArguments
@@ -783,8 +792,10 @@ void AgentParam::LogConfig() const {
     LOG(DEBUG, "Max Vm Flows                : " << max_vm_flows_);
     LOG(DEBUG, "Linklocal Max System Flows  : " << linklocal_system_flows_);
     LOG(DEBUG, "Linklocal Max Vm Flows      : " << linklocal_vm_flows_);
+    LOG(DEBUG, "Max Vm Flow Setup Rate      : " << max_vm_flow_setup_rate_);
     LOG(DEBUG, "Flow cache timeout          : " << flow_cache_timeout_);
     LOG(DEBUG, "Headless Mode               : " << headless_mode_);
+    LOG(DEBUG, "Checkpoint file             : " << checkpoint_file_);
     if (simulate_evpn_tor_) {
         LOG(DEBUG, "Simulate EVPN TOR           : " << simulate_evpn_tor_);
     }
@@ -839,6 +850,7 @@ AgentParam::AgentParam(Agent *agent, bool enable_flow_options,
         dss_server_(), mgmt_ip_(), mode_(MODE_KVM), xen_ll_(),
         tunnel_type_(), metadata_shared_secret_(), max_vm_flows_(),
         linklocal_system_flows_(), linklocal_vm_flows_(),
+        max_vm_flow_setup_rate_(),
         flow_cache_timeout_(), config_file_(), program_name_(),
         log_file_(), log_local_(false), log_flow_(false), log_level_(),
         log_category_(), use_syslog_(false),
@@ -847,7 +859,7 @@ AgentParam::AgentParam(Agent *agent, bool enable_flow_options,
         flow_stats_interval_(kFlowStatsInterval),
         vrouter_stats_interval_(kVrouterStatsInterval),
         vmware_physical_port_(""), test_mode_(false), debug_(false), tree_(),
-        headless_mode_(false), simulate_evpn_tor_(false),
+        headless_mode_(false), checkpoint_file_(), simulate_evpn_tor_(false),
         si_netns_command_(), si_netns_workers_(0),
         si_netns_timeout_(0) {
 
@@ -869,6 +881,8 @@ AgentParam::AgentParam(Agent *agent, bool enable_flow_options,
         ("DEFAULT.collectors",
          opt::value<std::vector<std::string> >()->multitoken(),
          "Collector server list")
+        ("DEFAULT.checkpoint_file", opt::value<string>(),
+         "File to checkpoint VRF, interface and MPLS label indices to")
         ("DEFAULT.debug", "Enable debug logging")
         ("DEFAULT.flow_cache_timeout", 
          opt::value<uint16_t>()->default_value(agent->kDefaultFlowCacheTimeout),
@@ -926,6 +940,8 @@ AgentParam::AgentParam(Agent *agent, bool enable_flow_options,
              "Maximum number of link-local flows allowed across all VMs")
             ("FLOWS.max_vm_linklocal_flows", opt::value<uint16_t>(), 
              "Maximum number of link-local flows allowed per VM")
+            ("FLOWS.max_vm_flow_setup_rate", opt::value<uint32_t>(),
+             "Maximum flow setup requests per second allowed per VM interface")
             ;
         options_.add(flow);
     }
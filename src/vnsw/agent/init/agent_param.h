@@ -81,8 +81,12 @@ public:
     float max_vm_flows() const { return max_vm_flows_; }
     uint32_t linklocal_system_flows() const { return linklocal_system_flows_; }
     uint32_t linklocal_vm_flows() const { return linklocal_vm_flows_; }
+    uint32_t max_vm_flow_setup_rate() const {
+        return max_vm_flow_setup_rate_;
+    }
     uint32_t flow_cache_timeout() const {return flow_cache_timeout_;}
     bool headless_mode() const {return headless_mode_;}
+    const std::string &checkpoint_file() const {return checkpoint_file_;}
     bool simulate_evpn_tor() const {return simulate_evpn_tor_;}
     std::string si_netns_command() const {return si_netns_command_;}
     const int si_netns_workers() const {return si_netns_workers_;}
@@ -233,6 +237,7 @@ private:
     float max_vm_flows_;
     uint16_t linklocal_system_flows_;
     uint16_t linklocal_vm_flows_;
+    uint32_t max_vm_flow_setup_rate_;
     uint16_t flow_cache_timeout_;
 
     // Parameters configured from command linke arguments only (for now)
@@ -260,6 +265,7 @@ private:
     boost::property_tree::ptree tree_;
     std::auto_ptr<VirtualGatewayConfigTable> vgw_config_table_;
     bool headless_mode_;
+    std::string checkpoint_file_;
     //Simulate EVPN TOR mode moves agent into L2 mode. This mode is required
     //only for testing where MX and bare metal are simulated. VM on the
     //simulated compute node behaves as bare metal.
@@ -33,6 +33,7 @@
 #include <ksync/ksync_init.h>
 
 #include <pkt/flow_proto.h>
+#include <pkt/agent_stats.h>
 #include <oper/agent_types.h>
 #include <services/services_init.h>
 #include <services/icmp_error_proto.h>
@@ -462,6 +463,11 @@ bool FlowTableKSyncEntry::IsLess(const KSyncEntry &rhs) const {
     return flow_entry_ < entry.flow_entry_;
 }
 
+void FlowTableKSyncEntry::SendMsg(char *msg, int msg_len,
+                                  KSyncEntry::KSyncEvent event) {
+    ksync_obj_->SendMsg(this, msg, msg_len, event);
+}
+
 void FlowTableKSyncEntry::ErrorHandler(int err, uint32_t seq_no) const {
     if (err == ENOSPC || err == EBADF) {
         KSYNC_ERROR(VRouterError, "VRouter operation failed. Error <", err,
@@ -480,7 +486,8 @@ FlowTableKSyncObject::FlowTableKSyncObject(KSync *ksync) :
                   "Flow Audit Timer",
                   TaskScheduler::GetInstance()->GetTaskId
                   ("Agent::StatsCollector"),
-                  StatsCollector::FlowStatsCollector)) { 
+                  StatsCollector::FlowStatsCollector)),
+    batch_depth_(0) {
 }
 
 FlowTableKSyncObject::FlowTableKSyncObject(KSync *ksync, int max_index) :
@@ -490,13 +497,87 @@ FlowTableKSyncObject::FlowTableKSyncObject(KSync *ksync, int max_index) :
                   "Flow Audit Timer",
                   TaskScheduler::GetInstance()->GetTaskId
                   ("Agent::StatsCollector"),
-                  StatsCollector::FlowStatsCollector)) {
+                  StatsCollector::FlowStatsCollector)),
+    batch_depth_(0) {
 }
 
 FlowTableKSyncObject::~FlowTableKSyncObject() {
+    assert(batch_.empty());
     TimerManager::DeleteTimer(audit_timer_);
 }
 
+// Completion of a batch of flow messages. Shared by the IoContexts of the
+// batch and freed once all of them are acked
+class FlowTableKSyncBatch {
+public:
+    FlowTableKSyncBatch(FlowTableKSyncObject *obj, uint32_t msg_count)
+        : obj_(obj), msg_count_(msg_count), start_time_(UTCTimestampUsec()) {
+    }
+    ~FlowTableKSyncBatch() {
+        obj_->BatchDone(msg_count_, UTCTimestampUsec() - start_time_);
+    }
+private:
+    FlowTableKSyncObject *obj_;
+    uint32_t msg_count_;
+    uint64_t start_time_;
+    DISALLOW_COPY_AND_ASSIGN(FlowTableKSyncBatch);
+};
+
+class FlowTableKSyncIoContext : public KSyncIoContext {
+public:
+    FlowTableKSyncIoContext(KSyncEntry *entry, int msg_len, char *msg,
+                            uint32_t seqno, KSyncEntry::KSyncEvent event)
+        : KSyncIoContext(entry, msg_len, msg, seqno, event) {
+    }
+    void set_batch(boost::shared_ptr<FlowTableKSyncBatch> batch) {
+        batch_ = batch;
+    }
+private:
+    boost::shared_ptr<FlowTableKSyncBatch> batch_;
+};
+
+void FlowTableKSyncObject::StartBatch() {
+    batch_depth_++;
+}
+
+void FlowTableKSyncObject::EndBatch() {
+    assert(batch_depth_);
+    batch_depth_--;
+    if (batch_depth_ == 0 || batch_.size() >= kMaxBatchSize) {
+        FlushBatch();
+    }
+}
+
+void FlowTableKSyncObject::SendMsg(FlowTableKSyncEntry *entry, char *msg,
+                                   int msg_len, KSyncEntry::KSyncEvent event) {
+    KSyncSock *sock = KSyncSock::Get(0);
+    if (batch_depth_ == 0) {
+        sock->SendAsync(entry, msg_len, msg, event);
+        return;
+    }
+    batch_.push_back(new FlowTableKSyncIoContext(entry, msg_len, msg,
+                                                 sock->AllocSeqNo(false),
+                                                 event));
+}
+
+void FlowTableKSyncObject::FlushBatch() {
+    if (batch_.empty())
+        return;
+
+    boost::shared_ptr<FlowTableKSyncBatch>
+        batch(new FlowTableKSyncBatch(this, batch_.size()));
+    for (IoContextList::iterator it = batch_.begin(); it != batch_.end();
+         ++it) {
+        static_cast<FlowTableKSyncIoContext *>(*it)->set_batch(batch);
+    }
+    KSyncSock::Get(0)->SendAsyncBulk(batch_);
+    batch_.clear();
+}
+
+void FlowTableKSyncObject::BatchDone(uint32_t msg_count, uint64_t latency) {
+    ksync_->agent()->stats()->UpdateFlowKSyncBatch(msg_count, latency);
+}
+
 KSyncEntry *FlowTableKSyncObject::Alloc(const KSyncEntry *key, uint32_t index) {
     const FlowTableKSyncEntry *entry  =
         static_cast<const FlowTableKSyncEntry *>(key);
@@ -15,6 +15,7 @@
 #include <ksync/ksync_entry.h>
 #include <ksync/ksync_object.h>
 #include <ksync/ksync_netlink.h>
+#include <ksync/ksync_sock.h>
 #include <ksync/agent_ksync_types.h>
 #include <pkt/flow_table.h>
 #include <vr_types.h>
@@ -44,6 +45,7 @@ public:
     virtual KSyncEntry *UnresolvedReference();
     bool AllowDeleteStateComp() {return false;}
     virtual void ErrorHandler(int, uint32_t) const;
+    virtual void SendMsg(char *msg, int msg_len, KSyncEntry::KSyncEvent event);
 private:
     FlowEntryPtr flow_entry_;
     uint32_t hash_id_;
@@ -67,6 +69,7 @@ public:
     static const uint32_t AuditYieldTimer = 500;         // in msec
     static const uint32_t AuditTimeout = 2000;           // in msec
     static const int AuditYield = 1024;
+    static const uint32_t kMaxBatchSize = 32;
 
     FlowTableKSyncObject(KSync *ksync);
     FlowTableKSyncObject(KSync *ksync, int max_index);
@@ -96,8 +99,21 @@ public:
     void Shutdown() {
         UnmapFlowMemTest();
     }
+
+    // Messages for flows updated between StartBatch and the matching
+    // EndBatch are sent to vrouter together. Calls can be nested, the batch
+    // is sent when the outermost EndBatch is called or when an inner one
+    // finds kMaxBatchSize messages pending. Forward and reverse flows updated
+    // in one inner batch are hence always sent together
+    void StartBatch();
+    void EndBatch();
+    void SendMsg(FlowTableKSyncEntry *entry, char *msg, int msg_len,
+                 KSyncEntry::KSyncEvent event);
+    void BatchDone(uint32_t msg_count, uint64_t latency);
 private:
     friend class KSyncSandeshContext;
+    void FlushBatch();
+
     KSync *ksync_;
     int major_devid_;
     int flow_table_size_;
@@ -110,7 +126,23 @@ private:
     uint64_t audit_timestamp_;
     std::list<std::pair<uint32_t, uint64_t> > audit_flow_list_;
     Timer *audit_timer_;
+    uint32_t batch_depth_;
+    IoContextList batch_;
     DISALLOW_COPY_AND_ASSIGN(FlowTableKSyncObject);
 };
 
+// Batches flow messages for the lifetime of the object
+class FlowTableKSyncBatchScope {
+public:
+    explicit FlowTableKSyncBatchScope(FlowTableKSyncObject *obj) : obj_(obj) {
+        obj_->StartBatch();
+    }
+    ~FlowTableKSyncBatchScope() {
+        obj_->EndBatch();
+    }
+private:
+    FlowTableKSyncObject *obj_;
+    DISALLOW_COPY_AND_ASSIGN(FlowTableKSyncBatchScope);
+};
+
 #endif /* __AGENT_FLOWTABLE_KSYNC_H__ */
@@ -19,8 +19,12 @@ using namespace std;
 AgentRouteWalker::AgentRouteWalker(Agent *agent, WalkType type) :
     agent_(agent), walk_type_(type),
     vrf_walkid_(DBTableWalker::kInvalidWalkerId), walk_done_cb_(),
-    route_walk_done_for_vrf_cb_() {
+    route_walk_done_for_vrf_cb_(), walk_start_time_(0), walk_start_clock_(0),
+    vrf_walk_time_(0), walk_time_(0), vrf_route_walks_(0),
+    route_table_walks_(0),
+    max_vrf_route_walk_time_(0) {
     walk_count_ = AgentRouteWalker::kInvalidWalkCount;
+    route_notify_count_ = 0;
     for (uint8_t table_type = 0; table_type < Agent::ROUTE_TABLE_MAX; 
          table_type++) {
         route_walkid_[table_type].clear();
@@ -62,6 +66,26 @@ void AgentRouteWalker::CancelRouteWalk(const VrfEntry *vrf) {
             DecrementWalkCount();
         }
     }
+    vrf_walk_start_.erase(vrf_id);
+}
+
+/*
+ * Resets the stats if no walk is pending, i.e. a new run of walks starts
+ */
+void AgentRouteWalker::StartWalkRun() {
+    if (walk_count_ != AgentRouteWalker::kInvalidWalkCount)
+        return;
+
+    walk_start_time_ = UTCTimestampUsec();
+    walk_start_clock_ = ClockMonotonicUsec();
+    vrf_walk_time_ = 0;
+    walk_time_ = 0;
+    vrf_route_walks_ = 0;
+    route_table_walks_ = 0;
+    route_notify_count_ = 0;
+    max_vrf_route_walk_time_ = 0;
+    max_vrf_route_walk_vrf_.clear();
+    vrf_walk_start_.clear();
 }
 
 /*
@@ -74,6 +98,7 @@ void AgentRouteWalker::StartVrfWalk()
 
     //Cancel the VRF walk if started previously
     CancelVrfWalk();
+    StartWalkRun();
 
     //New walk start for VRF
     vrf_walkid_ = walker->WalkTable(agent_->vrf_table(), NULL,
@@ -100,6 +125,8 @@ void AgentRouteWalker::StartRouteWalk(const VrfEntry *vrf) {
 
     //Cancel any walk started previously for this VRF
     CancelRouteWalk(vrf);
+    StartWalkRun();
+    vrf_walk_start_[vrf_id] = ClockMonotonicUsec();
 
     //Start the walk for every route table
     for (uint8_t table_type = 0; table_type < Agent::ROUTE_TABLE_MAX; 
@@ -107,12 +134,13 @@ void AgentRouteWalker::StartRouteWalk(const VrfEntry *vrf) {
         table = static_cast<AgentRouteTable *>
             (vrf->GetRouteTable(table_type));
         walkid = walker->WalkTable(table, NULL, 
-                             boost::bind(&AgentRouteWalker::RouteWalkNotify, 
-                                         this, _1, _2),
+                    boost::bind(&AgentRouteWalker::RouteWalkNotifyInternal,
+                                this, _1, _2),
                              boost::bind(&AgentRouteWalker::RouteWalkDone, 
                                          this, _1));
         if (walkid != DBTableWalker::kInvalidWalkerId) {
             IncrementWalkCount();
+            route_table_walks_++;
             route_walkid_[table_type][vrf_id] = walkid;
             AGENT_LOG(AgentRouteWalkerLog, walkid, walk_type_,
                       "Route table walk started for vrf ", vrf->GetName(), 
@@ -153,10 +181,17 @@ void AgentRouteWalker::VrfWalkDone(DBTableBase *part) {
     AGENT_LOG(AgentRouteWalkerLog, vrf_walkid_, walk_type_,
               "VRF table walk done ", "",  0);
     vrf_walkid_ = DBTableWalker::kInvalidWalkerId;
+    vrf_walk_time_ = ClockMonotonicUsec() - walk_start_clock_;
     DecrementWalkCount();
     OnWalkComplete();
 }
 
+bool AgentRouteWalker::RouteWalkNotifyInternal(DBTablePartBase *partition,
+                                               DBEntryBase *e) {
+    route_notify_count_++;
+    return RouteWalkNotify(partition, e);
+}
+
 /*
  * Route entry notification handler
  */
@@ -180,6 +215,19 @@ void AgentRouteWalker::RouteWalkDone(DBTableBase *part) {
         route_walkid_[table_type].erase(vrf_id);
         DecrementWalkCount();
 
+        std::map<uint32_t, uint64_t>::iterator start_it =
+            vrf_walk_start_.find(vrf_id);
+        if (start_it != vrf_walk_start_.end() &&
+            IsRouteWalkDoneForVrf(vrf_id)) {
+            uint64_t time = ClockMonotonicUsec() - start_it->second;
+            vrf_route_walks_++;
+            if (time > max_vrf_route_walk_time_ && table->vrf_entry()) {
+                max_vrf_route_walk_time_ = time;
+                max_vrf_route_walk_vrf_ = table->vrf_entry()->GetName();
+            }
+            vrf_walk_start_.erase(start_it);
+        }
+
         // vrf entry can be null as table wud have released the reference
         // via lifetime actor
         VrfEntry *vrf = table->vrf_entry();
@@ -207,19 +255,25 @@ void AgentRouteWalker::Callback(VrfEntry *vrf) {
 /*
  * Check if all route table walk have been reset for this VRF
  */
-void AgentRouteWalker::OnRouteTableWalkCompleteForVrf(VrfEntry *vrf) {
-    if (!route_walk_done_for_vrf_cb_)
-        return;
-
+bool AgentRouteWalker::IsRouteWalkDoneForVrf(uint32_t vrf_id) {
     for (uint8_t table_type = 0; table_type < Agent::ROUTE_TABLE_MAX; 
          table_type++) {
         VrfRouteWalkerIdMapIterator iter = 
-            route_walkid_[table_type].find(vrf->vrf_id());
+            route_walkid_[table_type].find(vrf_id);
         if (iter != route_walkid_[table_type].end()) {
-            return;
+            return false;
         }
     }
-    route_walk_done_for_vrf_cb_(vrf);
+    return true;
+}
+
+void AgentRouteWalker::OnRouteTableWalkCompleteForVrf(VrfEntry *vrf) {
+    if (!route_walk_done_for_vrf_cb_)
+        return;
+
+    if (IsRouteWalkDoneForVrf(vrf->vrf_id())) {
+        route_walk_done_for_vrf_cb_(vrf);
+    }
 }
 
 /*
@@ -241,6 +295,9 @@ void AgentRouteWalker::OnWalkComplete() {
     if (walk_done && walk_count_) {
         assert(0);
     }
+    if (walk_done) {
+        walk_time_ = ClockMonotonicUsec() - walk_start_clock_;
+    }
     if (walk_done && !walk_count_ && walk_done_cb_) {
         walk_done_cb_();
     }
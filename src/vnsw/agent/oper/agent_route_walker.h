@@ -35,6 +35,9 @@
  * argument.
  * TODO - Do route cancellation for route walks when vrf walk is cancelled.
  *
+ * Time taken by the last run of walks is kept for introspect. A run starts
+ * when a walk is issued with no other walk pending and ends when all VRF and
+ * route walks are done.
  */
 
 class AgentRouteWalker {
@@ -73,7 +76,25 @@ public:
     bool IsWalkCompleted() const {return (walk_count_ == 0);}
     Agent *agent() const {return agent_;}
 
+    // Stats of the last run, times are in usec. Start time is a UTC
+    // timestamp, durations are measured with the monotonic clock
+    uint64_t walk_start_time() const {return walk_start_time_;}
+    uint64_t vrf_walk_time() const {return vrf_walk_time_;}
+    uint64_t walk_time() const {return walk_time_;}
+    uint32_t vrf_route_walks() const {return vrf_route_walks_;}
+    uint32_t route_table_walks() const {return route_table_walks_;}
+    uint64_t route_notify_count() const {return route_notify_count_;}
+    uint64_t max_vrf_route_walk_time() const {
+        return max_vrf_route_walk_time_;
+    }
+    const std::string &max_vrf_route_walk_vrf() const {
+        return max_vrf_route_walk_vrf_;
+    }
+
 private:
+    bool RouteWalkNotifyInternal(DBTablePartBase *partition, DBEntryBase *e);
+    void StartWalkRun();
+    bool IsRouteWalkDoneForVrf(uint32_t vrf_id);
     void Callback(VrfEntry *vrf);
     void OnWalkComplete();
     void OnRouteTableWalkCompleteForVrf(VrfEntry *vrf);
@@ -87,6 +108,18 @@ private:
     VrfRouteWalkerIdMap route_walkid_[Agent::ROUTE_TABLE_MAX];
     WalkDone walk_done_cb_;
     RouteWalkDoneCb route_walk_done_for_vrf_cb_;
+
+    // Start time of route walks for a VRF
+    std::map<uint32_t, uint64_t> vrf_walk_start_;
+    uint64_t walk_start_time_;
+    uint64_t walk_start_clock_;
+    uint64_t vrf_walk_time_;
+    uint64_t walk_time_;
+    uint32_t vrf_route_walks_;
+    uint32_t route_table_walks_;
+    tbb::atomic<uint64_t> route_notify_count_;
+    uint64_t max_vrf_route_walk_time_;
+    std::string max_vrf_route_walk_vrf_;
     DISALLOW_COPY_AND_ASSIGN(AgentRouteWalker);
 };
 
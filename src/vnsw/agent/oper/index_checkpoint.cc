@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+
+#include <base/logging.h>
+#include <base/task.h>
+#include <base/timer.h>
+#include <cmn/agent_cmn.h>
+#include <oper/index_checkpoint.h>
+
+const uint32_t IndexCheckpoint::kInvalidIndex;
+const uint32_t IndexCheckpoint::kWriteInterval;
+const uint32_t IndexCheckpoint::kReleaseTimeout;
+
+static const char *type_names[] = {
+    "vrf",
+    "interface",
+    "label"
+};
+
+IndexCheckpoint::IndexCheckpoint(Agent *agent)
+    : agent_(agent), file_(), enabled_(false), dirty_(false),
+      write_timer_(NULL), release_timer_(NULL) {
+}
+
+IndexCheckpoint::~IndexCheckpoint() {
+    if (write_timer_) {
+        write_timer_->Cancel();
+        TimerManager::DeleteTimer(write_timer_);
+    }
+    if (release_timer_) {
+        release_timer_->Cancel();
+        TimerManager::DeleteTimer(release_timer_);
+    }
+}
+
+void IndexCheckpoint::Init(const std::string &file) {
+    if (file.empty()) {
+        return;
+    }
+
+    // Drop state of earlier run, if any
+    ReleaseRestored();
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        for (int type = 0; type < MAX_TYPE; type++) {
+            sections_[type].keys.clear();
+            sections_[type].indices.clear();
+        }
+    }
+
+    file_ = file;
+    Read();
+    enabled_ = true;
+
+    // Timers run in db::DBTable context as held indices are released into
+    // the tables
+    if (write_timer_ == NULL) {
+        int task_id = TaskScheduler::GetInstance()->GetTaskId("db::DBTable");
+        boost::asio::io_service &io = *(agent_->event_manager())->io_service();
+        write_timer_ = TimerManager::CreateTimer(io,
+                                                 "IndexCheckpointWriteTimer",
+                                                 task_id, 0);
+        release_timer_ = TimerManager::CreateTimer(io,
+                                                 "IndexCheckpointReleaseTimer",
+                                                 task_id, 0);
+    }
+    write_timer_->Cancel();
+    write_timer_->Start(kWriteInterval,
+                        boost::bind(&IndexCheckpoint::WriteTimerExpired, this));
+    release_timer_->Cancel();
+    release_timer_->Start(kReleaseTimeout,
+                          boost::bind(&IndexCheckpoint::ReleaseTimerExpired,
+                                      this));
+}
+
+void IndexCheckpoint::Shutdown() {
+    if (enabled_ == false) {
+        return;
+    }
+
+    Write();
+    tbb::mutex::scoped_lock lock(mutex_);
+    enabled_ = false;
+}
+
+// Read "<type> <index> <key>" lines from the file. Key is rest of the line
+bool IndexCheckpoint::Read() {
+    std::ifstream in(file_.c_str());
+    if (!in.is_open()) {
+        return false;
+    }
+
+    tbb::mutex::scoped_lock lock(mutex_);
+    std::string line;
+    uint32_t count = 0;
+    while (std::getline(in, line)) {
+        std::istringstream str(line);
+        std::string type_name;
+        uint32_t index;
+        std::string key;
+        if (!(str >> type_name >> index)) {
+            continue;
+        }
+        str.get();
+        std::getline(str, key);
+        if (key.empty()) {
+            continue;
+        }
+
+        for (int type = 0; type < MAX_TYPE; type++) {
+            if (type_name != type_names[type]) {
+                continue;
+            }
+            Section &section = sections_[type];
+            if (section.restored_index.find(index) !=
+                section.restored_index.end()) {
+                break;
+            }
+            section.restored[key] = index;
+            section.restored_index[index] = key;
+            count++;
+            break;
+        }
+    }
+
+    LOG(DEBUG, "Restored " << count << " indices from checkpoint file "
+        << file_);
+    return true;
+}
+
+bool IndexCheckpoint::Write() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return WriteInternal();
+}
+
+// Restored indices not claimed yet are written too, so that they survive
+// another restart within kReleaseTimeout
+bool IndexCheckpoint::WriteInternal() {
+    if (enabled_ == false) {
+        return false;
+    }
+
+    std::string tmp_file = file_ + ".tmp";
+    std::ofstream out(tmp_file.c_str(), std::ios::trunc);
+    if (!out.is_open()) {
+        LOG(ERROR, "Error opening checkpoint file " << tmp_file);
+        return false;
+    }
+
+    for (int type = 0; type < MAX_TYPE; type++) {
+        const Section &section = sections_[type];
+        for (IndexMap::const_iterator it = section.indices.begin();
+             it != section.indices.end(); ++it) {
+            out << type_names[type] << " " << it->first << " " << it->second
+                << "\n";
+        }
+        for (IndexMap::const_iterator it = section.restored_index.begin();
+             it != section.restored_index.end(); ++it) {
+            out << type_names[type] << " " << it->first << " " << it->second
+                << "\n";
+        }
+    }
+    out.close();
+    if (out.fail() || rename(tmp_file.c_str(), file_.c_str()) != 0) {
+        LOG(ERROR, "Error writing checkpoint file " << file_);
+        return false;
+    }
+
+    dirty_ = false;
+    return true;
+}
+
+bool IndexCheckpoint::WriteTimerExpired() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (dirty_) {
+        WriteInternal();
+    }
+    return enabled_;
+}
+
+bool IndexCheckpoint::ReleaseTimerExpired() {
+    ReleaseRestored();
+    return false;
+}
+
+void IndexCheckpoint::ReleaseRestored() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    for (int type = 0; type < MAX_TYPE; type++) {
+        Section &section = sections_[type];
+        for (HeldMap::iterator it = section.held.begin();
+             it != section.held.end(); ++it) {
+            it->second();
+        }
+        section.held.clear();
+        if (section.restored.empty() == false) {
+            dirty_ = true;
+        }
+        section.restored.clear();
+        section.restored_index.clear();
+    }
+}
+
+void IndexCheckpoint::AddInternal(Type type, const std::string &key,
+                                  uint32_t index) {
+    Section &section = sections_[type];
+    section.keys[key] = index;
+    section.indices[index] = key;
+    dirty_ = true;
+}
+
+void IndexCheckpoint::Free(Type type, size_t index) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (enabled_ == false) {
+        return;
+    }
+
+    Section &section = sections_[type];
+    IndexMap::iterator it = section.indices.find(index);
+    if (it == section.indices.end()) {
+        return;
+    }
+    // Key may have been given a new index before the old one is freed
+    KeyMap::iterator key_it = section.keys.find(it->second);
+    if (key_it != section.keys.end() && key_it->second == index) {
+        section.keys.erase(key_it);
+    }
+    section.indices.erase(it);
+    dirty_ = true;
+}
+
+uint32_t IndexCheckpoint::Find(Type type, const std::string &key) const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    const Section &section = sections_[type];
+    KeyMap::const_iterator it = section.keys.find(key);
+    if (it == section.keys.end()) {
+        return kInvalidIndex;
+    }
+    return it->second;
+}
+
+size_t IndexCheckpoint::restored_count(Type type) const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return sections_[type].restored.size();
+}
+
+size_t IndexCheckpoint::held_count(Type type) const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return sections_[type].held.size();
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef vnsw_agent_index_checkpoint_h
+#define vnsw_agent_index_checkpoint_h
+
+#include <map>
+#include <string>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <tbb/mutex.h>
+#include <base/util.h>
+#include <cmn/index_vector.h>
+
+class Agent;
+class Timer;
+
+// Checkpoints indices allocated by oper DB (vrf-id, interface-id and MPLS
+// labels of VM interfaces) to a local file.
+//
+// On restart, indices read from the file are given back to the same VRF,
+// interface or label when it is added again, so that vrouter and control
+// node see the same indices as before the restart. Index restored for a key
+// is not handed to any other key till kReleaseTimeout after the restart.
+//
+// Checkpoint is disabled when no file is configured.
+class IndexCheckpoint {
+public:
+    enum Type {
+        VRF,
+        INTERFACE,
+        MPLS_LABEL,
+        MAX_TYPE
+    };
+
+    static const uint32_t kInvalidIndex = 0xFFFFFFFF;
+    // Interval to write the file, if there was a change (msec)
+    static const uint32_t kWriteInterval = 5000;
+    // Time to hold restored indices not claimed yet (msec)
+    static const uint32_t kReleaseTimeout = 180000;
+
+    IndexCheckpoint(Agent *agent);
+    ~IndexCheckpoint();
+
+    // Restore indices from file and start checkpointing to it
+    void Init(const std::string &file);
+    // Write the file and stop tracking allocations
+    void Shutdown();
+
+    // Allocate index for key in table. Index restored for the key is used if
+    // it is free. Index allocated with empty key is not checkpointed, but is
+    // still kept off indices restored for other keys
+    template <typename EntryType>
+    size_t Allocate(Type type, const std::string &key,
+                    IndexVector<EntryType> *table, EntryType *entry) {
+        tbb::mutex::scoped_lock lock(mutex_);
+        if (enabled_ == false) {
+            return table->Insert(entry);
+        }
+
+        Section &section = sections_[type];
+        size_t index = kInvalidIndex;
+        KeyMap::iterator it = section.restored.find(key);
+        if (key.empty() == false && it != section.restored.end()) {
+            index = it->second;
+            section.restored.erase(it);
+            section.restored_index.erase(index);
+            HeldMap::iterator held_it = section.held.find(index);
+            if (held_it != section.held.end()) {
+                table->Update(index, entry);
+                section.held.erase(held_it);
+            } else if (table->InsertAtIndex(index, entry) == false) {
+                index = kInvalidIndex;
+            }
+        }
+
+        // Index restored for other keys are held till claimed
+        while (index == kInvalidIndex) {
+            index = table->Insert(entry);
+            if (section.restored_index.find(index) ==
+                section.restored_index.end()) {
+                break;
+            }
+            table->Update(index, NULL);
+            section.held[index] =
+                boost::bind(&IndexVector<EntryType>::Remove, table, index);
+            index = kInvalidIndex;
+        }
+
+        if (key.empty() == false) {
+            AddInternal(type, key, index);
+        }
+        return index;
+    }
+
+    // Index is freed from table
+    void Free(Type type, size_t index);
+    // Release held indices that were not claimed
+    void ReleaseRestored();
+    // Write the file now
+    bool Write();
+
+    const std::string &file() const { return file_; }
+    bool enabled() const { return enabled_; }
+    uint32_t Find(Type type, const std::string &key) const;
+    size_t restored_count(Type type) const;
+    size_t held_count(Type type) const;
+
+private:
+    typedef std::map<std::string, uint32_t> KeyMap;
+    typedef std::map<uint32_t, std::string> IndexMap;
+    typedef std::map<uint32_t, boost::function<void(void)> > HeldMap;
+
+    struct Section {
+        // Allocated indices
+        KeyMap keys;
+        IndexMap indices;
+        // Indices restored from file, not claimed yet
+        KeyMap restored;
+        IndexMap restored_index;
+        // Restored indices allocated from table to keep them from others
+        HeldMap held;
+    };
+
+    void AddInternal(Type type, const std::string &key, uint32_t index);
+    bool Read();
+    bool WriteInternal();
+    bool WriteTimerExpired();
+    bool ReleaseTimerExpired();
+
+    Agent *agent_;
+    std::string file_;
+    bool enabled_;
+    bool dirty_;
+    mutable tbb::mutex mutex_;
+    Section sections_[MAX_TYPE];
+    Timer *write_timer_;
+    Timer *release_timer_;
+    DISALLOW_COPY_AND_ASSIGN(IndexCheckpoint);
+};
+
+#endif // vnsw_agent_index_checkpoint_h
@@ -15,6 +15,7 @@
 #include <cfg/cfg_init.h>
 #include <cfg/cfg_interface.h>
 #include <oper/operdb_init.h>
+#include <oper/index_checkpoint.h>
 #include <oper/route_common.h>
 #include <oper/vm.h>
 #include <oper/vn.h>
@@ -61,7 +62,14 @@ DBEntry *InterfaceTable::Add(const DBRequest *req) {
     if (intf == NULL)
         return NULL;
 
-    intf->id_ = index_table_.Insert(intf);
+    // VM interfaces are identified by uuid, name is known only from config
+    std::string checkpoint_key = intf->name();
+    if (intf->type() == Interface::VM_INTERFACE) {
+        checkpoint_key = UuidToString(intf->GetUuid());
+    }
+    intf->id_ = agent()->oper_db()->index_checkpoint()->
+        Allocate(IndexCheckpoint::INTERFACE, checkpoint_key, &index_table_,
+                 intf);
 
     // Get the os-ifindex and mac of interface
     intf->GetOsParams(agent());
@@ -71,6 +79,12 @@ DBEntry *InterfaceTable::Add(const DBRequest *req) {
     return intf;
 }
 
+void InterfaceTable::FreeInterfaceId(size_t index) {
+    index_table_.Remove(index);
+    agent()->oper_db()->index_checkpoint()->Free(IndexCheckpoint::INTERFACE,
+                                                 index);
+}
+
 bool InterfaceTable::OnChange(DBEntry *entry, const DBRequest *req) {
     bool ret = false;
     InterfaceKey *key = static_cast<InterfaceKey *>(req->key.get());
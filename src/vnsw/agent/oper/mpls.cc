@@ -12,6 +12,8 @@
 #include <oper/mpls.h>
 #include <oper/mirror_table.h>
 #include <oper/agent_sandesh.h>
+#include <oper/operdb_init.h>
+#include <oper/index_checkpoint.h>
 
 using namespace std;
 
@@ -100,11 +102,23 @@ DBTableBase *MplsTable::CreateTable(DB *db, const std::string &name) {
     // We want to allocate labels from an offset
     // Pre-allocate entries 
     for (unsigned int i = 0; i < kStartLabel; i++) {
-        mpls_table_->AllocLabel();
+        mpls_table_->label_table_.Insert(NULL);
     }
     return mpls_table_;
 };
 
+uint32_t MplsTable::AllocLabel(const std::string &key) {
+    return agent()->oper_db()->index_checkpoint()->
+        Allocate<MplsLabel>(IndexCheckpoint::MPLS_LABEL, key, &label_table_,
+                            NULL);
+}
+
+void MplsTable::FreeLabel(uint32_t label) {
+    label_table_.Remove(label);
+    agent()->oper_db()->index_checkpoint()->Free(IndexCheckpoint::MPLS_LABEL,
+                                                 label);
+}
+
 void MplsTable::Process(DBRequest &req) {
     CHECK_CONCURRENCY("db::DBTable");
     DBTablePartition *tpart =
@@ -143,9 +143,11 @@ public:
     virtual void Delete(DBEntry *entry, const DBRequest *req);
 
     // Allocate and Free label from the label_table
-    uint32_t AllocLabel() {return label_table_.Insert(NULL);};
+    uint32_t AllocLabel() {return AllocLabel(std::string());};
+    // Allocate label checkpointed against key
+    uint32_t AllocLabel(const std::string &key);
     void UpdateLabel(uint32_t label, MplsLabel *entry) {return label_table_.Update(label, entry);};
-    void FreeLabel(uint32_t label) {label_table_.Remove(label);};
+    void FreeLabel(uint32_t label);
     MplsLabel *FindMplsLabel(size_t index) {return label_table_.At(index);};
 
     static DBTableBase *CreateTable(DB *db, const std::string &name);
@@ -21,6 +21,7 @@
 using namespace std;
 
 NextHopTable *NextHopTable::nexthop_table_;
+const uint32_t CompositeNH::kHashTableSize;
 
 /////////////////////////////////////////////////////////////////////////////
 // TunnelTyperoutines
@@ -1219,9 +1220,56 @@ bool CompositeNH::Change(const DBRequest* req) {
     }
 
     component_nh_list_ = component_nh_list;
+    UpdateHashTable();
     return changed;
 }
 
+// Weight of a component NH for a hash bucket. Mixes bucket and component
+// index (murmur3 finalizer) so that weights are spread uniformly
+static uint32_t HashWeight(uint32_t bucket, uint32_t idx) {
+    uint32_t h = (bucket * 0x9E3779B1) ^ (idx * 0x85EBCA6B);
+    h ^= h >> 16;
+    h *= 0x85EBCA6B;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35;
+    h ^= h >> 16;
+    return h;
+}
+
+// Assign each hash bucket to the active component NH with highest weight
+// for the bucket. Weights depend only on the bucket and component index,
+// which is retained across changes to composite NH. Hence, a new component
+// NH takes over only its share of buckets and buckets of a removed
+// component NH are spread across remaining ones, leaving flows hashed to
+// other component NH undisturbed
+void CompositeNH::UpdateHashTable() {
+    hash_table_.clear();
+    if (composite_nh_type_ != Composite::ECMP &&
+        composite_nh_type_ != Composite::LOCAL_ECMP) {
+        return;
+    }
+    if (ActiveComponentNHCount() == 0) {
+        return;
+    }
+
+    hash_table_.resize(kHashTableSize);
+    for (uint32_t bucket = 0; bucket < kHashTableSize; bucket++) {
+        uint32_t max_weight = 0;
+        uint32_t max_idx = 0xffff;
+        for (uint32_t idx = 0; idx < component_nh_list_.size(); idx++) {
+            if (component_nh_list_[idx].get() == NULL) {
+                continue;
+            }
+            uint32_t weight = HashWeight(bucket, idx);
+            if (max_idx == 0xffff || weight > max_weight) {
+                max_weight = weight;
+                max_idx = idx;
+            }
+        }
+        hash_table_[bucket] = max_idx;
+    }
+}
+
 void CompositeNH::SendObjectLog(AgentLogEvent::type event) const {
     NextHopObjectLogInfo info;
     FillObjectLog(event, info);
@@ -1374,6 +1422,7 @@ CompositeNH::KeyPtr CompositeNH::GetDBRequestKey() const {
 
 void CompositeNH::Delete(const DBRequest* req) {
     component_nh_list_.clear();
+    hash_table_.clear();
 }
 
 void CompositeNH::CreateComponentNH(Agent *agent,
@@ -1140,11 +1140,17 @@ private:
 //  If one of the component NH gets deleted, then a empty component NH
 //  would be installed, which would resulting in kernel trapping flow
 //  which are pointing to that component NH
+//* Flows are spread across ECMP component NH through a table of hash
+//  buckets. Buckets are assigned to component NH by rendezvous hashing on
+//  the component NH index, so adding or removing a component NH only moves
+//  the buckets of that component NH
 //* In case of multicast composite NH ordering of the component NH is not
 //  important
 class CompositeNH : public NextHop {
 public:
     static const uint32_t kInvalidComponentNHIdx = 0xFFFFFFFF;
+    // Number of hash buckets spread across active component NH
+    static const uint32_t kHashTableSize = 256;
     CompositeNH(COMPOSITETYPE type, bool policy,
         const ComponentNHKeyList &component_nh_key_list, VrfEntry *vrf):
         NextHop(COMPOSITE, policy), composite_nh_type_(type),
@@ -1220,16 +1226,13 @@ public:
     const VrfEntry* vrf() const {
         return vrf_.get();
     }
+   // Returns index of the component NH for a flow hash, or 0xffff if there
+   // are no active component NH
    uint32_t hash(uint32_t seed) const {
-       uint32_t idx = seed % component_nh_list_.size();
-       while (component_nh_list_[idx].get() == NULL) {
-           idx = (idx + 1) % component_nh_list_.size();
-           if (idx == seed % component_nh_list_.size()) {
-               idx = 0xffff;
-               break;
-           }
+       if (hash_table_.empty()) {
+           return 0xffff;
        }
-       return idx;
+       return hash_table_[seed % hash_table_.size()];
    }
    bool GetIndex(ComponentNH &nh, uint32_t &idx) const;
    const ComponentNH* Get(uint32_t idx) const {
@@ -1240,9 +1243,12 @@ private:
     void CreateComponentNH(Agent *agent, TunnelType::Type type) const;
     void ChangeComponentNHKeyTunnelType(ComponentNHKeyList &component_nh_list,
                                         TunnelType::Type type) const;
+    void UpdateHashTable();
     COMPOSITETYPE composite_nh_type_;
     ComponentNHKeyList component_nh_key_list_;
     ComponentNHList component_nh_list_;
+    // Index of component NH for each hash bucket
+    std::vector<uint32_t> hash_table_;
     VrfEntryRef vrf_;
     DISALLOW_COPY_AND_ASSIGN(CompositeNH);
 };
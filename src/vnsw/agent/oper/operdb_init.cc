@@ -33,6 +33,7 @@
 #include <base/task_trigger.h>
 #include <oper/namespace_manager.h>
 #include <oper/loadbalancer.h>
+#include <oper/index_checkpoint.h>
 
 SandeshTraceBufferPtr OperDBTraceBuf(SandeshTraceBufferCreate("Oper DB", 5000));
 
@@ -154,11 +155,15 @@ void OperDB::Init() {
     std::string netns_cmd;
     int netns_workers = -1;
     int netns_timeout = -1;
+    std::string checkpoint_file;
     if (agent_->params()) {
         netns_cmd = agent_->params()->si_netns_command();
         netns_workers = agent_->params()->si_netns_workers();
         netns_timeout = agent_->params()->si_netns_timeout();
+        checkpoint_file = agent_->params()->checkpoint_file();
     }
+    // Indices are restored before any VRF or interface is created
+    index_checkpoint_->Init(checkpoint_file);
     namespace_manager_->Initialize(agent_->db(), agent_->agent_signal(),
                                    netns_cmd, netns_workers, netns_timeout);
 }
@@ -175,7 +180,8 @@ OperDB::OperDB(Agent *agent)
                   agent->db(), agent->cfg()->cfg_graph())),
           namespace_manager_(
               AgentObjectFactory::Create<NamespaceManager>(
-                  agent->event_manager())) {
+                  agent->event_manager())),
+          index_checkpoint_(new IndexCheckpoint(agent)) {
 }
 
 OperDB::~OperDB() {
@@ -17,6 +17,7 @@ class PathPreferenceModule;
 class IFMapDependencyManager;
 class MulticastHandler;
 class NamespaceManager;
+class IndexCheckpoint;
 
 class OperDB {
 public:
@@ -45,6 +46,9 @@ public:
     DomainConfig *domain_config_table() {
         return domain_config_.get();
     }
+    IndexCheckpoint *index_checkpoint() const {
+        return index_checkpoint_.get();
+    }
 
 private:
     OperDB();
@@ -56,6 +60,7 @@ private:
     std::auto_ptr<IFMapDependencyManager> dependency_manager_;
     std::auto_ptr<NamespaceManager> namespace_manager_;
     std::auto_ptr<DomainConfig> domain_config_;
+    std::auto_ptr<IndexCheckpoint> index_checkpoint_;
     DISALLOW_COPY_AND_ASSIGN(OperDB);
 };
 #endif
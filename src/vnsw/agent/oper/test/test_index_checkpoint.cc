@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+
+#include "testing/gunit.h"
+
+#include <base/logging.h>
+#include <cmn/agent_cmn.h>
+#include "oper/operdb_init.h"
+#include "oper/interface_common.h"
+#include "oper/index_checkpoint.h"
+#include "oper/vrf.h"
+#include "oper/mpls.h"
+#include "test_cmn_util.h"
+#include <ksync/ksync_sock_user.h>
+
+void RouterIdDepInit(Agent *agent) {
+}
+
+struct PortInfo input1[] = {
+    {"vnet1", 1, "1.1.1.10", "00:00:01:01:01:10", 1, 1},
+};
+
+struct PortInfo input2[] = {
+    {"vnet2", 2, "2.2.2.20", "00:00:02:02:02:20", 2, 2},
+};
+
+class IndexCheckpointTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        agent_ = Agent::GetInstance();
+        checkpoint_ = agent_->oper_db()->index_checkpoint();
+        std::stringstream str;
+        str << "/tmp/test_index_checkpoint." << getpid();
+        file_ = str.str();
+        remove(file_.c_str());
+        checkpoint_->Init(file_);
+    }
+
+    virtual void TearDown() {
+        checkpoint_->Shutdown();
+        checkpoint_->ReleaseRestored();
+        remove(file_.c_str());
+        client->WaitForIdle();
+    }
+
+    Agent *agent_;
+    IndexCheckpoint *checkpoint_;
+    std::string file_;
+};
+
+// VRF, interface and labels get back their indices after restart, even when
+// other entries are added before them
+TEST_F(IndexCheckpointTest, RestoreIndex) {
+    CreateVmportEnv(input1, 1);
+    client->WaitForIdle();
+    EXPECT_TRUE(VmPortActive(input1, 0));
+
+    Interface *intf = VmPortGet(1);
+    uint32_t intf_id = intf->id();
+    uint32_t label = intf->label();
+    uint32_t vrf_id = VrfGet("vrf1")->vrf_id();
+    EXPECT_EQ(intf_id, checkpoint_->Find(IndexCheckpoint::INTERFACE,
+                                         UuidToString(intf->GetUuid())));
+    EXPECT_EQ(vrf_id, checkpoint_->Find(IndexCheckpoint::VRF, "vrf1"));
+    EXPECT_EQ(label, checkpoint_->Find(IndexCheckpoint::MPLS_LABEL,
+                                       UuidToString(intf->GetUuid()) + ":l3"));
+    EXPECT_TRUE(checkpoint_->Write());
+
+    DeleteVmportEnv(input1, 1, true);
+    client->WaitForIdle();
+    WAIT_FOR(1000, 1000, (VrfFind("vrf1") == false));
+    EXPECT_FALSE(VmPortFind(1));
+
+    // Simulate restart of agent
+    checkpoint_->Init(file_);
+    EXPECT_EQ(1U, checkpoint_->restored_count(IndexCheckpoint::VRF));
+    EXPECT_EQ(1U, checkpoint_->restored_count(IndexCheckpoint::INTERFACE));
+    EXPECT_TRUE(checkpoint_->restored_count(IndexCheckpoint::MPLS_LABEL) > 0);
+
+    // Indices restored for vnet1 are not given to vnet2
+    CreateVmportEnv(input2, 1);
+    client->WaitForIdle();
+    EXPECT_TRUE(VmPortActive(input2, 0));
+    EXPECT_NE(vrf_id, VrfGet("vrf2")->vrf_id());
+    EXPECT_NE(intf_id, VmPortGet(2)->id());
+    EXPECT_NE(label, VmPortGet(2)->label());
+
+    CreateVmportEnv(input1, 1);
+    client->WaitForIdle();
+    EXPECT_TRUE(VmPortActive(input1, 0));
+    intf = VmPortGet(1);
+    EXPECT_EQ(intf_id, intf->id());
+    EXPECT_EQ(label, intf->label());
+    EXPECT_EQ(vrf_id, VrfGet("vrf1")->vrf_id());
+    EXPECT_EQ(0U, checkpoint_->restored_count(IndexCheckpoint::VRF));
+    EXPECT_EQ(0U, checkpoint_->held_count(IndexCheckpoint::VRF));
+    EXPECT_EQ(0U, checkpoint_->held_count(IndexCheckpoint::INTERFACE));
+
+    // vrouter is programmed at the restored indices
+    KSyncSockTypeMap *sock = KSyncSockTypeMap::GetKSyncSockTypeMap();
+    EXPECT_TRUE(sock->if_map.find(intf_id) != sock->if_map.end());
+    EXPECT_TRUE(sock->mpls_map.find(label) != sock->mpls_map.end());
+
+    DeleteVmportEnv(input1, 1, true);
+    DeleteVmportEnv(input2, 1, true);
+    client->WaitForIdle();
+    WAIT_FOR(1000, 1000, (VrfFind("vrf1") == false));
+    WAIT_FOR(1000, 1000, (VrfFind("vrf2") == false));
+}
+
+// Restored index not claimed is held till released
+TEST_F(IndexCheckpointTest, ReleaseRestored) {
+    // Find the vrf-id to be allocated next
+    VrfAddReq("vrf3");
+    client->WaitForIdle();
+    uint32_t vrf_id = VrfGet("vrf3")->vrf_id();
+    VrfDelReq("vrf3");
+    client->WaitForIdle();
+    WAIT_FOR(1000, 1000, (VrfFind("vrf3") == false));
+
+    {
+        std::ofstream out(file_.c_str());
+        out << "vrf " << vrf_id << " vrf-restored\n";
+    }
+    checkpoint_->Init(file_);
+    EXPECT_EQ(1U, checkpoint_->restored_count(IndexCheckpoint::VRF));
+
+    VrfAddReq("vrf4");
+    client->WaitForIdle();
+    EXPECT_NE(vrf_id, VrfGet("vrf4")->vrf_id());
+    EXPECT_EQ(1U, checkpoint_->held_count(IndexCheckpoint::VRF));
+
+    // Restored index is written back till it is released
+    EXPECT_TRUE(checkpoint_->Write());
+    {
+        std::ifstream in(file_.c_str());
+        std::stringstream str;
+        str << in.rdbuf();
+        EXPECT_TRUE(str.str().find("vrf-restored") != std::string::npos);
+    }
+
+    checkpoint_->ReleaseRestored();
+    EXPECT_EQ(0U, checkpoint_->held_count(IndexCheckpoint::VRF));
+    EXPECT_EQ(0U, checkpoint_->restored_count(IndexCheckpoint::VRF));
+
+    VrfAddReq("vrf5");
+    client->WaitForIdle();
+    EXPECT_EQ(vrf_id, VrfGet("vrf5")->vrf_id());
+
+    VrfDelReq("vrf4");
+    VrfDelReq("vrf5");
+    client->WaitForIdle();
+    WAIT_FOR(1000, 1000, (VrfFind("vrf4") == false));
+    WAIT_FOR(1000, 1000, (VrfFind("vrf5") == false));
+}
+
+int main(int argc, char **argv) {
+    GETUSERARGS();
+
+    client = TestInit(init_file, ksync_init, false, false, false);
+
+    int ret = RUN_ALL_TESTS();
+
+    client->WaitForIdle();
+    TestShutdown();
+    delete client;
+
+    return ret;
+}
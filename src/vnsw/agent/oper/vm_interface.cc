@@ -1310,7 +1310,8 @@ void VmInterface::AllocL3MplsLabel(bool force_update, bool policy_change) {
     bool new_entry = false;
     if (label_ == MplsTable::kInvalidLabel) {
         Agent *agent = static_cast<InterfaceTable *>(get_table())->agent();
-        label_ = agent->mpls_table()->AllocLabel();
+        label_ = agent->mpls_table()->AllocLabel(UuidToString(GetUuid()) +
+                                                 ":l3");
         new_entry = true;
     }
 
@@ -1335,7 +1336,8 @@ void VmInterface::AllocL2MplsLabel(bool force_update,
     bool new_entry = false;
     if (l2_label_ == MplsTable::kInvalidLabel) {
         Agent *agent = static_cast<InterfaceTable *>(get_table())->agent();
-        l2_label_ = agent->mpls_table()->AllocLabel();
+        l2_label_ = agent->mpls_table()->AllocLabel(UuidToString(GetUuid()) +
+                                                    ":l2");
         new_entry = true;
     }
 
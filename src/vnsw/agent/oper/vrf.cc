@@ -25,6 +25,8 @@
 #include <controller/controller_vrf_export.h>
 #include <oper/agent_sandesh.h>
 #include <oper/nexthop.h>
+#include <oper/operdb_init.h>
+#include <oper/index_checkpoint.h>
 
 using namespace std;
 using namespace autogen;
@@ -259,7 +261,8 @@ DBEntry *VrfTable::Add(const DBRequest *req) {
         assert(0);
         return NULL;
     }
-    vrf->id_ = index_table_.Insert(vrf);
+    vrf->id_ = agent()->oper_db()->index_checkpoint()->
+        Allocate(IndexCheckpoint::VRF, key->name_, &index_table_, vrf);
     name_tree_.insert( VrfNamePair(key->name_, vrf));
 
     vrf->SendObjectLog(AgentLogEvent::ADD);
@@ -267,6 +270,11 @@ DBEntry *VrfTable::Add(const DBRequest *req) {
     return vrf;
 }
 
+void VrfTable::FreeVrfId(size_t index) {
+    index_table_.Remove(index);
+    agent()->oper_db()->index_checkpoint()->Free(IndexCheckpoint::VRF, index);
+}
+
 bool VrfTable::OnChange(DBEntry *entry, const DBRequest *req) {
     VrfEntry *vrf = static_cast<VrfEntry *>(entry);
     VrfData *data = static_cast<VrfData *>(req->data.get());
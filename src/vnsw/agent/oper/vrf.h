@@ -153,7 +153,7 @@ public:
 
     VrfEntry *FindVrfFromName(const string &name);
     VrfEntry *FindVrfFromId(size_t index);
-    void FreeVrfId(size_t index) {index_table_.Remove(index);};
+    void FreeVrfId(size_t index);
 
     virtual bool CanNotify(IFMapNode *dbe);
     
@@ -27,6 +27,8 @@ void AgentStats::Reset() {
     flow_drop_due_to_linklocal_limit_ = ipc_in_msgs_ = 0;
     ipc_out_msgs_ = in_tpkts_ = in_bytes_ = out_tpkts_ = 0;
     out_bytes_ = 0;
+    flow_ksync_batches_ = flow_ksync_batch_msgs_ = 0;
+    flow_ksync_batch_latency_ = flow_ksync_batch_max_latency_ = 0;
 }
 
 void AgentStatsReq::HandleRequest() const {
@@ -59,6 +61,11 @@ void AgentStatsReq::HandleRequest() const {
             stats->flow_drop_due_to_linklocal_limit());
     flow->set_flow_max_system_flows(agent->flow_table_size());
     flow->set_flow_max_vm_flows(agent->pkt()->flow_table()->max_vm_flows());
+    flow->set_flow_ksync_batches(stats->flow_ksync_batches());
+    flow->set_flow_ksync_batch_msgs(stats->flow_ksync_batch_msgs());
+    flow->set_flow_ksync_batch_latency(stats->flow_ksync_batch_latency());
+    flow->set_flow_ksync_batch_max_latency(
+            stats->flow_ksync_batch_max_latency());
     flow->set_context(context());
     flow->set_more(true);
     flow->Response();
@@ -18,7 +18,8 @@ public:
         flow_aged_(0U), flow_active_(0U), flow_drop_due_to_max_limit_(0),
         flow_drop_due_to_linklocal_limit_(0), ipc_in_msgs_(0U),
         ipc_out_msgs_(0U), in_tpkts_(0U), in_bytes_(0U), out_tpkts_(0U),
-        out_bytes_(0U) {
+        out_bytes_(0U), flow_ksync_batches_(0U), flow_ksync_batch_msgs_(0U),
+        flow_ksync_batch_latency_(0U), flow_ksync_batch_max_latency_(0U) {
         assert(singleton_ == NULL);
         singleton_ = this;
     }
@@ -69,6 +70,24 @@ public:
         return flow_drop_due_to_linklocal_limit_;
     }
 
+    // Batch of flow messages sent to vrouter, latency is the time taken
+    // for all the messages in the batch to be acked
+    void UpdateFlowKSyncBatch(uint32_t msg_count, uint64_t latency) {
+        flow_ksync_batches_++;
+        flow_ksync_batch_msgs_ += msg_count;
+        flow_ksync_batch_latency_ = latency;
+        if (latency > flow_ksync_batch_max_latency_)
+            flow_ksync_batch_max_latency_ = latency;
+    }
+    uint64_t flow_ksync_batches() const {return flow_ksync_batches_;}
+    uint64_t flow_ksync_batch_msgs() const {return flow_ksync_batch_msgs_;}
+    uint64_t flow_ksync_batch_latency() const {
+        return flow_ksync_batch_latency_;
+    }
+    uint64_t flow_ksync_batch_max_latency() const {
+        return flow_ksync_batch_max_latency_;
+    }
+
     void incr_pkt_exceptions() {pkt_exceptions_++;}
     uint64_t pkt_exceptions() const {return pkt_exceptions_;}
 
@@ -137,6 +156,12 @@ private:
     uint64_t out_tpkts_;
     uint64_t out_bytes_;
 
+    // Flow KSync batches, latencies are in usec
+    uint64_t flow_ksync_batches_;
+    uint64_t flow_ksync_batch_msgs_;
+    uint64_t flow_ksync_batch_latency_;
+    uint64_t flow_ksync_batch_max_latency_;
+
     static AgentStats *singleton_;
 };
 
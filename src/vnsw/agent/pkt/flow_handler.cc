@@ -9,6 +9,8 @@
 #include "pkt/flow_table.h"
 #include "pkt/flow_proto.h"
 #include "pkt/flow_handler.h"
+#include "ksync/ksync_init.h"
+#include "ksync/flowtable_ksync.h"
 
 SandeshTraceBufferPtr PktFlowTraceBuf(SandeshTraceBufferCreate("FlowHandler", 5000));
 
@@ -21,6 +23,8 @@ static const VmEntry *InterfaceToVm(const Interface *intf) {
 }
 
 bool FlowHandler::Run() {
+    // Flows added or updated in this run are programmed in one batch
+    FlowTableKSyncBatchScope batch(agent_->ksync()->flowtable_ksync_obj());
     PktControlInfo in;
     PktControlInfo out;
     PktFlowInfo info(pkt_info_, agent_->pkt()->flow_table());
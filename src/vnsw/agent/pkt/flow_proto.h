@@ -12,15 +12,27 @@
 #include "pkt/proto_handler.h"
 #include "pkt/flow_table.h"
 #include "pkt/flow_handler.h"
+#include "pkt/flow_scheduler.h"
+#include "pkt/agent_stats.h"
+#include "init/agent_param.h"
 
 class FlowProto : public Proto {
 public:
     FlowProto(Agent *agent, boost::asio::io_service &io) :
         Proto(agent, "Agent::FlowHandler", PktHandler::FLOW, io) {
         agent->SetFlowProto(this);
+        intf_listener_id_ = agent->interface_table()->Register(
+            boost::bind(&FlowProto::InterfaceNotify, this, _2));
+    }
+    virtual ~FlowProto() {
+        agent()->interface_table()->Unregister(intf_listener_id_);
+    }
+    void Init() {
+        if (agent()->params()) {
+            uint32_t rate = agent()->params()->max_vm_flow_setup_rate();
+            scheduler_.set_rate(rate, rate);
+        }
     }
-    virtual ~FlowProto() {}
-    void Init() {}
     void Shutdown() {}
 
     FlowHandler *AllocProtoHandler(boost::shared_ptr<PktInfo> info,
@@ -42,6 +54,43 @@ public:
     bool RemovePktBuff() {
         return true;
     }
+
+    // Flow setup requests are queued in the scheduler. Work queue only has
+    // a place holder per request, the request to process on each run is
+    // picked by the scheduler
+    bool EnqueueMessage(boost::shared_ptr<PktInfo> msg) {
+        uint32_t ifindex = msg->agent_hdr.ifindex;
+        const Interface *intf =
+            agent()->interface_table()->FindInterface(ifindex);
+        bool police = (intf && intf->type() == Interface::VM_INTERFACE);
+        if (scheduler_.Enqueue(msg, ifindex, police) == false) {
+            agent()->stats()->incr_pkt_dropped();
+            return true;
+        }
+        return work_queue_.Enqueue(boost::shared_ptr<PktInfo>());
+    }
+
+    bool ProcessProto(boost::shared_ptr<PktInfo> msg_info) {
+        boost::shared_ptr<PktInfo> info = scheduler_.Dequeue();
+        if (info.get() == NULL)
+            return true;
+        return Proto::ProcessProto(info);
+    }
+
+    FlowScheduler *scheduler() { return &scheduler_; }
+
+private:
+    // Interface index is reused, drop the queue of a deleted interface so
+    // that its stats are not reported against the next interface
+    void InterfaceNotify(DBEntryBase *entry) {
+        if (entry->IsDeleted()) {
+            const Interface *intf = static_cast<const Interface *>(entry);
+            scheduler_.DeleteQueue(intf->id());
+        }
+    }
+
+    FlowScheduler scheduler_;
+    DBTableBase::ListenerId intf_listener_id_;
 };
 
 extern SandeshTraceBufferPtr PktFlowTraceBuf;
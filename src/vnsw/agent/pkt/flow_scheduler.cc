@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "pkt/flow_scheduler.h"
+
+const uint32_t FlowScheduler::kDefaultQuantum;
+const uint32_t FlowScheduler::kMaxQueueLength;
+
+FlowScheduler::FlowScheduler()
+    : length_(0), rate_(0), burst_(0),
+      quantum_(kDefaultQuantum) {
+}
+
+FlowScheduler::~FlowScheduler() {
+    STLDeleteElements(&queues_);
+}
+
+void FlowScheduler::set_rate(uint32_t rate, uint32_t burst) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    rate_ = rate;
+    burst_ = burst;
+    for (QueueMap::iterator it = queues_.begin(); it != queues_.end(); ++it) {
+        it->second->tokens = burst;
+    }
+}
+
+// Refill the token bucket for the time elapsed since the last refill and
+// take a token
+bool FlowScheduler::Admit(Queue *queue, uint64_t now) {
+    if (now > queue->last_refill) {
+        queue->tokens += (double)(now - queue->last_refill) * rate_ / 1000000;
+        if (queue->tokens > burst_)
+            queue->tokens = burst_;
+    }
+    queue->last_refill = now;
+
+    if (queue->tokens < 1)
+        return false;
+    queue->tokens -= 1;
+    return true;
+}
+
+bool FlowScheduler::Enqueue(const PktInfoPtr &info, uint32_t ifindex,
+                            bool police) {
+    uint64_t now = UTCTimestampUsec();
+    tbb::mutex::scoped_lock lock(mutex_);
+
+    QueueMap::iterator it = queues_.find(ifindex);
+    if (it == queues_.end()) {
+        it = queues_.insert(std::make_pair(ifindex,
+                                           new Queue(burst_, now))).first;
+    }
+    Queue *queue = it->second;
+
+    // Admission control applies only to policed interfaces, and only when a
+    // rate is configured
+    if (police && rate_ != 0) {
+        if (queue->pkts.size() >= kMaxQueueLength ||
+            Admit(queue, now) == false) {
+            queue->stats.dropped++;
+            return false;
+        }
+    }
+
+    queue->stats.admitted++;
+    queue->pkts.push_back(info);
+    length_++;
+    if (queue->active == false) {
+        queue->active = true;
+        queue->deficit = 0;
+        active_list_.push_back(queue);
+    }
+    return true;
+}
+
+// Serve the interface at the head of the round till its deficit runs out,
+// then move it to the tail of the round if it still has requests queued
+FlowScheduler::PktInfoPtr FlowScheduler::Dequeue() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (active_list_.empty())
+        return PktInfoPtr();
+
+    Queue *queue = active_list_.front();
+    if (queue->deficit == 0)
+        queue->deficit = quantum_;
+
+    PktInfoPtr info = queue->pkts.front();
+    queue->pkts.pop_front();
+    queue->deficit--;
+    length_--;
+
+    if (queue->pkts.empty()) {
+        queue->active = false;
+        queue->deficit = 0;
+        active_list_.pop_front();
+    } else if (queue->deficit == 0 && active_list_.size() > 1) {
+        queue->stats.deferred++;
+        active_list_.pop_front();
+        active_list_.push_back(queue);
+    }
+    return info;
+}
+
+// Requests still queued for the interface are dropped along with the queue,
+// the place holders left in the work queue find nothing to dequeue for them
+void FlowScheduler::DeleteQueue(uint32_t ifindex) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    QueueMap::iterator it = queues_.find(ifindex);
+    if (it == queues_.end())
+        return;
+
+    Queue *queue = it->second;
+    if (queue->active)
+        active_list_.remove(queue);
+    length_ -= queue->pkts.size();
+    queues_.erase(it);
+    delete queue;
+}
+
+void FlowScheduler::GetStats(StatsMap *stats) const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    for (QueueMap::const_iterator it = queues_.begin(); it != queues_.end();
+         ++it) {
+        stats->insert(std::make_pair(it->first, it->second->stats));
+    }
+}
+
+void FlowScheduler::ClearStats() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    for (QueueMap::iterator it = queues_.begin(); it != queues_.end(); ++it) {
+        it->second->stats = Stats();
+    }
+}
+
+size_t FlowScheduler::Length() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return length_;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef vnsw_agent_flow_scheduler_hpp
+#define vnsw_agent_flow_scheduler_hpp
+
+#include <stdint.h>
+
+#include <deque>
+#include <list>
+#include <map>
+
+#include <boost/shared_ptr.hpp>
+#include <tbb/mutex.h>
+
+#include "base/util.h"
+
+struct PktInfo;
+
+// Admission control and fair queueing of flow setup requests.
+//
+// Requests are queued per interface they were trapped on. When a rate is
+// configured, requests from policed interfaces (VM interfaces) are first
+// admitted by a token bucket of the interface and are dropped once the
+// bucket runs dry or the queue of the interface is full. Queued
+// requests are handed out in deficit round robin order across the
+// interfaces, so that an interface with a large backlog can only take
+// quantum requests before the other backlogged interfaces get their turn.
+//
+// Enqueue is called from the packet receive path and Dequeue from the flow
+// task, hence all state is protected by a mutex.
+class FlowScheduler {
+public:
+    typedef boost::shared_ptr<PktInfo> PktInfoPtr;
+
+    static const uint32_t kDefaultQuantum = 16;
+    static const uint32_t kMaxQueueLength = 1024;
+
+    struct Stats {
+        Stats() : admitted(0), dropped(0), deferred(0) { }
+        uint64_t admitted;
+        uint64_t dropped;
+        uint64_t deferred;
+    };
+    typedef std::map<uint32_t, Stats> StatsMap;
+
+    FlowScheduler();
+    ~FlowScheduler();
+
+    // Returns false if the request is dropped
+    bool Enqueue(const PktInfoPtr &info, uint32_t ifindex, bool police);
+    // Returns NULL if there are no requests queued
+    PktInfoPtr Dequeue();
+    // Drops the queue and the stats of a deleted interface
+    void DeleteQueue(uint32_t ifindex);
+
+    void GetStats(StatsMap *stats) const;
+    void ClearStats();
+    size_t Length() const;
+
+    // Rate is in requests per second per interface, 0 disables admission
+    // control
+    void set_rate(uint32_t rate, uint32_t burst);
+    uint32_t rate() const { return rate_; }
+    uint32_t burst() const { return burst_; }
+    void set_quantum(uint32_t quantum) { quantum_ = quantum ? quantum : 1; }
+    uint32_t quantum() const { return quantum_; }
+
+private:
+    struct Queue {
+        Queue(uint32_t burst, uint64_t now)
+            : tokens(burst), last_refill(now), deficit(0), active(false) { }
+        std::deque<PktInfoPtr> pkts;
+        double tokens;
+        uint64_t last_refill;
+        uint32_t deficit;
+        bool active;
+        Stats stats;
+    };
+    typedef std::map<uint32_t, Queue *> QueueMap;
+    typedef std::list<Queue *> ActiveList;
+
+    bool Admit(Queue *queue, uint64_t now);
+
+    mutable tbb::mutex mutex_;
+    QueueMap queues_;
+    ActiveList active_list_;
+    size_t length_;
+    uint32_t rate_;
+    uint32_t burst_;
+    uint32_t quantum_;
+
+    DISALLOW_COPY_AND_ASSIGN(FlowScheduler);
+};
+
+#endif // vnsw_agent_flow_scheduler_hpp
@@ -97,7 +97,16 @@ FlowEntry::FlowEntry(const FlowKey &k) :
     key_(k), data_(), stats_(), flow_handle_(kInvalidFlowHandle),
     ksync_entry_(NULL), deleted_(false), flags_(0), short_flow_reason_(SHORT_UNKNOWN),
     linklocal_src_port_(),
-    linklocal_src_port_fd_(PktFlowInfo::kLinkLocalInvalidFd) {
+    linklocal_src_port_fd_(PktFlowInfo::kLinkLocalInvalidFd),
+    resync_flags_(0) {
+    vn_node_.flow = this;
+    intf_node_.flow = this;
+    in_vm_node_.flow = this;
+    out_vm_node_.flow = this;
+    src_route_node_.flow = this;
+    dst_route_node_.flow = this;
+    ecmp_node_.flow = this;
+    resync_node_.flow = this;
     flow_uuid_ = FlowTable::rand_gen_(); 
     egress_uuid_ = FlowTable::rand_gen_(); 
     refcount_ = 0;
@@ -120,6 +129,7 @@ void FlowEntry::GetSourceRouteInfo(const Inet4UnicastRouteEntry *rt) {
         data_.source_sg_id_l = path->sg_list();
         data_.source_plen = rt->plen();
     }
+    data_.source_vn_id = FlowData::kInvalidVnId;
 }
 
 void FlowEntry::GetDestRouteInfo(const Inet4UnicastRouteEntry *rt) {
@@ -137,6 +147,7 @@ void FlowEntry::GetDestRouteInfo(const Inet4UnicastRouteEntry *rt) {
         data_.dest_sg_id_l = path->sg_list();
         data_.dest_plen = rt->plen();
     }
+    data_.dest_vn_id = FlowData::kInvalidVnId;
 }
 
 uint32_t FlowEntry::MatchAcl(const PacketHeader &hdr,
@@ -899,6 +910,7 @@ void FlowEntry::GetPolicyInfo() {
 }
 
 void FlowTable::Add(FlowEntry *flow, FlowEntry *rflow) {
+    FlowTableKSyncBatchScope batch(agent_->ksync()->flowtable_ksync_obj());
     flow->reset_flags(FlowEntry::ReverseFlow);
     /* reverse flow may not be aviable always, eg: Flow Audit */
     if (rflow != NULL)
@@ -1416,6 +1428,8 @@ void FlowEntry::InitAuditFlow(uint32_t flow_idx) {
     short_flow_reason_ = SHORT_AUDIT_ENTRY;
     data_.source_vn = FlowHandler::UnknownVn();
     data_.dest_vn = FlowHandler::UnknownVn();
+    data_.source_vn_id = FlowData::kInvalidVnId;
+    data_.dest_vn_id = FlowData::kInvalidVnId;
     data_.source_sg_id_l = FlowTable::default_sg_list();
     data_.dest_sg_id_l = FlowTable::default_sg_list();
 }
@@ -1481,6 +1495,7 @@ void FlowTable::DeleteInternal(FlowEntryMap::iterator &it)
     }
     fe->set_reverse_flow_entry(NULL);
 
+    CancelResync(fe);
     DeleteFlowInfo(fe);
 
     FlowTableKSyncEntry *ksync_entry = fe->ksync_entry_;
@@ -1500,6 +1515,7 @@ void FlowTable::DeleteInternal(FlowEntryMap::iterator &it)
 
 bool FlowTable::Delete(FlowEntryMap::iterator &it, bool rev_flow)
 {
+    FlowTableKSyncBatchScope batch(agent_->ksync()->flowtable_ksync_obj());
     FlowEntry *fe;
     FlowEntryMap::iterator rev_it;
 
@@ -1531,6 +1547,7 @@ bool FlowTable::Delete(FlowEntryMap::iterator &it, bool rev_flow)
 
 bool FlowTable::Delete(const FlowKey &key, bool del_reverse_flow)
 {
+    FlowTableKSyncBatchScope batch(agent_->ksync()->flowtable_ksync_obj());
     FlowEntryMap::iterator it;
     FlowEntry *fe;
 
@@ -1615,6 +1632,11 @@ void FlowTable::Init() {
 
     nh_listener_ = new NhListener();
 
+    resync_trigger_.reset(new TaskTrigger
+        (boost::bind(&FlowTable::ResyncRun, this),
+         TaskScheduler::GetInstance()->GetTaskId("Agent::FlowHandler"),
+         PktHandler::FLOW));
+
     agent_->acl_table()->set_ace_flow_sandesh_data_cb
         (boost::bind(&FlowTable::SetAceSandeshData, this, _1, _2, _3));
 
@@ -1864,10 +1886,23 @@ void Inet4RouteUpdate::UnicastNotify(DBTablePartBase *partition, DBEntryBase *e)
     }
 
     if ((state->active_nh_ != active_nh) || (state->local_nh_ != local_nh)) {
-        Agent::GetInstance()->pkt()->flow_table()->ResyncRpfNH(skey, route);
+        Agent::GetInstance()->pkt()->flow_table()->ResyncRpfNH(skey);
         state->active_nh_ = active_nh;
         state->local_nh_ = local_nh;
     }
+
+    //Remap only flows pinned to component NH which changed
+    ComponentNHList components;
+    if (active_nh->GetType() == NextHop::COMPOSITE) {
+        const CompositeNH *comp_nh = static_cast<const CompositeNH *>(active_nh);
+        if (comp_nh->composite_nh_type() == Composite::ECMP ||
+            comp_nh->composite_nh_type() == Composite::LOCAL_ECMP) {
+            components.assign(comp_nh->begin(), comp_nh->end());
+        }
+    }
+    Agent::GetInstance()->pkt()->flow_table()->DeleteEcmpFlows(skey,
+        state->components_, components);
+    state->components_.swap(components);
 }
 
 Inet4RouteUpdate *Inet4RouteUpdate::UnicastInit(
@@ -1905,6 +1940,105 @@ void FlowTable::VrfNotify(DBTablePartBase *part, DBEntryBase *e)
     return;
 }
 
+void FlowIndexList::Add(FlowIndexNode *node) {
+    assert(node->list == NULL);
+    intrusive_ptr_add_ref(node->flow);
+    list_.push_back(*node);
+    node->list = this;
+}
+
+void FlowIndexList::Remove(FlowIndexNode *node) {
+    assert(node->list == this);
+    list_.erase(list_.iterator_to(*node));
+    node->list = NULL;
+    intrusive_ptr_release(node->flow);
+}
+
+void FlowIndexList::GetFlows(FlowList *flows) const {
+    flows->reserve(list_.size());
+    for (const_iterator it = list_.begin(); it != list_.end(); ++it) {
+        flows->push_back(it->flow);
+    }
+}
+
+// Changes to objects a flow depends on only mark the flow for re-evaluation.
+// Flows are re-evaluated later by ResyncRun in the flow task, so that a
+// change affecting a large number of flows does not hold up the DB task and
+// a flow affected by multiple changes is evaluated only once
+void FlowTable::EnqueueResync(FlowEntry *fe, uint8_t flags) {
+    if (fe->deleted()) {
+        return;
+    }
+
+    fe->resync_flags_ |= flags;
+    if (fe->resync_node_.is_linked() == false) {
+        resync_list_.Add(&fe->resync_node_);
+        resync_trigger_->Set();
+    }
+}
+
+void FlowTable::CancelResync(FlowEntry *fe) {
+    fe->resync_flags_ = 0;
+    if (fe->resync_node_.is_linked()) {
+        resync_list_.Remove(&fe->resync_node_);
+    }
+}
+
+bool FlowTable::ResyncRun() {
+    FlowTableKSyncBatchScope batch(agent_->ksync()->flowtable_ksync_obj());
+    uint32_t count = 0;
+    while (resync_list_.empty() == false && count < kMaxResyncIterations) {
+        FlowEntryPtr fe(resync_list_.front());
+        ResyncFlow(fe.get());
+        count++;
+    }
+    return resync_list_.empty();
+}
+
+void FlowTable::ResyncFlow(FlowEntry *fe) {
+    uint8_t flags = fe->resync_flags_;
+    CancelResync(fe);
+
+    // Forward flow needs to be evaluated before the reverse flow
+    FlowEntry *fwd_flow = NULL;
+    if (fe->is_flags_set(FlowEntry::ReverseFlow)) {
+        fwd_flow = fe->reverse_flow_entry();
+    }
+    if (fwd_flow && fwd_flow->resync_node_.is_linked()) {
+        ResyncFlow(fwd_flow);
+    }
+
+    if (flags & FlowEntry::ResyncPolicy) {
+        DeleteFlowInfo(fe);
+        const Interface *intf = fe->intf_entry();
+        if ((flags & FlowEntry::ResyncIntfVn) && intf &&
+            intf->type() == Interface::VM_INTERFACE) {
+            fe->GetPolicyInfo(static_cast<const VmInterface *>(intf)->vn());
+        } else {
+            fe->GetPolicyInfo();
+        }
+        ResyncAFlow(fe);
+        AddFlowInfo(fe);
+    }
+
+    if (flags & FlowEntry::ResyncRpfNH) {
+        const VrfEntry *vrf =
+            agent_->vrf_table()->FindVrfFromId(fe->data().flow_source_vrf);
+        const Inet4UnicastRouteEntry *rt = NULL;
+        if (vrf) {
+            rt = GetUcRoute(vrf, Ip4Address(fe->key().src.ipv4));
+        }
+        if (rt && fe->SetRpfNH(rt) == true) {
+            fe->UpdateKSync();
+        }
+    }
+
+    resync_count_++;
+    FlowInfo flow_info;
+    fe->FillFlowInfo(flow_info);
+    FLOW_TRACE(Trace, "Resync Flow", flow_info);
+}
+
 void FlowTable::ResyncVnFlows(const VnEntry *vn) {
     VnFlowTree::iterator vn_it;
     vn_it = vn_flow_tree_.find(vn);
@@ -1912,19 +2046,10 @@ void FlowTable::ResyncVnFlows(const VnEntry *vn) {
         return;
     }
 
-    FlowEntryTree fet = vn_it->second->fet;
-    FlowEntryTree::iterator fet_it, it;
-    it = fet.begin();
-    while (it != fet.end()) {
-        fet_it = it++;
-        FlowEntry *fe = (*fet_it).get();
-        DeleteFlowInfo(fe);
-        fe->GetPolicyInfo(vn);
-        ResyncAFlow(fe);
-        AddFlowInfo(fe);
-        FlowInfo flow_info;
-        fe->FillFlowInfo(flow_info);
-        FLOW_TRACE(Trace, "Evaluate Vn Flows", flow_info);
+    const VnFlowInfo *vn_flow_info = vn_it->second;
+    FlowIndexList::const_iterator it;
+    for (it = vn_flow_info->begin(); it != vn_flow_info->end(); ++it) {
+        EnqueueResync(it->flow, FlowEntry::ResyncPolicy);
     }
 }
 
@@ -1936,45 +2061,28 @@ void FlowTable::ResyncAclFlows(const AclDBEntry *acl)
         return;
     }
 
-    FlowEntryTree fet = acl_it->second->fet;
-    FlowEntryTree::iterator fet_it, it;
-    it = fet.begin();
-    while (it != fet.end()) {
-        fet_it = it++;
-        FlowEntry *fe = (*fet_it).get();
-        DeleteFlowInfo(fe);
-        fe->GetPolicyInfo();
-        ResyncAFlow(fe);
-        AddFlowInfo(fe);
-        FlowInfo flow_info;
-        fe->FillFlowInfo(flow_info);
-        FLOW_TRACE(Trace, "Evaluate Acl Flows", flow_info);
+    const FlowEntryTree &fet = acl_it->second->fet;
+    FlowEntryTree::const_iterator it;
+    for (it = fet.begin(); it != fet.end(); ++it) {
+        EnqueueResync((*it).get(), FlowEntry::ResyncPolicy);
     }
 }
 
-void FlowTable::ResyncRpfNH(const RouteFlowKey &key, 
-                            const Inet4UnicastRouteEntry *rt) {
+void FlowTable::ResyncRpfNH(const RouteFlowKey &key) {
     RouteFlowTree::iterator rf_it;
     rf_it = route_flow_tree_.find(key);
     if (rf_it == route_flow_tree_.end()) {
         return;
     }
-    FlowEntryTree fet = rf_it->second->fet;
-    FlowEntryTree::iterator fet_it, it;
-    it = fet.begin();
-    while (it != fet.end()) {
-        fet_it = it++;
-        FlowEntry *flow = (*fet_it).get();
+
+    const RouteFlowInfo *route_flow_info = rf_it->second;
+    FlowIndexList::const_iterator it;
+    for (it = route_flow_info->begin(); it != route_flow_info->end(); ++it) {
+        FlowEntry *flow = it->flow;
         if (flow->FlowSrcMatch(key) == false) {
             continue;
         }
-
-        if (flow->SetRpfNH(rt) == true) {
-            flow->UpdateKSync();
-            FlowInfo flow_info;
-            flow->FillFlowInfo(flow_info);
-            FLOW_TRACE(Trace, "Resync RPF NH", flow_info);
-        }
+        EnqueueResync(flow, FlowEntry::ResyncRpfNH);
     }
 }
 
@@ -1985,14 +2093,11 @@ void FlowTable::ResyncRouteFlows(RouteFlowKey &key, SecurityGroupList &sg_l)
     if (rf_it == route_flow_tree_.end()) {
         return;
     }
-    FlowEntryTree fet = rf_it->second->fet;
-    FlowEntryTree::iterator fet_it, it;
-    it = fet.begin();
-    while (it != fet.end()) {
-        fet_it = it++;
-        FlowEntry *fe = (*fet_it).get();
-        DeleteFlowInfo(fe);
-        fe->GetPolicyInfo();
+
+    const RouteFlowInfo *route_flow_info = rf_it->second;
+    FlowIndexList::const_iterator it;
+    for (it = route_flow_info->begin(); it != route_flow_info->end(); ++it) {
+        FlowEntry *fe = it->flow;
         if (fe->FlowSrcMatch(key)) {
             fe->set_source_sg_id_l(sg_l);
         } else if (fe->FlowDestMatch(key)) {
@@ -2016,18 +2121,10 @@ void FlowTable::ResyncRouteFlows(RouteFlowKey &key, SecurityGroupList &sg_l)
 
         //SG id for a reverse flow is updated
         //Reevaluate forward flow
-        if (fe->is_flags_set(FlowEntry::ReverseFlow)) {
-            FlowEntry *fwd_flow = fe->reverse_flow_entry();
-            if (fwd_flow) {
-                ResyncAFlow(fwd_flow);
-                AddFlowInfo(fwd_flow);
-            }
+        if (fe->is_flags_set(FlowEntry::ReverseFlow) && rev_flow) {
+            EnqueueResync(rev_flow, FlowEntry::ResyncPolicy);
         }
-        ResyncAFlow(fe);
-        AddFlowInfo(fe);
-        FlowInfo flow_info;
-        fe->FillFlowInfo(flow_info);
-        FLOW_TRACE(Trace, "Evaluate Route Flows", flow_info);
+        EnqueueResync(fe, FlowEntry::ResyncPolicy);
     }
 }
 
@@ -2038,33 +2135,19 @@ void FlowTable::ResyncVmPortFlows(const VmInterface *intf) {
         return;
     }
 
-    FlowEntryTree fet = intf_it->second->fet;
-    FlowEntryTree::iterator fet_it, it;
-    it = fet.begin();
-    while (it != fet.end()) {
-        fet_it = it++;
-        FlowEntry *fe = (*fet_it).get();
+    const IntfFlowInfo *intf_flow_info = intf_it->second;
+    FlowIndexList::const_iterator it;
+    for (it = intf_flow_info->begin(); it != intf_flow_info->end(); ++it) {
+        FlowEntry *fe = it->flow;
         // Local flow needs to evaluate fwd flow then reverse flow
         if (fe->is_flags_set(FlowEntry::LocalFlow) && 
             fe->is_flags_set(FlowEntry::ReverseFlow)) {
             FlowEntry *fwd_flow = fe->reverse_flow_entry();
             if (fwd_flow) {
-                DeleteFlowInfo(fwd_flow);
-                fwd_flow->GetPolicyInfo();
-                ResyncAFlow(fwd_flow);
-                AddFlowInfo(fwd_flow);
-                FlowInfo flow_info;
-                fwd_flow->FillFlowInfo(flow_info);
-                FLOW_TRACE(Trace, "Evaluate VmPort Flows", flow_info);
+                EnqueueResync(fwd_flow, FlowEntry::ResyncPolicy);
             }
         }
-        DeleteFlowInfo(fe);
-        fe->GetPolicyInfo(intf->vn());
-        ResyncAFlow(fe);
-        AddFlowInfo(fe);
-        FlowInfo flow_info;
-        fe->FillFlowInfo(flow_info);
-        FLOW_TRACE(Trace, "Evaluate VmPort Flows", flow_info);
+        EnqueueResync(fe, FlowEntry::ResyncPolicy | FlowEntry::ResyncIntfVn);
     }
 }
 
@@ -2077,13 +2160,68 @@ void FlowTable::DeleteRouteFlows(const RouteFlowKey &key)
         return;
     }
     FLOW_TRACE(ModuleInfo, "Delete Route flows");
-    FlowEntryTree fet = rf_it->second->fet;
-    FlowEntryTree::iterator fet_it, it;
-    it = fet.begin();
-    while (it != fet.end()) {
-        fet_it = it++;
-        FlowEntry *fe = (*fet_it).get();
-        Delete(fe->key(), true);
+    FlowIndexList::FlowList flows;
+    rf_it->second->GetFlows(&flows);
+    FlowIndexList::FlowList::iterator it;
+    for (it = flows.begin(); it != flows.end(); ++it) {
+        Delete((*it)->key(), true);
+    }
+}
+
+// Component NH of an ECMP route changed. Flows pinned to a slot now holding
+// a different component NH are deleted, so that they are setup again on the
+// new component NH. Flows pinned to slots that are unchanged are not
+// touched. Flows pinned to slots that became empty are trapped by vrouter
+// and moved to one of remaining component NH on flow setup. If the route is
+// no longer ECMP, flows are not pinned to a slot anymore and are only
+// removed from the index of every old slot
+void FlowTable::DeleteEcmpFlows(const RouteFlowKey &key,
+                                const ComponentNHList &old_list,
+                                const ComponentNHList &new_list) {
+    if (old_list.empty()) {
+        return;
+    }
+
+    if (new_list.empty()) {
+        for (uint32_t idx = 0; idx < old_list.size(); idx++) {
+            EcmpFlowTree::iterator ef_it =
+                ecmp_flow_tree_.find(EcmpFlowKey(key, idx));
+            if (ef_it == ecmp_flow_tree_.end()) {
+                continue;
+            }
+            FlowIndexList::FlowList flows;
+            ef_it->second->GetFlows(&flows);
+            FlowIndexList::FlowList::iterator it;
+            for (it = flows.begin(); it != flows.end(); ++it) {
+                DeleteEcmpFlowInfo(it->get());
+            }
+        }
+        return;
+    }
+
+    for (uint32_t idx = 0; idx < old_list.size(); idx++) {
+        if (old_list[idx].get() == NULL) {
+            continue;
+        }
+        if (idx < new_list.size()) {
+            if (new_list[idx].get() == NULL ||
+                *old_list[idx] == *new_list[idx]) {
+                continue;
+            }
+        }
+
+        EcmpFlowTree::iterator ef_it =
+            ecmp_flow_tree_.find(EcmpFlowKey(key, idx));
+        if (ef_it == ecmp_flow_tree_.end()) {
+            continue;
+        }
+        FLOW_TRACE(ModuleInfo, "Delete ECMP flows of component NH");
+        FlowIndexList::FlowList flows;
+        ef_it->second->GetFlows(&flows);
+        FlowIndexList::FlowList::iterator it;
+        for (it = flows.begin(); it != flows.end(); ++it) {
+            Delete((*it)->key(), true);
+        }
     }
 }
 
@@ -2148,24 +2286,22 @@ void FlowTable::DeleteFlowInfo(FlowEntry *fe)
     DeleteVmFlowInfo(fe);
     // Remove from RouteFlowTree
     DeleteRouteFlowInfo(fe);
+    // Remove from EcmpFlowTree
+    DeleteEcmpFlowInfo(fe);
 }
 
 void FlowTable::DeleteVnFlowInfo(FlowEntry *fe)
 {
-    VnFlowTree::iterator vn_it;
-    if (fe->vn_entry()) {
-        vn_it = vn_flow_tree_.find(fe->vn_entry());
-        if (vn_it != vn_flow_tree_.end()) {
-            VnFlowInfo *vn_flow_info = vn_it->second;
-            int count = vn_flow_info->fet.erase(fe);
-            if (count > 0) {
-                DecrVnFlowCounter(vn_flow_info, fe);
-            }
-            if (vn_flow_info->fet.empty()) {
-                delete vn_flow_info;
-                vn_flow_tree_.erase(vn_it);
-            }
-        }
+    if (fe->vn_node_.is_linked() == false) {
+        return;
+    }
+
+    VnFlowInfo *vn_flow_info = static_cast<VnFlowInfo *>(fe->vn_node_.list);
+    DecrVnFlowCounter(vn_flow_info, fe);
+    vn_flow_info->Remove(&fe->vn_node_);
+    if (vn_flow_info->empty()) {
+        vn_flow_tree_.erase(vn_flow_info->vn_entry.get());
+        delete vn_flow_info;
     }
 }
 
@@ -2193,72 +2329,71 @@ void FlowTable::DeleteAclFlowInfo(const AclDBEntry *acl, FlowEntry* flow,
 
 void FlowTable::DeleteIntfFlowInfo(FlowEntry *fe)
 {
-    IntfFlowTree::iterator intf_it;
-    if (fe->intf_entry()) {
-        intf_it = intf_flow_tree_.find(fe->intf_entry());
-        if (intf_it != intf_flow_tree_.end()) {
-            IntfFlowInfo *intf_flow_info = intf_it->second;
-            intf_flow_info->fet.erase(fe);
-            if (intf_flow_info->fet.empty()) {
-                delete intf_flow_info;
-                intf_flow_tree_.erase(intf_it);
-            }
-        }
+    if (fe->intf_node_.is_linked() == false) {
+        return;
+    }
+
+    IntfFlowInfo *intf_flow_info =
+        static_cast<IntfFlowInfo *>(fe->intf_node_.list);
+    intf_flow_info->Remove(&fe->intf_node_);
+    if (intf_flow_info->empty()) {
+        intf_flow_tree_.erase(intf_flow_info->intf_entry.get());
+        delete intf_flow_info;
     }
 }
 
 void FlowTable::DeleteVmFlowInfo(FlowEntry *fe) {
-    if (fe->in_vm_entry()) {
-        DeleteVmFlowInfo(fe, fe->in_vm_entry());
-    }
-    if (fe->out_vm_entry()) {
-        DeleteVmFlowInfo(fe, fe->out_vm_entry());
-    }
+    DeleteVmFlowInfo(fe, &fe->in_vm_node_);
+    DeleteVmFlowInfo(fe, &fe->out_vm_node_);
 }
 
-void FlowTable::DeleteVmFlowInfo(FlowEntry *fe, const VmEntry *vm) {
-    VmFlowTree::iterator vm_it = vm_flow_tree_.find(vm);
-    if (vm_it != vm_flow_tree_.end()) {
-        VmFlowInfo *vm_flow_info = vm_it->second;
-        if (vm_flow_info->fet.erase(fe)) {
-            if (fe->linklocal_src_port()) {
-                vm_flow_info->linklocal_flow_count--;
-                linklocal_flow_count_--;
-            }
-            if (vm_flow_info->fet.empty()) {
-                delete vm_flow_info;
-                vm_flow_tree_.erase(vm_it);
-            }
-        }
+void FlowTable::DeleteVmFlowInfo(FlowEntry *fe, FlowIndexNode *node) {
+    if (node->is_linked() == false) {
+        return;
+    }
+
+    VmFlowInfo *vm_flow_info = static_cast<VmFlowInfo *>(node->list);
+    if (fe->linklocal_src_port()) {
+        vm_flow_info->linklocal_flow_count--;
+        linklocal_flow_count_--;
+    }
+    vm_flow_info->Remove(node);
+    if (vm_flow_info->empty()) {
+        vm_flow_tree_.erase(vm_flow_info->vm_entry.get());
+        delete vm_flow_info;
     }
 }
 
 void FlowTable::DeleteRouteFlowInfo (FlowEntry *fe)
 {
-    RouteFlowTree::iterator rf_it;
-    RouteFlowKey skey(fe->data().flow_source_vrf, fe->key().src.ipv4, 
-                      fe->data().source_plen);
-    rf_it = route_flow_tree_.find(skey);
-    RouteFlowInfo *route_flow_info;
-    if (rf_it != route_flow_tree_.end()) {
-        route_flow_info = rf_it->second;
-        route_flow_info->fet.erase(fe);
-        if (route_flow_info->fet.empty()) {
-            delete route_flow_info;
-            route_flow_tree_.erase(rf_it);
-        }
+    DeleteRouteFlowInfo(&fe->src_route_node_);
+    DeleteRouteFlowInfo(&fe->dst_route_node_);
+}
+
+void FlowTable::DeleteRouteFlowInfo(FlowIndexNode *node) {
+    if (node->is_linked() == false) {
+        return;
     }
-   
-    RouteFlowKey dkey(fe->data().flow_dest_vrf, fe->key().dst.ipv4,
-                      fe->data().dest_plen);
-    rf_it = route_flow_tree_.find(dkey);
-    if (rf_it != route_flow_tree_.end()) {
-        route_flow_info = rf_it->second;
-        route_flow_info->fet.erase(fe);
-        if (route_flow_info->fet.empty()) {
-            delete route_flow_info;
-            route_flow_tree_.erase(rf_it);
-        }
+
+    RouteFlowInfo *route_flow_info = static_cast<RouteFlowInfo *>(node->list);
+    route_flow_info->Remove(node);
+    if (route_flow_info->empty()) {
+        route_flow_tree_.erase(route_flow_info->key);
+        delete route_flow_info;
+    }
+}
+
+void FlowTable::DeleteEcmpFlowInfo(FlowEntry *fe) {
+    if (fe->ecmp_node_.is_linked() == false) {
+        return;
+    }
+
+    EcmpFlowInfo *ecmp_flow_info =
+        static_cast<EcmpFlowInfo *>(fe->ecmp_node_.list);
+    ecmp_flow_info->Remove(&fe->ecmp_node_);
+    if (ecmp_flow_info->empty()) {
+        ecmp_flow_tree_.erase(ecmp_flow_info->key);
+        delete ecmp_flow_info;
     }
 }
 
@@ -2275,6 +2410,8 @@ void FlowTable::AddFlowInfo(FlowEntry *fe)
     AddVmFlowInfo(fe);
     // Add RouteFlowTree;
     AddRouteFlowInfo(fe);
+    // Add EcmpFlowTree
+    AddEcmpFlowInfo(fe);
 }
 
 void FlowTable::AddAclFlowInfo (FlowEntry *fe) 
@@ -2362,6 +2499,16 @@ void FlowTable::UpdateAclFlow(const AclDBEntry *acl, FlowEntry* flow,
 
 void FlowTable::AddIntfFlowInfo(FlowEntry *fe)
 {
+    /* fe can already exist. Move it only if interface of flow changed */
+    if (fe->intf_node_.is_linked()) {
+        IntfFlowInfo *old_info =
+            static_cast<IntfFlowInfo *>(fe->intf_node_.list);
+        if (old_info->intf_entry.get() == fe->intf_entry()) {
+            return;
+        }
+        DeleteIntfFlowInfo(fe);
+    }
+
     if (!fe->intf_entry()) {
         return;
     }
@@ -2371,25 +2518,38 @@ void FlowTable::AddIntfFlowInfo(FlowEntry *fe)
     if (it == intf_flow_tree_.end()) {
         intf_flow_info = new IntfFlowInfo();
         intf_flow_info->intf_entry = fe->intf_entry();
-        intf_flow_info->fet.insert(fe);
         intf_flow_tree_.insert(IntfFlowPair(fe->intf_entry(), intf_flow_info));
     } else {
         intf_flow_info = it->second;
-        /* fe can already exist. In that case it won't be inserted */
-        intf_flow_info->fet.insert(fe);
     }
+    intf_flow_info->Add(&fe->intf_node_);
 }
 
 void FlowTable::AddVmFlowInfo(FlowEntry *fe) {
-    if (fe->in_vm_entry()) {
-        AddVmFlowInfo(fe, fe->in_vm_entry());
-    }
-    if (fe->out_vm_entry()) {
-        AddVmFlowInfo(fe, fe->out_vm_entry());
+    AddVmFlowInfo(fe, &fe->in_vm_node_, fe->in_vm_entry());
+    // Flow is counted once when both ends are on the same VM
+    const VmEntry *out_vm = fe->out_vm_entry();
+    if (out_vm == fe->in_vm_entry()) {
+        out_vm = NULL;
     }
+    AddVmFlowInfo(fe, &fe->out_vm_node_, out_vm);
 }
 
-void FlowTable::AddVmFlowInfo(FlowEntry *fe, const VmEntry *vm) {
+void FlowTable::AddVmFlowInfo(FlowEntry *fe, FlowIndexNode *node,
+                              const VmEntry *vm) {
+    /* fe can already exist. Move it only if VM of flow changed */
+    if (node->is_linked()) {
+        VmFlowInfo *old_info = static_cast<VmFlowInfo *>(node->list);
+        if (old_info->vm_entry.get() == vm) {
+            return;
+        }
+        DeleteVmFlowInfo(fe, node);
+    }
+
+    if (vm == NULL) {
+        return;
+    }
+
     if (fe->is_flags_set(FlowEntry::ShortFlow)) {
         // do not include short flows
         // this is done so that we allow atleast the minimum allowed flows
@@ -2398,28 +2558,20 @@ void FlowTable::AddVmFlowInfo(FlowEntry *fe, const VmEntry *vm) {
         return;
     }
 
-    bool update = false;
     VmFlowTree::iterator it;
     it = vm_flow_tree_.find(vm);
     VmFlowInfo *vm_flow_info;
     if (it == vm_flow_tree_.end()) {
         vm_flow_info = new VmFlowInfo();
         vm_flow_info->vm_entry = vm;
-        vm_flow_info->fet.insert(fe);
         vm_flow_tree_.insert(VmFlowPair(vm, vm_flow_info));
-        update = true;
     } else {
         vm_flow_info = it->second;
-        /* fe can already exist. In that case it won't be inserted */
-        if (vm_flow_info->fet.insert(fe).second) {
-            update = true;
-        }
     }
-    if (update) {
-        if (fe->linklocal_src_port()) {
-            vm_flow_info->linklocal_flow_count++;
-            linklocal_flow_count_++;
-        }
+    vm_flow_info->Add(node);
+    if (fe->linklocal_src_port()) {
+        vm_flow_info->linklocal_flow_count++;
+        linklocal_flow_count_++;
     }
 }
 
@@ -2453,6 +2605,15 @@ void FlowTable::DecrVnFlowCounter(VnFlowInfo *vn_flow_info,
 
 void FlowTable::AddVnFlowInfo (FlowEntry *fe)
 {
+    /* fe can already exist. Move it only if VN of flow changed */
+    if (fe->vn_node_.is_linked()) {
+        VnFlowInfo *old_info = static_cast<VnFlowInfo *>(fe->vn_node_.list);
+        if (old_info->vn_entry.get() == fe->vn_entry()) {
+            return;
+        }
+        DeleteVnFlowInfo(fe);
+    }
+
     if (!fe->vn_entry()) {
         return;
     }    
@@ -2462,18 +2623,12 @@ void FlowTable::AddVnFlowInfo (FlowEntry *fe)
     if (it == vn_flow_tree_.end()) {
         vn_flow_info = new VnFlowInfo();
         vn_flow_info->vn_entry = fe->vn_entry();
-        vn_flow_info->fet.insert(fe);
-        IncrVnFlowCounter(vn_flow_info, fe);
         vn_flow_tree_.insert(VnFlowPair(fe->vn_entry(), vn_flow_info));
     } else {
         vn_flow_info = it->second;
-        /* fe can already exist. In that case it won't be inserted */
-        pair<FlowTable::FlowEntryTree::iterator, bool> ret = 
-                                            vn_flow_info->fet.insert(fe);
-        if (ret.second) {
-            IncrVnFlowCounter(vn_flow_info, fe);
-        }
     }
+    vn_flow_info->Add(&fe->vn_node_);
+    IncrVnFlowCounter(vn_flow_info, fe);
 }
 
 void FlowTable::VnFlowCounters(const VnEntry *vn, uint32_t *in_count, 
@@ -2494,7 +2649,7 @@ uint32_t FlowTable::VmFlowCount(const VmEntry *vm) {
     VmFlowTree::iterator it = vm_flow_tree_.find(vm);
     if (it != vm_flow_tree_.end()) {
         VmFlowInfo *vm_flow_info = it->second;
-        return vm_flow_info->fet.size();
+        return vm_flow_info->size();
     }
 
     return 0;
@@ -2512,35 +2667,84 @@ uint32_t FlowTable::VmLinkLocalFlowCount(const VmEntry *vm) {
 
 void FlowTable::AddRouteFlowInfo (FlowEntry *fe)
 {
-    RouteFlowTree::iterator it;
-    RouteFlowInfo *route_flow_info;
+    RouteFlowKey skey(fe->data().flow_source_vrf, fe->key().src.ipv4,
+                      fe->data().source_plen);
+    RouteFlowKey dkey(fe->data().flow_dest_vrf, fe->key().dst.ipv4, 
+                      fe->data().dest_plen);
+    const RouteFlowKey *src_key = NULL;
+    const RouteFlowKey *dst_key = NULL;
     if (fe->data().flow_source_vrf != VrfEntry::kInvalidIndex) {
-        RouteFlowKey skey(fe->data().flow_source_vrf, fe->key().src.ipv4,
-                          fe->data().source_plen);
-        it = route_flow_tree_.find(skey);
-        if (it == route_flow_tree_.end()) {
-            route_flow_info = new RouteFlowInfo();
-            route_flow_info->fet.insert(fe);
-            route_flow_tree_.insert(RouteFlowPair(skey, route_flow_info));
-        } else {
-            route_flow_info = it->second;
-            route_flow_info->fet.insert(fe);
+        src_key = &skey;
+    }
+    // Flow is added once when source and destination match same route
+    if (fe->data().flow_dest_vrf != VrfEntry::kInvalidIndex &&
+        (src_key == NULL || !(skey == dkey))) {
+        dst_key = &dkey;
+    }
+    AddRouteFlowInfo(&fe->src_route_node_, src_key);
+    AddRouteFlowInfo(&fe->dst_route_node_, dst_key);
+}
+
+void FlowTable::AddRouteFlowInfo(FlowIndexNode *node, const RouteFlowKey *key) {
+    /* flow can already exist. Move it only if route of flow changed */
+    if (node->is_linked()) {
+        RouteFlowInfo *old_info = static_cast<RouteFlowInfo *>(node->list);
+        if (key && old_info->key == *key) {
+            return;
         }
+        DeleteRouteFlowInfo(node);
     }
 
-    if (fe->data().flow_dest_vrf != VrfEntry::kInvalidIndex) {
-        RouteFlowKey dkey(fe->data().flow_dest_vrf, fe->key().dst.ipv4, 
-                          fe->data().dest_plen);
-        it = route_flow_tree_.find(dkey);
-        if (it == route_flow_tree_.end()) {
-            route_flow_info = new RouteFlowInfo();
-            route_flow_info->fet.insert(fe);
-            route_flow_tree_.insert(RouteFlowPair(dkey, route_flow_info));
-        } else {
-            route_flow_info = it->second;
-            route_flow_info->fet.insert(fe);
+    if (key == NULL) {
+        return;
+    }
+
+    RouteFlowTree::iterator it = route_flow_tree_.find(*key);
+    RouteFlowInfo *route_flow_info;
+    if (it == route_flow_tree_.end()) {
+        route_flow_info = new RouteFlowInfo(*key);
+        route_flow_tree_.insert(RouteFlowPair(*key, route_flow_info));
+    } else {
+        route_flow_info = it->second;
+    }
+    route_flow_info->Add(node);
+}
+
+// Index forward flows by the component NH they are pinned to. Reverse flows
+// follow the component NH the traffic came from and are not indexed
+void FlowTable::AddEcmpFlowInfo(FlowEntry *fe) {
+    EcmpFlowKey key(RouteFlowKey(fe->data().flow_dest_vrf, fe->key().dst.ipv4,
+                                 fe->data().dest_plen),
+                    fe->data().component_nh_idx);
+    bool pinned = (fe->is_flags_set(FlowEntry::EcmpFlow) &&
+                   fe->is_flags_set(FlowEntry::ReverseFlow) == false &&
+                   fe->data().flow_dest_vrf != VrfEntry::kInvalidIndex &&
+                   fe->data().component_nh_idx !=
+                   CompositeNH::kInvalidComponentNHIdx);
+
+    /* flow can already exist. Move it only if component NH of flow changed */
+    if (fe->ecmp_node_.is_linked()) {
+        EcmpFlowInfo *old_info =
+            static_cast<EcmpFlowInfo *>(fe->ecmp_node_.list);
+        if (pinned && old_info->key == key) {
+            return;
         }
+        DeleteEcmpFlowInfo(fe);
+    }
+
+    if (pinned == false) {
+        return;
+    }
+
+    EcmpFlowTree::iterator it = ecmp_flow_tree_.find(key);
+    EcmpFlowInfo *ecmp_flow_info;
+    if (it == ecmp_flow_tree_.end()) {
+        ecmp_flow_info = new EcmpFlowInfo(key);
+        ecmp_flow_tree_.insert(EcmpFlowPair(key, ecmp_flow_info));
+    } else {
+        ecmp_flow_info = it->second;
     }
+    ecmp_flow_info->Add(&fe->ecmp_node_);
 }
 
 void FlowTable::ResyncAFlow(FlowEntry *fe) {
@@ -2572,10 +2776,11 @@ void FlowTable::DeleteVnFlows(const VnEntry *vn)
         return;
     }
     FLOW_TRACE(ModuleInfo, "Delete Vn Flows");
-    FlowEntryTree fet = vn_it->second->fet;
-    FlowEntryTree::iterator fet_it;
-    for (fet_it = fet.begin(); fet_it != fet.end(); ++fet_it) {
-        Delete((*fet_it)->key(), true);
+    FlowIndexList::FlowList flows;
+    vn_it->second->GetFlows(&flows);
+    FlowIndexList::FlowList::iterator it;
+    for (it = flows.begin(); it != flows.end(); ++it) {
+        Delete((*it)->key(), true);
     }
 }
 
@@ -2587,10 +2792,11 @@ void FlowTable::DeleteVmFlows(const VmEntry *vm)
         return;
     }
     FLOW_TRACE(ModuleInfo, "Delete VM flows");
-    FlowEntryTree fet = vm_it->second->fet;
-    FlowEntryTree::iterator fet_it;
-    for (fet_it = fet.begin(); fet_it != fet.end(); ++fet_it) {
-        Delete((*fet_it)->key(), true);
+    FlowIndexList::FlowList flows;
+    vm_it->second->GetFlows(&flows);
+    FlowIndexList::FlowList::iterator it;
+    for (it = flows.begin(); it != flows.end(); ++it) {
+        Delete((*it)->key(), true);
     }
 }
 
@@ -2602,10 +2808,11 @@ void FlowTable::DeleteVmIntfFlows(const Interface *intf)
         return;
     }
     FLOW_TRACE(ModuleInfo, "Delete Interface Flows");
-    FlowEntryTree fet = intf_it->second->fet;
-    FlowEntryTree::iterator fet_it;
-    for (fet_it = fet.begin(); fet_it != fet.end(); ++fet_it) {
-        Delete((*fet_it)->key(), true);
+    FlowIndexList::FlowList flows;
+    intf_it->second->GetFlows(&flows);
+    FlowIndexList::FlowList::iterator it;
+    for (it = flows.begin(); it != flows.end(); ++it) {
+        Delete((*it)->key(), true);
     }
 }
 
@@ -2837,7 +3044,7 @@ void FlowTable::SetAclFlowSandeshData(const AclDBEntry *acl, AclFlowResp &data,
 
 FlowTable::FlowTable(Agent *agent) : 
     agent_(agent), flow_entry_map_(), acl_flow_tree_(),
-    linklocal_flow_count_(), acl_listener_id_(),
+    linklocal_flow_count_(), resync_count_(0), acl_listener_id_(),
     intf_listener_id_(), vn_listener_id_(), vm_listener_id_(),
     vrf_listener_id_(), nh_listener_(NULL),
     route_key_(NULL, Ip4Address(), 32, false) {
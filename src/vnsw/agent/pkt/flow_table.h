@@ -6,6 +6,7 @@
 #define __AGENT_FLOW_TABLE_H__
 
 #include <map>
+#include <vector>
 #if defined(__GNUC__)
 #include "base/compiler.h"
 #if __GNUC_PREREQ(4, 5)
@@ -20,9 +21,12 @@
 
 #include <boost/uuid/uuid_io.hpp>
 #include <boost/intrusive_ptr.hpp>
+#include <boost/intrusive/list.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <tbb/atomic.h>
 #include <tbb/mutex.h>
 #include <base/util.h>
+#include <base/task_trigger.h>
 #include <cmn/agent_cmn.h>
 #include <oper/mirror_table.h>
 #include <filter/traffic_action.h>
@@ -50,12 +54,15 @@ struct VmFlowInfo;
 struct RouteFlowKey;
 struct RouteFlowInfo;
 struct RouteFlowKeyCmp;
+struct EcmpFlowKey;
+struct EcmpFlowInfo;
 class Inet4RouteUpdate;
 class FlowEntry;
 class FlowTable;
 class FlowTableKSyncEntry;
 class NhListener;
 class NhState;
+class FlowIndexList;
 typedef boost::intrusive_ptr<FlowEntry> FlowEntryPtr;
 typedef boost::intrusive_ptr<const NhState> NhStatePtr;
 
@@ -66,6 +73,9 @@ struct RouteFlowKey {
         ip.ipv4 = GetPrefix(ipv4, prefix);
     }
     ~RouteFlowKey() {}
+    bool operator==(const RouteFlowKey &rhs) const {
+        return (vrf == rhs.vrf && ip.ipv4 == rhs.ip.ipv4 && plen == rhs.plen);
+    }
     static int32_t GetPrefix(uint32_t ip, uint8_t plen) {
         //Mask prefix
         uint8_t host = 32;
@@ -92,6 +102,29 @@ struct RouteFlowKeyCmp {
     }
 };
 
+// ECMP flows pinned to a component NH of the destination route
+struct EcmpFlowKey {
+    EcmpFlowKey(const RouteFlowKey &r, uint32_t idx) :
+        route(r), component_nh_idx(idx) { }
+    ~EcmpFlowKey() { }
+    bool operator==(const EcmpFlowKey &rhs) const {
+        return (route == rhs.route &&
+                component_nh_idx == rhs.component_nh_idx);
+    }
+
+    RouteFlowKey route;
+    uint32_t component_nh_idx;
+};
+
+struct EcmpFlowKeyCmp {
+    bool operator()(const EcmpFlowKey &lhs, const EcmpFlowKey &rhs) {
+        if (!(lhs.route == rhs.route)) {
+            return RouteFlowKeyCmp()(lhs.route, rhs.route);
+        }
+        return lhs.component_nh_idx < rhs.component_nh_idx;
+    }
+};
+
 struct FlowKey {
     FlowKey() :
         nh(0), src_port(0), dst_port(0), protocol(0) {
@@ -246,7 +279,10 @@ struct FlowData {
         mirror_vrf(VrfEntry::kInvalidIndex), dest_vrf(),
         component_nh_idx((uint32_t)CompositeNH::kInvalidComponentNHIdx),
         nh_state_(NULL), source_plen(0), dest_plen(0), drop_reason(0),
-        vrf_assign_evaluated(false) {}
+        vrf_assign_evaluated(false), source_vn_id(kInvalidVnId),
+        dest_vn_id(kInvalidVnId) {}
+
+    static const uint32_t kInvalidVnId = 0xFFFFFFFF;
 
     std::string source_vn;
     std::string dest_vn;
@@ -273,6 +309,52 @@ struct FlowData {
     uint8_t dest_plen;
     uint16_t drop_reason;
     bool vrf_assign_evaluated;
+
+    // Ids of source_vn and dest_vn interned by VnUveTable. Reset when the
+    // names change and filled by the stats collector on first use
+    uint32_t source_vn_id;
+    uint32_t dest_vn_id;
+};
+
+// Node linking a flow into a list of the dependency indexes in FlowTable.
+// A node is linked to atmost one list at a time and knows the list, so a
+// flow is added to or removed from an index in constant time
+struct FlowIndexNode {
+    FlowIndexNode() : flow(NULL), list(NULL) { }
+    bool is_linked() const { return list != NULL; }
+
+    boost::intrusive::list_member_hook<> hook;
+    FlowEntry *flow;
+    FlowIndexList *list;
+};
+
+// List of flows depending on an object. Holds a reference to flows linked
+class FlowIndexList {
+public:
+    typedef boost::intrusive::member_hook<FlowIndexNode,
+            boost::intrusive::list_member_hook<>,
+            &FlowIndexNode::hook> Hook;
+    typedef boost::intrusive::list<FlowIndexNode, Hook> List;
+    typedef List::const_iterator const_iterator;
+    typedef std::vector<FlowEntryPtr> FlowList;
+
+    FlowIndexList() { }
+    ~FlowIndexList() { }
+
+    void Add(FlowIndexNode *node);
+    void Remove(FlowIndexNode *node);
+    // Copy of the flows, used when walk can remove flows from the list
+    void GetFlows(FlowList *flows) const;
+
+    FlowEntry *front() const { return list_.front().flow; }
+    const_iterator begin() const { return list_.begin(); }
+    const_iterator end() const { return list_.end(); }
+    size_t size() const { return list_.size(); }
+    bool empty() const { return list_.empty(); }
+
+private:
+    List list_;
+    DISALLOW_COPY_AND_ASSIGN(FlowIndexList);
 };
 
 class FlowEntry {
@@ -340,6 +422,13 @@ class FlowEntry {
         LinkLocalBindLocalSrcPort = 1 << 9,
         TcpAckFlow      = 1 << 10
     };
+    // Re-evaluation pending for the flow, see FlowTable::ResyncFlow
+    enum FlowResyncFlags {
+        ResyncPolicy    = 1 << 0,
+        // Policy to be taken from VN of the interface
+        ResyncIntfVn    = 1 << 1,
+        ResyncRpfNH     = 1 << 2
+    };
     FlowEntry(const FlowKey &k);
     virtual ~FlowEntry() {
         if (linklocal_src_port_fd_ != PktFlowInfo::kLinkLocalInvalidFd) {
@@ -425,6 +514,7 @@ class FlowEntry {
     const std::string &sg_rule_uuid() const { return sg_rule_uuid_; }
     const std::string &nw_ace_uuid() const { return nw_ace_uuid_; }
     uint16_t short_flow_reason() const { return short_flow_reason_; }
+    uint8_t resync_flags() const { return resync_flags_; }
 private:
     friend class FlowTable;
     friend class FlowStatsCollector;
@@ -455,6 +545,17 @@ private:
     int linklocal_src_port_fd_;
     std::string sg_rule_uuid_;
     std::string nw_ace_uuid_;
+    // Nodes in the dependency indexes of FlowTable
+    FlowIndexNode vn_node_;
+    FlowIndexNode intf_node_;
+    FlowIndexNode in_vm_node_;
+    FlowIndexNode out_vm_node_;
+    FlowIndexNode src_route_node_;
+    FlowIndexNode dst_route_node_;
+    FlowIndexNode ecmp_node_;
+    // Node in the list of flows pending re-evaluation
+    FlowIndexNode resync_node_;
+    uint8_t resync_flags_;
     // atomic refcount
     tbb::atomic<int> refcount_;
 };
@@ -471,6 +572,8 @@ struct FlowEntryCmp {
 class FlowTable {
 public:
     static const int MaxResponses = 100;
+    // Flows re-evaluated per run of the resync task
+    static const uint32_t kMaxResyncIterations = 256;
     typedef std::map<FlowKey, FlowEntry *, FlowKeyCmp> FlowEntryMap;
 
     typedef std::map<int, int> AceIdFlowCntMap;
@@ -491,6 +594,9 @@ public:
     typedef std::map<RouteFlowKey, RouteFlowInfo *, RouteFlowKeyCmp> RouteFlowTree;
     typedef std::pair<RouteFlowKey, RouteFlowInfo *> RouteFlowPair;
 
+    typedef std::map<EcmpFlowKey, EcmpFlowInfo *, EcmpFlowKeyCmp> EcmpFlowTree;
+    typedef std::pair<EcmpFlowKey, EcmpFlowInfo *> EcmpFlowPair;
+
     struct VnFlowHandlerState : public DBState {
         AclDBEntryConstRef acl_;
         AclDBEntryConstRef macl_;
@@ -547,6 +653,9 @@ public:
     void DeleteFlow(const AclDBEntry *acl, const FlowKey &key, AclEntryIDList &id_list);
     void ResyncAclFlows(const AclDBEntry *acl);
     void DeleteAll();
+    size_t resync_pending() const { return resync_list_.size(); }
+    uint64_t resync_count() const { return resync_count_; }
+    TaskTrigger *resync_trigger() const { return resync_trigger_.get(); }
 
     void SetAclFlowSandeshData(const AclDBEntry *acl, AclFlowResp &data, 
                                const int last_count);
@@ -583,10 +692,16 @@ private:
     IntfFlowTree intf_flow_tree_;
     VmFlowTree vm_flow_tree_;
     RouteFlowTree route_flow_tree_;
+    EcmpFlowTree ecmp_flow_tree_;
 
     uint32_t max_vm_flows_;     // maximum flow count allowed per vm
     uint32_t linklocal_flow_count_;  // total linklocal flows in the agent
 
+    // Flows pending re-evaluation after change of an object they depend on
+    FlowIndexList resync_list_;
+    boost::scoped_ptr<TaskTrigger> resync_trigger_;
+    uint64_t resync_count_;
+
     DBTableBase::ListenerId acl_listener_id_;
     DBTableBase::ListenerId intf_listener_id_;
     DBTableBase::ListenerId vn_listener_id_;
@@ -609,15 +724,24 @@ private:
     void ResyncRouteFlows(RouteFlowKey &key, SecurityGroupList &sg_l);
     void ResyncAFlow(FlowEntry *fe);
     void ResyncVmPortFlows(const VmInterface *intf);
-    void ResyncRpfNH(const RouteFlowKey &key, const Inet4UnicastRouteEntry *rt);
+    void ResyncRpfNH(const RouteFlowKey &key);
     void DeleteRouteFlows(const RouteFlowKey &key);
+    void DeleteEcmpFlows(const RouteFlowKey &key,
+                         const ComponentNHList &old_list,
+                         const ComponentNHList &new_list);
+    void EnqueueResync(FlowEntry *fe, uint8_t flags);
+    void CancelResync(FlowEntry *fe);
+    void ResyncFlow(FlowEntry *fe);
+    bool ResyncRun();
 
     void DeleteFlowInfo(FlowEntry *fe);
     void DeleteVnFlowInfo(FlowEntry *fe);
     void DeleteVmFlowInfo(FlowEntry *fe);
-    void DeleteVmFlowInfo(FlowEntry *fe, const VmEntry *vm);
+    void DeleteVmFlowInfo(FlowEntry *fe, FlowIndexNode *node);
     void DeleteIntfFlowInfo(FlowEntry *fe);
     void DeleteRouteFlowInfo(FlowEntry *fe);
+    void DeleteRouteFlowInfo(FlowIndexNode *node);
+    void DeleteEcmpFlowInfo(FlowEntry *fe);
     void DeleteAclFlowInfo(const AclDBEntry *acl, FlowEntry* flow, const AclEntryIDList &id_list);
 
     void DeleteVnFlows(const VnEntry *vn);
@@ -630,8 +754,11 @@ private:
     void AddIntfFlowInfo(FlowEntry *fe);
     void AddVnFlowInfo(FlowEntry *fe);
     void AddVmFlowInfo(FlowEntry *fe);
-    void AddVmFlowInfo(FlowEntry *fe, const VmEntry *vm);
+    void AddVmFlowInfo(FlowEntry *fe, FlowIndexNode *node,
+                       const VmEntry *vm);
     void AddRouteFlowInfo(FlowEntry *fe);
+    void AddRouteFlowInfo(FlowIndexNode *node, const RouteFlowKey *key);
+    void AddEcmpFlowInfo(FlowEntry *fe);
 
     void DeleteAclFlows(const AclDBEntry *acl);
     void DeleteInternal(FlowEntryMap::iterator &it);
@@ -662,6 +789,8 @@ public:
         SecurityGroupList sg_l_;
         const NextHop* active_nh_;
         const NextHop* local_nh_;
+        // Component NH of active nexthop, if it is ECMP
+        ComponentNHList components_;
     };
 
     Inet4RouteUpdate(Inet4UnicastAgentRouteTable *rt_table);
@@ -736,37 +865,42 @@ struct AclFlowInfo {
     AclDBEntryConstRef acl_entry;
 };
 
-struct VnFlowInfo {
+struct VnFlowInfo : public FlowIndexList {
     VnFlowInfo() : ingress_flow_count(0), egress_flow_count(0) {}
     ~VnFlowInfo() {}
 
     VnEntryConstRef vn_entry;
-    FlowTable::FlowEntryTree fet;
     uint32_t ingress_flow_count;
     uint32_t egress_flow_count;
 };
 
-struct IntfFlowInfo {
+struct IntfFlowInfo : public FlowIndexList {
     IntfFlowInfo() {}
     ~IntfFlowInfo() {}
 
     InterfaceConstRef intf_entry;
-    FlowTable::FlowEntryTree fet;
 };
 
-struct VmFlowInfo {
+struct VmFlowInfo : public FlowIndexList {
     VmFlowInfo() : linklocal_flow_count() {}
     ~VmFlowInfo() {}
 
     VmEntryConstRef vm_entry;
-    FlowTable::FlowEntryTree fet;
     uint32_t linklocal_flow_count;
 };
 
-struct RouteFlowInfo {
-    RouteFlowInfo() {}
+struct RouteFlowInfo : public FlowIndexList {
+    RouteFlowInfo(const RouteFlowKey &k) : key(k) {}
     ~RouteFlowInfo() {}
-    FlowTable::FlowEntryTree fet;
+
+    RouteFlowKey key;
+};
+
+struct EcmpFlowInfo : public FlowIndexList {
+    EcmpFlowInfo(const EcmpFlowKey &k) : key(k) {}
+    ~EcmpFlowInfo() {}
+
+    EcmpFlowKey key;
 };
 
 extern SandeshTraceBufferPtr FlowTraceBuf;
@@ -7,10 +7,52 @@
 #include <pkt/control_interface.h>
 
 PacketBufferManager::PacketBufferManager(PktModule *pkt_module) :
-    alloc_(0), free_(0), pkt_module_(pkt_module) {
+    alloc_(0), free_(0), pkt_module_(pkt_module),
+    pools_(new BufferPool[PktHandler::MAX_MODULES]) {
 }
 
 PacketBufferManager::~PacketBufferManager() {
+    for (int module = 0; module < PktHandler::MAX_MODULES; module++) {
+        std::vector<uint8_t *> &free_list = pools_[module].free_list;
+        for (std::vector<uint8_t *>::iterator it = free_list.begin();
+             it != free_list.end(); ++it) {
+            delete [] *it;
+        }
+    }
+}
+
+PacketBufferManager::BufferPool *
+PacketBufferManager::GetPool(uint32_t module) const {
+    if (module >= PktHandler::MAX_MODULES)
+        return NULL;
+    return &pools_[module];
+}
+
+uint8_t *PacketBufferManager::AllocateBuffer(uint32_t module) {
+    BufferPool *pool = GetPool(module);
+    if (pool) {
+        tbb::mutex::scoped_lock lock(pool->mutex);
+        if (!pool->free_list.empty()) {
+            uint8_t *buff = pool->free_list.back();
+            pool->free_list.pop_back();
+            pool->hits++;
+            return buff;
+        }
+        pool->misses++;
+    }
+    return new uint8_t[ControlInterface::kMaxPacketSize];
+}
+
+void PacketBufferManager::FreeBuffer(uint32_t module, uint8_t *buff) {
+    BufferPool *pool = GetPool(module);
+    if (pool) {
+        tbb::mutex::scoped_lock lock(pool->mutex);
+        if (pool->free_list.size() < kMaxPoolSize) {
+            pool->free_list.push_back(buff);
+            return;
+        }
+    }
+    delete [] buff;
 }
 
 PacketBufferPtr PacketBufferManager::Allocate(uint32_t module, uint16_t len,
@@ -31,21 +73,70 @@ PacketBufferPtr PacketBufferManager::Allocate(uint32_t module, uint8_t *buff,
     return ptr;
 }
 
+// Create PacketBuffer from a buffer got with AllocateBuffer. The buffer goes
+// back to the pool of the module when the PacketBuffer is freed. The whole
+// buffer is usable, so that handlers can build responses larger than the
+// packet received in place
+PacketBufferPtr PacketBufferManager::AllocatePooled(uint32_t module,
+                                                    uint8_t *buff,
+                                                    uint16_t data_len,
+                                                    uint32_t mdata) {
+    PacketBuffer *pkt = new PacketBuffer(this, module, buff,
+                                         ControlInterface::kMaxPacketSize, 0,
+                                         data_len, mdata);
+    if (GetPool(module))
+        pkt->pool_ = module;
+    alloc_++;
+    return PacketBufferPtr(pkt);
+}
+
 void PacketBufferManager::FreeIndication(PacketBuffer *pkt) {
     free_++;
+    if (pkt->pool_ == PacketBuffer::kNoPool) {
+        delete [] pkt->buffer_;
+    } else {
+        FreeBuffer(pkt->pool_, pkt->buffer_);
+    }
+    pkt->buffer_ = NULL;
+}
+
+uint64_t PacketBufferManager::pool_hits(uint32_t module) const {
+    BufferPool *pool = GetPool(module);
+    if (pool == NULL)
+        return 0;
+    tbb::mutex::scoped_lock lock(pool->mutex);
+    return pool->hits;
+}
+
+uint64_t PacketBufferManager::pool_misses(uint32_t module) const {
+    BufferPool *pool = GetPool(module);
+    if (pool == NULL)
+        return 0;
+    tbb::mutex::scoped_lock lock(pool->mutex);
+    return pool->misses;
+}
+
+size_t PacketBufferManager::pool_size(uint32_t module) const {
+    BufferPool *pool = GetPool(module);
+    if (pool == NULL)
+        return 0;
+    tbb::mutex::scoped_lock lock(pool->mutex);
+    return pool->free_list.size();
 }
 
 PacketBuffer::PacketBuffer(PacketBufferManager *mgr, uint32_t module,
                            uint16_t len, uint32_t mdata) :
-    buffer_(new uint8_t[len]), buffer_len_(len), data_(buffer_.get()),
-    data_len_(len), module_(module), mdata_(mdata), mgr_(mgr) {
+    buffer_(new uint8_t[len]), buffer_len_(len), data_(buffer_),
+    data_len_(len), module_(module), mdata_(mdata), pool_(kNoPool),
+    mgr_(mgr) {
 }
 
 PacketBuffer::PacketBuffer(PacketBufferManager *mgr, uint32_t module,
                            uint8_t *buff, uint16_t len, uint16_t data_offset,
                            uint16_t data_len, uint32_t mdata) :
-    buffer_(buff), buffer_len_(len), data_(buffer_.get() + data_offset),
-    data_len_(data_len), module_(module), mdata_(mdata), mgr_(mgr) {
+    buffer_(buff), buffer_len_(len), data_(buffer_ + data_offset),
+    data_len_(data_len), module_(module), mdata_(mdata), pool_(kNoPool),
+    mgr_(mgr) {
 }
 
 PacketBuffer::~PacketBuffer() {
@@ -72,7 +163,7 @@ bool PacketBuffer::SetOffset(uint16_t offset) {
 
 // Set data_len in packet buffer
 void PacketBuffer::set_len(uint32_t len) {
-    uint32_t offset = data_ - buffer_.get();
+    uint32_t offset = data_ - buffer_;
 
     // Check if there is enough space first
     assert((buffer_len_ - offset) >= len);
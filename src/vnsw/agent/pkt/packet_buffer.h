@@ -6,8 +6,11 @@
 #define vnsw_agent_pkt_packet_buffer_hpp
 
 #include <string>
+#include <vector>
 #include <stdint.h>
+#include <boost/scoped_array.hpp>
 #include <boost/shared_ptr.hpp>
+#include <tbb/mutex.h>
 #include <base/util.h>
 
 class PacketBuffer;
@@ -20,9 +23,10 @@ typedef boost::shared_ptr<PacketBuffer> PacketBufferPtr;
 class PacketBuffer {
 public:
     static const uint32_t kDefaultBufferLen = 1024;
+    static const int kNoPool = -1;
     virtual ~PacketBuffer();
 
-    uint8_t *buffer() const { return buffer_.get(); }
+    uint8_t *buffer() const { return buffer_; }
     uint16_t buffer_len() const { return buffer_len_; }
 
     uint8_t *data() const;
@@ -43,7 +47,7 @@ private:
                  uint16_t len, uint16_t data_offset, uint16_t data_len,
                  uint32_t mdata);
 
-    boost::shared_ptr<uint8_t> buffer_;
+    uint8_t *buffer_;
     uint16_t buffer_len_;
 
     uint8_t *data_;
@@ -51,27 +55,66 @@ private:
 
     uint32_t module_;
     uint32_t mdata_;
+    // Pool that buffer_ goes back to when the PacketBuffer is freed
+    int pool_;
     PacketBufferManager *mgr_;
     DISALLOW_COPY_AND_ASSIGN(PacketBuffer);
 };
 
+// PacketBufferManager keeps a pool of free buffers of
+// ControlInterface::kMaxPacketSize bytes per module. The pools are used for
+// buffers read from the control interface (AllocateBuffer/AllocatePooled),
+// which are recycled when the PacketBuffer is freed, so that packet bursts
+// don't end up in malloc. Other allocations are sized to the request and
+// are not pooled. The pool of a module holds at most kMaxPoolSize free
+// buffers.
 class PacketBufferManager {
 public:
+    static const uint32_t kMaxPoolSize = 256;
+
     PacketBufferManager(PktModule *pkt_module);
     virtual ~PacketBufferManager();
 
     PacketBufferPtr Allocate(uint32_t module, uint16_t len, uint32_t mdata);
 
+    // Create PacketBuffer from memory allocated by the caller. The memory is
+    // freed along with the PacketBuffer
     PacketBufferPtr Allocate(uint32_t module, uint8_t *buff, uint16_t len,
                              uint16_t data_offset, uint16_t data_len,
                              uint32_t mdata);
+
+    // Get a buffer from the pool of the module. The buffer must either be
+    // handed over to a PacketBuffer with AllocatePooled or be returned with
+    // FreeBuffer
+    uint8_t *AllocateBuffer(uint32_t module);
+    void FreeBuffer(uint32_t module, uint8_t *buff);
+    PacketBufferPtr AllocatePooled(uint32_t module, uint8_t *buff,
+                                   uint16_t data_len, uint32_t mdata);
+
+    uint64_t alloc_count() const { return alloc_; }
+    uint64_t free_count() const { return free_; }
+    uint64_t pool_hits(uint32_t module) const;
+    uint64_t pool_misses(uint32_t module) const;
+    size_t pool_size(uint32_t module) const;
+
 private:
     friend class PacketBuffer;
+
+    struct BufferPool {
+        BufferPool() : hits(0), misses(0) { }
+        mutable tbb::mutex mutex;
+        std::vector<uint8_t *> free_list;
+        uint64_t hits;
+        uint64_t misses;
+    };
+
     void FreeIndication(PacketBuffer *);
+    BufferPool *GetPool(uint32_t module) const;
 
     uint64_t alloc_;
     uint64_t free_;
     PktModule *pkt_module_;
+    boost::scoped_array<BufferPool> pools_;
 
     DISALLOW_COPY_AND_ASSIGN(PacketBufferManager);
 };
@@ -118,6 +118,7 @@ static bool NhDecode(const NextHop *nh, const PktInfo *pkt, PktFlowInfo *info,
             const CompositeNH *comp_nh = static_cast<const CompositeNH *>(nh);
             if (info->out_component_nh_idx ==
                 CompositeNH::kInvalidComponentNHIdx ||
+                info->out_component_nh_idx >= comp_nh->ComponentNHCount() ||
                 (comp_nh->GetNH(info->out_component_nh_idx) == NULL)) {
                 if (info->out_component_nh_idx !=
                         CompositeNH::kInvalidComponentNHIdx) {
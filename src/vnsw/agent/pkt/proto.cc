@@ -35,6 +35,10 @@ bool Proto::ValidateAndEnqueueMessage(boost::shared_ptr<PktInfo> msg) {
         msg->data = NULL;
     }
 
+    return EnqueueMessage(msg);
+}
+
+bool Proto::EnqueueMessage(boost::shared_ptr<PktInfo> msg) {
     return work_queue_.Enqueue(msg);
 }
 
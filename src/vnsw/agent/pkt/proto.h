@@ -30,14 +30,15 @@ public:
     virtual ProtoHandler *AllocProtoHandler(boost::shared_ptr<PktInfo> info,
                                             boost::asio::io_service &io) = 0;
     virtual bool ValidateAndEnqueueMessage(boost::shared_ptr<PktInfo> msg);
-    bool ProcessProto(boost::shared_ptr<PktInfo> msg_info);
+    virtual bool EnqueueMessage(boost::shared_ptr<PktInfo> msg);
+    virtual bool ProcessProto(boost::shared_ptr<PktInfo> msg_info);
 
 protected:
     Agent *agent_;
     boost::asio::io_service &io_;
+    WorkQueue<boost::shared_ptr<PktInfo> > work_queue_;
 
 private:
-    WorkQueue<boost::shared_ptr<PktInfo> > work_queue_;
     DISALLOW_COPY_AND_ASSIGN(Proto);
 };
 
@@ -904,6 +904,128 @@ TEST_F(EcmpTest, EcmpReEval_3) {
     EXPECT_FALSE(VrfFind("vn10:vn10"));
 }
 
+static ComponentNHKeyPtr TunnelComponentNHKey(uint32_t label,
+                                               const char *server) {
+    return ComponentNHKeyPtr(new ComponentNHKey(
+        label, Agent::GetInstance()->fabric_vrf_name(),
+        Agent::GetInstance()->router_id(), Ip4Address::from_string(server),
+        false, TunnelType::AllType()));
+}
+
+static const CompositeNH *EcmpRouteNH(const char *vrf, const Ip4Address &ip,
+                                      uint8_t plen) {
+    Inet4UnicastRouteEntry *rt = RouteGet(vrf, ip, plen);
+    if (rt == NULL) {
+        return NULL;
+    }
+    return static_cast<const CompositeNH *>(rt->GetActiveNextHop());
+}
+
+//Adding a component NH moves only the hash buckets taken by new component
+//NH, deleting a component NH moves only the buckets of deleted component NH
+TEST_F(EcmpTest, ResilientHash_1) {
+    Ip4Address ip = Ip4Address::from_string("30.30.30.0");
+    ComponentNHKeyList comp_nh;
+    comp_nh.push_back(TunnelComponentNHKey(16, "15.15.15.15"));
+    comp_nh.push_back(TunnelComponentNHKey(17, "15.15.15.16"));
+    comp_nh.push_back(TunnelComponentNHKey(18, "15.15.15.17"));
+    EcmpTunnelRouteAdd(bgp_peer, "vrf2", ip, 24, comp_nh, -1, "vn2",
+                       SecurityGroupList(), PathPreference());
+    client->WaitForIdle();
+
+    const CompositeNH *nh = EcmpRouteNH("vrf2", ip, 24);
+    ASSERT_TRUE(nh != NULL);
+    std::vector<uint32_t> old_idx;
+    for (uint32_t i = 0; i < CompositeNH::kHashTableSize; i++) {
+        old_idx.push_back(nh->hash(i));
+        EXPECT_TRUE(old_idx[i] < 3);
+    }
+
+    comp_nh.push_back(TunnelComponentNHKey(19, "15.15.15.18"));
+    EcmpTunnelRouteAdd(bgp_peer, "vrf2", ip, 24, comp_nh, -1, "vn2",
+                       SecurityGroupList(), PathPreference());
+    client->WaitForIdle();
+
+    nh = EcmpRouteNH("vrf2", ip, 24);
+    ASSERT_TRUE(nh != NULL);
+    EXPECT_EQ(4U, nh->ComponentNHCount());
+    uint32_t moved = 0;
+    for (uint32_t i = 0; i < CompositeNH::kHashTableSize; i++) {
+        uint32_t idx = nh->hash(i);
+        if (idx != old_idx[i]) {
+            EXPECT_EQ(3U, idx);
+            moved++;
+        }
+        old_idx[i] = idx;
+    }
+    EXPECT_TRUE(moved > 0);
+    EXPECT_TRUE(moved < CompositeNH::kHashTableSize / 2);
+
+    comp_nh[1].reset();
+    EcmpTunnelRouteAdd(bgp_peer, "vrf2", ip, 24, comp_nh, -1, "vn2",
+                       SecurityGroupList(), PathPreference());
+    client->WaitForIdle();
+
+    nh = EcmpRouteNH("vrf2", ip, 24);
+    ASSERT_TRUE(nh != NULL);
+    EXPECT_TRUE(nh->GetNH(1) == NULL);
+    for (uint32_t i = 0; i < CompositeNH::kHashTableSize; i++) {
+        uint32_t idx = nh->hash(i);
+        if (old_idx[i] != 1) {
+            EXPECT_EQ(old_idx[i], idx);
+        } else {
+            EXPECT_TRUE(idx < 4 && idx != 1);
+        }
+    }
+
+    Agent::GetInstance()->fabric_inet4_unicast_table()->DeleteReq(bgp_peer,
+                                         "vrf2", ip, 24, NULL);
+    client->WaitForIdle();
+}
+
+//Replacing a component NH deletes only flows pinned to that component NH
+TEST_F(EcmpTest, ResilientHash_2) {
+    Ip4Address ip = Ip4Address::from_string("30.30.30.0");
+    ComponentNHKeyList comp_nh;
+    comp_nh.push_back(TunnelComponentNHKey(16, "15.15.15.15"));
+    comp_nh.push_back(TunnelComponentNHKey(17, "15.15.15.16"));
+    comp_nh.push_back(TunnelComponentNHKey(18, "15.15.15.17"));
+    EcmpTunnelRouteAdd(bgp_peer, "vrf2", ip, 24, comp_nh, -1, "vn2",
+                       SecurityGroupList(), PathPreference());
+    client->WaitForIdle();
+
+    TxIpPacket(VmPortGetId(1), "1.1.1.1", "30.30.30.1", 1);
+    client->WaitForIdle();
+    FlowEntry *entry = FlowGet(VrfGet("vrf2")->vrf_id(),
+            "1.1.1.1", "30.30.30.1", 1, 0, 0, GetFlowKeyNH(1));
+    ASSERT_TRUE(entry != NULL);
+    uint32_t ecmp_index = entry->data().component_nh_idx;
+    ASSERT_TRUE(ecmp_index < 3);
+
+    //Replace a component NH other than the one flow is pinned to
+    uint32_t other_index = (ecmp_index + 1) % 3;
+    comp_nh[other_index] = TunnelComponentNHKey(19, "15.15.15.18");
+    EcmpTunnelRouteAdd(bgp_peer, "vrf2", ip, 24, comp_nh, -1, "vn2",
+                       SecurityGroupList(), PathPreference());
+    client->WaitForIdle();
+    entry = FlowGet(VrfGet("vrf2")->vrf_id(),
+            "1.1.1.1", "30.30.30.1", 1, 0, 0, GetFlowKeyNH(1));
+    ASSERT_TRUE(entry != NULL);
+    EXPECT_EQ(ecmp_index, entry->data().component_nh_idx);
+
+    //Replace the component NH flow is pinned to
+    comp_nh[ecmp_index] = TunnelComponentNHKey(20, "15.15.15.19");
+    EcmpTunnelRouteAdd(bgp_peer, "vrf2", ip, 24, comp_nh, -1, "vn2",
+                       SecurityGroupList(), PathPreference());
+    client->WaitForIdle();
+    EXPECT_TRUE(FlowGet(VrfGet("vrf2")->vrf_id(),
+            "1.1.1.1", "30.30.30.1", 1, 0, 0, GetFlowKeyNH(1)) == NULL);
+
+    Agent::GetInstance()->fabric_inet4_unicast_table()->DeleteReq(bgp_peer,
+                                         "vrf2", ip, 24, NULL);
+    client->WaitForIdle();
+}
+
 TEST_F(EcmpTest, ServiceVlanTest_1) {
     struct PortInfo input1[] = {
         {"vnet10", 10, "10.1.1.1", "00:00:00:01:01:01", 10, 10},
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "test/test_cmn_util.h"
+#include "pkt/flow_scheduler.h"
+
+void RouterIdDepInit(Agent *agent) {
+}
+
+class FlowSchedulerTest : public ::testing::Test {
+protected:
+    FlowSchedulerTest() : msg_(0) { }
+
+    FlowScheduler::PktInfoPtr Request(uint32_t ifindex) {
+        FlowScheduler::PktInfoPtr info(new PktInfo(&msg_));
+        info->agent_hdr.ifindex = ifindex;
+        return info;
+    }
+
+    uint32_t Enqueue(uint32_t ifindex, uint32_t count, bool police) {
+        uint32_t enqueued = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            if (scheduler_.Enqueue(Request(ifindex), ifindex, police))
+                enqueued++;
+        }
+        return enqueued;
+    }
+
+    FlowScheduler::Stats GetStats(uint32_t ifindex) {
+        FlowScheduler::StatsMap stats;
+        scheduler_.GetStats(&stats);
+        return stats[ifindex];
+    }
+
+    InterTaskMsg msg_;
+    FlowScheduler scheduler_;
+};
+
+// Interface with a large backlog does not hold back requests from other
+// interfaces for more than a quantum
+TEST_F(FlowSchedulerTest, FairQueue) {
+    EXPECT_EQ(100U, Enqueue(1, 100, false));
+    EXPECT_EQ(10U, Enqueue(2, 10, false));
+    EXPECT_EQ(110U, scheduler_.Length());
+
+    uint32_t served[3] = { 0, 0, 0 };
+    uint32_t count = 0;
+    while (served[2] < 10) {
+        FlowScheduler::PktInfoPtr info = scheduler_.Dequeue();
+        ASSERT_TRUE(info.get() != NULL);
+        served[info->agent_hdr.ifindex]++;
+        count++;
+    }
+    EXPECT_EQ(scheduler_.quantum() + 10, count);
+    EXPECT_EQ(scheduler_.quantum(), served[1]);
+
+    while (scheduler_.Dequeue().get() != NULL) {
+        count++;
+    }
+    EXPECT_EQ(110U, count);
+    EXPECT_EQ(0U, scheduler_.Length());
+    EXPECT_EQ(1U, GetStats(1).deferred);
+    EXPECT_EQ(0U, GetStats(2).deferred);
+}
+
+// Requests from policed interfaces are dropped once the token bucket of the
+// interface runs dry
+TEST_F(FlowSchedulerTest, Admission) {
+    scheduler_.set_rate(10, 10);
+
+    uint32_t enqueued = Enqueue(1, 50, true);
+    EXPECT_TRUE(enqueued >= 10 && enqueued <= 11);
+    EXPECT_EQ(enqueued, GetStats(1).admitted);
+    EXPECT_EQ(50 - enqueued, GetStats(1).dropped);
+
+    // Interfaces that are not policed are not rate limited
+    EXPECT_EQ(50U, Enqueue(2, 50, false));
+    EXPECT_EQ(0U, GetStats(2).dropped);
+
+    // Bucket is refilled over time
+    usleep(200000);
+    EXPECT_TRUE(Enqueue(1, 1, true) == 1);
+
+    // Admission control is disabled without a rate
+    scheduler_.set_rate(0, 0);
+    EXPECT_EQ(50U, Enqueue(1, 50, true));
+
+    scheduler_.ClearStats();
+    EXPECT_EQ(0U, GetStats(1).dropped);
+    while (scheduler_.Dequeue().get() != NULL) {
+    }
+}
+
+// Queue of a deleted interface is dropped with the requests queued on it
+TEST_F(FlowSchedulerTest, DeleteQueue) {
+    EXPECT_EQ(10U, Enqueue(1, 10, false));
+    EXPECT_EQ(5U, Enqueue(2, 5, false));
+
+    scheduler_.DeleteQueue(1);
+    EXPECT_EQ(5U, scheduler_.Length());
+    FlowScheduler::StatsMap stats;
+    scheduler_.GetStats(&stats);
+    EXPECT_TRUE(stats.find(1) == stats.end());
+
+    uint32_t count = 0;
+    FlowScheduler::PktInfoPtr info;
+    while ((info = scheduler_.Dequeue()).get() != NULL) {
+        EXPECT_EQ(2U, info->agent_hdr.ifindex);
+        count++;
+    }
+    EXPECT_EQ(5U, count);
+
+    // Deleting an unknown or already deleted interface is a no-op
+    scheduler_.DeleteQueue(1);
+    scheduler_.DeleteQueue(3);
+    EXPECT_EQ(0U, scheduler_.Length());
+}
+
+int main(int argc, char *argv[]) {
+    GETUSERARGS();
+
+    client = TestInit(init_file, ksync_init);
+    int ret = RUN_ALL_TESTS();
+    client->WaitForIdle();
+    TestShutdown();
+    delete client;
+    return ret;
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <sys/socket.h>
+#include <tbb/atomic.h>
+
+#include "test/test_cmn_util.h"
+#include "pkt/packet_buffer.h"
+#include "pkt/pkt_init.h"
+#include "pkt/vrouter_interface.h"
+
+void RouterIdDepInit(Agent *agent) {
+}
+
+// VrouterControlInterface over one end of a socketpair, standing in for the
+// pkt0 tap interface. Reads packets the same way as Pkt0Interface
+class SocketPairInterface : public VrouterControlInterface {
+public:
+    SocketPairInterface(boost::asio::io_service *io)
+        : name_("pkt0-burst"), input_(*io), read_buff_(NULL) {
+        fds_[0] = fds_[1] = -1;
+        read_count_ = 0;
+        packet_count_ = 0;
+        closed_ = false;
+    }
+
+    virtual ~SocketPairInterface() {
+        delete [] read_buff_;
+        if (fds_[1] >= 0)
+            close(fds_[1]);
+    }
+
+    void InitControlInterface() {
+        VrouterControlInterface::InitControlInterface();
+        assert(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds_) == 0);
+        boost::system::error_code ec;
+        input_.assign(fds_[0], ec);
+        assert(ec == 0);
+        input_.non_blocking(true, ec);
+        assert(ec == 0);
+    }
+
+    void ShutdownControlInterface() { }
+
+    void IoShutdownControlInterface() {
+        boost::system::error_code ec;
+        input_.close(ec);
+    }
+
+    const std::string &Name() const { return name_; }
+
+    int Send(uint8_t *buff, uint16_t buff_len, const PacketBufferPtr &pkt) {
+        delete [] buff;
+        return buff_len + pkt->data_len();
+    }
+
+    // Write a packet on the other end of the socketpair
+    void Write(const uint8_t *buff, std::size_t len) {
+        assert(send(fds_[1], buff, len, 0) == (ssize_t)len);
+    }
+
+    void AsyncRead() {
+        if (read_buff_ == NULL) {
+            read_buff_ = pkt_handler()->agent()->pkt()->packet_buffer_manager()
+                ->AllocateBuffer(PktHandler::RX_PACKET);
+        }
+        input_.async_read_some(
+            boost::asio::buffer(read_buff_, kMaxPacketSize),
+            boost::bind(&SocketPairInterface::ReadHandler, this,
+                        boost::asio::placeholders::error,
+                        boost::asio::placeholders::bytes_transferred));
+    }
+
+    uint32_t read_count() const { return read_count_; }
+    uint32_t packet_count() const { return packet_count_; }
+    bool closed() const { return closed_; }
+
+private:
+    void ReadHandler(const boost::system::error_code &error,
+                     std::size_t length) {
+        if (error) {
+            closed_ = true;
+            return;
+        }
+
+        uint8_t *buff = read_buff_;
+        read_buff_ = NULL;
+        read_count_++;
+        packet_count_ += ProcessBurst(&input_, buff, length);
+        AsyncRead();
+    }
+
+    std::string name_;
+    int fds_[2];
+    boost::asio::posix::stream_descriptor input_;
+    uint8_t *read_buff_;
+    tbb::atomic<uint32_t> read_count_;
+    tbb::atomic<uint32_t> packet_count_;
+    tbb::atomic<bool> closed_;
+};
+
+class PktBurstTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        agent_ = Agent::GetInstance();
+        mgr_ = agent_->pkt()->packet_buffer_manager();
+    }
+
+    Agent *agent_;
+    PacketBufferManager *mgr_;
+};
+
+// Buffers of freed pooled PacketBuffers are reused for later allocations
+TEST_F(PktBurstTest, BufferPool) {
+    uint64_t hits = mgr_->pool_hits(PktHandler::RX_PACKET);
+    {
+        PacketBufferPtr pkt(mgr_->AllocatePooled(PktHandler::RX_PACKET,
+            mgr_->AllocateBuffer(PktHandler::RX_PACKET), 512, 0));
+        EXPECT_EQ(512, pkt->data_len());
+        // Whole pool buffer is available to build responses in place
+        EXPECT_EQ((uint32_t)ControlInterface::kMaxPacketSize,
+                  pkt->buffer_len());
+        pkt->set_len(ControlInterface::kMaxPacketSize);
+    }
+    size_t pool_size = mgr_->pool_size(PktHandler::RX_PACKET);
+    EXPECT_TRUE(pool_size > 0);
+
+    {
+        PacketBufferPtr pkt(mgr_->AllocatePooled(PktHandler::RX_PACKET,
+            mgr_->AllocateBuffer(PktHandler::RX_PACKET), 1024, 0));
+        EXPECT_EQ(1024, pkt->data_len());
+        EXPECT_EQ(pool_size - 1, mgr_->pool_size(PktHandler::RX_PACKET));
+    }
+    EXPECT_EQ(hits + 1, mgr_->pool_hits(PktHandler::RX_PACKET));
+    EXPECT_EQ(pool_size, mgr_->pool_size(PktHandler::RX_PACKET));
+
+    // Buffers allocated by length are not pooled
+    size_t icmp_pool_size = mgr_->pool_size(PktHandler::ICMP);
+    {
+        PacketBufferPtr pkt(mgr_->Allocate(PktHandler::ICMP, 512, 0));
+        EXPECT_EQ(512, pkt->buffer_len());
+    }
+    EXPECT_EQ(icmp_pool_size, mgr_->pool_size(PktHandler::ICMP));
+}
+
+// Packets queued on the interface are drained in bursts of upto
+// kMaxReadBurst packets per read completion
+TEST_F(PktBurstTest, BurstRead) {
+    static const uint32_t kPacketCount =
+        4 * VrouterControlInterface::kMaxReadBurst;
+
+    SocketPairInterface intf(agent_->event_manager()->io_service());
+    intf.Init(agent_->pkt()->pkt_handler());
+
+    // Packets are shorter than the agent header and get dropped right after
+    // they are read
+    uint64_t invalid = agent_->stats()->pkt_invalid_agent_hdr();
+    uint8_t buff[16];
+    memset(buff, 0, sizeof(buff));
+    for (uint32_t idx = 0; idx < kPacketCount; idx++) {
+        intf.Write(buff, sizeof(buff));
+    }
+
+    intf.AsyncRead();
+    TASK_UTIL_EXPECT_EQ(kPacketCount, intf.packet_count());
+    EXPECT_TRUE(intf.read_count() <
+                kPacketCount / VrouterControlInterface::kMaxReadBurst + 2);
+    EXPECT_EQ(invalid + kPacketCount,
+              agent_->stats()->pkt_invalid_agent_hdr());
+
+    // Buffers went back to the pool and are reused for the next burst
+    EXPECT_TRUE(mgr_->pool_size(PktHandler::RX_PACKET) > 0);
+    uint64_t hits = mgr_->pool_hits(PktHandler::RX_PACKET);
+    for (uint32_t idx = 0; idx < kPacketCount; idx++) {
+        intf.Write(buff, sizeof(buff));
+    }
+    TASK_UTIL_EXPECT_EQ(2 * kPacketCount, intf.packet_count());
+    EXPECT_TRUE(mgr_->pool_hits(PktHandler::RX_PACKET) > hits);
+
+    intf.IoShutdown();
+    TASK_UTIL_EXPECT_TRUE(intf.closed());
+}
+
+int main(int argc, char *argv[]) {
+    GETUSERARGS();
+
+    client = TestInit(init_file, ksync_init);
+    int ret = RUN_ALL_TESTS();
+    client->WaitForIdle();
+    TestShutdown();
+    delete client;
+    return ret;
+}
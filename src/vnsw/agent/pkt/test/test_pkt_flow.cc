@@ -976,6 +976,72 @@ TEST_F(FlowTest, FlowIndexChange) {
     EXPECT_TRUE(FlowTableWait(0));
 }
 
+// Forward and reverse flows are programmed in a single KSync batch
+TEST_F(FlowTest, FlowKSyncBatch) {
+    TestFlow flow[] = {
+        {
+            TestFlowPkt(vm1_ip, vm2_ip, 1, 0, 0, "vrf5",
+                    flow0->id(), 1),
+            { }
+        }
+    };
+
+    AgentStats *stats = agent()->stats();
+    uint64_t batches = stats->flow_ksync_batches();
+    uint64_t msgs = stats->flow_ksync_batch_msgs();
+    CreateFlow(flow, 1);
+    EXPECT_EQ(2U, agent()->pkt()->flow_table()->Size());
+    TASK_UTIL_EXPECT_TRUE(stats->flow_ksync_batches() > batches);
+    EXPECT_TRUE(stats->flow_ksync_batch_msgs() >= msgs + 2);
+    EXPECT_TRUE(stats->flow_ksync_batch_max_latency() >=
+                stats->flow_ksync_batch_latency());
+
+    DeleteFlow(flow, 1);
+    client->WaitForIdle();
+    EXPECT_TRUE(FlowTableWait(0));
+    EXPECT_TRUE(stats->flow_ksync_batches() > batches + 1);
+    EXPECT_TRUE(stats->flow_ksync_batch_msgs() >= msgs + 4);
+}
+
+// Flows depending on a VN are re-evaluated in background and a flow marked
+// by more than one change is re-evaluated only once
+TEST_F(FlowTest, FlowResync_1) {
+    TestFlow flow[] = {
+        {
+            TestFlowPkt(vm1_ip, vm2_ip, 1, 0, 0, "vrf5",
+                    flow0->id(), 1),
+            { }
+        }
+    };
+
+    FlowTable *table = agent()->pkt()->flow_table();
+    CreateFlow(flow, 1);
+    EXPECT_EQ(2U, table->Size());
+    EXPECT_EQ(0U, table->resync_pending());
+
+    uint64_t count = table->resync_count();
+    table->resync_trigger()->set_disable();
+    AddAcl("resync-acl", 10);
+    AddLink("virtual-network", "vn5", "access-control-list", "resync-acl");
+    client->WaitForIdle();
+    EXPECT_EQ(2U, table->resync_pending());
+
+    DelLink("virtual-network", "vn5", "access-control-list", "resync-acl");
+    client->WaitForIdle();
+    EXPECT_EQ(2U, table->resync_pending());
+    EXPECT_EQ(count, table->resync_count());
+
+    table->resync_trigger()->set_enable();
+    client->WaitForIdle();
+    EXPECT_EQ(0U, table->resync_pending());
+    EXPECT_EQ(count + 2, table->resync_count());
+
+    DelAcl("resync-acl");
+    DeleteFlow(flow, 1);
+    client->WaitForIdle();
+    EXPECT_TRUE(FlowTableWait(0));
+}
+
 // Validate flows to pkt 0 interface
 TEST_F(FlowTest, Flow_On_PktIntf) {
     TestFlow flow[] = {
@@ -4,8 +4,12 @@
 #ifndef vnsw_agent_pkt_vrouter_pkt_io_hpp
 #define vnsw_agent_pkt_vrouter_pkt_io_hpp
 
+#include <vector>
+
 #include "control_interface.h"
 #include "pkt/agent_stats.h"
+#include "pkt/packet_buffer.h"
+#include "pkt/pkt_init.h"
 #include "vr_types.h"
 #include "vr_defs.h"
 #include "vr_mpls.h"
@@ -17,6 +21,8 @@ class VrouterControlInterface : public ControlInterface {
 public:
     static const uint32_t kAgentHdrLen =
         (sizeof(ether_header) + sizeof(struct agent_hdr));
+    // Max packets read from the descriptor for each read completion
+    static const uint32_t kMaxReadBurst = 32;
 
     VrouterControlInterface() : ControlInterface() { }
     virtual ~VrouterControlInterface() {
@@ -96,6 +102,40 @@ public:
         return ControlInterface::Process(hdr, pkt);
     }
 
+    // Handle packet read into buff, a buffer got from the RX_PACKET pool of
+    // PacketBufferManager. Packets already queued on the descriptor are read
+    // along with it, upto kMaxReadBurst packets in all, before any of them is
+    // processed. The descriptor must be in non-blocking mode.
+    // Returns the number of packets read
+    uint32_t ProcessBurst(boost::asio::posix::stream_descriptor *input,
+                          uint8_t *buff, std::size_t length) {
+        PacketBufferManager *mgr =
+            pkt_handler()->agent()->pkt()->packet_buffer_manager();
+        std::vector<PacketBufferPtr> burst;
+        burst.reserve(kMaxReadBurst);
+        burst.push_back(mgr->AllocatePooled(PktHandler::RX_PACKET, buff,
+                                            length, 0));
+
+        while (burst.size() < kMaxReadBurst) {
+            uint8_t *next = mgr->AllocateBuffer(PktHandler::RX_PACKET);
+            boost::system::error_code ec;
+            std::size_t len = input->read_some(
+                boost::asio::buffer(next, kMaxPacketSize), ec);
+            if (ec || len == 0) {
+                mgr->FreeBuffer(PktHandler::RX_PACKET, next);
+                break;
+            }
+            burst.push_back(mgr->AllocatePooled(PktHandler::RX_PACKET, next,
+                                                len, 0));
+        }
+
+        for (std::vector<PacketBufferPtr>::iterator it = burst.begin();
+             it != burst.end(); ++it) {
+            Process(*it);
+        }
+        return burst.size();
+    }
+
     int EncodeAgentHdr(uint8_t *buff, const AgentHdr &hdr) {
         bzero(buff, sizeof(agent_hdr));
 
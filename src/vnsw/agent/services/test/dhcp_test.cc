@@ -199,7 +199,7 @@ public:
     void SendDhcp(short ifindex, uint16_t flags, uint8_t msg_type,
                   uint8_t *options, int num_options, bool error = false,
                   bool response = false, uint32_t yiaddr = 0,
-                  uint32_t vmifindex = 0) {
+                  uint32_t vmifindex = 0, bool pooled = false) {
         int len = 512;
         uint8_t *buf = new uint8_t[len];
         memset(buf, 0, len);
@@ -278,7 +278,11 @@ public:
                 Agent::GetInstance()->pkt()->pkt_handler()->EncapHeaderLen();
         TestPkt0Interface *tap = (TestPkt0Interface *)
                 (Agent::GetInstance()->pkt()->control_interface());
-        tap->TxPacket(buf, len);
+        if (pooled) {
+            tap->TxPooledPacket(buf, len);
+        } else {
+            tap->TxPacket(buf, len);
+        }
     }
 
     int AddOptions(uint8_t *ptr, uint8_t msg_type, uint32_t ifindex,
@@ -640,6 +644,44 @@ TEST_F(DhcpTest, DhcpOtherReqTest) {
     Agent::GetInstance()->GetDhcpProto()->ClearStats();
 }
 
+// DISCOVER without options, read into a pooled buffer, is smaller than the
+// OFFER built in place in the same buffer
+TEST_F(DhcpTest, DhcpSmallDiscoverTest) {
+    struct PortInfo input[] = {
+        {"vnet1", 1, "1.1.1.1", "00:00:00:01:01:01", 1, 1},
+    };
+    uint8_t options[] = {
+        DHCP_OPTION_MSG_TYPE,
+        DHCP_OPTION_END
+    };
+    DhcpProto::DhcpStats stats;
+    IpamInfo ipam_info[] = {
+        {"1.1.1.0", 24, "1.1.1.200", true},
+    };
+
+    CreateVmportEnv(input, 1, 0);
+    client->WaitForIdle();
+    client->Reset();
+    AddIPAM("vn1", ipam_info, 1);
+    client->WaitForIdle();
+
+    SendDhcp(GetItfId(0), 0x8000, DHCP_DISCOVER, options, 2, false, false,
+             0, 0, true);
+    int count = 0;
+    DHCP_CHECK (stats.offers < 1);
+    EXPECT_EQ(1U, stats.discover);
+    EXPECT_EQ(1U, stats.offers);
+
+    client->Reset();
+    DelIPAM("vn1");
+    client->WaitForIdle();
+    client->Reset();
+    DeleteVmportEnv(input, 1, 1, 0);
+    client->WaitForIdle();
+
+    Agent::GetInstance()->GetDhcpProto()->ClearStats();
+}
+
 TEST_F(DhcpTest, DhcpOptionTest) {
     struct PortInfo input[] = {
         {"vnet3", 3, CLIENT_REQ_IP, "00:00:00:03:03:03", 1, 3},
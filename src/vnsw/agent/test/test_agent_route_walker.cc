@@ -229,6 +229,30 @@ TEST_F(AgentRouteWalkerTest, walk_all_routes_with_3_vrf) {
     DeleteEnvironment(3);
 }
 
+TEST_F(AgentRouteWalkerTest, walk_stats_with_2_vrf) {
+    client->Reset();
+    SetupEnvironment(2);
+    StartVrfWalk();
+    VerifyNotifications(16, 3, 1, 9);
+    WAIT_FOR(100, 1000, IsWalkCompleted() == true);
+    EXPECT_TRUE(walk_start_time() != 0);
+    EXPECT_TRUE(walk_time() >= vrf_walk_time());
+    EXPECT_TRUE(walk_time() >= max_vrf_route_walk_time());
+    EXPECT_EQ(3U, vrf_route_walks());
+    EXPECT_EQ(9U, route_table_walks());
+    EXPECT_EQ(16U, route_notify_count());
+    EXPECT_FALSE(max_vrf_route_walk_vrf().empty());
+
+    //Stats are reset when a new walk starts
+    StartRouteWalk(VrfGet(vrf_name_1_.c_str()));
+    WAIT_FOR(100, 1000, IsWalkCompleted() == true);
+    EXPECT_EQ(1U, vrf_route_walks());
+    EXPECT_EQ(3U, route_table_walks());
+    EXPECT_EQ(5U, route_notify_count());
+    EXPECT_EQ(vrf_name_1_, max_vrf_route_walk_vrf());
+    DeleteEnvironment(2);
+}
+
 TEST_F(AgentRouteWalkerTest, restart_walk_with_2_vrf) {
     client->Reset();
     SetupEnvironment(2);
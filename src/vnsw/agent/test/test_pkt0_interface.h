@@ -148,6 +148,17 @@ public:
                         boost::asio::placeholders::bytes_transferred, buff));
     }
 
+    // Process packet the same way as Pkt0Interface, in a buffer from the
+    // RX_PACKET pool. Takes ownership of buff
+    void TxPooledPacket(uint8_t *buff, std::size_t len) {
+        PacketBufferManager *mgr = agent_->pkt()->packet_buffer_manager();
+        uint8_t *pool_buff = mgr->AllocateBuffer(PktHandler::RX_PACKET);
+        memcpy(pool_buff, buff, len);
+        delete [] buff;
+        VrouterControlInterface::Process(
+            mgr->AllocatePooled(PktHandler::RX_PACKET, pool_buff, len, 0));
+    }
+
     bool ProcessFlowPacket(uint8_t *buff, uint32_t payload_len,
                            uint32_t buff_len) {
         PacketBufferPtr pkt(agent_->pkt()->packet_buffer_manager()->Allocate
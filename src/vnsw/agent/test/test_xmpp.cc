@@ -40,6 +40,7 @@
 
 #include "controller/controller_peer.h" 
 #include "controller/controller_export.h" 
+#include "controller/controller_export_batcher.h"
 #include "controller/controller_vrf_export.h" 
 #include "controller/controller_types.h" 
 #include "controller/controller_route_path.h"
@@ -593,6 +594,104 @@ TEST_F(AgentXmppUnitTest, Connection) {
 
 }
 
+TEST_F(AgentXmppUnitTest, RouteExportBatch) {
+
+    client->Reset();
+
+    XmppConnectionSetUp();
+    //wait for connection establishment
+    WAIT_FOR(1000, 10000, (sconnection->GetStateMcState() == xmsm::ESTABLISHED));
+    WAIT_FOR(1000, 10000, (cchannel->GetPeerState() == xmps::READY));
+
+    //expect subscribe for __default__ at the mock server
+    WAIT_FOR(1000, 10000, (mock_peer.get()->Count() == 1));
+
+    RouteExportBatcher *batcher = bgp_peer.get()->export_batcher();
+    batcher->set_disable();
+    uint64_t suppressed = batcher->suppressed();
+
+    //Later message for a route replaces the pending one
+    batcher->Enqueue("1/1/vrf1/1.1.1.10/32", true, true, "");
+    batcher->Enqueue("1/1/vrf1/1.1.1.10/32", false, true, "");
+    EXPECT_EQ(1U, batcher->pending());
+    EXPECT_EQ(suppressed + 1, batcher->suppressed());
+    batcher->Enqueue("1/1/vrf1/1.1.1.11/32", true, false, "");
+    batcher->Enqueue("1/1/vrf1/1.1.1.11/32", true, true, "");
+    EXPECT_EQ(2U, batcher->pending());
+    EXPECT_EQ(suppressed + 2, batcher->suppressed());
+
+    //Delete of a route control node was never sent cancels the pending add
+    batcher->Enqueue("1/1/vrf1/1.1.1.12/32", true, false, "");
+    EXPECT_EQ(3U, batcher->pending());
+    batcher->Enqueue("1/1/vrf1/1.1.1.12/32", false, true, "");
+    EXPECT_EQ(2U, batcher->pending());
+    EXPECT_EQ(suppressed + 4, batcher->suppressed());
+
+    //Ordered messages like subscribe are never coalesced. Updates queued
+    //ahead of them are sent before them, later updates are queued after
+    batcher->EnqueueOrdered("");
+    batcher->EnqueueOrdered("");
+    EXPECT_EQ(4U, batcher->pending());
+    batcher->Enqueue("1/1/vrf1/1.1.1.11/32", false, true, "");
+    EXPECT_EQ(5U, batcher->pending());
+    batcher->Enqueue("1/1/vrf1/1.1.1.11/32", true, false, "");
+    EXPECT_EQ(5U, batcher->pending());
+    EXPECT_EQ(suppressed + 5, batcher->suppressed());
+    batcher->Clear();
+    batcher->set_enable();
+    client->WaitForIdle();
+
+    VxLanNetworkIdentifierMode(false);
+    client->WaitForIdle();
+    struct PortInfo input[] = {
+        {"vnet3", 3, "1.1.1.3", "00:00:00:01:01:03", 1, 3},
+    };
+
+    //Routes of vm-port are sent in batches
+    uint64_t batches = batcher->batches();
+    uint64_t msgs = batcher->batch_msgs();
+    CreateVmportEnv(input, 1);
+    //expect subscribe message+route at the mock server
+    WAIT_FOR(1000, 10000, (mock_peer.get()->Count() == 7));
+    client->WaitForIdle();
+    EXPECT_EQ(0U, batcher->pending());
+    EXPECT_TRUE(batcher->batches() > batches);
+    EXPECT_TRUE(batcher->batch_msgs() >= msgs + 2);
+    EXPECT_TRUE(batcher->max_latency() >= batcher->last_latency());
+
+    //Overlapping prefixes in one batch are exported separately
+    VrfEntry *vrf = VrfGet("vrf1");
+    Inet4UnicastRouteEntry rt1(vrf, Ip4Address::from_string("1.1.1.0"), 24,
+                               false);
+    Inet4UnicastRouteEntry rt2(vrf, Ip4Address::from_string("1.1.1.0"), 28,
+                               false);
+    SecurityGroupList sg_list;
+    batcher->set_disable();
+    EXPECT_TRUE(AgentXmppChannel::ControllerSendRouteAdd(bgp_peer.get(),
+                &rt1, "vn1", 100, TunnelType::GREType(), &sg_list,
+                Agent::INET4_UNICAST, PathPreference(), false));
+    EXPECT_TRUE(AgentXmppChannel::ControllerSendRouteAdd(bgp_peer.get(),
+                &rt2, "vn1", 101, TunnelType::GREType(), &sg_list,
+                Agent::INET4_UNICAST, PathPreference(), false));
+    EXPECT_EQ(2U, batcher->pending());
+    batcher->Clear();
+    batcher->set_enable();
+
+    DeleteVmportEnv(input, 1, true);
+    client->WaitForIdle();
+    EXPECT_FALSE(VmPortFind(input, 0));
+    WAIT_FOR(1000, 1000, (agent_->vn_table()->Size() == 0));
+
+    TaskScheduler::GetInstance()->Stop();
+    Agent::GetInstance()->controller()->unicast_cleanup_timer().cleanup_timer_->Fire();
+    TaskScheduler::GetInstance()->Start();
+    client->WaitForIdle();
+
+    EXPECT_FALSE(VrfFind("vrf1"));
+    xc->ConfigUpdate(new XmppConfigData());
+    client->WaitForIdle(5);
+}
+
 TEST_F(AgentXmppUnitTest, Del_db_req_by_deleted_peer_non_hv) {
 
     client->Reset();
@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <pkt/flow_proto.h>
 #include <ksync/ksync_init.h>
+#include <ksync/flowtable_ksync.h>
 
 FlowStatsCollector::FlowStatsCollector(boost::asio::io_service &io, int intvl,
                                        uint32_t flow_cache_timeout,
@@ -258,6 +259,8 @@ bool FlowStatsCollector::Run() {
     }
     FlowTableKSyncObject *ksync_obj = 
         Agent::GetInstance()->ksync()->flowtable_ksync_obj();
+    // Flows aged in this pass are deleted in batches
+    FlowTableKSyncBatchScope batch(ksync_obj);
 
     while (it != flow_obj->flow_entry_map_.end()) {
         entry = it->second;
@@ -30,6 +30,7 @@
 #include "vr_types.h"
 #include <uve/test/vm_uve_table_test.h>
 #include "uve/test/test_uve_util.h"
+#include <uve/vm_stat_collector.h>
 
 using namespace std;
 
@@ -1076,6 +1077,126 @@ TEST_F(UveVmUveTest, VmUVE_Name_1) {
     RemoveFipConfig();
 }
 
+// Source serving procfs and cgroup files from fixture data
+class VmStatSourceTest : public VmStatSource {
+public:
+    VmStatSourceTest() { }
+    virtual bool ReadFile(const std::string &path, std::string *data) {
+        std::map<std::string, std::string>::iterator it = files_.find(path);
+        if (it == files_.end()) {
+            return false;
+        }
+        *data = it->second;
+        return true;
+    }
+    virtual bool ReadDir(const std::string &path,
+                         std::vector<std::string> *entries) {
+        std::map<std::string, std::vector<std::string> >::iterator it =
+            dirs_.find(path);
+        if (it == dirs_.end()) {
+            return false;
+        }
+        *entries = it->second;
+        return true;
+    }
+    virtual uint32_t ClockTicks() { return 100; }
+
+    std::map<std::string, std::string> files_;
+    std::map<std::string, std::vector<std::string> > dirs_;
+};
+
+static std::string TaskStat(const std::string &comm, uint32_t utime,
+                            uint32_t stime) {
+    std::ostringstream str;
+    str << "1240 (" << comm << ") S 1 1 1 0 -1 0 0 0 0 0 " << utime << " "
+        << stime << " 0 0 20 0 1 0";
+    return str.str();
+}
+
+// Stats of all VMs are read from procfs and cgroup files in one pass
+TEST_F(UveVmUveTest, VmStatCollector_1) {
+    Agent *agent = Agent::GetInstance();
+    VmUveTableTest *vmut = static_cast<VmUveTableTest *>
+        (agent->uve()->vm_uve_table());
+    VmStatCollector collector(*(agent->event_manager()->io_service()),
+                              agent);
+    VmStatSourceTest *source = new VmStatSourceTest();
+    collector.set_source(source);
+
+    boost::uuids::uuid vm_uuid = MakeUuid(10);
+    std::string cmdline("/usr/bin/qemu-system-x86_64");
+    cmdline.push_back('\0');
+    cmdline += "-m";
+    cmdline.push_back('\0');
+    cmdline += "2048";
+    cmdline.push_back('\0');
+    cmdline += "-uuid";
+    cmdline.push_back('\0');
+    cmdline += UuidToString(vm_uuid);
+    cmdline.push_back('\0');
+    std::string cpuacct("/sys/fs/cgroup/cpu,cpuacct/machine/"
+                        "instance-00000001.libvirt-qemu/cpuacct.usage");
+
+    source->dirs_["/proc"].push_back("1");
+    source->dirs_["/proc"].push_back("1234");
+    source->dirs_["/proc"].push_back("self");
+    source->files_["/proc/1/cmdline"] = std::string("/sbin/init\0", 11);
+    source->files_["/proc/1234/cmdline"] = cmdline;
+    source->files_["/proc/1234/cgroup"] =
+        "4:cpu,cpuacct:/machine/instance-00000001.libvirt-qemu\n"
+        "3:memory:/machine/instance-00000001.libvirt-qemu\n";
+    source->files_[cpuacct] = "10000000000\n";
+    source->files_["/proc/1234/status"] =
+        "Name:\tqemu-system-x86\nVmPeak:\t    3000 kB\n"
+        "VmSize:\t    2500 kB\nVmRSS:\t    1000 kB\n";
+    source->dirs_["/proc/1234/task"].push_back("1234");
+    source->dirs_["/proc/1234/task"].push_back("1240");
+    source->files_["/proc/1234/task/1234/comm"] = "qemu-system-x86\n";
+    source->files_["/proc/1234/task/1240/comm"] = "CPU 0/KVM\n";
+    source->files_["/proc/1234/task/1240/stat"] = TaskStat("CPU 0/KVM",
+                                                           500, 100);
+
+    VmStat *stat = collector.Add(vm_uuid);
+    vmut->ClearCount();
+    collector.Collect(1000);
+    EXPECT_EQ(1234U, stat->pid());
+    EXPECT_EQ(cpuacct, stat->cpuacct_file());
+    EXPECT_EQ(2048U * 1024, stat->vm_memory_quota());
+    EXPECT_EQ(1U, collector.proc_scan_count());
+    EXPECT_EQ(1U, vmut->vm_stats_send_count());
+    const VirtualMachineStats &stats_uve = vmut->last_sent_stats_uve();
+    EXPECT_EQ(UuidToString(vm_uuid), stats_uve.get_name());
+    EXPECT_EQ(1000U, stats_uve.get_cpu_stats().front().get_rss());
+    EXPECT_EQ(2500U, stats_uve.get_cpu_stats().front().get_virt_memory());
+
+    // 30 seconds of CPU in 60 seconds, 30 of them on VCPU 0
+    source->files_[cpuacct] = "40000000000\n";
+    source->files_["/proc/1234/task/1240/stat"] = TaskStat("CPU 0/KVM",
+                                                           3500, 100);
+    collector.Collect(1060);
+    EXPECT_EQ(1U, collector.proc_scan_count());
+    EXPECT_EQ(2U, vmut->vm_stats_send_count());
+    uint32_t num_of_cpu = agent->uve()->vrouter_uve_entry()->GetCpuCount();
+    if (num_of_cpu) {
+        EXPECT_DOUBLE_EQ(50.0 / num_of_cpu, stat->cpu_usage());
+    }
+    EXPECT_EQ(1U, stat->vcpu_usage_percent().size());
+    EXPECT_DOUBLE_EQ(50.0, stat->vcpu_usage_percent()[0]);
+
+    // VM process is gone, pid is looked up again
+    source->files_.erase("/proc/1234/status");
+    collector.Collect(1120);
+    EXPECT_EQ(0U, stat->pid());
+    EXPECT_EQ(2U, vmut->vm_stats_send_count());
+    collector.Collect(1180);
+    EXPECT_EQ(2U, collector.proc_scan_count());
+    EXPECT_EQ(1234U, stat->pid());
+
+    collector.Delete(vm_uuid);
+    EXPECT_EQ(0U, collector.size());
+    vmut->ClearCount();
+}
+
 int main(int argc, char **argv) {
     GETUSERARGS();
     client = TestInit(init_file, ksync_init, true, false, true,
@@ -29,6 +29,7 @@
 #include "ksync/ksync_sock_user.h"
 #include "vr_types.h"
 #include <uve/test/vn_uve_table_test.h>
+#include <uve/test/vn_uve_entry_test.h>
 #include "uve/test/test_uve_util.h"
 
 using namespace std;
@@ -1045,6 +1046,10 @@ TEST_F(UveVnUveTest, InterVnStats_1) {
 
     const FlowEntry *fe1 = flow[0].pkt_.FlowFetch();
     const FlowEntry *fe2 = flow[1].pkt_.FlowFetch();
+    //VN ids are cached on the flow by the stats collector
+    EXPECT_EQ("vn5", vnut->VnIdToName(fe1->data().source_vn_id));
+    EXPECT_EQ("vn5", vnut->VnIdToName(fe1->data().dest_vn_id));
+
     //Inter-VN stats updation when flow stats are updated
     //Change the stats in mock kernel
     KSyncSockTypeMap::IncrFlowStats(fe1->flow_handle(), 1, 30);
@@ -1080,6 +1085,79 @@ TEST_F(UveVnUveTest, InterVnStats_1) {
     EXPECT_EQ(0U, ksock->flow_map.size());
 }
 
+// Interns VN names in the stats collector task, which owns the VN id map
+class VnNameInternTask : public Task {
+public:
+    VnNameInternTask(VnUveTable *table, const std::vector<std::string> &names,
+                     std::vector<uint32_t> *ids) :
+        Task((TaskScheduler::GetInstance()->GetTaskId("Agent::StatsCollector")),
+                StatsCollector::FlowStatsCollector),
+        table_(table), names_(names), ids_(ids) {
+    }
+    virtual bool Run() {
+        for (size_t i = 0; i < names_.size(); i++)
+            ids_->push_back(table_->VnNameToId(names_[i]));
+        return true;
+    }
+private:
+    VnUveTable *table_;
+    std::vector<std::string> names_;
+    std::vector<uint32_t> *ids_;
+};
+
+// VN names are interned to stable ids, and stats of destination VNs with
+// large ids are kept in sparse rows
+TEST_F(UveVnUveTest, InterVnStats_Interned) {
+    VnUveTableTest *vnut = static_cast<VnUveTableTest *>
+        (Agent::GetInstance()->uve()->vn_uve_table());
+
+    std::vector<std::string> names;
+    names.push_back("intern-vn1");
+    names.push_back("intern-vn1");
+    names.push_back("intern-vn2");
+    names.push_back(FlowHandler::UnknownVn());
+    names.push_back(FlowHandler::UnknownVn());
+    std::vector<uint32_t> ids;
+    TaskScheduler::GetInstance()->Enqueue(new VnNameInternTask(vnut, names,
+                                                               &ids));
+    client->WaitForIdle();
+    ASSERT_EQ(names.size(), ids.size());
+
+    uint32_t id = ids[0];
+    EXPECT_EQ(id, ids[1]);
+    EXPECT_NE(id, ids[2]);
+    EXPECT_EQ("intern-vn1", vnut->VnIdToName(id));
+    EXPECT_EQ(ids[3], ids[4]);
+
+    VnUveEntryTest entry(Agent::GetInstance());
+    uint32_t sparse_id = VnUveEntry::kMaxDenseVnId + 10;
+    entry.UpdateInterVnStats(id, "intern-vn1", 100, 1, false);
+    entry.UpdateInterVnStats(sparse_id, "intern-vn3", 200, 2, true);
+    entry.UpdateInterVnStats(id, "intern-vn1", 100, 1, true);
+    entry.UpdateInterVnStats(sparse_id, "intern-vn3", 200, 2, true);
+    EXPECT_EQ(2U, entry.inter_vn_stats()->size());
+
+    VnUveEntry::VnStatsPtr key(new VnUveEntry::VnStats("intern-vn1", 0, 0,
+                                                      false));
+    VnUveEntry::VnStatsSet::const_iterator it =
+        entry.inter_vn_stats()->find(key);
+    ASSERT_TRUE(it != entry.inter_vn_stats()->end());
+    EXPECT_EQ(100U, (*it)->in_bytes_);
+    EXPECT_EQ(100U, (*it)->out_bytes_);
+
+    key.reset(new VnUveEntry::VnStats("intern-vn3", 0, 0, false));
+    it = entry.inter_vn_stats()->find(key);
+    ASSERT_TRUE(it != entry.inter_vn_stats()->end());
+    EXPECT_EQ(0U, (*it)->in_pkts_);
+    EXPECT_EQ(4U, (*it)->out_pkts_);
+    EXPECT_EQ(400U, (*it)->out_bytes_);
+
+    entry.ClearInterVnStats();
+    EXPECT_EQ(0U, entry.inter_vn_stats()->size());
+    entry.UpdateInterVnStats(sparse_id, "intern-vn3", 200, 2, true);
+    EXPECT_EQ(1U, entry.inter_vn_stats()->size());
+}
+
 int main(int argc, char **argv) {
     GETUSERARGS();
     /* Sent AgentStatsCollector and FlowStatsCollector timer intervals to 10
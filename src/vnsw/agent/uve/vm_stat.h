@@ -11,45 +11,49 @@
 #include <sandesh/sandesh.h>
 #include <virtual_machine_types.h>
 #include <boost/uuid/uuid_io.hpp>
-#include "base/timer.h"
 #include <cmn/agent_cmn.h>
 
-class VmStatData;
+// Counters of a VM read by VmStatCollector in one collection pass
+struct VmStatSample {
+    VmStatSample() : cpu_time(0), mem_usage(0), virt_memory(0),
+        virt_memory_peak(0) {
+    }
 
+    // CPU time of all threads of the VM (seconds)
+    double cpu_time;
+    // CPU time of each VCPU (seconds)
+    std::vector<double> vcpu_time;
+    // Memory in KiB
+    uint32_t mem_usage;
+    uint32_t virt_memory;
+    uint32_t virt_memory_peak;
+};
+
+// Statistics of a VM. Usage is computed from samples read by VmStatCollector
 class VmStat {
 public:
-    static const size_t kBufLen = 4098;
-    static const uint32_t kTimeout = 60 * 1000;
-    static const uint32_t kRetryCount = 3;
-    typedef boost::function<void(void)> DoneCb;
-
     VmStat(Agent *agent, const boost::uuids::uuid &vm_uuid);
     ~VmStat();
-    bool marked_delete() const { return marked_delete_; }
 
-    void Start();
-    void Stop();
-    void HandleSigChild(const boost::system::error_code& error, int sig);
-    void ProcessData();
-private:
-    bool BuildVmStatsMsg(VirtualMachineStats *uve);
-    bool BuildVmMsg(UveVirtualMachineAgent *uve);
-    void ReadCpuStat();
-    void ReadVcpuStat();
-    void ReadMemStat();
-    void GetCpuStat();
-    void GetVcpuStat();
-    void GetMemStat();
-    void ReadData(const boost::system::error_code &ec, size_t read_bytes, 
-                  DoneCb &cb);
-    void ExecCmd(std::string cmd, DoneCb cb);
-    void StartTimer();
-    bool TimerExpiry();
-    void GetPid();
-    void ReadPid();
-    void ReadMemoryQuota();
-    void GetMemoryQuota();
+    const boost::uuids::uuid &vm_uuid() const { return vm_uuid_; }
+    uint32_t pid() const { return pid_; }
+    void set_pid(uint32_t pid) { pid_ = pid; }
+    const std::string &cpuacct_file() const { return cpuacct_file_; }
+    void set_cpuacct_file(const std::string &file) { cpuacct_file_ = file; }
+    uint32_t vm_memory_quota() const { return vm_memory_quota_; }
+    void set_vm_memory_quota(uint32_t quota) { vm_memory_quota_ = quota; }
+    double cpu_usage() const { return cpu_usage_; }
+    const std::vector<double> &vcpu_usage_percent() const {
+        return vcpu_usage_percent_;
+    }
+    uint32_t mem_usage() const { return mem_usage_; }
+
+    // Compute usage from sample read at time now
+    void Update(const VmStatSample &sample, uint32_t num_of_cpu, time_t now);
+    bool BuildVmStatsMsg(VirtualMachineStats *uve) const;
+    bool BuildVmMsg(UveVirtualMachineAgent *uve) const;
 
+private:
     Agent *agent_;
     const boost::uuids::uuid vm_uuid_;
     uint32_t mem_usage_;
@@ -62,14 +66,8 @@ private:
     std::vector<double> prev_vcpu_usage_;
     std::vector<double> vcpu_usage_percent_;
     time_t   prev_vcpu_snapshot_time_;
-    char     rx_buff_[kBufLen];
-    std::stringstream data_;
-    boost::asio::posix::stream_descriptor input_;
-    Timer *timer_;
-    bool marked_delete_;
     uint32_t pid_;
-    uint32_t retry_;
-    DoneCb call_back_;
+    std::string cpuacct_file_;
     DISALLOW_COPY_AND_ASSIGN(VmStat);
 };
 #endif // vnsw_agent_vm_stat_h
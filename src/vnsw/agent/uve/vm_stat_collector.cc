@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <cmn/agent_cmn.h>
+#include <uve/agent_uve.h>
+#include <uve/vm_stat_collector.h>
+#include <uve/vrouter_uve_entry.h>
+
+using namespace boost::uuids;
+
+const uint32_t VmStatCollector::kInterval;
+
+static std::string ProcFile(uint32_t pid, const std::string &file) {
+    std::ostringstream str;
+    str << "/proc/" << pid << "/" << file;
+    return str.str();
+}
+
+bool VmStatSource::ReadFile(const std::string &path, std::string *data) {
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        return false;
+    }
+    std::ostringstream str;
+    str << file.rdbuf();
+    *data = str.str();
+    return true;
+}
+
+bool VmStatSource::ReadDir(const std::string &path,
+                           std::vector<std::string> *entries) {
+    DIR *dir = opendir(path.c_str());
+    if (dir == NULL) {
+        return false;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        std::string name(entry->d_name);
+        if (name == "." || name == "..") {
+            continue;
+        }
+        entries->push_back(name);
+    }
+    closedir(dir);
+    return true;
+}
+
+uint32_t VmStatSource::ClockTicks() {
+    long ticks = sysconf(_SC_CLK_TCK);
+    return (ticks > 0) ? ticks : 100;
+}
+
+VmStatCollector::VmStatCollector(boost::asio::io_service &io, Agent *agent) :
+    StatsCollector(TaskScheduler::GetInstance()->GetTaskId("Agent::Uve"),
+                   0, io, kInterval, "VM stats collector"),
+    agent_(agent), source_(new VmStatSource()), proc_scan_count_(0) {
+}
+
+VmStatCollector::~VmStatCollector() {
+    STLDeleteValues(&vm_stat_map_);
+}
+
+VmStat *VmStatCollector::Add(const uuid &vm_uuid) {
+    VmStatMap::iterator it = vm_stat_map_.find(vm_uuid);
+    if (it != vm_stat_map_.end()) {
+        return it->second;
+    }
+    VmStat *stat = new VmStat(agent_, vm_uuid);
+    vm_stat_map_.insert(std::make_pair(vm_uuid, stat));
+    return stat;
+}
+
+void VmStatCollector::Delete(const uuid &vm_uuid) {
+    VmStatMap::iterator it = vm_stat_map_.find(vm_uuid);
+    if (it == vm_stat_map_.end()) {
+        return;
+    }
+    delete it->second;
+    vm_stat_map_.erase(it);
+}
+
+VmStat *VmStatCollector::Find(const uuid &vm_uuid) const {
+    VmStatMap::const_iterator it = vm_stat_map_.find(vm_uuid);
+    if (it == vm_stat_map_.end()) {
+        return NULL;
+    }
+    return it->second;
+}
+
+bool VmStatCollector::Run() {
+    run_counter_++;
+    Collect(time(NULL));
+    return true;
+}
+
+void VmStatCollector::Shutdown() {
+    StatsCollector::Shutdown();
+    STLDeleteValues(&vm_stat_map_);
+}
+
+void VmStatCollector::Collect(time_t now) {
+    if (vm_stat_map_.empty()) {
+        return;
+    }
+
+    ResolvePids();
+    uint32_t num_of_cpu = agent_->uve()->vrouter_uve_entry()->GetCpuCount();
+    VmUveTable *vm_uve_table = agent_->uve()->vm_uve_table();
+    for (VmStatMap::iterator it = vm_stat_map_.begin();
+         it != vm_stat_map_.end(); ++it) {
+        VmStat *stat = it->second;
+        if (stat->pid() == 0) {
+            continue;
+        }
+
+        VmStatSample sample;
+        if (ReadSample(stat, &sample) == false) {
+            //VM process is gone, look it up again in next pass
+            stat->set_pid(0);
+            stat->set_cpuacct_file("");
+            continue;
+        }
+        stat->Update(sample, num_of_cpu, now);
+
+        //We need to send same cpu info in two different UVEs
+        //(VirtualMachineStats and UveVirtualMachineAgent). One of them uses
+        //stats-oracle infra and other one does not use it. We need two because
+        //stats-oracle infra returns only SUM of cpu-info over a period of time
+        //and current value is returned using non-stats-oracle version.
+        VirtualMachineStats vm_agent;
+        if (stat->BuildVmStatsMsg(&vm_agent)) {
+            vm_uve_table->DispatchVmStatsMsg(vm_agent);
+        }
+        UveVirtualMachineAgent vm_msg;
+        if (stat->BuildVmMsg(&vm_msg)) {
+            vm_uve_table->DispatchVmMsg(vm_msg);
+        }
+    }
+}
+
+//Find qemu process of all VMs without a pid in a single scan of /proc
+void VmStatCollector::ResolvePids() {
+    std::map<std::string, VmStat *> unresolved;
+    for (VmStatMap::iterator it = vm_stat_map_.begin();
+         it != vm_stat_map_.end(); ++it) {
+        if (it->second->pid() == 0) {
+            unresolved.insert(std::make_pair(UuidToString(it->first),
+                                             it->second));
+        }
+    }
+    if (unresolved.empty()) {
+        return;
+    }
+
+    proc_scan_count_++;
+    std::vector<std::string> entries;
+    if (source_->ReadDir("/proc", &entries) == false) {
+        return;
+    }
+
+    for (std::vector<std::string>::const_iterator it = entries.begin();
+         it != entries.end() && unresolved.empty() == false; ++it) {
+        char *end = NULL;
+        unsigned long pid = strtoul(it->c_str(), &end, 10);
+        if (pid == 0 || *end != '\0') {
+            continue;
+        }
+
+        std::string uuid_str;
+        uint32_t quota = 0;
+        ReadCmdline(pid, &uuid_str, &quota);
+        std::map<std::string, VmStat *>::iterator vm_it =
+            unresolved.find(uuid_str);
+        if (vm_it == unresolved.end()) {
+            continue;
+        }
+
+        VmStat *stat = vm_it->second;
+        stat->set_pid(pid);
+        stat->set_vm_memory_quota(quota);
+        stat->set_cpuacct_file(CpuacctFile(pid));
+        unresolved.erase(vm_it);
+    }
+}
+
+//Get VM uuid and memory (KiB) from "-uuid" and "-m" arguments of qemu
+void VmStatCollector::ReadCmdline(uint32_t pid, std::string *uuid_str,
+                                  uint32_t *quota) {
+    std::string data;
+    if (source_->ReadFile(ProcFile(pid, "cmdline"), &data) == false) {
+        return;
+    }
+
+    std::vector<std::string> args;
+    std::istringstream str(data);
+    std::string arg;
+    while (std::getline(str, arg, '\0')) {
+        args.push_back(arg);
+    }
+    if (args.empty() || (args[0].find("qemu") == std::string::npos &&
+                         args[0].find("kvm") == std::string::npos)) {
+        return;
+    }
+
+    for (size_t i = 0; i + 1 < args.size(); i++) {
+        if (args[i] == "-uuid") {
+            *uuid_str = args[i + 1];
+        } else if (args[i] == "-m") {
+            //Memory is either "<size>[unit]" or "size=<size>[unit],..."
+            std::string mem = args[i + 1];
+            if (mem.compare(0, 5, "size=") == 0) {
+                mem.erase(0, 5);
+            }
+            char *end = NULL;
+            uint64_t size = strtoull(mem.c_str(), &end, 10);
+            switch (*end) {
+            case 'k':
+            case 'K':
+                break;
+            case 'g':
+            case 'G':
+                size *= 1024 * 1024;
+                break;
+            default:
+                size *= 1024;
+                break;
+            }
+            *quota = size;
+        }
+    }
+}
+
+//Get cpuacct.usage file of the cgroup libvirt created for the VM
+std::string VmStatCollector::CpuacctFile(uint32_t pid) {
+    std::string data;
+    if (source_->ReadFile(ProcFile(pid, "cgroup"), &data) == false) {
+        return "";
+    }
+
+    //Each line is "<id>:<controller>[,<controller>]:<path>"
+    std::istringstream str(data);
+    std::string line;
+    while (std::getline(str, line)) {
+        size_t first = line.find(':');
+        size_t second = line.find(':', first + 1);
+        if (first == std::string::npos || second == std::string::npos) {
+            continue;
+        }
+        std::string controllers = line.substr(first + 1, second - first - 1);
+        std::string path = line.substr(second + 1);
+        std::string controller;
+        std::istringstream controller_str(controllers);
+        while (std::getline(controller_str, controller, ',')) {
+            if (controller != "cpuacct") {
+                continue;
+            }
+            //Process in root cgroup, usage is of the whole system
+            if (path.empty() || path == "/") {
+                return "";
+            }
+            return "/sys/fs/cgroup/" + controllers + path + "/cpuacct.usage";
+        }
+    }
+    return "";
+}
+
+bool VmStatCollector::ReadSample(const VmStat *stat, VmStatSample *sample) {
+    uint32_t pid = stat->pid();
+    if (ReadMemStat(pid, sample) == false) {
+        return false;
+    }
+
+    //cpuacct.usage is in nanoseconds
+    std::string data;
+    if (stat->cpuacct_file().empty() == false &&
+        source_->ReadFile(stat->cpuacct_file(), &data)) {
+        sample->cpu_time = strtoull(data.c_str(), NULL, 10) / 1000000000.0;
+    } else if (ReadTaskTime(ProcFile(pid, "stat"), &sample->cpu_time) ==
+               false) {
+        return false;
+    }
+
+    ReadVcpuTime(pid, &sample->vcpu_time);
+    return true;
+}
+
+//Get utime + stime from a /proc stat file. Fields are counted after the
+//command name, which may have spaces in it
+bool VmStatCollector::ReadTaskTime(const std::string &stat_file,
+                                   double *cpu_time) {
+    std::string data;
+    if (source_->ReadFile(stat_file, &data) == false) {
+        return false;
+    }
+    size_t pos = data.rfind(')');
+    if (pos == std::string::npos) {
+        return false;
+    }
+
+    std::istringstream str(data.substr(pos + 1));
+    std::vector<std::string> fields;
+    std::string field;
+    while (str >> field) {
+        fields.push_back(field);
+    }
+    //utime and stime are fields 14 and 15 of the file
+    if (fields.size() < 13) {
+        return false;
+    }
+    uint64_t ticks = strtoull(fields[11].c_str(), NULL, 10) +
+        strtoull(fields[12].c_str(), NULL, 10);
+    *cpu_time = static_cast<double>(ticks) / source_->ClockTicks();
+    return true;
+}
+
+//VCPU threads of qemu are named "CPU <index>/KVM"
+void VmStatCollector::ReadVcpuTime(uint32_t pid,
+                                   std::vector<double> *vcpu_time) {
+    std::vector<std::string> tasks;
+    if (source_->ReadDir(ProcFile(pid, "task"), &tasks) == false) {
+        return;
+    }
+
+    for (std::vector<std::string>::const_iterator it = tasks.begin();
+         it != tasks.end(); ++it) {
+        std::string comm;
+        if (source_->ReadFile(ProcFile(pid, "task/" + *it + "/comm"),
+                              &comm) == false) {
+            continue;
+        }
+        unsigned int index;
+        if (sscanf(comm.c_str(), "CPU %u/KVM", &index) != 1) {
+            continue;
+        }
+        double cpu_time = 0;
+        if (ReadTaskTime(ProcFile(pid, "task/" + *it + "/stat"),
+                         &cpu_time) == false) {
+            continue;
+        }
+        if (vcpu_time->size() <= index) {
+            vcpu_time->resize(index + 1, 0);
+        }
+        (*vcpu_time)[index] = cpu_time;
+    }
+}
+
+bool VmStatCollector::ReadMemStat(uint32_t pid, VmStatSample *sample) {
+    std::string data;
+    if (source_->ReadFile(ProcFile(pid, "status"), &data) == false) {
+        return false;
+    }
+
+    std::istringstream str(data);
+    std::string line;
+    while (std::getline(str, line)) {
+        std::istringstream vm(line);
+        std::string tmp;
+        vm >> tmp;
+        if (tmp == "VmSize:") {
+            vm >> sample->virt_memory;
+        } else if (tmp == "VmRSS:") {
+            vm >> sample->mem_usage;
+        } else if (tmp == "VmPeak:") {
+            vm >> sample->virt_memory_peak;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef vnsw_agent_vm_stat_collector_h
+#define vnsw_agent_vm_stat_collector_h
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/scoped_ptr.hpp>
+#include <cmn/agent_cmn.h>
+#include <uve/stats_collector.h>
+#include <uve/vm_stat.h>
+
+//Source of procfs and cgroup files read by VmStatCollector. Reads from the
+//local filesystem; tests override it to serve fixture data
+class VmStatSource {
+public:
+    VmStatSource() { }
+    virtual ~VmStatSource() { }
+
+    virtual bool ReadFile(const std::string &path, std::string *data);
+    virtual bool ReadDir(const std::string &path,
+                         std::vector<std::string> *entries);
+    //Clock ticks per second used in /proc/<pid>/stat
+    virtual uint32_t ClockTicks();
+private:
+    DISALLOW_COPY_AND_ASSIGN(VmStatSource);
+};
+
+//Collects statistics of all VMs on the compute node in one pass over procfs
+//and cgroup files, and sends VirtualMachineStats and UveVirtualMachineAgent
+//UVEs for them.
+//Runs in the context of "Agent::Uve" which has exclusion with "db::DBTable"
+class VmStatCollector : public StatsCollector {
+public:
+    static const uint32_t kInterval = 60 * 1000;
+    typedef std::map<boost::uuids::uuid, VmStat *> VmStatMap;
+
+    VmStatCollector(boost::asio::io_service &io, Agent *agent);
+    virtual ~VmStatCollector();
+
+    VmStat *Add(const boost::uuids::uuid &vm_uuid);
+    void Delete(const boost::uuids::uuid &vm_uuid);
+    VmStat *Find(const boost::uuids::uuid &vm_uuid) const;
+
+    bool Run();
+    //Read stats of all VMs, taking now as time of the snapshot
+    void Collect(time_t now);
+    void Shutdown();
+
+    //Takes ownership of source
+    void set_source(VmStatSource *source) { source_.reset(source); }
+    size_t size() const { return vm_stat_map_.size(); }
+    uint32_t proc_scan_count() const { return proc_scan_count_; }
+private:
+    void ResolvePids();
+    void ReadCmdline(uint32_t pid, std::string *uuid_str, uint32_t *quota);
+    std::string CpuacctFile(uint32_t pid);
+    bool ReadSample(const VmStat *stat, VmStatSample *sample);
+    bool ReadTaskTime(const std::string &stat_file, double *cpu_time);
+    void ReadVcpuTime(uint32_t pid, std::vector<double> *vcpu_time);
+    bool ReadMemStat(uint32_t pid, VmStatSample *sample);
+
+    Agent *agent_;
+    boost::scoped_ptr<VmStatSource> source_;
+    VmStatMap vm_stat_map_;
+    uint32_t proc_scan_count_;
+    DISALLOW_COPY_AND_ASSIGN(VmStatCollector);
+};
+
+#endif //vnsw_agent_vm_stat_collector_h
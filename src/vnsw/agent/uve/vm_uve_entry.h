@@ -15,7 +15,6 @@
 #include <virtual_machine_types.h>
 #include <uve/l4_port_bitmap.h>
 #include <uve/vm_stat.h>
-#include <uve/vm_stat_data.h>
 #include <oper/interface_common.h>
 #include <oper/interface.h>
 #include <oper/vm.h>
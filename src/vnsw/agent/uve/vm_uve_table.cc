@@ -9,10 +9,9 @@
 VmUveTable::VmUveTable(Agent *agent)
     : uve_vm_map_(), agent_(agent), 
       intf_listener_id_(DBTableBase::kInvalidId),
-      vm_listener_id_(DBTableBase::kInvalidId) {
-    event_queue_.reset(new WorkQueue<VmStatData *>
-            (TaskScheduler::GetInstance()->GetTaskId("Agent::Uve"), 0,
-             boost::bind(&VmUveTable::Process, this, _1)));
+      vm_listener_id_(DBTableBase::kInvalidId),
+      vm_stat_collector_(new VmStatCollector(
+                             *(agent->event_manager()->io_service()), agent)) {
 }
 
 VmUveTable::~VmUveTable() {
@@ -213,14 +212,12 @@ void VmUveTable::VmNotify(DBTablePartBase *partition, DBEntryBase *e) {
 }
 
 void VmUveTable::VmStatCollectionStart(VmUveVmState *state, const VmEntry *vm) {
-    //Create object to poll for VM stats
-    VmStat *stat = new VmStat(agent_, vm->GetUuid());
-    stat->Start();
-    state->stat_ = stat;
+    //Stats of the VM are read in the next pass of VmStatCollector
+    state->stat_ = vm_stat_collector_->Add(vm->GetUuid());
 }
 
 void VmUveTable::VmStatCollectionStop(VmUveVmState *state) {
-    state->stat_->Stop();
+    vm_stat_collector_->Delete(state->stat_->vm_uuid());
     state->stat_ = NULL;
 }
 
@@ -237,6 +234,7 @@ void VmUveTable::RegisterDBClients() {
 void VmUveTable::Shutdown(void) {
     agent_->vm_table()->Unregister(vm_listener_id_);
     agent_->interface_table()->Unregister(intf_listener_id_);
+    vm_stat_collector_->Shutdown();
 }
 
 void VmUveTable::SendVmStats(void) {
@@ -256,20 +254,6 @@ void VmUveTable::UpdateBitmap(const VmEntry* vm, uint8_t proto, uint16_t sport,
     }
 }
 
-void VmUveTable::EnqueueVmStatData(VmStatData *data) {
-    event_queue_->Enqueue(data);
-}
-
-bool VmUveTable::Process(VmStatData* vm_stat_data) {
-    if (vm_stat_data->vm_stat()->marked_delete()) {
-        delete vm_stat_data->vm_stat();
-    } else {
-        vm_stat_data->vm_stat()->ProcessData();
-    }
-    delete vm_stat_data;
-    return true;
-}
-
 void VmUveTable::UpdateFloatingIpStats(const FlowEntry *flow, uint64_t bytes,
                                        uint64_t pkts) {
     VmUveEntry::FipInfo fip_info;
@@ -17,7 +17,7 @@
 #include <virtual_machine_types.h>
 #include <uve/l4_port_bitmap.h>
 #include <uve/vm_stat.h>
-#include <uve/vm_stat_data.h>
+#include <uve/vm_stat_collector.h>
 #include <oper/vm.h>
 #include <oper/peer.h>
 #include <cmn/index_vector.h>
@@ -57,10 +57,11 @@ public:
                       uint16_t dport);
     virtual void DispatchVmMsg(const UveVirtualMachineAgent &uve);
     virtual void DispatchVmStatsMsg(const VirtualMachineStats &uve);
-    void EnqueueVmStatData(VmStatData *data);
-    bool Process(VmStatData *vm_stat_data);
     void UpdateFloatingIpStats(const FlowEntry *flow, uint64_t bytes,
                                uint64_t pkts);
+    VmStatCollector *vm_stat_collector() const {
+        return vm_stat_collector_.get();
+    }
 
 protected:
     virtual void VmStatCollectionStart(VmUveVmState *state, const VmEntry *vm);
@@ -86,7 +87,7 @@ private:
 
     DBTableBase::ListenerId intf_listener_id_;
     DBTableBase::ListenerId vm_listener_id_;
-    boost::scoped_ptr<WorkQueue<VmStatData *> > event_queue_;
+    boost::scoped_ptr<VmStatCollector> vm_stat_collector_;
     DISALLOW_COPY_AND_ASSIGN(VmUveTable);
 };
 
@@ -5,6 +5,8 @@
 #include <uve/vn_uve_entry.h>
 #include <uve/agent_uve.h>
 
+const uint32_t VnUveEntry::kMaxDenseVnId;
+
 VnUveEntry::VnUveEntry(Agent *agent, const VnEntry *vn) 
     : agent_(agent), vn_(vn), port_bitmap_(), uve_info_(), 
       interface_tree_(), vm_tree_(), inter_vn_stats_(), mutex_(), 
@@ -58,28 +60,49 @@ void VnUveEntry::UpdatePortBitmap(uint8_t proto, uint16_t sport,
     port_bitmap_.AddPort(proto, sport, dport);
 }
 
-void VnUveEntry::UpdateInterVnStats(const string &dst_vn, uint64_t bytes, 
-                                    uint64_t pkts, bool outgoing) {
+void VnUveEntry::UpdateInterVnStats(uint32_t dst_vn_id, const string &dst_vn,
+                                    uint64_t bytes, uint64_t pkts,
+                                    bool outgoing) {
     tbb::mutex::scoped_lock lock(mutex_);
-    VnStatsPtr key(new VnStats(dst_vn, 0, 0, false));
-    VnStatsSet::iterator stats_it = inter_vn_stats_.find(key);
-    if (stats_it == inter_vn_stats_.end()) {
-        VnStatsPtr stats(new VnStats(dst_vn, bytes, pkts, outgoing));
-        inter_vn_stats_.insert(stats);
+    VnStats *stats = NULL;
+    if (dst_vn_id < kMaxDenseVnId) {
+        if (dst_vn_id < inter_vn_stats_dense_.size()) {
+            stats = inter_vn_stats_dense_[dst_vn_id];
+        }
     } else {
-        VnStatsPtr stats_ptr(*stats_it);
-        VnStats *stats = stats_ptr.get();
-        if (outgoing) {
-            stats->out_bytes_ += bytes;
-            stats->out_pkts_ += pkts;
+        VnStatsMap::iterator it = inter_vn_stats_sparse_.find(dst_vn_id);
+        if (it != inter_vn_stats_sparse_.end()) {
+            stats = it->second;
+        }
+    }
+
+    if (stats == NULL) {
+        VnStatsPtr stats_ptr(new VnStats(dst_vn, bytes, pkts, outgoing));
+        inter_vn_stats_.insert(stats_ptr);
+        if (dst_vn_id < kMaxDenseVnId) {
+            if (dst_vn_id >= inter_vn_stats_dense_.size()) {
+                inter_vn_stats_dense_.resize(dst_vn_id + 1, NULL);
+            }
+            inter_vn_stats_dense_[dst_vn_id] = stats_ptr.get();
         } else {
-            stats->in_bytes_ += bytes;
-            stats->in_pkts_ += pkts;
+            inter_vn_stats_sparse_[dst_vn_id] = stats_ptr.get();
         }
+        return;
+    }
+
+    if (outgoing) {
+        stats->out_bytes_ += bytes;
+        stats->out_pkts_ += pkts;
+    } else {
+        stats->in_bytes_ += bytes;
+        stats->in_pkts_ += pkts;
     }
 }
 
 void VnUveEntry::ClearInterVnStats() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    inter_vn_stats_dense_.clear();
+    inter_vn_stats_sparse_.clear();
     /* Remove all the elements of map entry value which is a set */
     VnStatsSet::iterator stats_it = inter_vn_stats_.begin();
     VnStatsSet::iterator del_it;
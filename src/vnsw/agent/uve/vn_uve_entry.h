@@ -69,6 +69,11 @@ public:
     typedef std::set<const Interface *> InterfaceSet;
     typedef std::set<std::string> VmSet;
     typedef std::set<VnStatsPtr, VnStatsCmp> VnStatsSet;
+    //Stats are indexed by interned id of destination VN. Rows are dense
+    //till kMaxDenseVnId and sparse after it
+    typedef std::vector<VnStats *> VnStatsVector;
+    typedef std::map<uint32_t, VnStats *> VnStatsMap;
+    static const uint32_t kMaxDenseVnId = 1024;
 
     VnUveEntry(Agent *agent, const VnEntry *vn);
     VnUveEntry(Agent *agent);
@@ -87,8 +92,8 @@ public:
     bool FrameVnMsg(const VnEntry *vn, UveVirtualNetworkAgent &uve);
     bool FrameVnStatsMsg(const VnEntry *vn, UveVirtualNetworkAgent &uve,
                          bool only_vrf_stats);
-    void UpdateInterVnStats(const string &dst_vn, uint64_t bytes, 
-                            uint64_t pkts, bool outgoing);
+    void UpdateInterVnStats(uint32_t dst_vn_id, const string &dst_vn,
+                            uint64_t bytes, uint64_t pkts, bool outgoing);
     void ClearInterVnStats();
     const VnEntry *vn() const { return vn_; }
     void GetInStats(uint64_t *in_bytes, uint64_t *in_pkts) const;
@@ -101,6 +106,8 @@ protected:
     InterfaceSet interface_tree_;
     VmSet vm_tree_;
     VnStatsSet inter_vn_stats_;
+    VnStatsVector inter_vn_stats_dense_;
+    VnStatsMap inter_vn_stats_sparse_;
 
 private:
     bool UveVnInterfaceListChanged(const std::vector<string> &new_list) const;
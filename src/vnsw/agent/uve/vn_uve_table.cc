@@ -9,7 +9,8 @@
 VnUveTable::VnUveTable(Agent *agent) 
     : uve_vn_map_(), agent_(agent), 
       vn_listener_id_(DBTableBase::kInvalidId),
-      intf_listener_id_(DBTableBase::kInvalidId) {
+      intf_listener_id_(DBTableBase::kInvalidId), vn_id_map_(), vn_names_(),
+      vn_uve_by_id_(), unknown_vn_id_(VnNameToId(FlowHandler::UnknownVn())) {
 }
 
 VnUveTable::~VnUveTable() {
@@ -128,6 +129,7 @@ void VnUveTable::Delete(const VnEntry *vn) {
     if (it != uve_vn_map_.end()) {
         uve_vn_map_.erase(it);
     }
+    SetVnUveEntry(vn->GetName(), VnUveEntryPtr());
 }
 
 VnUveEntry* VnUveTable::Add(const VnEntry *vn) {
@@ -137,13 +139,36 @@ VnUveEntry* VnUveTable::Add(const VnEntry *vn) {
     UveVnMap::iterator it = ret.first;
     VnUveEntry* entry = it->second.get();
     entry->set_vn(vn);
+    SetVnUveEntry(vn->GetName(), it->second);
 
     return entry;
 }
 
 void VnUveTable::Add(const string &vn) {
     VnUveEntryPtr uve = Allocate();
-    uve_vn_map_.insert(UveVnPair(vn, uve));
+    pair<UveVnMap::iterator, bool> ret;
+    ret = uve_vn_map_.insert(UveVnPair(vn, uve));
+    SetVnUveEntry(vn, ret.first->second);
+}
+
+uint32_t VnUveTable::VnNameToId(const string &vn) {
+    VnIdMap::const_iterator it = vn_id_map_.find(vn);
+    if (it != vn_id_map_.end()) {
+        return it->second;
+    }
+
+    uint32_t id = vn_names_.size();
+    vn_names_.push_back(vn);
+    vn_id_map_.insert(std::make_pair(vn, id));
+    return id;
+}
+
+void VnUveTable::SetVnUveEntry(const string &vn, const VnUveEntryPtr &entry) {
+    uint32_t id = VnNameToId(vn);
+    if (id >= vn_uve_by_id_.size()) {
+        vn_uve_by_id_.resize(id + 1);
+    }
+    vn_uve_by_id_[id] = entry;
 }
 
 VnUveTable::VnUveEntryPtr VnUveTable::Allocate(const VnEntry *vn) {
@@ -283,27 +308,37 @@ void VnUveTable::UpdateBitmap(const string &vn, uint8_t proto, uint16_t sport,
     it->second.get()->UpdatePortBitmap(proto, sport, dport);
 }
 
-void VnUveTable::VnStatsUpdateInternal(const string &src, const string &dst, 
+void VnUveTable::VnStatsUpdateInternal(uint32_t src_id, uint32_t dst_id,
                                        uint64_t bytes, uint64_t pkts, 
                                        bool outgoing) {
-    UveVnMap::iterator it = uve_vn_map_.find(src);
-    if (it == uve_vn_map_.end()) {
+    if (src_id >= vn_uve_by_id_.size()) {
+        return;
+    }
+    VnUveEntry *entry = vn_uve_by_id_[src_id].get();
+    if (entry == NULL) {
         return;
     }
 
-    VnUveEntryPtr vn_uve_entry(it->second);
-    vn_uve_entry.get()->UpdateInterVnStats(dst, bytes, pkts, outgoing);
+    entry->UpdateInterVnStats(dst_id, vn_names_[dst_id], bytes, pkts,
+                              outgoing);
 }
 
-void VnUveTable::UpdateInterVnStats(const FlowEntry *fe, uint64_t bytes, 
-                                    uint64_t pkts) {
-
-    string src_vn = fe->data().source_vn, dst_vn = fe->data().dest_vn;
+uint32_t VnUveTable::FlowVnId(const string &vn, uint32_t *id) {
+    if (*id == FlowData::kInvalidVnId) {
+        *id = vn.length() ? VnNameToId(vn) : unknown_vn_id_;
+    }
+    return *id;
+}
 
-    if (!fe->data().source_vn.length())
-        src_vn = FlowHandler::UnknownVn();
-    if (!fe->data().dest_vn.length())
-        dst_vn = FlowHandler::UnknownVn();
+void VnUveTable::UpdateInterVnStats(FlowEntry *fe, uint64_t bytes,
+                                    uint64_t pkts) {
+    /* VN names are interned once per flow and the ids are cached in flow
+     * data, so that stats of a flow are updated without hashing or comparing
+     * names. Stats collector is mutually exclusive with the flow handler
+     * which sets the names */
+    FlowData &data = fe->data();
+    uint32_t src_id = FlowVnId(data.source_vn, &data.source_vn_id);
+    uint32_t dst_id = FlowVnId(data.dest_vn, &data.dest_vn_id);
 
     /* When packet is going from src_vn to dst_vn it should be interpreted 
      * as ingress to vrouter and hence in-stats for src_vn w.r.t. dst_vn
@@ -312,13 +347,13 @@ void VnUveTable::UpdateInterVnStats(const FlowEntry *fe, uint64_t bytes,
      * Here the direction "in" and "out" should be interpreted w.r.t vrouter
      */
     if (fe->is_flags_set(FlowEntry::LocalFlow)) {
-        VnStatsUpdateInternal(src_vn, dst_vn, bytes, pkts, false);
-        VnStatsUpdateInternal(dst_vn, src_vn, bytes, pkts, true);
+        VnStatsUpdateInternal(src_id, dst_id, bytes, pkts, false);
+        VnStatsUpdateInternal(dst_id, src_id, bytes, pkts, true);
     } else {
         if (fe->is_flags_set(FlowEntry::IngressDir)) {
-            VnStatsUpdateInternal(src_vn, dst_vn, bytes, pkts, false);
+            VnStatsUpdateInternal(src_id, dst_id, bytes, pkts, false);
         } else {
-            VnStatsUpdateInternal(dst_vn, src_vn, bytes, pkts, true);
+            VnStatsUpdateInternal(dst_id, src_id, bytes, pkts, true);
         }
     }
 }
@@ -9,6 +9,7 @@
 #include <set>
 #include <map>
 #include <vector>
+#include <boost/unordered_map.hpp>
 #include <sandesh/sandesh_types.h>
 #include <sandesh/sandesh_constants.h>
 #include <sandesh/sandesh.h>
@@ -40,15 +41,21 @@ public:
     typedef boost::shared_ptr<VnUveEntry> VnUveEntryPtr;
     typedef std::map<std::string, VnUveEntryPtr> UveVnMap;
     typedef std::pair<std::string, VnUveEntryPtr> UveVnPair;
+    typedef boost::unordered_map<std::string, uint32_t> VnIdMap;
     VnUveTable(Agent *agent);
     virtual ~VnUveTable();
 
     void UpdateBitmap(const std::string &vn, uint8_t proto, uint16_t sport, 
                       uint16_t dport);
     void SendVnStats(bool only_vrf_stats);
-    void UpdateInterVnStats(const FlowEntry *e, uint64_t bytes, uint64_t pkts);
+    void UpdateInterVnStats(FlowEntry *e, uint64_t bytes, uint64_t pkts);
     void RegisterDBClients();
     void Shutdown(void);
+    //VN names are interned to ids used to index inter-VN stats. Ids are
+    //never reused, since stats of other VNs may refer to them
+    uint32_t VnNameToId(const std::string &vn);
+    const std::string &VnIdToName(uint32_t id) const { return vn_names_[id]; }
+    uint32_t vn_id_count() const { return vn_names_.size(); }
 
 protected:
     //The following API is made protected for UT.
@@ -71,13 +78,20 @@ private:
     void InterfaceAddHandler(const VmEntry *vm, const VnEntry *vn, 
                              const Interface* intf);
     bool SendUnresolvedVnMsg(const std::string &vn, UveVirtualNetworkAgent &u);
-    void VnStatsUpdateInternal(const std::string &src, const std::string &dst,
+    void VnStatsUpdateInternal(uint32_t src_id, uint32_t dst_id,
                                uint64_t bytes, uint64_t pkts, bool outgoing);
+    uint32_t FlowVnId(const std::string &vn, uint32_t *id);
+    void SetVnUveEntry(const std::string &vn, const VnUveEntryPtr &entry);
     void RemoveInterVnStats(const std::string &vn);
     VnUveEntry* UveEntryFromVn(const VnEntry *vn);
 
     DBTableBase::ListenerId vn_listener_id_;
     DBTableBase::ListenerId intf_listener_id_;
+    VnIdMap vn_id_map_;
+    std::vector<std::string> vn_names_;
+    //UVE entry of VN indexed by its interned id
+    std::vector<VnUveEntryPtr> vn_uve_by_id_;
+    uint32_t unknown_vn_id_;
     DISALLOW_COPY_AND_ASSIGN(VnUveTable);
 };
 
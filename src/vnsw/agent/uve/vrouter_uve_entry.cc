@@ -409,6 +409,13 @@ bool VrouterUveEntry::SendVrouterMsg() {
         prev_stats_.set_phy_if_stats_list(phy_if_list);
         change = true;
     }
+    vector<AgentFlowSetupStats> flow_setup_list;
+    BuildFlowSetupStatsList(flow_setup_list);
+    if (prev_stats_.get_flow_setup_stats_list() != flow_setup_list) {
+        stats.set_flow_setup_stats_list(flow_setup_list);
+        prev_stats_.set_flow_setup_stats_list(flow_setup_list);
+        change = true;
+    }
     bandwidth_count_++;
     if (first) {
         InitPrevStats();
@@ -904,6 +911,38 @@ void VrouterUveEntry::FetchDropStats(AgentDropStats &ds) const {
     ds.ds_frag_err = stats.get_vds_frag_err();
 }
 
+// Only VM interfaces that had flow setup requests dropped or deferred are
+// reported
+void VrouterUveEntry::BuildFlowSetupStatsList
+    (vector<AgentFlowSetupStats> &list) const {
+    FlowProto *proto = agent_->GetFlowProto();
+    if (proto == NULL) {
+        return;
+    }
+
+    FlowScheduler::StatsMap stats_map;
+    proto->scheduler()->GetStats(&stats_map);
+    FlowScheduler::StatsMap::const_iterator it = stats_map.begin();
+    while (it != stats_map.end()) {
+        const FlowScheduler::Stats &s = it->second;
+        const Interface *intf =
+            agent_->interface_table()->FindInterface(it->first);
+        ++it;
+        if (intf == NULL || intf->type() != Interface::VM_INTERFACE) {
+            continue;
+        }
+        if (s.dropped == 0 && s.deferred == 0) {
+            continue;
+        }
+        AgentFlowSetupStats entry;
+        entry.set_name(intf->name());
+        entry.set_admitted(s.admitted);
+        entry.set_dropped(s.dropped);
+        entry.set_deferred(s.deferred);
+        list.push_back(entry);
+    }
+}
+
 void VrouterUveEntry::BuildXmppStatsList(vector<AgentXmppStats> &list) const {
     for (int count = 0; count < MAX_XMPP_SERVERS; count++) {
         AgentXmppStats peer;
@@ -87,6 +87,7 @@ private:
     std::string GetMacAddress(const ether_addr &mac) const;
     bool BuildPhysicalInterfaceList(std::vector<AgentIfStats> &list) const;
     void BuildXmppStatsList(std::vector<AgentXmppStats> &list) const;
+    void BuildFlowSetupStatsList(std::vector<AgentFlowSetupStats> &list) const;
     void SendVrouterUve();
     void BuildAndSendComputeCpuStateMsg(const CpuLoadInfo &info);
     void SubnetToStringList(VirtualGatewayConfig::SubnetList &l1, 